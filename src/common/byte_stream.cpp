@@ -751,6 +751,22 @@ u32 GrowableMemoryByteStream::Write(const void* pSource, u32 ByteCount)
   return ByteCount;
 }
 
+u8* GrowableMemoryByteStream::GetWritePointer(u32 MinimumSize, u32* pAvailableSize)
+{
+  if ((m_iPosition + MinimumSize) > m_iMemorySize)
+    Grow(MinimumSize);
+
+  *pAvailableSize = m_iMemorySize - m_iPosition;
+  return m_pMemory + m_iPosition;
+}
+
+void GrowableMemoryByteStream::AdvanceWritePosition(u32 ByteCount)
+{
+  DebugAssert((m_iPosition + ByteCount) <= m_iMemorySize);
+  m_iPosition += ByteCount;
+  m_iSize = std::max(m_iSize, m_iPosition);
+}
+
 bool GrowableMemoryByteStream::Write2(const void* pSource, u32 ByteCount, u32* pNumberOfBytesWritten /* = nullptr */)
 {
   u32 r = Write(pSource, ByteCount);
@@ -170,6 +170,12 @@ public:
   u8* GetMemoryPointer() const { return m_pMemory; }
   u32 GetMemorySize() const { return m_iSize; }
 
+  // returns a pointer to the memory at the current position, growing it so at least MinimumSize bytes can be written
+  // there. the number of bytes which can be written is stored in pAvailableSize. they only become part of the stream
+  // once AdvanceWritePosition() is called.
+  u8* GetWritePointer(u32 MinimumSize, u32* pAvailableSize);
+  void AdvanceWritePosition(u32 ByteCount);
+
   virtual bool ReadByte(u8* pDestByte) override;
   virtual u32 Read(void* pDestination, u32 ByteCount) override;
   virtual bool Read2(void* pDestination, u32 ByteCount, u32* pNumberOfBytesRead /* = nullptr */) override;
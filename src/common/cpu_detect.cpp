@@ -0,0 +1,92 @@
+#include "cpu_detect.h"
+#include "types.h"
+
+#if defined(CPU_X64) || defined(CPU_X86)
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+namespace CPUDetect {
+
+namespace {
+struct Features
+{
+  bool sse41 = false;
+  bool avx2 = false;
+
+  Features();
+};
+} // namespace
+
+#if defined(CPU_X64) || defined(CPU_X86)
+
+static void GetCPUID(u32 function, u32 subfunction, u32 regs[4])
+{
+#ifdef _MSC_VER
+  int iregs[4];
+  __cpuidex(iregs, static_cast<int>(function), static_cast<int>(subfunction));
+  for (u32 i = 0; i < 4; i++)
+    regs[i] = static_cast<u32>(iregs[i]);
+#else
+  __cpuid_count(function, subfunction, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+static u64 GetXCR0()
+{
+#ifdef _MSC_VER
+  return _xgetbv(0);
+#else
+  u32 eax, edx;
+  __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+  return (static_cast<u64>(edx) << 32) | eax;
+#endif
+}
+
+Features::Features()
+{
+  u32 regs[4];
+  GetCPUID(0, 0, regs);
+  const u32 max_function = regs[0];
+  if (max_function < 1)
+    return;
+
+  GetCPUID(1, 0, regs);
+  sse41 = (regs[2] & (1u << 19)) != 0;
+
+  // AVX requires the OS to save the upper halves of the YMM registers.
+  const bool osxsave = (regs[2] & (1u << 27)) != 0;
+  const bool avx = (regs[2] & (1u << 28)) != 0;
+  if (!osxsave || !avx || (GetXCR0() & 6) != 6 || max_function < 7)
+    return;
+
+  GetCPUID(7, 0, regs);
+  avx2 = (regs[1] & (1u << 5)) != 0;
+}
+
+#else
+
+Features::Features() = default;
+
+#endif
+
+static const Features& GetFeatures()
+{
+  static const Features features;
+  return features;
+}
+
+bool HasSSE41()
+{
+  return GetFeatures().sse41;
+}
+
+bool HasAVX2()
+{
+  return GetFeatures().avx2;
+}
+
+} // namespace CPUDetect
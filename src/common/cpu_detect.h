@@ -29,3 +29,13 @@
 #error Unknown compiler.
 
 #endif
+
+namespace CPUDetect {
+
+/// Returns true if the host CPU supports SSE4.1 instructions.
+bool HasSSE41();
+
+/// Returns true if the host CPU and OS support AVX2 instructions.
+bool HasAVX2();
+
+} // namespace CPUDetect
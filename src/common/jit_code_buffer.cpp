@@ -10,8 +10,10 @@
 #include <sys/mman.h>
 #endif
 
-JitCodeBuffer::JitCodeBuffer(u32 size /* = 64 * 1024 * 1024 */, u32 far_code_size /* = 0 */)
+JitCodeBuffer::JitCodeBuffer(u32 size /* = 64 * 1024 * 1024 */, u32 far_code_size /* = 0 */,
+                             u32 region_count /* = 1 */)
 {
+  DebugAssert(region_count > 0);
   m_total_size = size + far_code_size;
 
 #if defined(WIN32)
@@ -23,14 +25,18 @@ JitCodeBuffer::JitCodeBuffer(u32 size /* = 64 * 1024 * 1024 */, u32 far_code_siz
   m_code_ptr = nullptr;
 #endif
   m_free_code_ptr = m_code_ptr;
-  m_code_size = size;
+  m_code_size = size / region_count;
   m_code_used = 0;
 
   m_far_code_ptr = static_cast<u8*>(m_code_ptr) + size;
   m_free_far_code_ptr = m_far_code_ptr;
-  m_far_code_size = far_code_size;
+  m_far_code_size = far_code_size / region_count;
   m_far_code_used = 0;
 
+  m_region_count = region_count;
+  m_region_code_used.resize(region_count);
+  m_region_far_code_used.resize(region_count);
+
   if (!m_code_ptr)
     Panic("Failed to allocate code space.");
 }
@@ -57,6 +63,7 @@ void JitCodeBuffer::CommitCode(u32 length)
   Assert(length <= (m_code_size - m_code_used));
   m_free_code_ptr += length;
   m_code_used += length;
+  m_region_code_used[m_current_region] = m_code_used;
 }
 
 void JitCodeBuffer::CommitFarCode(u32 length)
@@ -72,24 +79,67 @@ void JitCodeBuffer::CommitFarCode(u32 length)
   Assert(length <= (m_far_code_size - m_far_code_used));
   m_free_far_code_ptr += length;
   m_far_code_used += length;
+  m_region_far_code_used[m_current_region] = m_far_code_used;
 }
 
 void JitCodeBuffer::Reset()
 {
-  std::memset(m_code_ptr, 0, m_code_size);
-  FlushInstructionCache(m_code_ptr, m_code_size);
+  // Backwards, so that the first region is current at the end.
+  for (u32 i = m_region_count; i > 0; i--)
+    ResetRegion(i - 1);
+}
+
+u32 JitCodeBuffer::GetRegionForPointer(const void* ptr) const
+{
+  const u8* byte_ptr = static_cast<const u8*>(ptr);
+  if (m_far_code_size > 0 && byte_ptr >= m_far_code_ptr)
+    return static_cast<u32>(byte_ptr - m_far_code_ptr) / m_far_code_size;
+  else
+    return static_cast<u32>(byte_ptr - m_code_ptr) / m_code_size;
+}
+
+void JitCodeBuffer::ResetRegion(u32 region)
+{
+  DebugAssert(region < m_region_count);
+  u8* region_code_ptr = m_code_ptr + (region * m_code_size);
+  std::memset(region_code_ptr, 0, m_region_code_used[region]);
+  FlushInstructionCache(region_code_ptr, m_region_code_used[region]);
+
+  u8* region_far_code_ptr = m_far_code_ptr + (region * m_far_code_size);
   if (m_far_code_size > 0)
   {
-    std::memset(m_far_code_ptr, 0, m_far_code_size);
-    FlushInstructionCache(m_far_code_ptr, m_far_code_size);
+    std::memset(region_far_code_ptr, 0, m_region_far_code_used[region]);
+    FlushInstructionCache(region_far_code_ptr, m_region_far_code_used[region]);
   }
-  m_free_code_ptr = m_code_ptr;
-  m_code_used = 0;
 
-  m_free_far_code_ptr = m_far_code_ptr;
+  m_region_code_used[region] = 0;
+  m_region_far_code_used[region] = 0;
+
+  m_current_region = region;
+  m_free_code_ptr = region_code_ptr;
+  m_code_used = 0;
+  m_free_far_code_ptr = region_far_code_ptr;
   m_far_code_used = 0;
 }
 
+u32 JitCodeBuffer::GetTotalCodeUsed() const
+{
+  u32 total = 0;
+  for (const u32 used : m_region_code_used)
+    total += used;
+
+  return total;
+}
+
+u32 JitCodeBuffer::GetTotalFarCodeUsed() const
+{
+  u32 total = 0;
+  for (const u32 used : m_region_far_code_used)
+    total += used;
+
+  return total;
+}
+
 void JitCodeBuffer::Align(u32 alignment, u8 padding_value)
 {
   DebugAssert(Common::IsPow2(alignment));
@@ -100,6 +150,7 @@ void JitCodeBuffer::Align(u32 alignment, u8 padding_value)
   std::memset(m_free_code_ptr, padding_value, num_padding_bytes);
   m_free_code_ptr += num_padding_bytes;
   m_code_used += num_padding_bytes;
+  m_region_code_used[m_current_region] = m_code_used;
 }
 
 void JitCodeBuffer::FlushInstructionCache(void* address, u32 size)
@@ -1,12 +1,17 @@
 #pragma once
 #include "types.h"
+#include <vector>
 
+/// Executable memory for recompiled code, with separate near and far code areas. Both areas can be split into the
+/// same number of regions. Code is allocated from the current region only, and a region can be emptied and reused
+/// without touching the others.
 class JitCodeBuffer
 {
 public:
-  JitCodeBuffer(u32 size = 64 * 1024 * 1024, u32 far_code_size = 0);
+  JitCodeBuffer(u32 size = 64 * 1024 * 1024, u32 far_code_size = 0, u32 region_count = 1);
   ~JitCodeBuffer();
 
+  /// Empties all regions, and continues allocating from the first.
   void Reset();
 
   u8* GetFreeCodePointer() const { return m_free_code_ptr; }
@@ -17,6 +22,24 @@ public:
   u32 GetFreeFarCodeSpace() const { return static_cast<u32>(m_far_code_size - m_far_code_used); }
   void CommitFarCode(u32 length);
 
+  u32 GetRegionCount() const { return m_region_count; }
+  u32 GetCurrentRegion() const { return m_current_region; }
+  u32 GetRegionCodeSize() const { return m_code_size; }
+  u32 GetRegionFarCodeSize() const { return m_far_code_size; }
+
+  /// Returns the region which the near or far code pointer belongs to.
+  u32 GetRegionForPointer(const void* ptr) const;
+
+  /// Returns true if the near or far code pointer is within the region.
+  bool IsPointerInRegion(const void* ptr, u32 region) const { return (GetRegionForPointer(ptr) == region); }
+
+  /// Empties the region, and continues allocating from it. Nothing may execute the old code afterwards.
+  void ResetRegion(u32 region);
+
+  /// Returns the number of bytes allocated across all regions.
+  u32 GetTotalCodeUsed() const;
+  u32 GetTotalFarCodeUsed() const;
+
   /// Adjusts the free code pointer to the specified alignment, padding with bytes.
   /// Assumes alignment is a power-of-two.
   void Align(u32 alignment, u8 padding_value);
@@ -25,6 +48,7 @@ public:
   static void FlushInstructionCache(void* address, u32 size);
 
 private:
+  // The free pointers, sizes and usage are for the current region, the base pointers for the first.
   u8* m_code_ptr;
   u8* m_free_code_ptr;
   u32 m_code_size;
@@ -36,5 +60,10 @@ private:
   u32 m_far_code_used;
 
   u32 m_total_size;
+
+  u32 m_region_count;
+  u32 m_current_region = 0;
+  std::vector<u32> m_region_code_used;
+  std::vector<u32> m_region_far_code_used;
 };
 
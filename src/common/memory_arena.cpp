@@ -0,0 +1,127 @@
+#include "memory_arena.h"
+#include "log.h"
+#include <cerrno>
+Log_SetChannel(MemoryArena);
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+MemoryArena::MemoryArena() = default;
+
+MemoryArena::~MemoryArena()
+{
+  Destroy();
+}
+
+bool MemoryArena::IsSupported()
+{
+#if defined(__linux__)
+  return true;
+#else
+  return false;
+#endif
+}
+
+bool MemoryArena::Create(size_t size)
+{
+  Destroy();
+
+#if defined(__linux__)
+  m_fd = memfd_create("duckstation_memory_arena", MFD_CLOEXEC);
+  if (m_fd < 0)
+  {
+    Log_ErrorPrintf("memfd_create() failed: %d", errno);
+    return false;
+  }
+
+  if (ftruncate(m_fd, static_cast<off_t>(size)) < 0)
+  {
+    Log_ErrorPrintf("ftruncate(%zu) failed: %d", size, errno);
+    Destroy();
+    return false;
+  }
+
+  m_size = size;
+  return true;
+#else
+  return false;
+#endif
+}
+
+void MemoryArena::Destroy()
+{
+#if defined(__linux__)
+  if (m_fd >= 0)
+  {
+    close(m_fd);
+    m_fd = -1;
+  }
+#endif
+
+  m_size = 0;
+}
+
+void* MemoryArena::CreateView(size_t offset, size_t size, bool writable, void* fixed_address /* = nullptr */)
+{
+#if defined(__linux__)
+  if (m_fd < 0 || (offset + size) > m_size)
+    return nullptr;
+
+  const int prot = writable ? (PROT_READ | PROT_WRITE) : PROT_READ;
+  const int flags = fixed_address ? (MAP_SHARED | MAP_FIXED) : MAP_SHARED;
+  void* ptr = mmap(fixed_address, size, prot, flags, m_fd, static_cast<off_t>(offset));
+  if (ptr == MAP_FAILED)
+  {
+    Log_ErrorPrintf("mmap(%p, %zu) of arena offset %zu failed: %d", fixed_address, size, offset, errno);
+    return nullptr;
+  }
+
+  return ptr;
+#else
+  return nullptr;
+#endif
+}
+
+bool MemoryArena::ReleaseView(void* address, size_t size)
+{
+#if defined(__linux__)
+  return (munmap(address, size) == 0);
+#else
+  return false;
+#endif
+}
+
+void* MemoryArena::ReserveRange(size_t size)
+{
+#if defined(__linux__)
+  void* ptr = mmap(nullptr, size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+  if (ptr == MAP_FAILED)
+  {
+    Log_ErrorPrintf("Failed to reserve %zu bytes of address space: %d", size, errno);
+    return nullptr;
+  }
+
+  return ptr;
+#else
+  return nullptr;
+#endif
+}
+
+void MemoryArena::ReleaseRange(void* address, size_t size)
+{
+#if defined(__linux__)
+  munmap(address, size);
+#endif
+}
+
+bool MemoryArena::SetPageProtection(void* address, size_t size, bool writable)
+{
+#if defined(__linux__)
+  return (mprotect(address, size, writable ? (PROT_READ | PROT_WRITE) : PROT_READ) == 0);
+#else
+  return false;
+#endif
+}
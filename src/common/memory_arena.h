@@ -0,0 +1,32 @@
+#pragma once
+#include "types.h"
+
+/// Block of shared memory which can be mapped at several host addresses at once. Used to mirror guest memory into a
+/// host address range, so that recompiled code can access it directly.
+class MemoryArena
+{
+public:
+  MemoryArena();
+  ~MemoryArena();
+
+  /// Returns true if views can be created on this host.
+  static bool IsSupported();
+
+  bool Create(size_t size);
+  void Destroy();
+
+  /// Maps the range offset..offset+size of the arena. If fixed_address is not null, the view replaces whatever is
+  /// mapped there, which should be part of a range from ReserveRange(). Returns nullptr on failure.
+  void* CreateView(size_t offset, size_t size, bool writable, void* fixed_address = nullptr);
+  static bool ReleaseView(void* address, size_t size);
+
+  /// Reserves an inaccessible range of address space, which views can be placed in.
+  static void* ReserveRange(size_t size);
+  static void ReleaseRange(void* address, size_t size);
+
+  static bool SetPageProtection(void* address, size_t size, bool writable);
+
+private:
+  int m_fd = -1;
+  size_t m_size = 0;
+};
@@ -0,0 +1,136 @@
+#include "page_fault_handler.h"
+#include "cpu_detect.h"
+#include "log.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <mutex>
+Log_SetChannel(Common::PageFaultHandler);
+
+#if defined(__linux__) && defined(CPU_X64)
+#define USE_SIGSEGV_HANDLER 1
+#include <csignal>
+#include <ucontext.h>
+#endif
+
+namespace Common::PageFaultHandler {
+
+// Faults can happen on any thread, including while another one is installing or removing a handler, so the signal
+// handler doesn't lock anything and only reads the slots. A slot is in use while its callback is set. The mutex only
+// serializes InstallHandler() and RemoveHandler().
+struct RegisteredHandler
+{
+  std::atomic<void*> owner{nullptr};
+  std::atomic<Callback> callback{nullptr};
+};
+
+static constexpr u32 MAX_HANDLERS = 8;
+
+static std::array<RegisteredHandler, MAX_HANDLERS> s_handlers;
+static u32 s_handler_count = 0;
+static std::mutex s_handlers_mutex;
+
+#ifdef USE_SIGSEGV_HANDLER
+
+static struct sigaction s_old_sigsegv_action;
+static bool s_sigsegv_handler_installed = false;
+
+static void SIGSEGVHandler(int sig, siginfo_t* info, void* ctx)
+{
+  ucontext_t* const uc = static_cast<ucontext_t*>(ctx);
+  void* const exception_pc = reinterpret_cast<void*>(uc->uc_mcontext.gregs[REG_RIP]);
+  const bool is_write = (uc->uc_mcontext.gregs[REG_ERR] & 2) != 0;
+
+  for (const RegisteredHandler& handler : s_handlers)
+  {
+    const Callback callback = handler.callback.load(std::memory_order_acquire);
+    if (callback && callback(handler.owner.load(std::memory_order_relaxed), exception_pc, info->si_addr, is_write) ==
+                      HandlerResult::ContinueExecution)
+    {
+      return;
+    }
+  }
+
+  // Not ours, pass it on. With the default action, returning re-runs the instruction and takes the fault again.
+  if (s_old_sigsegv_action.sa_flags & SA_SIGINFO)
+    s_old_sigsegv_action.sa_sigaction(sig, info, ctx);
+  else if (s_old_sigsegv_action.sa_handler == SIG_DFL)
+    signal(sig, SIG_DFL);
+  else if (s_old_sigsegv_action.sa_handler != SIG_IGN)
+    s_old_sigsegv_action.sa_handler(sig);
+}
+
+#endif
+
+bool IsSupported()
+{
+#ifdef USE_SIGSEGV_HANDLER
+  return true;
+#else
+  return false;
+#endif
+}
+
+bool InstallHandler(void* owner, Callback callback)
+{
+#ifdef USE_SIGSEGV_HANDLER
+  std::unique_lock lock(s_handlers_mutex);
+  auto iter = std::find_if(s_handlers.begin(), s_handlers.end(), [](const RegisteredHandler& handler) {
+    return handler.callback.load(std::memory_order_relaxed) == nullptr;
+  });
+  if (iter == s_handlers.end())
+  {
+    Log_ErrorPrint("Too many page fault handlers");
+    return false;
+  }
+
+  if (!s_sigsegv_handler_installed)
+  {
+    struct sigaction sa = {};
+    sa.sa_sigaction = SIGSEGVHandler;
+    sa.sa_flags = SA_SIGINFO | SA_NODEFER;
+    sigemptyset(&sa.sa_mask);
+    if (sigaction(SIGSEGV, &sa, &s_old_sigsegv_action) != 0)
+    {
+      Log_ErrorPrint("Failed to install SIGSEGV handler");
+      return false;
+    }
+
+    s_sigsegv_handler_installed = true;
+  }
+
+  // The owner has to be visible before the callback, which marks the slot as used.
+  iter->owner.store(owner, std::memory_order_relaxed);
+  iter->callback.store(callback, std::memory_order_release);
+  s_handler_count++;
+  return true;
+#else
+  return false;
+#endif
+}
+
+bool RemoveHandler(void* owner)
+{
+  std::unique_lock lock(s_handlers_mutex);
+  auto iter = std::find_if(s_handlers.begin(), s_handlers.end(), [owner](const RegisteredHandler& handler) {
+    return handler.callback.load(std::memory_order_relaxed) && handler.owner.load(std::memory_order_relaxed) == owner;
+  });
+  if (iter == s_handlers.end())
+    return false;
+
+  iter->callback.store(nullptr, std::memory_order_release);
+  iter->owner.store(nullptr, std::memory_order_relaxed);
+  s_handler_count--;
+
+#ifdef USE_SIGSEGV_HANDLER
+  if (s_handler_count == 0 && s_sigsegv_handler_installed)
+  {
+    sigaction(SIGSEGV, &s_old_sigsegv_action, nullptr);
+    s_sigsegv_handler_installed = false;
+  }
+#endif
+
+  return true;
+}
+
+} // namespace Common::PageFaultHandler
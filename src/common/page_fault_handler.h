@@ -0,0 +1,21 @@
+#pragma once
+#include "types.h"
+
+namespace Common::PageFaultHandler {
+
+enum class HandlerResult
+{
+  ContinueExecution,
+  ExecuteNextHandler,
+};
+
+/// Called on the faulting thread. Returning ContinueExecution retries the faulting instruction.
+using Callback = HandlerResult (*)(void* owner, void* exception_pc, void* fault_address, bool is_write);
+
+/// Returns true if faults can be intercepted on this host.
+bool IsSupported();
+
+bool InstallHandler(void* owner, Callback callback);
+bool RemoveHandler(void* owner);
+
+} // namespace Common::PageFaultHandler
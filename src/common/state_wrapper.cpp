@@ -7,36 +7,105 @@ Log_SetChannel(StateWrapper);
 
 StateWrapper::StateWrapper(ByteStream* stream, Mode mode) : m_stream(stream), m_mode(mode) {}
 
-StateWrapper::~StateWrapper() = default;
+StateWrapper::StateWrapper(GrowableMemoryByteStream* stream, Mode mode)
+  : m_stream(stream), m_memory_stream(stream), m_buffer_offset(static_cast<u32>(stream->GetPosition())), m_mode(mode)
+{
+  if (mode == Mode::Read)
+  {
+    m_buffer = stream->GetMemoryPointer() + m_buffer_offset;
+    m_buffer_size = stream->GetMemorySize() - m_buffer_offset;
+  }
+  else
+  {
+    m_buffer = stream->GetWritePointer(0, &m_buffer_size);
+  }
+}
+
+StateWrapper::StateWrapper(const void* data, u32 size)
+  : m_stream(nullptr), m_buffer(static_cast<u8*>(const_cast<void*>(data))), m_buffer_size(size), m_mode(Mode::Read)
+{
+}
+
+StateWrapper::~StateWrapper()
+{
+  if (!m_memory_stream)
+    return;
+
+  if (m_mode == Mode::Read)
+    m_memory_stream->SeekAbsolute(m_buffer_offset + m_buffer_position);
+  else
+    m_memory_stream->AdvanceWritePosition(m_buffer_position);
+}
+
+bool StateWrapper::GrowBuffer(u32 size)
+{
+  if (!m_memory_stream || m_mode != Mode::Write)
+    return false;
+
+  // Everything so far becomes part of the stream, and the buffer restarts at the end of it.
+  m_memory_stream->AdvanceWritePosition(m_buffer_position);
+  m_buffer_offset += m_buffer_position;
+  m_buffer_position = 0;
+  m_buffer = m_memory_stream->GetWritePointer(size, &m_buffer_size);
+  return true;
+}
+
+u64 StateWrapper::GetPosition() const
+{
+  return m_buffer ? static_cast<u64>(m_buffer_offset + m_buffer_position) : m_stream->GetPosition();
+}
+
+u64 StateWrapper::GetRemainingSize() const
+{
+  if (m_buffer)
+    return m_buffer_size - m_buffer_position;
+
+  const u64 size = m_stream->GetSize();
+  const u64 position = m_stream->GetPosition();
+  return (position < size) ? (size - position) : 0;
+}
 
 void StateWrapper::DoBytes(void* data, size_t length)
 {
   if (m_mode == Mode::Read)
   {
-    if (m_error || (m_error |= !m_stream->Read2(data, static_cast<u32>(length))) == true)
+    if (m_error || (m_error |= !ReadData(data, static_cast<u32>(length))) == true)
       std::memset(data, 0, length);
   }
   else
   {
     if (!m_error)
-      m_error |= !m_stream->Write2(data, static_cast<u32>(length));
+      m_error |= !WriteData(data, static_cast<u32>(length));
   }
 }
 
+const void* StateWrapper::ReadInPlace(size_t length, size_t alignment)
+{
+  if (m_error || !m_buffer || m_mode != Mode::Read || length > (m_buffer_size - m_buffer_position))
+    return nullptr;
+
+  const u8* data = m_buffer + m_buffer_position;
+  if ((reinterpret_cast<uintptr_t>(data) % alignment) != 0)
+    return nullptr;
+
+  m_buffer_position += static_cast<u32>(length);
+  return data;
+}
+
 void StateWrapper::Do(bool* value_ptr)
 {
   if (m_mode == Mode::Read)
   {
     u8 value = 0;
     if (!m_error)
-      m_error |= !m_stream->ReadByte(&value);
+      m_error |= !ReadData(&value, sizeof(value));
     *value_ptr = (value != 0);
   }
   else
   {
     u8 value = static_cast<u8>(*value_ptr);
     if (!m_error)
-      m_error |= !m_stream->WriteByte(value);
+      m_error |= !WriteData(&value, sizeof(value));
   }
 }
 
@@ -70,7 +139,7 @@ bool StateWrapper::DoMarker(const char* marker)
   if (m_mode == Mode::Write || file_value.Compare(marker))
     return true;
 
-  Log_ErrorPrintf("Marker mismatch at offset %" PRIu64 ": found '%s' expected '%s'", m_stream->GetPosition(),
+  Log_ErrorPrintf("Marker mismatch at offset %" PRIu64 ": found '%s' expected '%s'", GetPosition(),
                   file_value.GetCharArray(), marker);
 
   return false;
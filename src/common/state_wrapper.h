@@ -21,15 +21,26 @@ public:
   };
 
   StateWrapper(ByteStream* stream, Mode mode);
+
+  /// Reads or writes directly in the stream's memory, instead of going through the stream for every value. The
+  /// stream's position is only updated when the wrapper is destroyed.
+  StateWrapper(GrowableMemoryByteStream* stream, Mode mode);
+
+  /// Reads directly from memory.
+  StateWrapper(const void* data, u32 size);
+
   StateWrapper(const StateWrapper&) = delete;
   ~StateWrapper();
 
+  /// Returns the stream, or null when reading directly from memory.
   ByteStream* GetStream() const { return m_stream; }
   bool HasError() const { return m_error; }
   bool IsReading() const { return (m_mode == Mode::Read); }
   bool IsWriting() const { return (m_mode == Mode::Write); }
   Mode GetMode() const { return m_mode; }
-  void SetMode(Mode mode) { m_mode = mode; }
+
+  /// Returns the number of bytes left to read, so lengths read from the data can be checked before allocating.
+  u64 GetRemainingSize() const;
 
   /// Overload for integral or floating-point types. Writes bytes as-is.
   template<typename T, std::enable_if_t<std::is_integral_v<T> || std::is_floating_point_v<T>, int> = 0>
@@ -37,13 +48,13 @@ public:
   {
     if (m_mode == Mode::Read)
     {
-      if (m_error || (m_error |= !m_stream->Read2(value_ptr, sizeof(T))) == true)
+      if (m_error || (m_error |= !ReadData(value_ptr, sizeof(T))) == true)
         *value_ptr = static_cast<T>(0);
     }
     else
     {
       if (!m_error)
-        m_error |= !m_stream->Write2(value_ptr, sizeof(T));
+        m_error |= !WriteData(value_ptr, sizeof(T));
     }
   }
 
@@ -55,7 +66,7 @@ public:
     if (m_mode == Mode::Read)
     {
       TType temp;
-      if (m_error || (m_error |= !m_stream->Read2(&temp, sizeof(TType))) == true)
+      if (m_error || (m_error |= !ReadData(&temp, sizeof(TType))) == true)
         temp = static_cast<TType>(0);
 
       *value_ptr = static_cast<T>(temp);
@@ -65,7 +76,7 @@ public:
       TType temp;
       std::memcpy(&temp, value_ptr, sizeof(TType));
       if (!m_error)
-        m_error |= !m_stream->Write2(&temp, sizeof(TType));
+        m_error |= !WriteData(&temp, sizeof(TType));
     }
   }
 
@@ -75,32 +86,46 @@ public:
   {
     if (m_mode == Mode::Read)
     {
-      if (m_error || (m_error |= !m_stream->Read2(value_ptr, sizeof(T))) == true)
+      if (m_error || (m_error |= !ReadData(value_ptr, sizeof(T))) == true)
         std::memset(value_ptr, 0, sizeof(*value_ptr));
     }
     else
     {
       if (!m_error)
-        m_error |= !m_stream->Write2(value_ptr, sizeof(T));
+        m_error |= !WriteData(value_ptr, sizeof(T));
     }
   }
 
   template<typename T>
   void DoArray(T* values, size_t count)
   {
-    for (size_t i = 0; i < count; i++)
-      Do(&values[i]);
+    // Values which are stored as-is can be done in one go, e.g. memory card data.
+    if constexpr ((std::is_integral_v<T> && !std::is_same_v<T, bool>) || std::is_floating_point_v<T> ||
+                  std::is_enum_v<T>)
+    {
+      DoBytes(values, sizeof(T) * count);
+    }
+    else
+    {
+      for (size_t i = 0; i < count; i++)
+        Do(&values[i]);
+    }
   }
 
   template<typename T>
   void DoPODArray(T* values, size_t count)
   {
-    for (size_t i = 0; i < count; i++)
-      DoPOD(&values[i]);
+    static_assert(std::is_pod_v<T>);
+    DoBytes(values, sizeof(T) * count);
   }
 
   void DoBytes(void* data, size_t length);
 
+  /// When reading from memory, returns a pointer to the next length bytes and skips over them, so large blocks can be
+  /// used without copying them. Returns null when reading from a stream, or if the data isn't suitably aligned, in
+  /// which case DoBytes() should be used instead.
+  const void* ReadInPlace(size_t length, size_t alignment);
+
   void Do(bool* value_ptr);
   void Do(std::string* value_ptr);
   void Do(String* value_ptr);
@@ -176,7 +201,45 @@ public:
   bool DoMarker(const char* marker);
 
 private:
+  ALWAYS_INLINE bool ReadData(void* data, u32 size)
+  {
+    if (!m_buffer)
+      return m_stream->Read2(data, size);
+
+    if (size > (m_buffer_size - m_buffer_position))
+      return false;
+
+    std::memcpy(data, m_buffer + m_buffer_position, size);
+    m_buffer_position += size;
+    return true;
+  }
+
+  ALWAYS_INLINE bool WriteData(const void* data, u32 size)
+  {
+    if (!m_buffer)
+      return m_stream->Write2(data, size);
+
+    if (size > (m_buffer_size - m_buffer_position) && !GrowBuffer(size))
+      return false;
+
+    std::memcpy(m_buffer + m_buffer_position, data, size);
+    m_buffer_position += size;
+    return true;
+  }
+
+  bool GrowBuffer(u32 size);
+  u64 GetPosition() const;
+
   ByteStream* m_stream;
+  GrowableMemoryByteStream* m_memory_stream = nullptr;
+
+  // Only set when reading or writing directly in memory. Offset is the position in the stream of the start of the
+  // buffer.
+  u8* m_buffer = nullptr;
+  u32 m_buffer_offset = 0;
+  u32 m_buffer_position = 0;
+  u32 m_buffer_size = 0;
+
   Mode m_mode;
   bool m_error = false;
 };
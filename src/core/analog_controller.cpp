@@ -45,6 +45,12 @@ bool AnalogController::DoState(StateWrapper& sw)
   return true;
 }
 
+void AnalogController::DoInputState(StateWrapper& sw)
+{
+  sw.Do(&m_button_state);
+  sw.Do(&m_axis_state);
+}
+
 std::optional<s32> AnalogController::GetAxisCodeByName(std::string_view axis_name) const
 {
   return StaticGetAxisCodeByName(axis_name);
@@ -55,6 +55,7 @@ public:
 
   void Reset() override;
   bool DoState(StateWrapper& sw) override;
+  void DoInputState(StateWrapper& sw) override;
 
   void SetAxisState(s32 axis_code, float value) override;
   void SetButtonState(s32 button_code, bool pressed) override;
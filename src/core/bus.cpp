@@ -16,6 +16,7 @@
 #include "spu.h"
 #include "timers.h"
 #include <cstdio>
+#include <cstring>
 Log_SetChannel(Bus);
 
 #define FIXUP_WORD_READ_OFFSET(offset) ((offset) & ~u32(3))
@@ -29,9 +30,27 @@ void FixupUnalignedWordAccessW32(u32& offset, u32& value)
   value <<= byte_offset * 8;
 }
 
-Bus::Bus() = default;
+// KUSEG, KSEG0 and KSEG1 each get four mirrors of RAM in the fastmem range.
+static constexpr std::array<u32, 3> s_fastmem_segment_bases = {{0x00000000, 0x80000000, 0xA0000000}};
 
-Bus::~Bus() = default;
+Bus::Bus()
+{
+  if (MemoryArena::IsSupported() && m_memory_arena.Create(RAM_SIZE))
+    m_ram = static_cast<u8*>(m_memory_arena.CreateView(0, RAM_SIZE, true));
+
+  if (!m_ram)
+  {
+    m_ram_storage = std::make_unique<u8[]>(RAM_SIZE);
+    m_ram = m_ram_storage.get();
+  }
+}
+
+Bus::~Bus()
+{
+  UpdateFastmemViews(false);
+  if (!m_ram_storage)
+    MemoryArena::ReleaseView(m_ram, RAM_SIZE);
+}
 
 void Bus::Initialize(CPU::Core* cpu, CPU::CodeCache* cpu_code_cache, DMA* dma,
                      InterruptController* interrupt_controller, GPU* gpu, CDROM* cdrom, Pad* pad, Timers* timers,
@@ -52,7 +71,7 @@ void Bus::Initialize(CPU::Core* cpu, CPU::CodeCache* cpu_code_cache, DMA* dma,
 
 void Bus::Reset()
 {
-  m_ram.fill(static_cast<u8>(0));
+  std::memset(m_ram, 0, RAM_SIZE);
   m_MEMCTRL.exp1_base = 0x1F000000;
   m_MEMCTRL.exp2_base = 0x1F802000;
   m_MEMCTRL.exp1_delay_size.bits = 0x0013243F;
@@ -73,7 +92,7 @@ bool Bus::DoState(StateWrapper& sw)
   sw.Do(&m_bios_access_time);
   sw.Do(&m_cdrom_access_time);
   sw.Do(&m_spu_access_time);
-  sw.DoBytes(m_ram.data(), m_ram.size());
+  sw.DoBytes(m_ram, RAM_SIZE);
   sw.DoBytes(m_bios.data(), m_bios.size());
   sw.DoArray(m_MEMCTRL.regs, countof(m_MEMCTRL.regs));
   sw.Do(&m_ram_size_reg);
@@ -166,18 +185,126 @@ TickCount Bus::WriteWords(PhysicalMemoryAddress address, const u32* words, u32 w
     return total_ticks;
   }
 
+  if (word_count == 0)
+    return 0;
+
+  const u32 size = word_count * sizeof(u32);
   const u32 start_page = address / CPU_CODE_CACHE_PAGE_SIZE;
-  const u32 end_page = (address + word_count * sizeof(u32)) / CPU_CODE_CACHE_PAGE_SIZE;
+  const u32 end_page = (address + size - 1) / CPU_CODE_CACHE_PAGE_SIZE;
   for (u32 page = start_page; page <= end_page; page++)
   {
     if (m_ram_code_bits[page])
-      DoInvalidateCodeCache(page);
+      DoInvalidateCodeCache(page, address, size);
   }
 
   std::memcpy(&m_ram[address], words, sizeof(u32) * word_count);
   return static_cast<TickCount>(word_count + ((word_count + 15) / 16));
 }
 
+void Bus::ClearRAMCodePageFlags()
+{
+  m_ram_code_bits.reset();
+
+  if (m_fastmem_base && m_fastmem_write_protected_pages.any())
+  {
+    SetFastmemPageProtection(0, RAM_SIZE, true);
+    m_fastmem_write_protected_pages.reset();
+  }
+}
+
+u64 Bus::GetRAMHash() const
+{
+  // FNV-1a over 32-bit words, like the VRAM hash but wider since there's twice as much RAM.
+  u64 hash = UINT64_C(0xCBF29CE484222325);
+  for (u32 offset = 0; offset < RAM_SIZE; offset += sizeof(u32))
+  {
+    u32 value;
+    std::memcpy(&value, &m_ram[offset], sizeof(value));
+    hash = (hash ^ value) * UINT64_C(0x100000001B3);
+  }
+
+  return hash;
+}
+
+void Bus::UpdateFastmemViews(bool enabled)
+{
+  if (enabled == (m_fastmem_base != nullptr))
+    return;
+
+  if (!enabled)
+  {
+    Log_InfoPrintf("Removing fastmem views");
+    MemoryArena::ReleaseRange(m_fastmem_base, FASTMEM_REGION_SIZE);
+    m_fastmem_base = nullptr;
+    m_fastmem_write_protected_pages.reset();
+    return;
+  }
+
+  if (m_ram_storage)
+  {
+    Log_WarningPrintf("Fastmem is not supported on this host");
+    return;
+  }
+
+  u8* base = static_cast<u8*>(MemoryArena::ReserveRange(FASTMEM_REGION_SIZE));
+  if (!base)
+    return;
+
+  for (const u32 segment_base : s_fastmem_segment_bases)
+  {
+    for (u32 mirror = 0; mirror < (RAM_MIRROR_END / RAM_SIZE); mirror++)
+    {
+      if (!m_memory_arena.CreateView(0, RAM_SIZE, true, base + segment_base + (mirror * RAM_SIZE)))
+      {
+        Log_ErrorPrintf("Failed to map fastmem view at 0x%08X", segment_base + (mirror * RAM_SIZE));
+        MemoryArena::ReleaseRange(base, FASTMEM_REGION_SIZE);
+        return;
+      }
+    }
+  }
+
+  m_fastmem_base = base;
+  Log_InfoPrintf("Fastmem base: %p", m_fastmem_base);
+
+  // Pages with existing code still need to be caught.
+  for (u32 i = 0; i < CPU_CODE_CACHE_PAGE_COUNT; i++)
+  {
+    if (m_ram_code_bits[i])
+      UpdateFastmemPageProtection(i);
+  }
+}
+
+void Bus::UpdateFastmemPageProtection(u32 code_page_index)
+{
+  static constexpr u32 code_pages_per_host_page = FASTMEM_HOST_PAGE_SIZE / CPU_CODE_CACHE_PAGE_SIZE;
+  static_assert(code_pages_per_host_page > 0, "host pages are at least as large as code pages");
+
+  const u32 host_page_index = code_page_index / code_pages_per_host_page;
+  const u32 first_code_page = host_page_index * code_pages_per_host_page;
+  bool has_code = false;
+  for (u32 i = 0; i < code_pages_per_host_page; i++)
+    has_code |= m_ram_code_bits[first_code_page + i];
+
+  if (m_fastmem_write_protected_pages[host_page_index] == has_code)
+    return;
+
+  m_fastmem_write_protected_pages[host_page_index] = has_code;
+  SetFastmemPageProtection(host_page_index * FASTMEM_HOST_PAGE_SIZE, FASTMEM_HOST_PAGE_SIZE, !has_code);
+}
+
+void Bus::SetFastmemPageProtection(u32 offset, u32 size, bool writable)
+{
+  for (const u32 segment_base : s_fastmem_segment_bases)
+  {
+    for (u32 mirror = 0; mirror < (RAM_MIRROR_END / RAM_SIZE); mirror++)
+    {
+      u8* address = m_fastmem_base + segment_base + (mirror * RAM_SIZE) + offset;
+      if (!MemoryArena::SetPageProtection(address, size, writable))
+        Log_ErrorPrintf("Failed to change protection of fastmem page at %p", address);
+    }
+  }
+}
+
 void Bus::SetExpansionROM(std::vector<u8> data)
 {
   m_exp1_rom = std::move(data);
@@ -250,6 +377,23 @@ void Bus::RecalculateMemoryTimings()
                   m_spu_access_time[2] + 1);
 }
 
+bool Bus::IsPollableAddress(PhysicalMemoryAddress address)
+{
+  if (IsCacheableAddress(address))
+    return true;
+
+  // Timer and SPU reads catch the device up to the current tick, so their values change between events. The FIFO
+  // registers of the other devices are popped when read.
+  if (address >= INTERRUPT_CONTROLLER_BASE && address < (DMA_BASE + DMA_SIZE))
+    return true;
+  else if (address == CDROM_BASE || address == (CDROM_BASE + 3))
+    return true;
+  else if (address == (GPU_BASE + 4))
+    return true;
+  else
+    return false;
+}
+
 TickCount Bus::DoInvalidAccess(MemoryAccessType type, MemoryAccessSize size, PhysicalMemoryAddress address, u32& value)
 {
   SmallString str;
@@ -527,9 +671,9 @@ void Bus::DoWriteSPU(MemoryAccessSize size, u32 offset, u32 value)
   m_spu->WriteRegister(offset, Truncate16(value));
 }
 
-void Bus::DoInvalidateCodeCache(u32 page_index)
+void Bus::DoInvalidateCodeCache(u32 page_index, u32 offset, u32 size)
 {
-  m_cpu_code_cache->InvalidateBlocksWithPageIndex(page_index);
+  m_cpu_code_cache->InvalidateBlocksWithPageIndex(page_index, offset, size);
 }
 
 u32 Bus::DoReadDMA(MemoryAccessSize size, u32 offset)
@@ -1,8 +1,10 @@
 #pragma once
 #include "common/bitfield.h"
+#include "common/memory_arena.h"
 #include "types.h"
 #include <array>
 #include <bitset>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -74,16 +76,68 @@ public:
   /// Returns true if the address specified is writable (RAM).
   ALWAYS_INLINE static bool IsRAMAddress(PhysicalMemoryAddress address) { return address < RAM_MIRROR_END; }
 
+  /// Returns true if reading the address has no side effects, and the value read can only change when the CPU writes
+  /// to it or a timing event runs. Loops which only poll such addresses can be skipped up to the next event.
+  static bool IsPollableAddress(PhysicalMemoryAddress address);
+
   /// Flags a RAM region as code, so we know when to invalidate blocks.
-  ALWAYS_INLINE void SetRAMCodePage(u32 index) { m_ram_code_bits[index] = true; }
+  ALWAYS_INLINE void SetRAMCodePage(u32 index)
+  {
+    m_ram_code_bits[index] = true;
+    if (m_fastmem_base)
+      UpdateFastmemPageProtection(index);
+  }
 
   /// Unflags a RAM region as code, the code cache will no longer be notified when writes occur.
-  ALWAYS_INLINE void ClearRAMCodePage(u32 index) { m_ram_code_bits[index] = false; }
+  ALWAYS_INLINE void ClearRAMCodePage(u32 index)
+  {
+    m_ram_code_bits[index] = false;
+    if (m_fastmem_base)
+      UpdateFastmemPageProtection(index);
+  }
 
   /// Clears all code bits for RAM regions.
-  ALWAYS_INLINE void ClearRAMCodePageFlags() { m_ram_code_bits.reset(); }
+  void ClearRAMCodePageFlags();
+
+  /// Returns the start of RAM. Only the first 2MB are backed, so addresses in the mirrors have to be masked.
+  const u8* GetRAM() const { return m_ram; }
+
+  /// Returns a hash of the RAM contents, for checking that runs are identical.
+  u64 GetRAMHash() const;
+
+  /// Maps RAM and its mirrors into a host address range laid out like the CPU's KUSEG, KSEG0 and KSEG1 segments, or
+  /// removes the mapping. Pages containing code are mapped read-only, so writes to them fault.
+  void UpdateFastmemViews(bool enabled);
+
+  /// Returns the base of the fastmem range, or nullptr if it isn't mapped.
+  u8* GetFastmemBase() const { return m_fastmem_base; }
+
+  /// Returns true if the host address is within the fastmem range.
+  bool IsFastmemHostAddress(const void* address) const
+  {
+    return (m_fastmem_base && static_cast<const u8*>(address) >= m_fastmem_base &&
+            static_cast<const u8*>(address) < (m_fastmem_base + FASTMEM_REGION_SIZE));
+  }
+
+  /// Returns true if the virtual address is mapped in the fastmem range.
+  ALWAYS_INLINE static bool IsFastmemAddress(VirtualMemoryAddress address)
+  {
+    const u32 segment = address >> 29;
+    return (segment == 0 || segment == 4 || segment == 5) && IsRAMAddress(address & UINT32_C(0x1FFFFFFF));
+  }
+
+  enum : TickCount
+  {
+    RAM_READ_ACCESS_DELAY = 5,  // Nocash docs say RAM takes 6 cycles to access. Subtract one because we already add a
+                                // tick for the instruction.
+    RAM_WRITE_ACCESS_DELAY = 0, // Writes are free unless we're executing more than 4 stores in a row.
+  };
 
 private:
+  static constexpr u64 FASTMEM_REGION_SIZE = UINT64_C(0x100000000);
+  static constexpr u32 FASTMEM_HOST_PAGE_SIZE = 4096;
+  static constexpr u32 FASTMEM_HOST_PAGE_COUNT = 0x200000 / FASTMEM_HOST_PAGE_SIZE;
+
   enum : u32
   {
     RAM_BASE = 0x00000000,
@@ -138,13 +192,6 @@ private:
     MEMCTRL_REG_COUNT = 9
   };
 
-  enum : TickCount
-  {
-    RAM_READ_ACCESS_DELAY = 5,  // Nocash docs say RAM takes 6 cycles to access. Subtract one because we already add a
-                                // tick for the instruction.
-    RAM_WRITE_ACCESS_DELAY = 0, // Writes are free unless we're executing more than 4 stores in a row.
-  };
-
   union MEMDELAY
   {
     u32 bits;
@@ -241,7 +288,11 @@ private:
   u32 DoReadSPU(MemoryAccessSize size, u32 offset);
   void DoWriteSPU(MemoryAccessSize size, u32 offset, u32 value);
 
-  void DoInvalidateCodeCache(u32 page_index);
+  void DoInvalidateCodeCache(u32 page_index, u32 offset, u32 size);
+
+  /// Write-protects the fastmem views of the host page containing the code page if any code is in it.
+  void UpdateFastmemPageProtection(u32 code_page_index);
+  void SetFastmemPageProtection(u32 offset, u32 size, bool writable);
 
   CPU::Core* m_cpu = nullptr;
   CPU::CodeCache* m_cpu_code_cache = nullptr;
@@ -262,10 +313,16 @@ private:
   std::array<TickCount, 3> m_spu_access_time = {};
 
   std::bitset<CPU_CODE_CACHE_PAGE_COUNT> m_ram_code_bits{};
-  std::array<u8, RAM_SIZE> m_ram{};   // 2MB RAM
+  u8* m_ram = nullptr;                // 2MB RAM
   std::array<u8, BIOS_SIZE> m_bios{}; // 512K BIOS ROM
   std::vector<u8> m_exp1_rom;
 
+  // RAM is allocated from the arena when the host supports it, so that it can be mapped again for fastmem.
+  MemoryArena m_memory_arena;
+  std::unique_ptr<u8[]> m_ram_storage;
+  u8* m_fastmem_base = nullptr;
+  std::bitset<FASTMEM_HOST_PAGE_COUNT> m_fastmem_write_protected_pages{};
+
   MEMCTRL m_MEMCTRL = {};
   u32 m_ram_size_reg = 0;
 
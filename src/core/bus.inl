@@ -27,7 +27,7 @@ TickCount Bus::DoRAMAccess(u32 offset, u32& value)
   {
     const u32 page_index = offset / CPU_CODE_CACHE_PAGE_SIZE;
     if (m_ram_code_bits[page_index])
-      DoInvalidateCodeCache(page_index);
+      DoInvalidateCodeCache(page_index, offset, 1u << static_cast<u32>(size));
 
     if constexpr (size == MemoryAccessSize::Byte)
     {
@@ -23,9 +23,16 @@ void CDROM::Initialize(System* system, DMA* dma, InterruptController* interrupt_
   m_interrupt_controller = interrupt_controller;
   m_spu = spu;
   m_command_event =
-    m_system->CreateTimingEvent("CDROM Command Event", 1, 1, std::bind(&CDROM::ExecuteCommand, this), false);
+    m_system->CreateTimingEvent("CDROM Command Event", 1, 1,
+                                [](void* param, TickCount ticks, TickCount ticks_late) {
+                                  static_cast<CDROM*>(param)->ExecuteCommand();
+                                },
+                                this, false);
   m_drive_event = m_system->CreateTimingEvent("CDROM Drive Event", 1, 1,
-                                              std::bind(&CDROM::ExecuteDrive, this, std::placeholders::_2), false);
+                                              [](void* param, TickCount ticks, TickCount ticks_late) {
+                                                static_cast<CDROM*>(param)->ExecuteDrive(ticks_late);
+                                              },
+                                              this, false);
 }
 
 void CDROM::Reset()
@@ -401,6 +408,7 @@ void CDROM::WriteRegister(u32 offset, u8 value)
 
 void CDROM::DMARead(u32* words, u32 word_count)
 {
+  SystemComponentScope component_scope(m_system, System::Component::CDROM);
   const u32 words_in_fifo = m_data_fifo.GetSize() / 4;
   if (words_in_fifo < word_count)
   {
@@ -540,6 +548,7 @@ void CDROM::EndCommand()
 
 void CDROM::ExecuteCommand()
 {
+  SystemComponentScope component_scope(m_system, System::Component::CDROM);
   Log_DevPrintf("CDROM executing command 0x%02X", ZeroExtend32(static_cast<u8>(m_command)));
 
   if (!m_response_fifo.IsEmpty())
@@ -965,6 +974,7 @@ void CDROM::UpdateCommandEvent()
 
 void CDROM::ExecuteDrive(TickCount ticks_late)
 {
+  SystemComponentScope component_scope(m_system, System::Component::CDROM);
   switch (m_drive_state)
   {
     case DriveState::SpinningUp:
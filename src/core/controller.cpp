@@ -14,6 +14,8 @@ bool Controller::DoState(StateWrapper& sw)
   return !sw.HasError();
 }
 
+void Controller::DoInputState(StateWrapper& sw) {}
+
 void Controller::ResetTransferState() {}
 
 bool Controller::Transfer(const u8 data_in, u8* data_out)
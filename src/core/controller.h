@@ -29,6 +29,10 @@ public:
   virtual void Reset();
   virtual bool DoState(StateWrapper& sw);
 
+  /// Saves or restores the button and axis states set by the host, which aren't part of save states. Used to record
+  /// input movies.
+  virtual void DoInputState(StateWrapper& sw);
+
   // Resets all state for the transferring to/from the device.
   virtual void ResetTransferState();
 
@@ -1,8 +1,18 @@
 #include "cpu_code_cache.h"
+#include "bus.h"
+#include "common/byte_stream.h"
+#include "common/file_system.h"
 #include "common/log.h"
+#include "common/string_util.h"
+#include "common/timer.h"
 #include "cpu_core.h"
 #include "cpu_disasm.h"
+#include "cpu_predecoded_interpreter.h"
 #include "system.h"
+#include <algorithm>
+#include <cinttypes>
+#include <cstring>
+#include <imgui.h>
 Log_SetChannel(CPU::CodeCache);
 
 #ifdef WITH_RECOMPILER
@@ -14,31 +24,60 @@ namespace CPU {
 
 constexpr bool USE_BLOCK_LINKING = true;
 
+// With the recompiler, blocks continue past conditional branches. The taken path leaves the block through a side
+// exit, and the fall-through path keeps its cached registers.
+constexpr bool USE_SUPERBLOCKS = true;
+static constexpr u32 SUPERBLOCK_MAX_SIDE_EXITS = 4;
+static constexpr u32 SUPERBLOCK_MAX_INSTRUCTIONS = 128;
+
+// Loops which only poll memory that can't change until the next event skip straight to it.
+constexpr bool USE_IDLE_LOOP_SKIPPING = true;
+
+// Loads whose delay slot doesn't read the loaded register are written immediately by the recompiler.
+constexpr bool USE_LOAD_DELAY_ANALYSIS = true;
+
 static constexpr u32 RECOMPILER_CODE_CACHE_SIZE = 32 * 1024 * 1024;
 static constexpr u32 RECOMPILER_FAR_CODE_CACHE_SIZE = 32 * 1024 * 1024;
+static constexpr u32 RECOMPILER_CODE_CACHE_REGION_COUNT = 8;
+
+static constexpr u32 PERSISTENT_BLOCKS_SIGNATURE = 0x42435344; // DSCB
+static constexpr u32 PERSISTENT_BLOCKS_VERSION = 1;
 
 CodeCache::CodeCache() = default;
 
-CodeCache::~CodeCache() = default;
+CodeCache::~CodeCache()
+{
+  Common::PageFaultHandler::RemoveHandler(this);
+
+  // The bus may already be gone, so don't go through Flush().
+  for (auto& it : m_blocks)
+    delete it.second;
+}
 
-void CodeCache::Initialize(System* system, Core* core, Bus* bus, bool use_recompiler)
+void CodeCache::Initialize(System* system, Core* core, Bus* bus, CPUExecutionMode execution_mode, bool use_fastmem)
 {
   m_system = system;
   m_core = core;
   m_bus = bus;
+  m_use_predecoded_interpreter = (execution_mode != CPUExecutionMode::CachedInterpreter);
 
 #ifdef WITH_RECOMPILER
-  m_use_recompiler = use_recompiler;
-  m_code_buffer = std::make_unique<JitCodeBuffer>(RECOMPILER_CODE_CACHE_SIZE, RECOMPILER_FAR_CODE_CACHE_SIZE);
+  m_use_recompiler = (execution_mode == CPUExecutionMode::Recompiler);
+  m_use_fastmem = use_fastmem;
+  m_code_buffer = std::make_unique<JitCodeBuffer>(RECOMPILER_CODE_CACHE_SIZE, RECOMPILER_FAR_CODE_CACHE_SIZE,
+                                                  RECOMPILER_CODE_CACHE_REGION_COUNT);
   m_asm_functions = std::make_unique<Recompiler::ASMFunctions>();
   m_asm_functions->Generate(m_code_buffer.get());
+  UpdateFastmemMapping();
 #else
   m_use_recompiler = false;
+  m_use_fastmem = false;
 #endif
 }
 
 void CodeCache::Execute()
 {
+  const u32 frame_number = m_system->GetFrameNumber();
   CodeBlockKey next_block_key = GetNextBlockKey();
 
   while (m_core->m_pending_ticks < m_core->m_downcount)
@@ -55,6 +94,7 @@ void CodeCache::Execute()
     if (!block)
     {
       Log_WarningPrintf("Falling back to uncached interpreter at 0x%08X", m_core->GetRegs().pc);
+      LeaveProfiledBlock(m_core);
       InterpretUncachedBlock();
       continue;
     }
@@ -71,8 +111,19 @@ void CodeCache::Execute()
     LogCurrentState();
 #endif
 
-    if (m_use_recompiler)
+    // Blocks entered through links aren't stamped, but the chain is entered from here often enough.
+    block->last_used_frame = frame_number;
+
+    // Recompiled blocks count themselves, since linked blocks don't come back here.
+    if (m_core->m_block_profiling_enabled && !block->host_code)
+      EnterProfiledBlock(m_core, block);
+
+    // Blocks in pages which keep being rewritten are interpreted, even with the recompiler.
+    const TickCount block_start_ticks = m_core->m_pending_ticks;
+    if (block->host_code)
       block->host_code(m_core);
+    else if (!block->decoded_instructions.empty())
+      PredecodedInterpreter::ExecuteBlock(m_core, *block);
     else
       InterpretCachedBlock(*block);
 
@@ -82,6 +133,35 @@ void CodeCache::Execute()
       continue;
 
     next_block_key = GetNextBlockKey();
+
+    // Idle loops aren't linked, so this was exactly one iteration.
+    if (block->is_idle_loop && next_block_key.bits == block->key.bits &&
+        SkipIdleLoop(block, m_core->m_pending_ticks - block_start_ticks))
+    {
+      m_core->m_unlinked_exit_block = nullptr;
+      break;
+    }
+
+#ifdef WITH_RECOMPILER
+    if (m_use_recompiler)
+    {
+      // Linked blocks jump to each other directly, so the block which returned isn't necessarily the one we called.
+      // If it left through an unlinked exit, link it to the next block so the exit doesn't return here again.
+      CodeBlock* next_block = LookupBlock(next_block_key);
+      if (!next_block)
+        continue;
+
+      // Read after the lookup, since compiling the next block may have flushed the cache.
+      CodeBlock* exit_block = m_core->m_unlinked_exit_block;
+      m_core->m_unlinked_exit_block = nullptr;
+      if (exit_block)
+        LinkBlock(exit_block, next_block);
+
+      block = next_block;
+      goto reexecute_block;
+    }
+#endif
+
     if (next_block_key.bits == block->key.bits)
     {
       // we can jump straight to it if there's no pending interrupts
@@ -121,18 +201,98 @@ void CodeCache::Execute()
     }
   }
 
+  // Pending ticks are reset when the events run.
+  LeaveProfiledBlock(m_core);
+
   // in case we switch to interpreter...
   m_core->m_regs.npc = m_core->m_regs.pc;
 }
 
-void CodeCache::SetUseRecompiler(bool enable)
+void CodeCache::SetExecutionMode(CPUExecutionMode mode)
+{
+  const bool use_predecoded_interpreter = (mode != CPUExecutionMode::CachedInterpreter);
+#ifdef WITH_RECOMPILER
+  const bool use_recompiler = (mode == CPUExecutionMode::Recompiler);
+#else
+  const bool use_recompiler = false;
+#endif
+  if (m_use_recompiler == use_recompiler && m_use_predecoded_interpreter == use_predecoded_interpreter)
+    return;
+
+  m_use_recompiler = use_recompiler;
+  m_use_predecoded_interpreter = use_predecoded_interpreter;
+  Flush();
+  UpdateFastmemMapping();
+}
+
+void CodeCache::SetUseFastmem(bool enable)
 {
 #ifdef WITH_RECOMPILER
-  if (m_use_recompiler == enable)
+  if (m_use_fastmem == enable)
     return;
 
-  m_use_recompiler = enable;
+  m_use_fastmem = enable;
   Flush();
+  UpdateFastmemMapping();
+#endif
+}
+
+void CodeCache::UpdateFastmemMapping()
+{
+#ifdef WITH_RECOMPILER
+  const bool enable = Recompiler::SUPPORTS_FASTMEM && m_use_recompiler && m_use_fastmem &&
+                      Common::PageFaultHandler::IsSupported();
+  if (enable == (m_core->m_fastmem_base != nullptr))
+    return;
+
+  if (enable)
+  {
+    if (!Common::PageFaultHandler::InstallHandler(this, FastmemFaultHandler))
+      return;
+
+    m_bus->UpdateFastmemViews(true);
+    if (!m_bus->GetFastmemBase())
+    {
+      Common::PageFaultHandler::RemoveHandler(this);
+      return;
+    }
+  }
+  else
+  {
+    m_bus->UpdateFastmemViews(false);
+    Common::PageFaultHandler::RemoveHandler(this);
+  }
+
+  m_core->m_fastmem_base = m_bus->GetFastmemBase();
+#endif
+}
+
+Common::PageFaultHandler::HandlerResult CodeCache::FastmemFaultHandler(void* owner, void* exception_pc,
+                                                                       void* fault_address, bool is_write)
+{
+#ifdef WITH_RECOMPILER
+  CodeCache* const cache = static_cast<CodeCache*>(owner);
+  if (!cache->m_bus->IsFastmemHostAddress(fault_address))
+    return Common::PageFaultHandler::HandlerResult::ExecuteNextHandler;
+
+  auto iter = cache->m_fastmem_backpatch_info.find(exception_pc);
+  if (iter == cache->m_fastmem_backpatch_info.end())
+    return Common::PageFaultHandler::HandlerResult::ExecuteNextHandler;
+
+  // MMIO, scratchpad, or a write to a page with code. Either way this access needs the slow path from now on.
+  Log_DevPrintf("Backpatching fastmem %s at %p (address 0x%08X)", is_write ? "store" : "load", exception_pc,
+                static_cast<u32>(static_cast<u8*>(fault_address) - cache->m_bus->GetFastmemBase()));
+
+  // The handler is only installed on hosts with SUPPORTS_FASTMEM, the others don't define BackpatchLoadStore().
+  if constexpr (Recompiler::SUPPORTS_FASTMEM)
+    Recompiler::CodeGenerator::BackpatchLoadStore(iter->second);
+  else
+    Panic("Fastmem fault on a host without fastmem support");
+
+  cache->m_fastmem_backpatch_info.erase(iter);
+  return Common::PageFaultHandler::HandlerResult::ContinueExecution;
+#else
+  return Common::PageFaultHandler::HandlerResult::ExecuteNextHandler;
 #endif
 }
 
@@ -141,8 +301,17 @@ void CodeCache::Flush()
   m_bus->ClearRAMCodePageFlags();
   for (auto& it : m_ram_block_map)
     it.clear();
+  m_ram_code_line_masks.fill(0);
+  m_page_recompile_counts.fill(0);
+  m_interpreter_only_pages.reset();
 
+  for (auto& it : m_blocks)
+    delete it.second;
   m_blocks.clear();
+  ClearLookupTable();
+  m_fastmem_backpatch_info.clear();
+  m_core->m_unlinked_exit_block = nullptr;
+  m_core->m_profiled_block = nullptr;
 #ifdef WITH_RECOMPILER
   m_code_buffer->Reset();
 #endif
@@ -173,6 +342,22 @@ CodeBlockKey CodeCache::GetNextBlockKey() const
 }
 
 CodeBlock* CodeCache::LookupBlock(CodeBlockKey key)
+{
+  // Invalidated blocks stay in the table, they go through the map so they can be revalidated.
+  CodeBlock** entry = GetLookupTableEntry(key, false);
+  if (entry && *entry && (*entry)->key == key && !(*entry)->invalidated)
+    return *entry;
+
+  CodeBlock* block = LookupBlockInMap(key);
+
+  // Revalidating or compiling can flush the cache, so the slot has to be fetched again.
+  if (block && (entry = GetLookupTableEntry(key, true)) != nullptr)
+    *entry = block;
+
+  return block;
+}
+
+CodeBlock* CodeCache::LookupBlockInMap(CodeBlockKey key)
 {
   BlockMap::iterator iter = m_blocks.find(key.bits);
   if (iter != m_blocks.end())
@@ -200,28 +385,580 @@ CodeBlock* CodeCache::LookupBlock(CodeBlockKey key)
   return block;
 }
 
+CodeBlock** CodeCache::GetLookupTableEntry(CodeBlockKey key, bool allocate)
+{
+  const u32 address = key.GetPCPhysicalAddress();
+  u32 offset;
+  if (Bus::IsRAMAddress(address))
+    offset = address & (LOOKUP_TABLE_RAM_SIZE - 1);
+  else if (address >= LOOKUP_TABLE_BIOS_BASE && address < (LOOKUP_TABLE_BIOS_BASE + LOOKUP_TABLE_BIOS_SIZE))
+    offset = LOOKUP_TABLE_RAM_SIZE + (address - LOOKUP_TABLE_BIOS_BASE);
+  else
+    return nullptr;
+
+  const u32 page_index = (key.user_mode ? LOOKUP_TABLE_PAGES_PER_MODE : 0) + (offset >> LOOKUP_TABLE_PAGE_SHIFT);
+  std::unique_ptr<LookupTablePage>& page = m_lookup_table[page_index];
+  if (!page)
+  {
+    if (!allocate)
+      return nullptr;
+
+    page = std::make_unique<LookupTablePage>();
+    page->fill(nullptr);
+    m_lookup_table_page_count++;
+  }
+
+  return &(*page)[(offset & (LOOKUP_TABLE_PAGE_SIZE - 1)) / sizeof(u32)];
+}
+
+void CodeCache::ClearLookupTable()
+{
+  Log_DevPrintf("Block lookup table used %u pages (%u KB)", m_lookup_table_page_count,
+                GetLookupTableMemoryUsage() / 1024);
+
+  for (std::unique_ptr<LookupTablePage>& page : m_lookup_table)
+    page.reset();
+  m_lookup_table_page_count = 0;
+}
+
+u32 CodeCache::GetLookupTableMemoryUsage() const
+{
+  return static_cast<u32>(sizeof(m_lookup_table) + (m_lookup_table_page_count * sizeof(LookupTablePage)));
+}
+
+static bool ReadU32(ByteStream* stream, u32* dest)
+{
+  return stream->Read2(dest, sizeof(u32));
+}
+
+static bool WriteU32(ByteStream* stream, u32 dest)
+{
+  return stream->Write2(&dest, sizeof(u32));
+}
+
+static u32 HashBlockCode(const u32* words, u32 word_count)
+{
+  // FNV-1a, only used to catch damaged files. The code itself is compared against memory before it runs.
+  u32 hash = 2166136261u;
+  for (u32 i = 0; i < word_count; i++)
+  {
+    for (u32 shift = 0; shift < 32; shift += 8)
+      hash = (hash ^ ((words[i] >> shift) & 0xFF)) * 16777619u;
+  }
+
+  return hash;
+}
+
+bool CodeCache::SavePersistentBlocks(ByteStream* stream)
+{
+  const u32 block_count = static_cast<u32>(
+    std::count_if(m_blocks.begin(), m_blocks.end(), [](const auto& it) { return it.second != nullptr; }));
+
+  bool result = WriteU32(stream, PERSISTENT_BLOCKS_SIGNATURE);
+  result &= WriteU32(stream, PERSISTENT_BLOCKS_VERSION);
+  result &= WriteU32(stream, block_count);
+
+  for (const auto& it : m_blocks)
+  {
+    const CodeBlock* block = it.second;
+    if (!block)
+      continue;
+
+    const u32 word_count = static_cast<u32>(block->instruction_words.size());
+    result &= WriteU32(stream, block->key.bits);
+    result &= WriteU32(stream, word_count);
+    result &= WriteU32(stream, HashBlockCode(block->instruction_words.data(), word_count));
+    result &= stream->Write2(block->instruction_words.data(), word_count * sizeof(u32));
+  }
+
+  Log_InfoPrintf("Saved %u blocks to persistent code cache", block_count);
+  return result;
+}
+
+bool CodeCache::LoadPersistentBlocks(ByteStream* stream)
+{
+  u32 signature, version, block_count;
+  if (!ReadU32(stream, &signature) || !ReadU32(stream, &version) || !ReadU32(stream, &block_count) ||
+      signature != PERSISTENT_BLOCKS_SIGNATURE || version != PERSISTENT_BLOCKS_VERSION)
+  {
+    Log_WarningPrintf("Persistent code cache is corrupted or from another version");
+    return false;
+  }
+
+  Common::Timer timer;
+  u32 loaded_count = 0;
+  std::vector<u32> words;
+  for (u32 i = 0; i < block_count; i++)
+  {
+    u32 key_bits, word_count, hash;
+    if (!ReadU32(stream, &key_bits) || !ReadU32(stream, &word_count) || !ReadU32(stream, &hash) ||
+        word_count == 0 || word_count > (LOOKUP_TABLE_RAM_SIZE / sizeof(u32)))
+    {
+      Log_WarningPrintf("Persistent code cache block %u is corrupted", i);
+      return false;
+    }
+
+    words.resize(word_count);
+    if (!stream->Read2(words.data(), word_count * sizeof(u32)) || HashBlockCode(words.data(), word_count) != hash)
+    {
+      Log_WarningPrintf("Persistent code cache block %u is corrupted", i);
+      return false;
+    }
+
+    CodeBlockKey key;
+    key.bits = key_bits;
+    if (m_blocks.find(key.bits) != m_blocks.end())
+      continue;
+
+#ifdef WITH_RECOMPILER
+    // Leave space for code which wasn't seen in earlier sessions, running out would evict blocks loaded here.
+    if (m_use_recompiler && (m_code_buffer->GetTotalCodeUsed() > (RECOMPILER_CODE_CACHE_SIZE / 4 * 3) ||
+                             m_code_buffer->GetTotalFarCodeUsed() > (RECOMPILER_FAR_CODE_CACHE_SIZE / 4 * 3)))
+    {
+      Log_WarningPrintf("Code buffer is filling up, not preloading remaining %u blocks", block_count - i);
+      break;
+    }
+#endif
+
+    CodeBlock* block = new CodeBlock(key);
+    if (!CompileBlock(block, words.data(), word_count))
+    {
+      delete block;
+      continue;
+    }
+
+    // Memory probably doesn't contain this code yet. Marking it as invalidated means RevalidateBlock() compares it
+    // against memory before it first executes, and adds it to the page map.
+    block->invalidated = true;
+    m_blocks.emplace(key.bits, block);
+    loaded_count++;
+  }
+
+  Log_InfoPrintf("Preloaded %u of %u blocks from persistent code cache in %.2f ms", loaded_count, block_count,
+                 timer.GetTimeMilliseconds());
+  return true;
+}
+
+CodeCache::PageStatistics CodeCache::GetTotalPageStatistics() const
+{
+  PageStatistics total = {};
+  for (const PageStatistics& stats : m_page_statistics)
+  {
+    total.invalidations += stats.invalidations;
+    total.revalidations += stats.revalidations;
+    total.recompilations += stats.recompilations;
+    total.data_writes += stats.data_writes;
+  }
+
+  return total;
+}
+
+CodeCache::CodeBufferStatistics CodeCache::GetCodeBufferStatistics() const
+{
+  CodeBufferStatistics stats = {};
+#ifdef WITH_RECOMPILER
+  stats.code_size = m_code_buffer->GetRegionCodeSize() * m_code_buffer->GetRegionCount();
+  stats.code_used = m_code_buffer->GetTotalCodeUsed();
+  stats.far_code_size = m_code_buffer->GetRegionFarCodeSize() * m_code_buffer->GetRegionCount();
+  stats.far_code_used = m_code_buffer->GetTotalFarCodeUsed();
+  for (const auto& it : m_blocks)
+  {
+    if (it.second && it.second->host_code)
+      stats.live_code_size += it.second->host_code_size;
+  }
+#endif
+  stats.evicted_regions = m_evicted_region_count;
+  stats.evicted_blocks = m_evicted_block_count;
+  return stats;
+}
+
+CodeCache::LoadDelayStatistics CodeCache::GetLoadDelayStatistics() const
+{
+  LoadDelayStatistics stats = {};
+  stats.loads = m_load_count;
+  stats.skipped_load_delays = m_skipped_load_delay_count;
+  return stats;
+}
+
+CodeCache::IdleLoopStatistics CodeCache::GetIdleLoopStatistics() const
+{
+  IdleLoopStatistics stats = {};
+  stats.idle_loops = m_idle_loop_count;
+  stats.skips = m_idle_loop_skips;
+  stats.skipped_ticks = m_idle_loop_skipped_ticks;
+  return stats;
+}
+
+void CodeCache::DrawDebugWindow()
+{
+  static constexpr u32 NUM_COLUMNS = 7;
+  static constexpr u32 MAX_PAGES_SHOWN = 64;
+  static constexpr std::array<const char*, NUM_COLUMNS> column_names = {
+    {"Page", "Blocks", "Invalidations", "Revalidations", "Recompilations", "Data Writes", "Mode"}};
+
+  ImGui::SetNextWindowSize(ImVec2(600, 400), ImGuiCond_FirstUseEver);
+  if (!ImGui::Begin("Code Cache State", &m_system->GetSettings().debugging.show_code_cache_state))
+  {
+    ImGui::End();
+    return;
+  }
+
+  const PageStatistics total = GetTotalPageStatistics();
+  ImGui::Text("Blocks: %u", static_cast<u32>(m_blocks.size()));
+  ImGui::Text("Lookup table: %u KB", GetLookupTableMemoryUsage() / 1024);
+  ImGui::Text("Invalidations: %u, revalidations: %u, recompilations: %u", total.invalidations, total.revalidations,
+              total.recompilations);
+  ImGui::Text("Writes to data in code pages: %u", total.data_writes);
+  ImGui::Text("Interpreted pages: %u", static_cast<u32>(m_interpreter_only_pages.count()));
+
+  // Code of blocks which were recompiled or flushed stays in the buffer until its region is evicted.
+  const CodeBufferStatistics buffer_stats = GetCodeBufferStatistics();
+  ImGui::Text("Code buffer: %u/%u KB near, %u/%u KB far", buffer_stats.code_used / 1024, buffer_stats.code_size / 1024,
+              buffer_stats.far_code_used / 1024, buffer_stats.far_code_size / 1024);
+  ImGui::Text("Unreferenced near code: %.1f%%",
+              (buffer_stats.code_used > 0) ?
+                (100.0f * static_cast<float>(buffer_stats.code_used - buffer_stats.live_code_size) /
+                 static_cast<float>(buffer_stats.code_used)) :
+                0.0f);
+  ImGui::Text("Evicted regions: %u, evicted blocks: %u", buffer_stats.evicted_regions, buffer_stats.evicted_blocks);
+
+  const IdleLoopStatistics idle_stats = GetIdleLoopStatistics();
+  ImGui::Text("Idle loops: %u, skips: %" PRIu64 ", skipped cycles: %" PRIu64, idle_stats.idle_loops, idle_stats.skips,
+              idle_stats.skipped_ticks);
+
+  const LoadDelayStatistics load_delay_stats = GetLoadDelayStatistics();
+  ImGui::Text("Loads without delay: %u/%u", load_delay_stats.skipped_load_delays, load_delay_stats.loads);
+  ImGui::Separator();
+
+  // Pages with code which keeps changing (or sharing a page with data) are the ones worth looking at.
+  std::vector<u32> pages;
+  for (u32 i = 0; i < CPU_CODE_CACHE_PAGE_COUNT; i++)
+  {
+    if (m_page_statistics[i].invalidations > 0 || m_page_statistics[i].data_writes > 0)
+      pages.push_back(i);
+  }
+  std::sort(pages.begin(), pages.end(), [this](u32 lhs, u32 rhs) {
+    return m_page_statistics[lhs].invalidations > m_page_statistics[rhs].invalidations;
+  });
+  if (pages.size() > MAX_PAGES_SHOWN)
+    pages.resize(MAX_PAGES_SHOWN);
+
+  ImGui::Columns(NUM_COLUMNS);
+  for (const char* title : column_names)
+  {
+    ImGui::TextUnformatted(title);
+    ImGui::NextColumn();
+  }
+
+  for (const u32 page : pages)
+  {
+    const PageStatistics& stats = m_page_statistics[page];
+    ImGui::Text("0x%08X", page * CPU_CODE_CACHE_PAGE_SIZE);
+    ImGui::NextColumn();
+    ImGui::Text("%u", static_cast<u32>(m_ram_block_map[page].size()));
+    ImGui::NextColumn();
+    ImGui::Text("%u", stats.invalidations);
+    ImGui::NextColumn();
+    ImGui::Text("%u", stats.revalidations);
+    ImGui::NextColumn();
+    ImGui::Text("%u", stats.recompilations);
+    ImGui::NextColumn();
+    ImGui::Text("%u", stats.data_writes);
+    ImGui::NextColumn();
+    ImGui::TextUnformatted(m_interpreter_only_pages[page] ? "Interpreter" : "Compiled");
+    ImGui::NextColumn();
+  }
+
+  ImGui::Columns(1);
+  ImGui::End();
+}
+
+void CodeCache::SetBlockProfilingEnabled(bool enabled)
+{
+  if (m_core->m_block_profiling_enabled == enabled)
+    return;
+
+  // Blocks compiled while profiling keep calling EnterProfiledBlock() after it's disabled, but it does nothing then.
+  // Not flushing here keeps the counts around for the report.
+  m_core->m_block_profiling_enabled = enabled;
+  m_core->m_profiled_block = nullptr;
+  if (enabled)
+    Flush();
+}
+
+bool CodeCache::IsBlockProfilingEnabled() const
+{
+  return m_core->m_block_profiling_enabled;
+}
+
+void CodeCache::ResetBlockProfile()
+{
+  for (auto& it : m_blocks)
+  {
+    CodeBlock* block = it.second;
+    if (!block)
+      continue;
+
+    block->profile_execution_count = 0;
+    block->profile_ticks = 0;
+  }
+}
+
+void CodeCache::EnterProfiledBlock(Core* core, CodeBlock* block)
+{
+  if (!core->m_block_profiling_enabled)
+    return;
+
+  LeaveProfiledBlock(core);
+  block->profile_execution_count++;
+  core->m_profiled_block = block;
+  core->m_profiled_block_start_ticks = core->m_pending_ticks;
+}
+
+void CodeCache::LeaveProfiledBlock(Core* core)
+{
+  if (!core->m_profiled_block)
+    return;
+
+  core->m_profiled_block->profile_ticks +=
+    static_cast<u64>(core->m_pending_ticks - core->m_profiled_block_start_ticks);
+  core->m_profiled_block = nullptr;
+}
+
+std::vector<const CodeBlock*> CodeCache::GetHotBlocks(u32 count) const
+{
+  std::vector<const CodeBlock*> blocks;
+  for (const auto& it : m_blocks)
+  {
+    if (it.second && it.second->profile_execution_count > 0)
+      blocks.push_back(it.second);
+  }
+
+  const size_t sorted_count = std::min(blocks.size(), static_cast<size_t>(count));
+  std::partial_sort(blocks.begin(), blocks.begin() + sorted_count, blocks.end(),
+                    [](const CodeBlock* lhs, const CodeBlock* rhs) { return lhs->profile_ticks > rhs->profile_ticks; });
+  blocks.resize(sorted_count);
+  return blocks;
+}
+
+// There are no symbols for guest code, so blocks are labelled with the segment and memory they're in.
+static const char* GetBlockLocation(const CodeBlock* block)
+{
+  static constexpr std::array<const char*, 8> ram_names = {
+    {"KUSEG RAM", "KUSEG RAM", "KUSEG RAM", "KUSEG RAM", "KSEG0 RAM", "KSEG1 RAM", "KSEG2 RAM", "KSEG2 RAM"}};
+  static constexpr std::array<const char*, 8> bios_names = {
+    {"KUSEG BIOS", "KUSEG BIOS", "KUSEG BIOS", "KUSEG BIOS", "KSEG0 BIOS", "KSEG1 BIOS", "KSEG2 BIOS", "KSEG2 BIOS"}};
+
+  // Blocks are only compiled from cacheable memory.
+  const u32 segment = block->GetPC() >> 29;
+  const PhysicalMemoryAddress phys_addr = block->key.GetPCPhysicalAddress();
+  return Bus::IsRAMAddress(phys_addr) ? ram_names[segment] : bios_names[segment];
+}
+
+bool CodeCache::DumpHotBlocks(const char* filename, u32 count) const
+{
+  std::unique_ptr<ByteStream> stream =
+    FileSystem::OpenFile(filename, BYTESTREAM_OPEN_CREATE | BYTESTREAM_OPEN_WRITE | BYTESTREAM_OPEN_TRUNCATE |
+                                     BYTESTREAM_OPEN_ATOMIC_UPDATE | BYTESTREAM_OPEN_STREAMED);
+  if (!stream)
+  {
+    Log_ErrorPrintf("Failed to open '%s' for writing", filename);
+    return false;
+  }
+
+  u64 total_ticks = 0;
+  for (const auto& it : m_blocks)
+  {
+    if (it.second)
+      total_ticks += it.second->profile_ticks;
+  }
+
+  std::string line = StringUtil::StdStringFromFormat(
+    "%-4s %-10s %-10s %6s %6s %12s %14s %7s %6s %8s\n", "Rank", "PC", "Location", "Insns", "Host", "Executions",
+    "Ticks", "Share", "Inval", "Compile");
+  stream->Write2(line.data(), static_cast<u32>(line.size()));
+
+  const std::vector<const CodeBlock*> blocks = GetHotBlocks(count);
+  for (size_t i = 0; i < blocks.size(); i++)
+  {
+    const CodeBlock* block = blocks[i];
+    line = StringUtil::StdStringFromFormat(
+      "%-4u 0x%08X %-10s %6u %6u %12" PRIu64 " %14" PRIu64 " %6.2f%% %6u %6.3fms\n", static_cast<u32>(i + 1),
+      block->GetPC(), GetBlockLocation(block), static_cast<u32>(block->instructions.size()),
+      block->host_code_size, block->profile_execution_count, block->profile_ticks,
+      (total_ticks > 0) ? (static_cast<double>(block->profile_ticks) * 100.0 / static_cast<double>(total_ticks)) : 0.0,
+      block->invalidation_count, block->compile_time_ms);
+    stream->Write2(line.data(), static_cast<u32>(line.size()));
+  }
+
+  SmallString disasm;
+  for (size_t i = 0; i < blocks.size(); i++)
+  {
+    const CodeBlock* block = blocks[i];
+    line = StringUtil::StdStringFromFormat("\n#%u 0x%08X (%s):\n", static_cast<u32>(i + 1), block->GetPC(),
+                                           GetBlockLocation(block));
+    for (const CodeBlockInstruction& cbi : block->instructions)
+    {
+      DisassembleInstruction(&disasm, cbi.pc, cbi.instruction.bits, nullptr);
+      line += StringUtil::StdStringFromFormat("  0x%08X  %08X  %s\n", cbi.pc, cbi.instruction.bits,
+                                              disasm.GetCharArray());
+    }
+
+    stream->Write2(line.data(), static_cast<u32>(line.size()));
+  }
+
+  if (!stream->Commit())
+  {
+    Log_ErrorPrintf("Failed to write hot blocks to '%s'", filename);
+    stream->Discard();
+    return false;
+  }
+
+  return true;
+}
+
+void CodeCache::DrawHotBlocksWindow(bool* is_open)
+{
+  static constexpr u32 NUM_COLUMNS = 8;
+  static constexpr u32 MAX_BLOCKS_SHOWN = 50;
+  static constexpr std::array<const char*, NUM_COLUMNS> column_names = {
+    {"PC", "Location", "Insns", "Host", "Executions", "Share", "Inval", "Compile"}};
+
+  ImGui::SetNextWindowSize(ImVec2(750, 600), ImGuiCond_FirstUseEver);
+  if (!ImGui::Begin("Hot Blocks", is_open))
+  {
+    ImGui::End();
+    return;
+  }
+
+  bool profiling_enabled = IsBlockProfilingEnabled();
+  if (ImGui::Checkbox("Profile blocks", &profiling_enabled))
+    SetBlockProfilingEnabled(profiling_enabled);
+  ImGui::SameLine();
+  if (ImGui::Button("Reset"))
+    ResetBlockProfile();
+
+  u64 total_ticks = 0;
+  for (const auto& it : m_blocks)
+  {
+    if (it.second)
+      total_ticks += it.second->profile_ticks;
+  }
+
+  ImGui::Text("Ticks in profiled blocks: %" PRIu64, total_ticks);
+  ImGui::Separator();
+
+  ImGui::BeginChild("blocks", ImVec2(0, 300));
+  ImGui::Columns(NUM_COLUMNS);
+  for (const char* title : column_names)
+  {
+    ImGui::TextUnformatted(title);
+    ImGui::NextColumn();
+  }
+
+  for (const CodeBlock* block : GetHotBlocks(MAX_BLOCKS_SHOWN))
+  {
+    char label[32];
+    std::snprintf(label, sizeof(label), "0x%08X##%08X", block->GetPC(), block->key.bits);
+    if (ImGui::Selectable(label, m_hot_blocks_selected_key == block->key.bits, ImGuiSelectableFlags_SpanAllColumns))
+      m_hot_blocks_selected_key = block->key.bits;
+    ImGui::NextColumn();
+    ImGui::TextUnformatted(GetBlockLocation(block));
+    ImGui::NextColumn();
+    ImGui::Text("%u", static_cast<u32>(block->instructions.size()));
+    ImGui::NextColumn();
+    ImGui::Text("%u", block->host_code_size);
+    ImGui::NextColumn();
+    ImGui::Text("%" PRIu64, block->profile_execution_count);
+    ImGui::NextColumn();
+    ImGui::Text("%.2f%%", (total_ticks > 0) ?
+                            (static_cast<double>(block->profile_ticks) * 100.0 / static_cast<double>(total_ticks)) :
+                            0.0);
+    ImGui::NextColumn();
+    ImGui::Text("%u", block->invalidation_count);
+    ImGui::NextColumn();
+    ImGui::Text("%.3f ms", block->compile_time_ms);
+    ImGui::NextColumn();
+  }
+
+  ImGui::Columns(1);
+  ImGui::EndChild();
+  ImGui::Separator();
+
+  // The selected block may have been flushed since, or failed to compile when it was looked up again.
+  auto iter = m_blocks.find(m_hot_blocks_selected_key);
+  if (iter != m_blocks.end() && iter->second)
+  {
+    SmallString disasm;
+    ImGui::BeginChild("disassembly");
+    for (const CodeBlockInstruction& cbi : iter->second->instructions)
+    {
+      DisassembleInstruction(&disasm, cbi.pc, cbi.instruction.bits, nullptr);
+      ImGui::Text("0x%08X  %08X  %s", cbi.pc, cbi.instruction.bits, disasm.GetCharArray());
+    }
+    ImGui::EndChild();
+  }
+
+  ImGui::End();
+}
+
 bool CodeCache::RevalidateBlock(CodeBlock* block)
 {
-  for (const CodeBlockInstruction& cbi : block->instructions)
+  // Blocks which were invalidated by a write are always in RAM, only preloaded blocks can be elsewhere.
+  PageStatistics* const stats = block->IsInRAM() ? &m_page_statistics[block->GetStartPageIndex()] : nullptr;
+  const u32 ram_offset = block->key.GetPCPhysicalAddress();
+  if (block->IsInRAM() && (ram_offset + block->GetSizeInBytes()) <= LOOKUP_TABLE_RAM_SIZE)
   {
-    u32 new_code = 0;
-    m_bus->DispatchAccess<MemoryAccessType::Read, MemoryAccessSize::Word>(cbi.pc & PHYSICAL_MEMORY_ADDRESS_MASK,
-                                                                          new_code);
-    if (cbi.instruction.bits != new_code)
+    if (std::memcmp(m_bus->GetRAM() + ram_offset, block->instruction_words.data(), block->GetSizeInBytes()) != 0)
     {
-      Log_DebugPrintf("Block 0x%08X changed at PC 0x%08X - %08X to %08X - recompiling.", block->GetPC(), cbi.pc,
-                      cbi.instruction.bits, new_code);
+      Log_DebugPrintf("Block 0x%08X changed - recompiling.", block->GetPC());
       goto recompile;
     }
   }
+  else
+  {
+    for (const CodeBlockInstruction& cbi : block->instructions)
+    {
+      u32 new_code = 0;
+      m_bus->DispatchAccess<MemoryAccessType::Read, MemoryAccessSize::Word>(cbi.pc & PHYSICAL_MEMORY_ADDRESS_MASK,
+                                                                            new_code);
+      if (cbi.instruction.bits != new_code)
+      {
+        Log_DebugPrintf("Block 0x%08X changed at PC 0x%08X - %08X to %08X - recompiling.", block->GetPC(), cbi.pc,
+                        cbi.instruction.bits, new_code);
+        goto recompile;
+      }
+    }
+  }
 
   // re-add it to the page map since it's still up-to-date
+  if (stats)
+    stats->revalidations++;
+
   block->invalidated = false;
   AddBlockToPageMap(block);
   return true;
 
 recompile:
+  if (stats)
+  {
+    stats->recompilations++;
+
+    const u32 page_index = block->GetStartPageIndex();
+    if (++m_page_recompile_counts[page_index] == INTERPRETER_ONLY_PAGE_RECOMPILE_THRESHOLD && m_use_recompiler)
+    {
+      Log_DevPrintf("Code in page 0x%08X keeps changing, interpreting it from now on",
+                    page_index * CPU_CODE_CACHE_PAGE_SIZE);
+      m_interpreter_only_pages[page_index] = true;
+    }
+  }
+
+  // The old code is going away, so nothing can jump to it, and its exits no longer exist.
+  UnlinkBlock(block);
   block->instructions.clear();
+  block->instruction_words.clear();
+  block->decoded_instructions.clear();
+  block->exits.clear();
   if (!CompileBlock(block))
   {
     Log_WarningPrintf("Failed to recompile block 0x%08X - flushing.", block->GetPC());
@@ -230,17 +967,370 @@ recompile:
   }
 
   // re-add to page map again
+  block->invalidated = false;
   if (block->IsInRAM())
     AddBlockToPageMap(block);
 
   return true;
 }
 
-bool CodeCache::CompileBlock(CodeBlock* block)
+static bool CanBranchHaveSideExit(const CodeBlockInstruction& cbi)
+{
+  // Only conditional branches with a fixed target, which don't write a link register. Branches which are always
+  // taken, like beq $zero, $zero which assemblers use for b, would carry on into whatever follows them.
+  if (cbi.is_branch_delay_slot)
+    return false;
+
+  switch (cbi.instruction.op)
+  {
+    case InstructionOp::beq:
+      return (cbi.instruction.i.rs != cbi.instruction.i.rt);
+
+    case InstructionOp::bne:
+    case InstructionOp::bgtz:
+      return true;
+
+    case InstructionOp::blez:
+      return (cbi.instruction.i.rs != Reg::zero);
+
+    case InstructionOp::b:
+    {
+      // bgez $zero is always taken.
+      const u8 rt = static_cast<u8>(cbi.instruction.i.rt.GetValue());
+      return ((rt & u8(0x1E)) != u8(0x10) && !((rt & u8(1)) && cbi.instruction.i.rs == Reg::zero));
+    }
+
+    default:
+      return false;
+  }
+}
+
+static bool GetStaticBranchTarget(const CodeBlockInstruction& cbi, u32* target)
+{
+  switch (cbi.instruction.op)
+  {
+    case InstructionOp::j:
+      *target = ((cbi.pc + 4) & UINT32_C(0xF0000000)) | (cbi.instruction.j.target << 2);
+      return true;
+
+    case InstructionOp::b:
+    case InstructionOp::beq:
+    case InstructionOp::bne:
+    case InstructionOp::bgtz:
+    case InstructionOp::blez:
+      *target = cbi.pc + 4 + (cbi.instruction.i.imm_sext32() << 2);
+      return true;
+
+    default:
+      return false;
+  }
+}
+
+// Whether the instruction reads the guest register. Instructions which aren't known are assumed to read it.
+static bool InstructionReadsRegister(const Instruction& inst, Reg reg)
+{
+  switch (inst.op)
+  {
+    case InstructionOp::funct:
+    {
+      switch (inst.r.funct)
+      {
+        case InstructionFunct::sll:
+        case InstructionFunct::srl:
+        case InstructionFunct::sra:
+          return (inst.r.rt == reg);
+
+        case InstructionFunct::jr:
+        case InstructionFunct::jalr:
+        case InstructionFunct::mthi:
+        case InstructionFunct::mtlo:
+          return (inst.r.rs == reg);
+
+        case InstructionFunct::syscall:
+        case InstructionFunct::break_:
+        case InstructionFunct::mfhi:
+        case InstructionFunct::mflo:
+          return false;
+
+        case InstructionFunct::sllv:
+        case InstructionFunct::srlv:
+        case InstructionFunct::srav:
+        case InstructionFunct::mult:
+        case InstructionFunct::multu:
+        case InstructionFunct::div:
+        case InstructionFunct::divu:
+        case InstructionFunct::add:
+        case InstructionFunct::addu:
+        case InstructionFunct::sub:
+        case InstructionFunct::subu:
+        case InstructionFunct::and_:
+        case InstructionFunct::or_:
+        case InstructionFunct::xor_:
+        case InstructionFunct::nor:
+        case InstructionFunct::slt:
+        case InstructionFunct::sltu:
+          return (inst.r.rs == reg || inst.r.rt == reg);
+
+        default:
+          return true;
+      }
+    }
+
+    case InstructionOp::j:
+    case InstructionOp::jal:
+    case InstructionOp::lui:
+      return false;
+
+    case InstructionOp::b:
+    case InstructionOp::blez:
+    case InstructionOp::bgtz:
+    case InstructionOp::addi:
+    case InstructionOp::addiu:
+    case InstructionOp::slti:
+    case InstructionOp::sltiu:
+    case InstructionOp::andi:
+    case InstructionOp::ori:
+    case InstructionOp::xori:
+    case InstructionOp::lb:
+    case InstructionOp::lh:
+    case InstructionOp::lw:
+    case InstructionOp::lbu:
+    case InstructionOp::lhu:
+    case InstructionOp::lwc2:
+    case InstructionOp::swc2:
+      return (inst.i.rs == reg);
+
+    // lwl/lwr merge with the old value of rt.
+    case InstructionOp::beq:
+    case InstructionOp::bne:
+    case InstructionOp::lwl:
+    case InstructionOp::lwr:
+    case InstructionOp::sb:
+    case InstructionOp::sh:
+    case InstructionOp::swl:
+    case InstructionOp::sw:
+    case InstructionOp::swr:
+      return (inst.i.rs == reg || inst.i.rt == reg);
+
+    case InstructionOp::cop0:
+    case InstructionOp::cop2:
+    {
+      if (!inst.cop.IsCommonInstruction())
+        return false;
+
+      switch (inst.cop.CommonOp())
+      {
+        case CopCommonInstruction::mfcn:
+        case CopCommonInstruction::cfcn:
+          return false;
+
+        case CopCommonInstruction::mtcn:
+        case CopCommonInstruction::ctcn:
+          return (inst.r.rt == reg);
+
+        default:
+          return true;
+      }
+    }
+
+    default:
+      return true;
+  }
+}
+
+/// Returns the registers read and written by an instruction which can be part of an idle loop, or false if it can't.
+static bool GetIdleLoopInstructionRegisters(const Instruction& inst, Reg* read0, Reg* read1, Reg* write)
+{
+  *read0 = Reg::zero;
+  *read1 = Reg::zero;
+  *write = Reg::zero;
+
+  switch (inst.op)
+  {
+    case InstructionOp::funct:
+    {
+      switch (inst.r.funct)
+      {
+        case InstructionFunct::sll:
+        case InstructionFunct::srl:
+        case InstructionFunct::sra:
+          *read0 = inst.r.rt;
+          *write = inst.r.rd;
+          return true;
+
+        case InstructionFunct::sllv:
+        case InstructionFunct::srlv:
+        case InstructionFunct::srav:
+        case InstructionFunct::addu:
+        case InstructionFunct::subu:
+        case InstructionFunct::and_:
+        case InstructionFunct::or_:
+        case InstructionFunct::xor_:
+        case InstructionFunct::nor:
+        case InstructionFunct::slt:
+        case InstructionFunct::sltu:
+          *read0 = inst.r.rs;
+          *read1 = inst.r.rt;
+          *write = inst.r.rd;
+          return true;
+
+        default:
+          return false;
+      }
+    }
+
+    case InstructionOp::lui:
+      *write = inst.i.rt;
+      return true;
+
+    case InstructionOp::addiu:
+    case InstructionOp::slti:
+    case InstructionOp::sltiu:
+    case InstructionOp::andi:
+    case InstructionOp::ori:
+    case InstructionOp::xori:
+    case InstructionOp::lb:
+    case InstructionOp::lbu:
+    case InstructionOp::lh:
+    case InstructionOp::lhu:
+    case InstructionOp::lw:
+      *read0 = inst.i.rs;
+      *write = inst.i.rt;
+      return true;
+
+    case InstructionOp::beq:
+    case InstructionOp::bne:
+      *read0 = inst.i.rs;
+      *read1 = inst.i.rt;
+      return true;
+
+    case InstructionOp::b:
+    {
+      // No link variants.
+      if ((static_cast<u8>(inst.i.rt.GetValue()) & u8(0x1E)) == u8(0x10))
+        return false;
+
+      *read0 = inst.i.rs;
+      return true;
+    }
+
+    case InstructionOp::blez:
+    case InstructionOp::bgtz:
+      *read0 = inst.i.rs;
+      return true;
+
+    case InstructionOp::j:
+      return true;
+
+    default:
+      return false;
+  }
+}
+
+/// Checks whether the block is a loop which only polls memory: the last branch jumps back to the start, nothing is
+/// stored, and every register the loop reads is either never written in it, or recomputed earlier in the same
+/// iteration. Each iteration then leaves the CPU in the same state until a value it loads changes. Fills in the loads.
+static bool AnalyzeIdleLoop(CodeBlock* block)
+{
+  const std::vector<CodeBlockInstruction>& instructions = block->instructions;
+  const size_t count = instructions.size();
+  u32 branch_target;
+  if (count < 2 || !GetStaticBranchTarget(instructions[count - 2], &branch_target) ||
+      branch_target != block->GetPC() || instructions.back().is_load_instruction)
+  {
+    return false;
+  }
+
+  std::bitset<static_cast<u8>(Reg::count)> loop_writes;
+  for (const CodeBlockInstruction& cbi : instructions)
+  {
+    Reg read0, read1, write;
+    if (!GetIdleLoopInstructionRegisters(cbi.instruction, &read0, &read1, &write))
+      return false;
+    if (cbi.is_branch_instruction && &cbi != &instructions[count - 2])
+      return false;
+
+    loop_writes[static_cast<u8>(write)] = true;
+  }
+
+  // Registers written so far in the iteration, and whether they hold a constant, for the base of loads.
+  std::bitset<static_cast<u8>(Reg::count)> written;
+  std::bitset<static_cast<u8>(Reg::count)> constant;
+  std::array<u32, static_cast<u8>(Reg::count)> constant_values{};
+  constant[static_cast<u8>(Reg::zero)] = true;
+  Reg load_delay_reg = Reg::count;
+  block->idle_loop_loads.clear();
+
+  for (const CodeBlockInstruction& cbi : instructions)
+  {
+    Reg read0, read1, write;
+    GetIdleLoopInstructionRegisters(cbi.instruction, &read0, &read1, &write);
+    for (const Reg reg : {read0, read1})
+    {
+      // Values carried over from the last iteration, or the old value of a register in the load delay slot.
+      const u8 index = static_cast<u8>(reg);
+      if (reg != Reg::zero && ((loop_writes[index] && !written[index]) || reg == load_delay_reg))
+        return false;
+    }
+
+    load_delay_reg = Reg::count;
+    if (cbi.is_load_instruction)
+    {
+      const u8 base = static_cast<u8>(read0);
+      if (!written[base])
+        block->idle_loop_loads.push_back({read0, cbi.instruction.i.imm_sext32()});
+      else if (constant[base])
+        block->idle_loop_loads.push_back({Reg::zero, constant_values[base] + cbi.instruction.i.imm_sext32()});
+      else
+        return false;
+
+      load_delay_reg = write;
+    }
+
+    const u8 index = static_cast<u8>(write);
+    if (write == Reg::zero)
+      continue;
+
+    const u8 source = static_cast<u8>(read0);
+    written[index] = true;
+    switch (cbi.instruction.op)
+    {
+      case InstructionOp::lui:
+        constant[index] = true;
+        constant_values[index] = cbi.instruction.i.imm_zext32() << 16;
+        break;
+
+      case InstructionOp::addiu:
+        constant[index] = constant[source];
+        constant_values[index] = constant_values[source] + cbi.instruction.i.imm_sext32();
+        break;
+
+      case InstructionOp::ori:
+        constant[index] = constant[source];
+        constant_values[index] = constant_values[source] | cbi.instruction.i.imm_zext32();
+        break;
+
+      default:
+        constant[index] = false;
+        break;
+    }
+  }
+
+  return true;
+}
+
+bool CodeCache::CompileBlock(CodeBlock* block, const u32* words /* = nullptr */, u32 word_count /* = 0 */)
 {
+  Common::Timer compile_timer;
   u32 pc = block->GetPC();
+  u32 word_index = 0;
+  u32 side_exit_count = 0;
   bool is_branch_delay_slot = false;
   bool is_load_delay_slot = false;
+  bool has_cop0_instruction = false;
+  block->is_idle_loop = false;
+  block->idle_loop_loads.clear();
+  block->decoded_instructions.clear();
 
 #if 0
   if (pc == 0x0005aa90)
@@ -252,13 +1342,25 @@ bool CodeCache::CompileBlock(CodeBlock* block)
     CodeBlockInstruction cbi = {};
 
     const PhysicalMemoryAddress phys_addr = pc & PHYSICAL_MEMORY_ADDRESS_MASK;
-    if (!m_bus->IsCacheableAddress(phys_addr) ||
-        m_bus->DispatchAccess<MemoryAccessType::Read, MemoryAccessSize::Word>(phys_addr, cbi.instruction.bits) < 0 ||
-        !IsInvalidInstruction(cbi.instruction))
+    if (!m_bus->IsCacheableAddress(phys_addr))
+      break;
+
+    if (words)
+    {
+      if (word_index == word_count)
+        break;
+
+      cbi.instruction.bits = words[word_index++];
+    }
+    else if (m_bus->DispatchAccess<MemoryAccessType::Read, MemoryAccessSize::Word>(phys_addr,
+                                                                                     cbi.instruction.bits) < 0)
     {
       break;
     }
 
+    if (!IsInvalidInstruction(cbi.instruction))
+      break;
+
     cbi.pc = pc;
     cbi.is_branch_delay_slot = is_branch_delay_slot;
     cbi.is_load_delay_slot = is_load_delay_slot;
@@ -266,16 +1368,50 @@ bool CodeCache::CompileBlock(CodeBlock* block)
     cbi.is_load_instruction = IsMemoryLoadInstruction(cbi.instruction);
     cbi.is_store_instruction = IsMemoryStoreInstruction(cbi.instruction);
     cbi.has_load_delay = InstructionHasLoadDelay(cbi.instruction);
-    cbi.can_trap = CanInstructionTrap(cbi.instruction, m_core->InUserMode());
+    cbi.can_trap = CanInstructionTrap(cbi.instruction, block->key.user_mode);
+    m_load_count += BoolToUInt32(cbi.has_load_delay);
+
+    // Loads in branch delay slots are followed by the branch target, which may be outside the block. A second load to
+    // the same register cancels the first one, so the old value survives.
+    if (USE_LOAD_DELAY_ANALYSIS && is_load_delay_slot)
+    {
+      CodeBlockInstruction& load = block->instructions.back();
+      if (!load.is_branch_delay_slot && !InstructionReadsRegister(cbi.instruction, load.instruction.r.rt) &&
+          !(cbi.has_load_delay && cbi.instruction.r.rt == load.instruction.r.rt))
+      {
+        load.can_skip_load_delay = true;
+        m_skipped_load_delay_count++;
+      }
+    }
 
     // instruction is decoded now
     block->instructions.push_back(cbi);
+    block->instruction_words.push_back(cbi.instruction.bits);
     pc += sizeof(cbi.instruction.bits);
 
     // if we're in a branch delay slot, the block is now done
     // except if this is a branch in a branch delay slot, then we grab the one after that, and so on...
+    // Superblocks carry on after conditional branches, cop0 instructions could change the mode the exits run in.
+    has_cop0_instruction |= (cbi.instruction.op == InstructionOp::cop0);
     if (is_branch_delay_slot && !cbi.is_branch_instruction)
-      break;
+    {
+      // Idle loops end at the branch back to the start, so the dispatcher sees each iteration.
+      if (USE_IDLE_LOOP_SKIPPING && side_exit_count == 0 && AnalyzeIdleLoop(block))
+      {
+        block->is_idle_loop = true;
+        m_idle_loop_count++;
+        break;
+      }
+
+      const CodeBlockInstruction& branch = block->instructions[block->instructions.size() - 2];
+      if (!USE_SUPERBLOCKS || !m_use_recompiler || has_cop0_instruction || !CanBranchHaveSideExit(branch) ||
+          side_exit_count == SUPERBLOCK_MAX_SIDE_EXITS || block->instructions.size() >= SUPERBLOCK_MAX_INSTRUCTIONS)
+      {
+        break;
+      }
+
+      side_exit_count++;
+    }
 
     // if this is a branch, we grab the next instruction (delay slot), and then exit
     is_branch_delay_slot = cbi.is_branch_instruction;
@@ -309,61 +1445,224 @@ bool CodeCache::CompileBlock(CodeBlock* block)
     return false;
   }
 
+  block->host_code = nullptr;
+  block->host_code_size = 0;
+  block->last_used_frame = m_system->GetFrameNumber();
+
 #ifdef WITH_RECOMPILER
-  if (m_use_recompiler)
+  // Blocks which wouldn't fit in an empty region are interpreted.
+  const u32 max_code_size =
+    static_cast<u32>(block->instructions.size()) * Recompiler::MAX_NEAR_HOST_BYTES_PER_INSTRUCTION;
+  const u32 max_far_code_size =
+    static_cast<u32>(block->instructions.size()) * Recompiler::MAX_FAR_HOST_BYTES_PER_INSTRUCTION;
+  if (m_use_recompiler && !IsInterpreterOnlyBlock(block) && max_code_size <= m_code_buffer->GetRegionCodeSize() &&
+      max_far_code_size <= m_code_buffer->GetRegionFarCodeSize())
   {
     // Ensure we're not going to run out of space while compiling this block.
-    if (m_code_buffer->GetFreeCodeSpace() <
-          (block->instructions.size() * Recompiler::MAX_NEAR_HOST_BYTES_PER_INSTRUCTION) ||
-        m_code_buffer->GetFreeFarCodeSpace() <
-          (block->instructions.size() * Recompiler::MAX_FAR_HOST_BYTES_PER_INSTRUCTION))
-    {
-      Log_WarningPrintf("Out of code space, flushing all blocks.");
-      Flush();
-    }
+    if (m_code_buffer->GetFreeCodeSpace() < max_code_size || m_code_buffer->GetFreeFarCodeSpace() < max_far_code_size)
+      EvictColdestRegion();
 
+    std::vector<LoadStoreBackpatchInfo> backpatch_info;
     Recompiler::CodeGenerator codegen(m_core, m_code_buffer.get(), *m_asm_functions.get());
-    if (!codegen.CompileBlock(block, &block->host_code, &block->host_code_size))
+    if (!codegen.CompileBlock(block, &block->host_code, &block->host_code_size, &block->exits, &backpatch_info))
     {
       Log_ErrorPrintf("Failed to compile host code for block at 0x%08X", block->key.GetPC());
       return false;
     }
+
+    for (const LoadStoreBackpatchInfo& info : backpatch_info)
+      m_fastmem_backpatch_info.emplace(info.host_code, info);
   }
 #endif
 
+  if (!block->host_code && m_use_predecoded_interpreter)
+    PredecodedInterpreter::DecodeBlock(block);
+
+  block->compile_time_ms += static_cast<float>(compile_timer.GetTimeMilliseconds());
   return true;
 }
 
-void CodeCache::InvalidateBlocksWithPageIndex(u32 page_index)
+bool CodeCache::SkipIdleLoop(const CodeBlock* block, TickCount iteration_ticks)
+{
+  // Anything which can change between events could end the loop earlier.
+  for (const CodeBlockIdleLoopLoad& load : block->idle_loop_loads)
+  {
+    const VirtualMemoryAddress address = m_core->m_regs.r[static_cast<u8>(load.base)] + load.offset;
+    const u32 segment = address >> 29;
+    const PhysicalMemoryAddress phys_addr = address & PHYSICAL_MEMORY_ADDRESS_MASK;
+    if (segment != 0 && segment != 4 && segment != 5)
+      return false;
+    else if (segment != 5 && (phys_addr & Core::DCACHE_LOCATION_MASK) == Core::DCACHE_LOCATION)
+      continue;
+    else if (!Bus::IsPollableAddress(phys_addr))
+      return false;
+  }
+
+  // Skip whole iterations, so the loop ends where it would have if it had run until the downcount.
+  const TickCount remaining_ticks = m_core->m_downcount - m_core->m_pending_ticks;
+  const TickCount skipped_ticks = ((remaining_ticks + iteration_ticks - 1) / iteration_ticks) * iteration_ticks;
+  m_core->m_pending_ticks += skipped_ticks;
+  m_idle_loop_skips++;
+  m_idle_loop_skipped_ticks += static_cast<u64>(skipped_ticks);
+  return true;
+}
+
+void CodeCache::InvalidateBlocksWithPageIndex(u32 page_index, u32 offset, u32 size)
 {
   DebugAssert(page_index < CPU_CODE_CACHE_PAGE_COUNT);
+
+  // Only the part of the write which is in this page matters, block DMAs can cover several pages.
+  const u32 page_start = page_index * CPU_CODE_CACHE_PAGE_SIZE;
+  const u32 write_start = std::max(offset, page_start);
+  const u32 write_end = std::min(offset + size, page_start + CPU_CODE_CACHE_PAGE_SIZE);
+  const u32 first_line = (write_start - page_start) / CODE_LINE_SIZE;
+  const u32 last_line = (write_end - 1 - page_start) / CODE_LINE_SIZE;
+  const CodeLineMask write_mask =
+    static_cast<CodeLineMask>(((2u << last_line) - 1) & ~((1u << first_line) - 1));
+
+  if (!(m_ram_code_line_masks[page_index] & write_mask))
+  {
+    m_page_statistics[page_index].data_writes++;
+    return;
+  }
+
+  // Invalidating removes the block from this list, so don't advance when that happens.
   auto& blocks = m_ram_block_map[page_index];
-  for (CodeBlock* block : blocks)
+  for (size_t i = 0; i < blocks.size();)
   {
-    // Invalidate forces the block to be checked again.
-    Log_DebugPrintf("Invalidating block at 0x%08X", block->GetPC());
-    block->invalidated = true;
+    if (GetBlockCodeLineMask(blocks[i], page_index) & write_mask)
+      InvalidateBlock(blocks[i]);
+    else
+      i++;
   }
 
-  // Block will be re-added next execution.
-  blocks.clear();
-  m_bus->ClearRAMCodePage(page_index);
+  m_page_statistics[page_index].invalidations++;
+}
+
+void CodeCache::InvalidateBlock(CodeBlock* block)
+{
+  // Invalidate forces the block to be checked again. Linked blocks would skip that check, so unlink it too.
+  // Block will be re-added to the page map next execution.
+  Log_DebugPrintf("Invalidating block at 0x%08X", block->GetPC());
+  block->invalidated = true;
+  block->invalidation_count++;
+  UnlinkBlock(block);
+  RemoveBlockFromPageMap(block);
+}
+
+CodeCache::CodeLineMask CodeCache::GetBlockCodeLineMask(const CodeBlock* block, u32 page_index)
+{
+  // Pages past the end of RAM are the start of the first mirror.
+  const u32 block_start = block->key.GetPCPhysicalAddress();
+  const u32 block_end = block_start + block->GetSizeInBytes() - 1;
+  CodeLineMask mask = 0;
+  for (u32 page = block->GetStartPageIndex(); page <= block->GetEndPageIndex(); page++)
+  {
+    if ((page % CPU_CODE_CACHE_PAGE_COUNT) != page_index)
+      continue;
+
+    const u32 page_start = page * CPU_CODE_CACHE_PAGE_SIZE;
+    const u32 first_line = (std::max(block_start, page_start) - page_start) / CODE_LINE_SIZE;
+    const u32 last_line =
+      (std::min(block_end, page_start + CPU_CODE_CACHE_PAGE_SIZE - 1) - page_start) / CODE_LINE_SIZE;
+    mask |= static_cast<CodeLineMask>(((2u << last_line) - 1) & ~((1u << first_line) - 1));
+  }
+
+  return mask;
+}
+
+bool CodeCache::IsInterpreterOnlyBlock(const CodeBlock* block) const
+{
+  return block->IsInRAM() && m_interpreter_only_pages[block->GetStartPageIndex()];
 }
 
 void CodeCache::FlushBlock(CodeBlock* block)
 {
-  BlockMap::iterator iter = m_blocks.find(block->key.GetPC());
+  BlockMap::iterator iter = m_blocks.find(block->key.bits);
   Assert(iter != m_blocks.end() && iter->second == block);
   Log_DevPrintf("Flushing block at address 0x%08X", block->GetPC());
 
+  CodeBlock** entry = GetLookupTableEntry(block->key, false);
+  if (entry && *entry == block)
+    *entry = nullptr;
+
   // if it's been invalidated it won't be in the page map
-  if (block->invalidated)
+  if (!block->invalidated)
     RemoveBlockFromPageMap(block);
 
+  UnlinkBlock(block);
+  if (m_core->m_unlinked_exit_block == block)
+    m_core->m_unlinked_exit_block = nullptr;
+  if (m_core->m_profiled_block == block)
+    m_core->m_profiled_block = nullptr;
+
   m_blocks.erase(iter);
   delete block;
 }
 
+void CodeCache::EvictColdestRegion()
+{
+#ifdef WITH_RECOMPILER
+  // Code can't be moved once other blocks link to it, so whole regions are reused instead. The block being compiled
+  // has no host code at this point, so it can't be flushed here.
+  const u32 region_count = m_code_buffer->GetRegionCount();
+  const u32 current_region = m_code_buffer->GetCurrentRegion();
+  std::vector<s64> region_last_used(region_count, -1);
+  for (const auto& it : m_blocks)
+  {
+    const CodeBlock* block = it.second;
+    if (!block || !block->host_code)
+      continue;
+
+    const u32 region = m_code_buffer->GetRegionForPointer(reinterpret_cast<const void*>(block->host_code));
+    region_last_used[region] = std::max(region_last_used[region], static_cast<s64>(block->last_used_frame));
+  }
+
+  // Ties go to the region after the current one, so regions are reused in order when nothing is clearly colder.
+  u32 evict_region = current_region;
+  if (region_count > 1)
+  {
+    evict_region = (current_region + 1) % region_count;
+    for (u32 i = 2; i < region_count; i++)
+    {
+      const u32 region = (current_region + i) % region_count;
+      if (region_last_used[region] < region_last_used[evict_region])
+        evict_region = region;
+    }
+  }
+
+  std::vector<CodeBlock*> evict_blocks;
+  for (const auto& it : m_blocks)
+  {
+    CodeBlock* block = it.second;
+    if (block && block->host_code &&
+        m_code_buffer->IsPointerInRegion(reinterpret_cast<const void*>(block->host_code), evict_region))
+    {
+      evict_blocks.push_back(block);
+    }
+  }
+
+  Log_DevPrintf("Out of code space, evicting %u blocks in region %u (last used in frame %lld)",
+                static_cast<u32>(evict_blocks.size()), evict_region,
+                static_cast<long long>(region_last_used[evict_region]));
+
+  for (CodeBlock* block : evict_blocks)
+    FlushBlock(block);
+
+  for (auto iter = m_fastmem_backpatch_info.begin(); iter != m_fastmem_backpatch_info.end();)
+  {
+    if (m_code_buffer->IsPointerInRegion(iter->first, evict_region))
+      iter = m_fastmem_backpatch_info.erase(iter);
+    else
+      ++iter;
+  }
+
+  m_code_buffer->ResetRegion(evict_region);
+  m_evicted_region_count++;
+  m_evicted_block_count += static_cast<u32>(evict_blocks.size());
+#endif
+}
+
 void CodeCache::AddBlockToPageMap(CodeBlock* block)
 {
   if (!block->IsInRAM())
@@ -373,8 +1672,11 @@ void CodeCache::AddBlockToPageMap(CodeBlock* block)
   const u32 end_page = block->GetEndPageIndex();
   for (u32 page = start_page; page <= end_page; page++)
   {
-    m_ram_block_map[page].push_back(block);
-    m_bus->SetRAMCodePage(page);
+    // A block at the end of RAM can continue into the first mirror.
+    const u32 page_index = page % CPU_CODE_CACHE_PAGE_COUNT;
+    m_ram_block_map[page_index].push_back(block);
+    m_ram_code_line_masks[page_index] |= GetBlockCodeLineMask(block, page_index);
+    m_bus->SetRAMCodePage(page_index);
   }
 }
 
@@ -387,18 +1689,38 @@ void CodeCache::RemoveBlockFromPageMap(CodeBlock* block)
   const u32 end_page = block->GetEndPageIndex();
   for (u32 page = start_page; page <= end_page; page++)
   {
-    auto& page_blocks = m_ram_block_map[page];
+    const u32 page_index = page % CPU_CODE_CACHE_PAGE_COUNT;
+    auto& page_blocks = m_ram_block_map[page_index];
     auto page_block_iter = std::find(page_blocks.begin(), page_blocks.end(), block);
     Assert(page_block_iter != page_blocks.end());
     page_blocks.erase(page_block_iter);
+
+    // Writes only need to be caught in lines which still contain code.
+    CodeLineMask mask = 0;
+    for (const CodeBlock* page_block : page_blocks)
+      mask |= GetBlockCodeLineMask(page_block, page_index);
+    m_ram_code_line_masks[page_index] = mask;
+    if (page_blocks.empty())
+      m_bus->ClearRAMCodePage(page_index);
   }
 }
 
 void CodeCache::LinkBlock(CodeBlock* from, CodeBlock* to)
 {
+  // Idle loops return to the dispatcher after every iteration, so it can skip the rest of them.
+  if (from->is_idle_loop)
+    return;
+
+  if (std::find(from->link_successors.begin(), from->link_successors.end(), to) != from->link_successors.end())
+    return;
+
   Log_DebugPrintf("Linking block %p(%08x) to %p(%08x)", from, from->GetPC(), to, to->GetPC());
   from->link_successors.push_back(to);
   to->link_predecessors.push_back(from);
+
+  // Exits don't check the CPU mode, so only link blocks which were compiled for the same mode.
+  if (from->key.user_mode == to->key.user_mode)
+    PatchBlockExits(from, to, to->GetPC());
 }
 
 void CodeCache::UnlinkBlock(CodeBlock* block)
@@ -408,6 +1730,7 @@ void CodeCache::UnlinkBlock(CodeBlock* block)
     auto iter = std::find(predecessor->link_successors.begin(), predecessor->link_successors.end(), block);
     Assert(iter != predecessor->link_successors.end());
     predecessor->link_successors.erase(iter);
+    PatchBlockExits(predecessor, nullptr, block->GetPC());
   }
   block->link_predecessors.clear();
 
@@ -416,10 +1739,37 @@ void CodeCache::UnlinkBlock(CodeBlock* block)
     auto iter = std::find(successor->link_predecessors.begin(), successor->link_predecessors.end(), block);
     Assert(iter != successor->link_predecessors.end());
     successor->link_predecessors.erase(iter);
+    PatchBlockExits(block, nullptr, successor->GetPC());
   }
   block->link_successors.clear();
 }
 
+void CodeCache::PatchBlockExits(CodeBlock* from, const CodeBlock* to, u32 target_pc)
+{
+#ifdef WITH_RECOMPILER
+  // Interpreted blocks can't be jumped to, exits to them stay unlinked.
+  if (to && !to->host_code)
+    return;
+
+  // Hosts without linkable exits don't define PatchExitJump(), they always return to the dispatcher instead.
+  if constexpr (Recompiler::SUPPORTS_BLOCK_LINKING)
+  {
+    for (const CodeBlockExit& exit : from->exits)
+    {
+      if (exit.target_pc == target_pc)
+      {
+        Recompiler::CodeGenerator::PatchExitJump(
+          exit.jump_code, to ? reinterpret_cast<const void*>(to->host_code) : exit.unlinked_code);
+      }
+    }
+  }
+  else
+  {
+    Assert(from->exits.empty());
+  }
+#endif
+}
+
 void CodeCache::InterpretCachedBlock(const CodeBlock& block)
 {
   // set up the state so we've already fetched the instruction
@@ -451,6 +1801,10 @@ void CodeCache::InterpretCachedBlock(const CodeBlock& block)
 
     if (m_core->m_exception_raised)
       break;
+
+    // Branches in the middle of a superblock leave it when taken.
+    if (cbi.is_branch_delay_slot && &cbi != &block.instructions.back() && m_core->m_regs.pc != (&cbi + 1)->pc)
+      break;
   }
 
   // cleanup so the interpreter can kick in if needed
@@ -1,11 +1,15 @@
 #pragma once
 #include "common/bitfield.h"
+#include "common/page_fault_handler.h"
 #include "cpu_types.h"
+#include "types.h"
 #include <array>
+#include <bitset>
 #include <memory>
 #include <unordered_map>
 #include <vector>
 
+class ByteStream;
 class JitCodeBuffer;
 
 class Bus;
@@ -54,6 +58,54 @@ struct CodeBlockInstruction
   bool is_last_instruction : 1;
   bool has_load_delay : 1;
   bool can_trap : 1;
+
+  // The next instruction doesn't read the loaded register, so the load can write it without a delay.
+  bool can_skip_load_delay : 1;
+};
+
+/// Instruction with its operands extracted for the pre-decoded interpreter, and the function which executes it.
+struct CodeBlockDecodedInstruction
+{
+  using Handler = void (*)(Core* cpu, const CodeBlockDecodedInstruction& inst);
+
+  Handler handler;
+  Instruction instruction;
+  u32 pc;
+
+  // Extended immediate, or the target of a branch.
+  u32 imm;
+
+  Reg rs;
+  Reg rt;
+  Reg rd;
+  u8 shamt;
+  bool is_branch_delay_slot;
+};
+
+/// Load made by each iteration of an idle loop, from a register the loop doesn't modify plus an offset. Constant
+/// addresses use the zero register.
+struct CodeBlockIdleLoopLoad
+{
+  Reg base;
+  u32 offset;
+};
+
+/// Exit from recompiled code which can jump directly to the block at target_pc, instead of returning to the
+/// dispatcher. The jump points to unlinked_code until the blocks are linked.
+struct CodeBlockExit
+{
+  u32 target_pc;
+  void* jump_code;
+  void* unlinked_code;
+};
+
+/// Fastmem load or store in recompiled code. If it faults, the host_code_size bytes at host_code are replaced with a
+/// jump to slow_code, which calls the memory handlers instead.
+struct LoadStoreBackpatchInfo
+{
+  void* host_code;
+  void* slow_code;
+  u32 host_code_size;
 };
 
 struct CodeBlock
@@ -67,17 +119,38 @@ struct CodeBlock
   HostCodePointer host_code = nullptr;
 
   std::vector<CodeBlockInstruction> instructions;
+
+  // Only filled in when the block is run by the pre-decoded interpreter.
+  std::vector<CodeBlockDecodedInstruction> decoded_instructions;
+
+  // Copy of the guest code, so revalidation can compare it against RAM in one go.
+  std::vector<u32> instruction_words;
+  std::vector<CodeBlockExit> exits;
   std::vector<CodeBlock*> link_predecessors;
   std::vector<CodeBlock*> link_successors;
 
+  // Loads of a block which is a loop that only polls memory, checked before its iterations are skipped.
+  std::vector<CodeBlockIdleLoopLoad> idle_loop_loads;
+
+  // Frame in which the dispatcher last entered the block, so cold blocks can be evicted from the code buffer.
+  u32 last_used_frame = 0;
+
+  // Executions and ticks are only counted while block profiling is enabled. The ticks run until the next block is
+  // entered, so they include skipped idle loop iterations.
+  u64 profile_execution_count = 0;
+  u64 profile_ticks = 0;
+  u32 invalidation_count = 0;
+  float compile_time_ms = 0.0f;
+
   bool invalidated = false;
+  bool is_idle_loop = false;
 
   const u32 GetPC() const { return key.GetPC(); }
   const u32 GetSizeInBytes() const { return static_cast<u32>(instructions.size()) * sizeof(Instruction); }
   const u32 GetStartPageIndex() const { return (key.GetPCPhysicalAddress() / CPU_CODE_CACHE_PAGE_SIZE); }
   const u32 GetEndPageIndex() const
   {
-    return ((key.GetPCPhysicalAddress() + GetSizeInBytes()) / CPU_CODE_CACHE_PAGE_SIZE);
+    return ((key.GetPCPhysicalAddress() + GetSizeInBytes() - 1) / CPU_CODE_CACHE_PAGE_SIZE);
   }
   bool IsInRAM() const
   {
@@ -89,24 +162,135 @@ struct CodeBlock
 class CodeCache
 {
 public:
+  /// How often the blocks in a RAM code page were invalidated by writes, and whether their code had really changed
+  /// when they next ran.
+  struct PageStatistics
+  {
+    u32 invalidations;
+    u32 revalidations;
+    u32 recompilations;
+    u32 data_writes;
+  };
+
+  /// How many compiled loads (including coprocessor moves) could skip the load delay.
+  struct LoadDelayStatistics
+  {
+    u32 loads;
+    u32 skipped_load_delays;
+  };
+
+  /// Usage of the host code buffer, and how much of it has been reclaimed by evicting cold blocks.
+  struct CodeBufferStatistics
+  {
+    u32 code_size;
+    u32 code_used;
+    u32 far_code_size;
+    u32 far_code_used;
+    u32 live_code_size;
+    u32 evicted_regions;
+    u32 evicted_blocks;
+  };
+
+  /// How many idle loops were found, and how much time was skipped in them.
+  struct IdleLoopStatistics
+  {
+    u32 idle_loops;
+    u64 skips;
+    u64 skipped_ticks;
+  };
+
   CodeCache();
   ~CodeCache();
 
-  void Initialize(System* system, Core* core, Bus* bus, bool use_recompiler);
+  void Initialize(System* system, Core* core, Bus* bus, CPUExecutionMode execution_mode, bool use_fastmem);
   void Execute();
 
   /// Flushes the code cache, forcing all blocks to be recompiled.
   void Flush();
 
-  /// Changes whether the recompiler is enabled.
-  void SetUseRecompiler(bool enable);
+  /// Changes how blocks are executed. Blocks the recompiler can't compile still go through the pre-decoded handlers.
+  void SetExecutionMode(CPUExecutionMode mode);
+
+  /// Changes whether recompiled code accesses RAM directly through the fastmem range.
+  void SetUseFastmem(bool enable);
+
+  /// Invalidates the blocks in the specified code page whose code overlaps the write to RAM offset..offset+size.
+  void InvalidateBlocksWithPageIndex(u32 page_index, u32 offset, u32 size);
+
+  /// Returns the number of bytes currently allocated for the block lookup table.
+  u32 GetLookupTableMemoryUsage() const;
+
+  /// Returns the statistics of all pages added together.
+  PageStatistics GetTotalPageStatistics() const;
 
-  /// Invalidates all blocks which are in the range of the specified code page.
-  void InvalidateBlocksWithPageIndex(u32 page_index);
+  /// Returns the current host code buffer usage. All zero if the recompiler is not available.
+  CodeBufferStatistics GetCodeBufferStatistics() const;
+
+  /// Returns the number of idle loops which have been compiled, and the time skipped in them.
+  IdleLoopStatistics GetIdleLoopStatistics() const;
+
+  /// Returns the number of load-delayed instructions which have been compiled, and how many of them skip the delay.
+  LoadDelayStatistics GetLoadDelayStatistics() const;
+
+  void DrawDebugWindow();
+
+  /// Changes whether executions and ticks are counted for each block. Enabling it flushes the cache, so recompiled
+  /// blocks include the counting code. Disabling it keeps the counts for the report.
+  void SetBlockProfilingEnabled(bool enabled);
+  bool IsBlockProfilingEnabled() const;
+
+  /// Clears the execution counts and ticks of all blocks.
+  void ResetBlockProfile();
+
+  /// Writes the blocks which used the most ticks, with their disassembly, to a text file.
+  bool DumpHotBlocks(const char* filename, u32 count) const;
+
+  void DrawHotBlocksWindow(bool* is_open);
+
+  /// Charges the ticks since the last block was entered to it, and starts counting for this block. Called by
+  /// recompiled code when profiling is enabled.
+  static void EnterProfiledBlock(Core* core, CodeBlock* block);
+  static void LeaveProfiledBlock(Core* core);
+
+  /// Writes the guest code of all compiled blocks to the stream, so they can be preloaded in a later session.
+  bool SavePersistentBlocks(ByteStream* stream);
+
+  /// Compiles the blocks saved by SavePersistentBlocks(). They are checked against guest memory when first executed,
+  /// and recompiled if the code no longer matches.
+  bool LoadPersistentBlocks(ByteStream* stream);
 
 private:
   using BlockMap = std::unordered_map<u32, CodeBlock*>;
 
+  // The lookup table covers RAM followed by the BIOS, for each CPU mode. Each page holds a block pointer for every
+  // instruction in LOOKUP_TABLE_PAGE_SIZE bytes of code, and is only allocated once a block is compiled in it.
+  enum : u32
+  {
+    LOOKUP_TABLE_PAGE_SHIFT = 12,
+    LOOKUP_TABLE_PAGE_SIZE = 1u << LOOKUP_TABLE_PAGE_SHIFT,
+    LOOKUP_TABLE_ENTRIES_PER_PAGE = LOOKUP_TABLE_PAGE_SIZE / sizeof(u32),
+    LOOKUP_TABLE_RAM_SIZE = 0x200000,
+    LOOKUP_TABLE_BIOS_BASE = 0x1FC00000,
+    LOOKUP_TABLE_BIOS_SIZE = 0x80000,
+    LOOKUP_TABLE_PAGES_PER_MODE = (LOOKUP_TABLE_RAM_SIZE + LOOKUP_TABLE_BIOS_SIZE) / LOOKUP_TABLE_PAGE_SIZE,
+    LOOKUP_TABLE_PAGE_COUNT = LOOKUP_TABLE_PAGES_PER_MODE * 2
+  };
+
+  using LookupTablePage = std::array<CodeBlock*, LOOKUP_TABLE_ENTRIES_PER_PAGE>;
+
+  // Each code page keeps a mask of the lines which contain code, so writes to data sharing the page with code can be
+  // skipped without looking at the blocks.
+  enum : u32
+  {
+    CODE_LINE_SIZE = 64,
+    CODE_LINES_PER_PAGE = CPU_CODE_CACHE_PAGE_SIZE / CODE_LINE_SIZE,
+  };
+  using CodeLineMask = u16;
+  static_assert(CODE_LINES_PER_PAGE <= (sizeof(CodeLineMask) * 8), "code line mask covers a page");
+
+  // Blocks which start in a page whose code has been recompiled this many times are interpreted instead.
+  static constexpr u32 INTERPRETER_ONLY_PAGE_RECOMPILE_THRESHOLD = 16;
+
   void LogCurrentState();
 
   /// Returns the block key for the current execution state.
@@ -115,21 +299,60 @@ private:
   /// Looks up the block in the cache if it's already been compiled.
   CodeBlock* LookupBlock(CodeBlockKey key);
 
+  /// Slow path of LookupBlock(), compiling the block if it isn't in the map.
+  CodeBlock* LookupBlockInMap(CodeBlockKey key);
+
+  /// Returns the lookup table slot for the key, or nullptr if the address isn't covered by the table.
+  /// The slot is only a hint, the block in it may have been compiled for a mirror or another segment of the address.
+  CodeBlock** GetLookupTableEntry(CodeBlockKey key, bool allocate);
+
+  /// Frees all lookup table pages.
+  void ClearLookupTable();
+
   /// Can the current block execute? This will re-validate the block if necessary.
   /// The block can also be flushed if recompilation failed, so ignore the pointer if false is returned.
   bool RevalidateBlock(CodeBlock* block);
 
-  bool CompileBlock(CodeBlock* block);
+  /// Decodes and compiles the block. If words is not null, the guest code is read from it instead of memory.
+  bool CompileBlock(CodeBlock* block, const u32* words = nullptr, u32 word_count = 0);
+
+  /// Fast-forwards the CPU to the downcount if the block is an idle loop which branched back to itself, and all of
+  /// the addresses it reads only change when an event runs. Returns false if the loop has to keep running.
+  bool SkipIdleLoop(const CodeBlock* block, TickCount iteration_ticks);
   void FlushBlock(CodeBlock* block);
+
+  /// Flushes the blocks in the code buffer region which was used least recently, and continues compiling into it.
+  void EvictColdestRegion();
+
   void AddBlockToPageMap(CodeBlock* block);
   void RemoveBlockFromPageMap(CodeBlock* block);
 
+  /// Marks the block as invalidated and removes it from the page map, so it is checked before it next executes.
+  void InvalidateBlock(CodeBlock* block);
+
+  /// Returns the mask of lines in the code page which contain part of the block.
+  static CodeLineMask GetBlockCodeLineMask(const CodeBlock* block, u32 page_index);
+
+  /// Returns true if the block should be interpreted even though the recompiler is enabled.
+  bool IsInterpreterOnlyBlock(const CodeBlock* block) const;
+
   /// Link block from to to.
   void LinkBlock(CodeBlock* from, CodeBlock* to);
 
   /// Unlink all blocks which point to this block, and any that this block links to.
   void UnlinkBlock(CodeBlock* block);
 
+  /// Points the recompiled exits of from which lead to to's PC at to's code, or back to the dispatcher if to is null.
+  void PatchBlockExits(CodeBlock* from, const CodeBlock* to, u32 target_pc);
+
+  /// Maps or unmaps the fastmem range and installs the fault handler, depending on the current settings.
+  void UpdateFastmemMapping();
+  static Common::PageFaultHandler::HandlerResult FastmemFaultHandler(void* owner, void* exception_pc,
+                                                                      void* fault_address, bool is_write);
+
+  /// Returns up to count blocks, ordered by the ticks they used while profiling.
+  std::vector<const CodeBlock*> GetHotBlocks(u32 count) const;
+
   void InterpretCachedBlock(const CodeBlock& block);
   void InterpretUncachedBlock();
 
@@ -144,9 +367,36 @@ private:
 
   BlockMap m_blocks;
 
+  std::array<std::unique_ptr<LookupTablePage>, LOOKUP_TABLE_PAGE_COUNT> m_lookup_table;
+  u32 m_lookup_table_page_count = 0;
+
   bool m_use_recompiler = false;
+  bool m_use_predecoded_interpreter = false;
+  bool m_use_fastmem = false;
+
+  u32 m_evicted_region_count = 0;
+  u32 m_evicted_block_count = 0;
+
+  u32 m_idle_loop_count = 0;
+  u64 m_idle_loop_skips = 0;
+  u64 m_idle_loop_skipped_ticks = 0;
+
+  u32 m_load_count = 0;
+  u32 m_skipped_load_delay_count = 0;
+
+  // Key of the block whose disassembly is shown in the hot blocks window.
+  u32 m_hot_blocks_selected_key = 0;
+
+  // Fastmem accesses in recompiled code which haven't been backpatched yet, by host code address.
+  std::unordered_map<const void*, LoadStoreBackpatchInfo> m_fastmem_backpatch_info;
 
   std::array<std::vector<CodeBlock*>, CPU_CODE_CACHE_PAGE_COUNT> m_ram_block_map;
+  std::array<CodeLineMask, CPU_CODE_CACHE_PAGE_COUNT> m_ram_code_line_masks{};
+  std::array<PageStatistics, CPU_CODE_CACHE_PAGE_COUNT> m_page_statistics{};
+
+  // Recompilations since the last flush, which decide whether a page is only interpreted.
+  std::array<u32, CPU_CODE_CACHE_PAGE_COUNT> m_page_recompile_counts{};
+  std::bitset<CPU_CODE_CACHE_PAGE_COUNT> m_interpreter_only_pages;
 };
 
 } // namespace CPU
\ No newline at end of file
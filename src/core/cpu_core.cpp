@@ -380,35 +380,6 @@ void Core::FlushPipeline()
   m_current_instruction_was_branch_taken = false;
 }
 
-u32 Core::ReadReg(Reg rs)
-{
-  return m_regs.r[static_cast<u8>(rs)];
-}
-
-void Core::WriteReg(Reg rd, u32 value)
-{
-  m_regs.r[static_cast<u8>(rd)] = value;
-  m_load_delay_reg = (rd == m_load_delay_reg) ? Reg::count : m_load_delay_reg;
-
-  // prevent writes to $zero from going through - better than branching/cmov
-  m_regs.zero = 0;
-}
-
-void Core::WriteRegDelayed(Reg rd, u32 value)
-{
-  Assert(m_next_load_delay_reg == Reg::count);
-  if (rd == Reg::zero)
-    return;
-
-  // double load delays ignore the first value
-  if (m_load_delay_reg == rd)
-    m_load_delay_reg = Reg::count;
-
-  // save the old value, if something else overwrites this reg we want to preserve it
-  m_next_load_delay_reg = rd;
-  m_next_load_delay_value = value;
-}
-
 std::optional<u32> Core::ReadCop0Reg(Cop0Reg reg)
 {
   switch (reg)
@@ -1,4 +1,5 @@
 #pragma once
+#include "common/assert.h"
 #include "common/bitfield.h"
 #include "cpu_types.h"
 #include "gte.h"
@@ -14,6 +15,8 @@ class System;
 namespace CPU {
 
 class CodeCache;
+class PredecodedInterpreter;
+struct CodeBlock;
 
 namespace Recompiler {
 class CodeGenerator;
@@ -30,6 +33,7 @@ public:
   static constexpr PhysicalMemoryAddress DCACHE_SIZE = UINT32_C(0x00000400);
 
   friend CodeCache;
+  friend PredecodedInterpreter;
   friend Recompiler::CodeGenerator;
   friend Recompiler::Thunks;
 
@@ -124,11 +128,31 @@ private:
   void FlushPipeline();
 
   // helper functions for registers which aren't writable
-  u32 ReadReg(Reg rs);
-  void WriteReg(Reg rd, u32 value);
+  ALWAYS_INLINE u32 ReadReg(Reg rs) const { return m_regs.r[static_cast<u8>(rs)]; }
+  ALWAYS_INLINE void WriteReg(Reg rd, u32 value)
+  {
+    m_regs.r[static_cast<u8>(rd)] = value;
+    m_load_delay_reg = (rd == m_load_delay_reg) ? Reg::count : m_load_delay_reg;
+
+    // prevent writes to $zero from going through - better than branching/cmov
+    m_regs.zero = 0;
+  }
 
   // helper for generating a load delay write
-  void WriteRegDelayed(Reg rd, u32 value);
+  ALWAYS_INLINE void WriteRegDelayed(Reg rd, u32 value)
+  {
+    Assert(m_next_load_delay_reg == Reg::count);
+    if (rd == Reg::zero)
+      return;
+
+    // double load delays ignore the first value
+    if (m_load_delay_reg == rd)
+      m_load_delay_reg = Reg::count;
+
+    // save the old value, if something else overwrites this reg we want to preserve it
+    m_next_load_delay_reg = rd;
+    m_next_load_delay_value = value;
+  }
 
   // write to cache control register
   void WriteCacheControl(u32 value);
@@ -165,6 +189,17 @@ private:
   u32 m_cache_control = 0;
   System* m_system = nullptr;
 
+  // Recompiled block which last returned to the dispatcher through an unlinked exit. Set by the recompiled code.
+  CodeBlock* m_unlinked_exit_block = nullptr;
+
+  // Base of the host range which RAM is mapped into for recompiled loads and stores, or nullptr if fastmem is off.
+  u8* m_fastmem_base = nullptr;
+
+  // Block which was entered last while blocks are being profiled, and the pending ticks at the time.
+  CodeBlock* m_profiled_block = nullptr;
+  TickCount m_profiled_block_start_ticks = 0;
+  bool m_block_profiling_enabled = false;
+
   // data cache (used as scratchpad)
   std::array<u8, DCACHE_SIZE> m_dcache = {};
 
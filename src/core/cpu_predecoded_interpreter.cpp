@@ -0,0 +1,510 @@
+#include "cpu_predecoded_interpreter.h"
+#include "cpu_code_cache.h"
+#include "cpu_core.h"
+
+namespace CPU {
+
+void PredecodedInterpreter::DecodeBlock(CodeBlock* block)
+{
+  block->decoded_instructions.resize(block->instructions.size());
+  for (size_t i = 0; i < block->instructions.size(); i++)
+    DecodeInstruction(block->instructions[i], &block->decoded_instructions[i]);
+}
+
+void PredecodedInterpreter::ExecuteBlock(Core* cpu, const CodeBlock& block)
+{
+  // Same bookkeeping as CodeCache::InterpretCachedBlock(), only the decoding is done up front.
+  DebugAssert(cpu->m_regs.pc == block.GetPC());
+  cpu->m_regs.npc = block.GetPC() + 4;
+
+  const Inst* const begin = block.decoded_instructions.data();
+  const Inst* const end = begin + block.decoded_instructions.size();
+  for (const Inst* inst = begin; inst != end; inst++)
+  {
+    cpu->m_pending_ticks++;
+
+    cpu->m_current_instruction.bits = inst->instruction.bits;
+    cpu->m_current_instruction_pc = inst->pc;
+    cpu->m_current_instruction_in_branch_delay_slot = inst->is_branch_delay_slot;
+    cpu->m_current_instruction_was_branch_taken = cpu->m_branch_was_taken;
+    cpu->m_branch_was_taken = false;
+    cpu->m_exception_raised = false;
+
+    cpu->m_regs.pc = cpu->m_regs.npc;
+    cpu->m_regs.npc += 4;
+
+    inst->handler(cpu, *inst);
+
+    cpu->UpdateLoadDelay();
+
+    if (cpu->m_exception_raised)
+      break;
+
+    // Branches in the middle of a superblock leave it when taken.
+    if (inst->is_branch_delay_slot && (inst + 1) != end && cpu->m_regs.pc != (inst + 1)->pc)
+      break;
+  }
+
+  cpu->m_next_instruction_is_branch_delay_slot = false;
+}
+
+void PredecodedInterpreter::DecodeInstruction(const CodeBlockInstruction& cbi, Inst* inst)
+{
+  const Instruction instruction = cbi.instruction;
+  inst->handler = &Interpret;
+  inst->instruction.bits = instruction.bits;
+  inst->pc = cbi.pc;
+  inst->imm = instruction.i.imm_sext32();
+  inst->rs = instruction.r.rs;
+  inst->rt = instruction.r.rt;
+  inst->rd = instruction.r.rd;
+  inst->shamt = instruction.r.shamt;
+  inst->is_branch_delay_slot = cbi.is_branch_delay_slot;
+
+  // Instructions which can't trap and only write this register do nothing if it's the zero register.
+  Reg pure_destination = Reg::count;
+
+  // Branch targets are relative to the delay slot.
+  const u32 branch_target = cbi.pc + 4 + (instruction.i.imm_sext32() << 2);
+  const u32 jump_target = ((cbi.pc + 4) & UINT32_C(0xF0000000)) | (instruction.j.target << 2);
+
+#define DECODE(value, handler_)                                                                                        \
+  case value:                                                                                                          \
+    inst->handler = &handler_;                                                                                         \
+    break;
+
+#define DECODE_PURE(value, handler_, destination)                                                                      \
+  case value:                                                                                                          \
+    inst->handler = &handler_;                                                                                         \
+    pure_destination = destination;                                                                                    \
+    break;
+
+  switch (instruction.op)
+  {
+    case InstructionOp::funct:
+    {
+      switch (instruction.r.funct)
+      {
+        DECODE_PURE(InstructionFunct::sll, ALURegister<InstructionFunct::sll>, inst->rd)
+        DECODE_PURE(InstructionFunct::srl, ALURegister<InstructionFunct::srl>, inst->rd)
+        DECODE_PURE(InstructionFunct::sra, ALURegister<InstructionFunct::sra>, inst->rd)
+        DECODE_PURE(InstructionFunct::sllv, ALURegister<InstructionFunct::sllv>, inst->rd)
+        DECODE_PURE(InstructionFunct::srlv, ALURegister<InstructionFunct::srlv>, inst->rd)
+        DECODE_PURE(InstructionFunct::srav, ALURegister<InstructionFunct::srav>, inst->rd)
+        DECODE_PURE(InstructionFunct::addu, ALURegister<InstructionFunct::addu>, inst->rd)
+        DECODE_PURE(InstructionFunct::subu, ALURegister<InstructionFunct::subu>, inst->rd)
+        DECODE_PURE(InstructionFunct::and_, ALURegister<InstructionFunct::and_>, inst->rd)
+        DECODE_PURE(InstructionFunct::or_, ALURegister<InstructionFunct::or_>, inst->rd)
+        DECODE_PURE(InstructionFunct::xor_, ALURegister<InstructionFunct::xor_>, inst->rd)
+        DECODE_PURE(InstructionFunct::nor, ALURegister<InstructionFunct::nor>, inst->rd)
+        DECODE_PURE(InstructionFunct::slt, ALURegister<InstructionFunct::slt>, inst->rd)
+        DECODE_PURE(InstructionFunct::sltu, ALURegister<InstructionFunct::sltu>, inst->rd)
+        DECODE_PURE(InstructionFunct::mfhi, MoveHiLo<InstructionFunct::mfhi>, inst->rd)
+        DECODE_PURE(InstructionFunct::mflo, MoveHiLo<InstructionFunct::mflo>, inst->rd)
+        DECODE(InstructionFunct::mthi, MoveHiLo<InstructionFunct::mthi>)
+        DECODE(InstructionFunct::mtlo, MoveHiLo<InstructionFunct::mtlo>)
+        DECODE(InstructionFunct::mult, MultDiv<InstructionFunct::mult>)
+        DECODE(InstructionFunct::multu, MultDiv<InstructionFunct::multu>)
+        DECODE(InstructionFunct::div, MultDiv<InstructionFunct::div>)
+        DECODE(InstructionFunct::divu, MultDiv<InstructionFunct::divu>)
+        DECODE(InstructionFunct::jr, JumpRegister<false>)
+        DECODE(InstructionFunct::jalr, JumpRegister<true>)
+
+        default:
+          break;
+      }
+    }
+    break;
+
+    case InstructionOp::lui:
+    {
+      // Same as ori from the zero register.
+      inst->rs = Reg::zero;
+      inst->imm = instruction.i.imm_zext32() << 16;
+      inst->handler = &ALUImmediate<InstructionOp::ori>;
+      pure_destination = inst->rt;
+    }
+    break;
+
+    case InstructionOp::andi:
+    case InstructionOp::ori:
+    case InstructionOp::xori:
+    {
+      inst->imm = instruction.i.imm_zext32();
+      if (instruction.op == InstructionOp::andi)
+        inst->handler = &ALUImmediate<InstructionOp::andi>;
+      else if (instruction.op == InstructionOp::ori)
+        inst->handler = &ALUImmediate<InstructionOp::ori>;
+      else
+        inst->handler = &ALUImmediate<InstructionOp::xori>;
+
+      pure_destination = inst->rt;
+    }
+    break;
+
+    DECODE_PURE(InstructionOp::addiu, ALUImmediate<InstructionOp::addiu>, inst->rt)
+    DECODE_PURE(InstructionOp::slti, ALUImmediate<InstructionOp::slti>, inst->rt)
+    DECODE_PURE(InstructionOp::sltiu, ALUImmediate<InstructionOp::sltiu>, inst->rt)
+
+    // Loads to the zero register still access memory, WriteRegDelayed() drops the value.
+    DECODE(InstructionOp::lb, Load<InstructionOp::lb>)
+    DECODE(InstructionOp::lbu, Load<InstructionOp::lbu>)
+    DECODE(InstructionOp::lh, Load<InstructionOp::lh>)
+    DECODE(InstructionOp::lhu, Load<InstructionOp::lhu>)
+    DECODE(InstructionOp::lw, Load<InstructionOp::lw>)
+    DECODE(InstructionOp::sb, Store<InstructionOp::sb>)
+    DECODE(InstructionOp::sh, Store<InstructionOp::sh>)
+    DECODE(InstructionOp::sw, Store<InstructionOp::sw>)
+
+    case InstructionOp::beq:
+    case InstructionOp::bne:
+    case InstructionOp::bgtz:
+    case InstructionOp::blez:
+    {
+      inst->imm = branch_target;
+      if (instruction.op == InstructionOp::beq)
+        inst->handler = &Branch<InstructionOp::beq>;
+      else if (instruction.op == InstructionOp::bne)
+        inst->handler = &Branch<InstructionOp::bne>;
+      else if (instruction.op == InstructionOp::bgtz)
+        inst->handler = &Branch<InstructionOp::bgtz>;
+      else
+        inst->handler = &Branch<InstructionOp::blez>;
+    }
+    break;
+
+    case InstructionOp::b:
+    {
+      const u8 rt = static_cast<u8>(instruction.i.rt.GetValue());
+      const bool bgez = ConvertToBoolUnchecked(rt & u8(1));
+      const bool link = (rt & u8(0x1E)) == u8(0x10);
+      inst->imm = branch_target;
+      if (link)
+        inst->handler = bgez ? &BranchZero<true, true> : &BranchZero<false, true>;
+      else
+        inst->handler = bgez ? &BranchZero<true, false> : &BranchZero<false, false>;
+    }
+    break;
+
+    case InstructionOp::j:
+    case InstructionOp::jal:
+    {
+      inst->imm = jump_target;
+      inst->handler = (instruction.op == InstructionOp::jal) ? &Jump<true> : &Jump<false>;
+    }
+    break;
+
+    case InstructionOp::cop2:
+    {
+      if (!instruction.cop.IsCommonInstruction())
+        inst->handler = &Cop2Command;
+    }
+    break;
+
+    default:
+      break;
+  }
+
+#undef DECODE_PURE
+#undef DECODE
+
+  if (pure_destination == Reg::zero)
+    inst->handler = &Nop;
+}
+
+void PredecodedInterpreter::Interpret(Core* cpu, const Inst& inst)
+{
+  cpu->ExecuteInstruction();
+}
+
+void PredecodedInterpreter::Nop(Core* cpu, const Inst& inst) {}
+
+template<InstructionFunct funct>
+void PredecodedInterpreter::ALURegister(Core* cpu, const Inst& inst)
+{
+  const u32 rs = cpu->ReadReg(inst.rs);
+  const u32 rt = cpu->ReadReg(inst.rt);
+  u32 value;
+  switch (funct)
+  {
+    case InstructionFunct::sll:
+      value = rt << inst.shamt;
+      break;
+    case InstructionFunct::srl:
+      value = rt >> inst.shamt;
+      break;
+    case InstructionFunct::sra:
+      value = static_cast<u32>(static_cast<s32>(rt) >> inst.shamt);
+      break;
+    case InstructionFunct::sllv:
+      value = rt << (rs & UINT32_C(0x1F));
+      break;
+    case InstructionFunct::srlv:
+      value = rt >> (rs & UINT32_C(0x1F));
+      break;
+    case InstructionFunct::srav:
+      value = static_cast<u32>(static_cast<s32>(rt) >> (rs & UINT32_C(0x1F)));
+      break;
+    case InstructionFunct::addu:
+      value = rs + rt;
+      break;
+    case InstructionFunct::subu:
+      value = rs - rt;
+      break;
+    case InstructionFunct::and_:
+      value = rs & rt;
+      break;
+    case InstructionFunct::or_:
+      value = rs | rt;
+      break;
+    case InstructionFunct::xor_:
+      value = rs ^ rt;
+      break;
+    case InstructionFunct::nor:
+      value = ~(rs | rt);
+      break;
+    case InstructionFunct::slt:
+      value = BoolToUInt32(static_cast<s32>(rs) < static_cast<s32>(rt));
+      break;
+    case InstructionFunct::sltu:
+      value = BoolToUInt32(rs < rt);
+      break;
+    default:
+      UnreachableCode();
+      return;
+  }
+
+  cpu->WriteReg(inst.rd, value);
+}
+
+template<InstructionOp op>
+void PredecodedInterpreter::ALUImmediate(Core* cpu, const Inst& inst)
+{
+  const u32 rs = cpu->ReadReg(inst.rs);
+  u32 value;
+  switch (op)
+  {
+    case InstructionOp::addiu:
+      value = rs + inst.imm;
+      break;
+    case InstructionOp::slti:
+      value = BoolToUInt32(static_cast<s32>(rs) < static_cast<s32>(inst.imm));
+      break;
+    case InstructionOp::sltiu:
+      value = BoolToUInt32(rs < inst.imm);
+      break;
+    case InstructionOp::andi:
+      value = rs & inst.imm;
+      break;
+    case InstructionOp::ori:
+      value = rs | inst.imm;
+      break;
+    case InstructionOp::xori:
+      value = rs ^ inst.imm;
+      break;
+    default:
+      UnreachableCode();
+      return;
+  }
+
+  cpu->WriteReg(inst.rt, value);
+}
+
+template<InstructionFunct funct>
+void PredecodedInterpreter::MultDiv(Core* cpu, const Inst& inst)
+{
+  Registers& regs = cpu->m_regs;
+  const u32 lhs = cpu->ReadReg(inst.rs);
+  const u32 rhs = cpu->ReadReg(inst.rt);
+  if constexpr (funct == InstructionFunct::mult)
+  {
+    const u64 result = static_cast<u64>(static_cast<s64>(SignExtend64(lhs)) * static_cast<s64>(SignExtend64(rhs)));
+    regs.hi = Truncate32(result >> 32);
+    regs.lo = Truncate32(result);
+  }
+  else if constexpr (funct == InstructionFunct::multu)
+  {
+    const u64 result = ZeroExtend64(lhs) * ZeroExtend64(rhs);
+    regs.hi = Truncate32(result >> 32);
+    regs.lo = Truncate32(result);
+  }
+  else if constexpr (funct == InstructionFunct::div)
+  {
+    const s32 num = static_cast<s32>(lhs);
+    const s32 denom = static_cast<s32>(rhs);
+    if (denom == 0)
+    {
+      regs.lo = (num >= 0) ? UINT32_C(0xFFFFFFFF) : UINT32_C(1);
+      regs.hi = static_cast<u32>(num);
+    }
+    else if (static_cast<u32>(num) == UINT32_C(0x80000000) && denom == -1)
+    {
+      regs.lo = UINT32_C(0x80000000);
+      regs.hi = 0;
+    }
+    else
+    {
+      regs.lo = static_cast<u32>(num / denom);
+      regs.hi = static_cast<u32>(num % denom);
+    }
+  }
+  else
+  {
+    if (rhs == 0)
+    {
+      regs.lo = UINT32_C(0xFFFFFFFF);
+      regs.hi = lhs;
+    }
+    else
+    {
+      regs.lo = lhs / rhs;
+      regs.hi = lhs % rhs;
+    }
+  }
+}
+
+template<InstructionFunct funct>
+void PredecodedInterpreter::MoveHiLo(Core* cpu, const Inst& inst)
+{
+  if constexpr (funct == InstructionFunct::mfhi)
+    cpu->WriteReg(inst.rd, cpu->m_regs.hi);
+  else if constexpr (funct == InstructionFunct::mflo)
+    cpu->WriteReg(inst.rd, cpu->m_regs.lo);
+  else if constexpr (funct == InstructionFunct::mthi)
+    cpu->m_regs.hi = cpu->ReadReg(inst.rs);
+  else
+    cpu->m_regs.lo = cpu->ReadReg(inst.rs);
+}
+
+template<InstructionOp op>
+void PredecodedInterpreter::Load(Core* cpu, const Inst& inst)
+{
+  // Same as Core::ReadMemoryByte() and friends, inlined.
+  constexpr MemoryAccessSize size =
+    (op == InstructionOp::lb || op == InstructionOp::lbu) ?
+      MemoryAccessSize::Byte :
+      ((op == InstructionOp::lh || op == InstructionOp::lhu) ? MemoryAccessSize::HalfWord : MemoryAccessSize::Word);
+
+  const VirtualMemoryAddress addr = cpu->ReadReg(inst.rs) + inst.imm;
+  if (!cpu->DoAlignmentCheck<MemoryAccessType::Read, size>(addr))
+    return;
+
+  u32 value = 0;
+  const TickCount cycles = cpu->DoMemoryAccess<MemoryAccessType::Read, size>(addr, value);
+  if (cycles < 0)
+  {
+    cpu->RaiseException(Exception::DBE);
+    return;
+  }
+
+  cpu->m_pending_ticks += cycles;
+
+  if constexpr (op == InstructionOp::lb)
+    value = SignExtend32(Truncate8(value));
+  else if constexpr (op == InstructionOp::lbu)
+    value = ZeroExtend32(Truncate8(value));
+  else if constexpr (op == InstructionOp::lh)
+    value = SignExtend32(Truncate16(value));
+  else if constexpr (op == InstructionOp::lhu)
+    value = ZeroExtend32(Truncate16(value));
+
+  cpu->WriteRegDelayed(inst.rt, value);
+}
+
+template<InstructionOp op>
+void PredecodedInterpreter::Store(Core* cpu, const Inst& inst)
+{
+  constexpr MemoryAccessSize size =
+    (op == InstructionOp::sb) ? MemoryAccessSize::Byte :
+                                ((op == InstructionOp::sh) ? MemoryAccessSize::HalfWord : MemoryAccessSize::Word);
+
+  const VirtualMemoryAddress addr = cpu->ReadReg(inst.rs) + inst.imm;
+  u32 value = cpu->ReadReg(inst.rt);
+  if constexpr (op == InstructionOp::sb)
+    value = ZeroExtend32(Truncate8(value));
+  else if constexpr (op == InstructionOp::sh)
+    value = ZeroExtend32(Truncate16(value));
+
+  if (!cpu->DoAlignmentCheck<MemoryAccessType::Write, size>(addr))
+    return;
+
+  if (cpu->DoMemoryAccess<MemoryAccessType::Write, size>(addr, value) < 0)
+    cpu->RaiseException(Exception::DBE);
+}
+
+template<InstructionOp op>
+void PredecodedInterpreter::Branch(Core* cpu, const Inst& inst)
+{
+  // We're still flagged as a branch delay slot even if the branch isn't taken. The target is always aligned.
+  cpu->m_next_instruction_is_branch_delay_slot = true;
+
+  bool taken;
+  if constexpr (op == InstructionOp::beq)
+    taken = (cpu->ReadReg(inst.rs) == cpu->ReadReg(inst.rt));
+  else if constexpr (op == InstructionOp::bne)
+    taken = (cpu->ReadReg(inst.rs) != cpu->ReadReg(inst.rt));
+  else if constexpr (op == InstructionOp::bgtz)
+    taken = (static_cast<s32>(cpu->ReadReg(inst.rs)) > 0);
+  else
+    taken = (static_cast<s32>(cpu->ReadReg(inst.rs)) <= 0);
+
+  if (taken)
+  {
+    cpu->m_regs.npc = inst.imm;
+    cpu->m_branch_was_taken = true;
+  }
+}
+
+template<bool bgez, bool link>
+void PredecodedInterpreter::BranchZero(Core* cpu, const Inst& inst)
+{
+  cpu->m_next_instruction_is_branch_delay_slot = true;
+  const bool taken = (static_cast<s32>(cpu->ReadReg(inst.rs)) < 0) ^ bgez;
+
+  // register is still linked even if the branch isn't taken
+  if constexpr (link)
+    cpu->WriteReg(Reg::ra, cpu->m_regs.npc);
+
+  if (taken)
+  {
+    cpu->m_regs.npc = inst.imm;
+    cpu->m_branch_was_taken = true;
+  }
+}
+
+template<bool link>
+void PredecodedInterpreter::Jump(Core* cpu, const Inst& inst)
+{
+  if constexpr (link)
+    cpu->WriteReg(Reg::ra, cpu->m_regs.npc);
+
+  cpu->m_next_instruction_is_branch_delay_slot = true;
+  cpu->m_regs.npc = inst.imm;
+  cpu->m_branch_was_taken = true;
+}
+
+template<bool link>
+void PredecodedInterpreter::JumpRegister(Core* cpu, const Inst& inst)
+{
+  // The target can be misaligned, so this goes through Core::Branch().
+  cpu->m_next_instruction_is_branch_delay_slot = true;
+  const u32 target = cpu->ReadReg(inst.rs);
+  if constexpr (link)
+    cpu->WriteReg(inst.rd, cpu->m_regs.npc);
+
+  cpu->Branch(target);
+}
+
+void PredecodedInterpreter::Cop2Command(Core* cpu, const Inst& inst)
+{
+  // Let the interpreter raise the exception.
+  if (cpu->InUserMode() && !cpu->m_cop0_regs.sr.CU2)
+  {
+    cpu->ExecuteInstruction();
+    return;
+  }
+
+  cpu->m_cop2.ExecuteInstruction(GTE::Instruction{inst.instruction.bits});
+}
+
+} // namespace CPU
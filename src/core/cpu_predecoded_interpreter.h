@@ -0,0 +1,57 @@
+#pragma once
+#include "cpu_types.h"
+
+namespace CPU {
+
+class Core;
+struct CodeBlock;
+struct CodeBlockDecodedInstruction;
+struct CodeBlockInstruction;
+
+/// Interpreter which decodes each block once, into a handler per instruction with its operands already extracted.
+/// Used when blocks aren't recompiled, and the recompiler isn't available or isn't wanted.
+class PredecodedInterpreter
+{
+public:
+  /// Fills in the decoded instructions of the block from its instructions.
+  static void DecodeBlock(CodeBlock* block);
+
+  /// Runs the decoded instructions of the block. Stops early on an exception, or a taken branch out of a superblock.
+  static void ExecuteBlock(Core* cpu, const CodeBlock& block);
+
+private:
+  using Inst = CodeBlockDecodedInstruction;
+
+  static void DecodeInstruction(const CodeBlockInstruction& cbi, Inst* inst);
+
+  // Instructions which aren't worth a handler of their own go through the full interpreter.
+  static void Interpret(Core* cpu, const Inst& inst);
+  static void Nop(Core* cpu, const Inst& inst);
+
+  template<InstructionFunct funct>
+  static void ALURegister(Core* cpu, const Inst& inst);
+  template<InstructionOp op>
+  static void ALUImmediate(Core* cpu, const Inst& inst);
+  template<InstructionFunct funct>
+  static void MultDiv(Core* cpu, const Inst& inst);
+  template<InstructionFunct funct>
+  static void MoveHiLo(Core* cpu, const Inst& inst);
+
+  template<InstructionOp op>
+  static void Load(Core* cpu, const Inst& inst);
+  template<InstructionOp op>
+  static void Store(Core* cpu, const Inst& inst);
+
+  template<InstructionOp op>
+  static void Branch(Core* cpu, const Inst& inst);
+  template<bool bgez, bool link>
+  static void BranchZero(Core* cpu, const Inst& inst);
+  template<bool link>
+  static void Jump(Core* cpu, const Inst& inst);
+  template<bool link>
+  static void JumpRegister(Core* cpu, const Inst& inst);
+
+  static void Cop2Command(Core* cpu, const Inst& inst);
+};
+
+} // namespace CPU
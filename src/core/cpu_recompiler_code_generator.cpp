@@ -1,4 +1,5 @@
 #include "cpu_recompiler_code_generator.h"
+#include "bus.h"
 #include "common/log.h"
 #include "cpu_core.h"
 #include "cpu_disasm.h"
@@ -16,13 +17,18 @@ u32 CodeGenerator::CalculateRegisterOffset(Reg reg)
 }
 
 bool CodeGenerator::CompileBlock(const CodeBlock* block, CodeBlock::HostCodePointer* out_host_code,
-                                 u32* out_host_code_size)
+                                 u32* out_host_code_size, std::vector<CodeBlockExit>* out_exits,
+                                 std::vector<LoadStoreBackpatchInfo>* out_backpatch_info)
 {
   // TODO: Align code buffer.
 
   m_block = block;
   m_block_start = block->instructions.data();
   m_block_end = block->instructions.data() + block->instructions.size();
+  m_exits = out_exits;
+  m_backpatch_info = out_backpatch_info;
+  CalculateExitTargets();
+  CalculateDeadGuestRegisters();
 
   EmitBeginBlock();
   BlockPrologue();
@@ -38,12 +44,19 @@ bool CodeGenerator::CompileBlock(const CodeBlock* block, CodeBlock::HostCodePoin
 
     if (!CompileInstruction(*cbi))
     {
+      m_exits->clear();
+      m_exits = nullptr;
+      m_backpatch_info->clear();
+      m_backpatch_info = nullptr;
       m_block_end = nullptr;
       m_block_start = nullptr;
       m_block = nullptr;
       return false;
     }
 
+    if (cbi->is_branch_delay_slot && !cbi->is_branch_instruction && (cbi + 1) != m_block_end)
+      GenerateSideExit(*(cbi - 1), *(cbi + 1));
+
     cbi++;
   }
 
@@ -51,11 +64,23 @@ bool CodeGenerator::CompileBlock(const CodeBlock* block, CodeBlock::HostCodePoin
   EmitEndBlock();
 
   FinalizeBlock(out_host_code, out_host_code_size);
-  Log_ProfilePrintf("JIT block 0x%08X: %zu instructions (%u bytes), %u host bytes", block->GetPC(),
-                    block->instructions.size(), block->GetSizeInBytes(), *out_host_code_size);
+
+  u32 load_count = 0;
+  u32 skipped_load_delay_count = 0;
+  for (const CodeBlockInstruction& block_cbi : block->instructions)
+  {
+    load_count += BoolToUInt32(block_cbi.has_load_delay);
+    skipped_load_delay_count += BoolToUInt32(block_cbi.can_skip_load_delay);
+  }
+
+  Log_ProfilePrintf("JIT block 0x%08X: %zu instructions (%u bytes), %u host bytes, %u/%u loads without delay",
+                    block->GetPC(), block->instructions.size(), block->GetSizeInBytes(), *out_host_code_size,
+                    skipped_load_delay_count, load_count);
 
   DebugAssert(m_register_cache.GetUsedHostRegisters() == 0);
 
+  m_exits = nullptr;
+  m_backpatch_info = nullptr;
   m_block_end = nullptr;
   m_block_start = nullptr;
   m_block = nullptr;
@@ -827,6 +852,13 @@ void CodeGenerator::BlockPrologue()
 {
   EmitStoreCPUStructField(offsetof(Core, m_exception_raised), Value::FromConstantU8(0));
 
+  // Linked blocks jump straight here, so the dispatcher can't count them.
+  if (m_cpu->m_block_profiling_enabled)
+  {
+    EmitFunctionCall(nullptr, &CodeCache::EnterProfiledBlock, m_register_cache.GetCPUPtr(),
+                     Value::FromConstantU64(static_cast<u64>(reinterpret_cast<uintptr_t>(m_block))));
+  }
+
   // we don't know the state of the last block, so assume load delays might be in progress
   // TODO: Pull load delay into register cache
   m_current_instruction_in_branch_delay_slot_dirty = true;
@@ -848,6 +880,294 @@ void CodeGenerator::BlockEpilogue()
   AddPendingCycles(true);
 }
 
+bool CodeGenerator::ShouldUseFastmem(const Value& address, RegSize size) const
+{
+  if (!m_cpu->m_fastmem_base)
+    return false;
+
+  // Constant addresses are usually I/O registers, which would fault every time until backpatched.
+  if (!address.IsConstant())
+    return true;
+
+  const VirtualMemoryAddress constant_address = static_cast<VirtualMemoryAddress>(address.constant_value);
+  const u32 alignment_mask = (size == RegSize_32) ? 3 : ((size == RegSize_16) ? 1 : 0);
+  return Bus::IsFastmemAddress(constant_address) && (constant_address & alignment_mask) == 0;
+}
+
+bool CodeGenerator::IsScratchpadAddress(const Value& address, RegSize size)
+{
+  if (!address.IsConstant())
+    return false;
+
+  // Only KUSEG and KSEG0 go through the data cache, misaligned accesses have to raise an exception.
+  const VirtualMemoryAddress constant_address = static_cast<VirtualMemoryAddress>(address.constant_value);
+  const u32 segment = constant_address >> 29;
+  const u32 alignment_mask = (size == RegSize_32) ? 3 : ((size == RegSize_16) ? 1 : 0);
+  return (segment == 0x00 || segment == 0x04) &&
+         (constant_address & Core::DCACHE_LOCATION_MASK & PHYSICAL_MEMORY_ADDRESS_MASK) == Core::DCACHE_LOCATION &&
+         (constant_address & alignment_mask) == 0;
+}
+
+Value CodeGenerator::EmitLoadScratchpad(const Value& address, RegSize size)
+{
+  const u32 offset = static_cast<u32>(address.constant_value) & Core::DCACHE_OFFSET_MASK;
+  Value result = m_register_cache.AllocateScratch(RegSize_32);
+  EmitLoadCPUStructField(result.host_reg, size, static_cast<u32>(offsetof(Core, m_dcache)) + offset);
+  if (size != RegSize_32)
+    result.size = size;
+
+  return result;
+}
+
+void CodeGenerator::EmitStoreScratchpad(const Value& address, const Value& value)
+{
+  const u32 offset = static_cast<u32>(address.constant_value) & Core::DCACHE_OFFSET_MASK;
+
+  // Writes are dropped while the cache is isolated.
+  LabelType skip_store;
+  Value sr = m_register_cache.AllocateScratch(RegSize_32);
+  EmitLoadCPUStructField(sr.host_reg, RegSize_32, offsetof(Core, m_cop0_regs.sr.bits));
+  EmitTest(sr.host_reg, Value::FromConstantU32(UINT32_C(1) << 16));
+  sr.ReleaseAndClear();
+  EmitConditionalBranch(Condition::NotZero, false, &skip_store);
+  EmitStoreCPUStructField(static_cast<u32>(offsetof(Core, m_dcache)) + offset, value);
+  EmitBindLabel(&skip_store);
+}
+
+void CodeGenerator::CalculateExitTargets()
+{
+  m_num_exit_targets = 0;
+
+  const CodeBlockInstruction* branch = nullptr;
+  for (const CodeBlockInstruction* cbi = m_block_start; cbi != m_block_end; cbi++)
+  {
+    // cop0 instructions can switch between user and kernel mode, and branches in delay slots are rare enough that
+    // it's not worth handling them. Earlier branches in superblocks have their own exits.
+    if (cbi->instruction.op == InstructionOp::cop0 || (cbi->is_branch_instruction && cbi->is_branch_delay_slot))
+      return;
+
+    if (cbi->is_branch_instruction)
+      branch = cbi;
+  }
+
+  const CodeBlockInstruction& last = *(m_block_end - 1);
+  if (!branch)
+  {
+    // syscall/break always raise an exception.
+    if (!IsExitBlockInstruction(last.instruction))
+      m_exit_targets[m_num_exit_targets++] = last.pc + 4;
+
+    return;
+  }
+
+  // The delay slot should be the last instruction.
+  if ((m_block_end - branch) != 2)
+    return;
+
+  switch (branch->instruction.op)
+  {
+    case InstructionOp::j:
+    case InstructionOp::jal:
+      m_exit_targets[m_num_exit_targets++] =
+        ((branch->pc + 4) & UINT32_C(0xF0000000)) | (branch->instruction.j.target << 2);
+      break;
+
+    case InstructionOp::b:
+    case InstructionOp::beq:
+    case InstructionOp::bne:
+    case InstructionOp::bgtz:
+    case InstructionOp::blez:
+      m_exit_targets[m_num_exit_targets++] = branch->pc + 4 + (branch->instruction.i.imm_sext32() << 2);
+      m_exit_targets[m_num_exit_targets++] = branch->pc + 8;
+      break;
+
+    default:
+      // Register jumps go wherever, so they return to the dispatcher.
+      break;
+  }
+}
+
+void CodeGenerator::GenerateSideExit(const CodeBlockInstruction& branch, const CodeBlockInstruction& next_cbi)
+{
+  const u32 taken_pc = branch.pc + 4 + (branch.instruction.i.imm_sext32() << 2);
+
+  // The branch left the new PC in a register. When it wasn't taken, carry on with the cached registers.
+  Value pc = m_register_cache.ReadGuestRegister(Reg::pc, true, true);
+  LabelType not_taken;
+  EmitConditionalBranch(Condition::Equal, false, pc.host_reg, Value::FromConstantU32(next_cbi.pc), &not_taken);
+
+  // Same as the end of the block, but the state is only written back on this path.
+  const bool load_delay_dirty = m_load_delay_dirty;
+  m_register_cache.PushState();
+  EmitBranch(GetCurrentFarCodePointer());
+
+  SwitchToFarCode();
+  m_register_cache.FlushAllGuestRegisters(true, true);
+  if (m_register_cache.HasLoadDelay())
+    m_register_cache.WriteLoadDelayToCPU(true);
+  AddPendingCycles(false);
+  EmitBlockExit(&taken_pc, 1, false);
+  SwitchToNearCode();
+
+  m_register_cache.PopState();
+  m_load_delay_dirty = load_delay_dirty;
+  EmitBindLabel(&not_taken);
+
+  // The next instruction sets the PC as a constant again.
+  m_register_cache.InvalidateGuestRegister(Reg::pc);
+}
+
+// Guest registers which an instruction reads and writes. Returns false if the instruction can raise an exception or
+// is compiled as a call to the interpreter, either of which can see every register.
+static bool GetGuestRegisterUsage(const CodeBlockInstruction& cbi, u64* reads, u64* writes)
+{
+  const Instruction inst = cbi.instruction;
+  auto Bit = [](Reg reg) { return UINT64_C(1) << static_cast<u8>(reg); };
+
+  switch (inst.op)
+  {
+    case InstructionOp::ori:
+    case InstructionOp::andi:
+    case InstructionOp::xori:
+    case InstructionOp::addiu:
+    case InstructionOp::slti:
+    case InstructionOp::sltiu:
+      *reads = Bit(inst.i.rs);
+      *writes = Bit(inst.i.rt);
+      return true;
+
+    case InstructionOp::lui:
+      *reads = 0;
+      *writes = Bit(inst.i.rt);
+      return true;
+
+    case InstructionOp::funct:
+    {
+      switch (inst.r.funct)
+      {
+        case InstructionFunct::sll:
+        case InstructionFunct::srl:
+        case InstructionFunct::sra:
+          *reads = Bit(inst.r.rt);
+          *writes = Bit(inst.r.rd);
+          return true;
+
+        case InstructionFunct::sllv:
+        case InstructionFunct::srlv:
+        case InstructionFunct::srav:
+        case InstructionFunct::and_:
+        case InstructionFunct::or_:
+        case InstructionFunct::xor_:
+        case InstructionFunct::nor:
+        case InstructionFunct::addu:
+        case InstructionFunct::subu:
+        case InstructionFunct::slt:
+        case InstructionFunct::sltu:
+          *reads = Bit(inst.r.rs) | Bit(inst.r.rt);
+          *writes = Bit(inst.r.rd);
+          return true;
+
+        case InstructionFunct::mfhi:
+          *reads = Bit(Reg::hi);
+          *writes = Bit(inst.r.rd);
+          return true;
+
+        case InstructionFunct::mflo:
+          *reads = Bit(Reg::lo);
+          *writes = Bit(inst.r.rd);
+          return true;
+
+        case InstructionFunct::mthi:
+          *reads = Bit(inst.r.rs);
+          *writes = Bit(Reg::hi);
+          return true;
+
+        case InstructionFunct::mtlo:
+          *reads = Bit(inst.r.rs);
+          *writes = Bit(Reg::lo);
+          return true;
+
+        case InstructionFunct::mult:
+        case InstructionFunct::multu:
+          *reads = Bit(inst.r.rs) | Bit(inst.r.rt);
+          *writes = Bit(Reg::hi) | Bit(Reg::lo);
+          return true;
+
+        default:
+          return false;
+      }
+    }
+
+    case InstructionOp::cop2:
+    {
+      // GTE commands only touch GTE registers, and are called without flushing the register cache.
+      if (inst.cop.IsCommonInstruction())
+        return false;
+
+      *reads = 0;
+      *writes = 0;
+      return true;
+    }
+
+    default:
+      return false;
+  }
+}
+
+void CodeGenerator::CalculateDeadGuestRegisters()
+{
+  // Walk backwards, tracking which registers are read before they're next written. Everything is live at the block
+  // end and at side exits, and before instructions which could see the whole register file.
+  static constexpr u64 ALL_REGISTERS = ~UINT64_C(0);
+  const size_t count = static_cast<size_t>(m_block_end - m_block_start);
+  m_dead_guest_registers.resize(count);
+
+  u64 live = ALL_REGISTERS;
+  for (size_t i = count; i > 0; i--)
+  {
+    const CodeBlockInstruction& cbi = m_block_start[i - 1];
+    if (cbi.is_branch_delay_slot || cbi.is_last_instruction)
+      live = ALL_REGISTERS;
+
+    m_dead_guest_registers[i - 1] = ~live;
+
+    u64 reads, writes;
+    if (GetGuestRegisterUsage(cbi, &reads, &writes))
+      live = (live & ~writes) | reads;
+    else
+      live = ALL_REGISTERS;
+  }
+}
+
+void CodeGenerator::DiscardDeadGuestRegisters(const CodeBlockInstruction& cbi)
+{
+  const u64 dead = m_dead_guest_registers[&cbi - m_block_start];
+  if (dead == 0)
+    return;
+
+  for (u8 reg = 1; reg < static_cast<u8>(Reg::pc); reg++)
+  {
+    if ((dead & (UINT64_C(1) << reg)) && m_register_cache.IsGuestRegisterCached(static_cast<Reg>(reg)))
+    {
+      Log_DebugPrintf("Discarding dead guest register %s", GetRegName(static_cast<Reg>(reg)));
+      m_register_cache.InvalidateGuestRegister(static_cast<Reg>(reg));
+    }
+  }
+}
+
+void CodeGenerator::WriteLoadDelayedGuestRegister(const CodeBlockInstruction& cbi, Reg guest_reg, Value&& value)
+{
+  if (!cbi.can_skip_load_delay)
+  {
+    m_register_cache.WriteGuestRegisterDelayed(guest_reg, std::move(value));
+    return;
+  }
+
+  // A load delay left over from the previous block can still be flushed to the CPU struct at the end of this
+  // instruction, but the register stays dirty in the cache, so this value is the one written back.
+  m_register_cache.WriteGuestRegister(guest_reg, std::move(value));
+}
+
 void CodeGenerator::InstructionPrologue(const CodeBlockInstruction& cbi, TickCount cycles,
                                         bool force_sync /* = false */)
 {
@@ -924,6 +1244,8 @@ void CodeGenerator::InstructionEpilogue(const CodeBlockInstruction& cbi)
     m_next_load_delay_dirty = false;
     m_load_delay_dirty = true;
   }
+
+  DiscardDeadGuestRegisters(cbi);
 }
 
 void CodeGenerator::AddPendingCycles(bool commit)
@@ -1109,23 +1431,29 @@ bool CodeGenerator::Compile_Load(const CodeBlockInstruction& cbi)
   Value offset = Value::FromConstantU32(cbi.instruction.i.imm_sext32());
   Value address = AddValues(base, offset, false);
 
+  // Addresses built from lui/ori/addiu are constant by now, scratchpad accesses don't need the memory handlers.
+  auto DoLoad = [this, &cbi, &address](RegSize size) {
+    return IsScratchpadAddress(address, size) ? EmitLoadScratchpad(address, size) :
+                                                EmitLoadGuestMemory(cbi, address, size);
+  };
+
   Value result;
   switch (cbi.instruction.op)
   {
     case InstructionOp::lb:
     case InstructionOp::lbu:
-      result = EmitLoadGuestMemory(cbi, address, RegSize_8);
+      result = DoLoad(RegSize_8);
       ConvertValueSizeInPlace(&result, RegSize_32, (cbi.instruction.op == InstructionOp::lb));
       break;
 
     case InstructionOp::lh:
     case InstructionOp::lhu:
-      result = EmitLoadGuestMemory(cbi, address, RegSize_16);
+      result = DoLoad(RegSize_16);
       ConvertValueSizeInPlace(&result, RegSize_32, (cbi.instruction.op == InstructionOp::lh));
       break;
 
     case InstructionOp::lw:
-      result = EmitLoadGuestMemory(cbi, address, RegSize_32);
+      result = DoLoad(RegSize_32);
       break;
 
     default:
@@ -1133,7 +1461,7 @@ bool CodeGenerator::Compile_Load(const CodeBlockInstruction& cbi)
       break;
   }
 
-  m_register_cache.WriteGuestRegisterDelayed(cbi.instruction.i.rt, std::move(result));
+  WriteLoadDelayedGuestRegister(cbi, cbi.instruction.i.rt, std::move(result));
 
   InstructionEpilogue(cbi);
   return true;
@@ -1149,18 +1477,25 @@ bool CodeGenerator::Compile_Store(const CodeBlockInstruction& cbi)
   Value address = AddValues(base, offset, false);
   Value value = m_register_cache.ReadGuestRegister(cbi.instruction.i.rt);
 
+  auto DoStore = [this, &cbi, &address](const Value& store_value) {
+    if (IsScratchpadAddress(address, store_value.size))
+      EmitStoreScratchpad(address, store_value);
+    else
+      EmitStoreGuestMemory(cbi, address, store_value);
+  };
+
   switch (cbi.instruction.op)
   {
     case InstructionOp::sb:
-      EmitStoreGuestMemory(cbi, address, value.ViewAsSize(RegSize_8));
+      DoStore(value.ViewAsSize(RegSize_8));
       break;
 
     case InstructionOp::sh:
-      EmitStoreGuestMemory(cbi, address, value.ViewAsSize(RegSize_16));
+      DoStore(value.ViewAsSize(RegSize_16));
       break;
 
     case InstructionOp::sw:
-      EmitStoreGuestMemory(cbi, address, value);
+      DoStore(value);
       break;
 
     default:
@@ -1609,7 +1944,7 @@ bool CodeGenerator::Compile_cop0(const CodeBlockInstruction& cbi)
           // coprocessor loads are load-delayed
           Value value = m_register_cache.AllocateScratch(RegSize_32);
           EmitLoadCPUStructField(value.host_reg, value.size, offset);
-          m_register_cache.WriteGuestRegisterDelayed(cbi.instruction.r.rt, std::move(value));
+          WriteLoadDelayedGuestRegister(cbi, cbi.instruction.r.rt, std::move(value));
         }
         else
         {
@@ -1690,7 +2025,7 @@ Value CodeGenerator::DoGTERegisterRead(u32 index)
 
     default:
     {
-      EmitLoadCPUStructField(value.host_reg, RegSize_32, offsetof(Core, m_cop2.m_regs.r32[index]));
+      EmitLoadCPUStructField(value.host_reg, RegSize_32, offsetof(Core, m_cop2.m_regs.r32[0]) + (index * sizeof(u32)));
     }
     break;
   }
@@ -1719,7 +2054,7 @@ void CodeGenerator::DoGTERegisterWrite(u32 index, const Value& value)
     {
       // sign-extend z component of vector registers
       Value temp = ConvertValueSize(value.ViewAsSize(RegSize_16), RegSize_32, true);
-      EmitStoreCPUStructField(offsetof(Core, m_cop2.m_regs.r32[index]), temp);
+      EmitStoreCPUStructField(offsetof(Core, m_cop2.m_regs.r32[0]) + (index * sizeof(u32)), temp);
       return;
     }
     break;
@@ -1732,7 +2067,7 @@ void CodeGenerator::DoGTERegisterWrite(u32 index, const Value& value)
     {
       // zero-extend unsigned values
       Value temp = ConvertValueSize(value.ViewAsSize(RegSize_16), RegSize_32, false);
-      EmitStoreCPUStructField(offsetof(Core, m_cop2.m_regs.r32[index]), temp);
+      EmitStoreCPUStructField(offsetof(Core, m_cop2.m_regs.r32[0]) + (index * sizeof(u32)), temp);
       return;
     }
     break;
@@ -1775,7 +2110,7 @@ void CodeGenerator::DoGTERegisterWrite(u32 index, const Value& value)
     default:
     {
       // written as-is, 2x16 or 1x32 bits
-      EmitStoreCPUStructField(offsetof(Core, m_cop2.m_regs.r32[index]), value);
+      EmitStoreCPUStructField(offsetof(Core, m_cop2.m_regs.r32[0]) + (index * sizeof(u32)), value);
       return;
     }
   }
@@ -1818,7 +2153,7 @@ bool CodeGenerator::Compile_cop2(const CodeBlockInstruction& cbi)
                         ((cbi.instruction.cop.CommonOp() == CopCommonInstruction::cfcn) ? 32 : 0);
 
         InstructionPrologue(cbi, 1);
-        m_register_cache.WriteGuestRegisterDelayed(cbi.instruction.r.rt, DoGTERegisterRead(reg));
+        WriteLoadDelayedGuestRegister(cbi, cbi.instruction.r.rt, DoGTERegisterRead(reg));
         InstructionEpilogue(cbi);
         return true;
       }
@@ -1841,11 +2176,11 @@ bool CodeGenerator::Compile_cop2(const CodeBlockInstruction& cbi)
   }
   else
   {
-    // forward everything to the GTE.
+    // call the GTE's entry point for this command directly, the operands are already decoded.
     InstructionPrologue(cbi, 1);
 
-    Value instruction_bits = Value::FromConstantU32(cbi.instruction.bits & GTE::Instruction::REQUIRED_BITS_MASK);
-    EmitFunctionCall(nullptr, &Thunks::ExecuteGTEInstruction, m_register_cache.GetCPUPtr(), instruction_bits);
+    const GTE::Core::InstructionImpl impl = GTE::Core::GetInstructionImpl(GTE::Instruction{cbi.instruction.bits});
+    EmitFunctionCall(nullptr, impl, Value::FromConstantU64(reinterpret_cast<uintptr_t>(&m_cpu->m_cop2)));
 
     InstructionEpilogue(cbi);
     return true;
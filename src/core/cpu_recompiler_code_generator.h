@@ -23,13 +23,24 @@ public:
   static const char* GetHostRegName(HostReg reg, RegSize size = HostPointerSize);
   static void AlignCodeBuffer(JitCodeBuffer* code_buffer);
 
-  bool CompileBlock(const CodeBlock* block, CodeBlock::HostCodePointer* out_host_code, u32* out_host_code_size);
+  bool CompileBlock(const CodeBlock* block, CodeBlock::HostCodePointer* out_host_code, u32* out_host_code_size,
+                    std::vector<CodeBlockExit>* out_exits, std::vector<LoadStoreBackpatchInfo>* out_backpatch_info);
+
+  /// Redirects a block exit's jump to the specified code. Only defined on hosts with SUPPORTS_BLOCK_LINKING.
+  static void PatchExitJump(void* jump_code, const void* target);
+
+  /// Replaces a fastmem access with a jump to its slow path. Only defined on hosts with SUPPORTS_FASTMEM.
+  static void BackpatchLoadStore(const LoadStoreBackpatchInfo& info);
 
   //////////////////////////////////////////////////////////////////////////
   // Code Generation
   //////////////////////////////////////////////////////////////////////////
   void EmitBeginBlock();
   void EmitEndBlock();
+
+  /// Returns from the block, or jumps to the block linked to the guest PC if it's one of the exit targets.
+  void EmitBlockExit(const u32* exit_targets, u32 num_exit_targets, bool commit);
+
   void EmitExceptionExit();
   void EmitExceptionExitOnBool(const Value& value);
   void FinalizeBlock(CodeBlock::HostCodePointer* out_host_code, u32* out_host_code_size);
@@ -67,6 +78,16 @@ public:
   Value EmitLoadGuestMemory(const CodeBlockInstruction& cbi, const Value& address, RegSize size);
   void EmitStoreGuestMemory(const CodeBlockInstruction& cbi, const Value& address, const Value& value);
 
+  // Accesses through the fastmem range, with the slow path in far code.
+  void EmitLoadGuestMemoryFastmem(const CodeBlockInstruction& cbi, const Value& address, RegSize size, Value& result);
+  void EmitStoreGuestMemoryFastmem(const CodeBlockInstruction& cbi, const Value& address, const Value& value);
+
+  // Accesses through the memory handlers. in_far_code is set when this is the slow path of a fastmem access.
+  void EmitLoadGuestMemorySlowmem(const CodeBlockInstruction& cbi, const Value& address, RegSize size, Value& result,
+                                  bool in_far_code);
+  void EmitStoreGuestMemorySlowmem(const CodeBlockInstruction& cbi, const Value& address, const Value& value,
+                                   Value& result, bool in_far_code);
+
   // Unconditional branch to pointer. May allocate a scratch register.
   void EmitBranch(const void* address, bool allow_scratch = true);
 
@@ -166,6 +187,29 @@ private:
   void SetCurrentInstructionPC(const CodeBlockInstruction& cbi);
   void AddPendingCycles(bool commit);
 
+  /// Determines which PCs the block can continue at without changing the CPU mode, for linking.
+  void CalculateExitTargets();
+
+  /// Leaves a superblock after the delay slot of a branch in the middle of it, if the branch was taken.
+  void GenerateSideExit(const CodeBlockInstruction& branch, const CodeBlockInstruction& next_cbi);
+
+  /// Finds the guest registers which are overwritten after each instruction, before anything could read them.
+  void CalculateDeadGuestRegisters();
+
+  /// Drops cached guest registers which are dead after the instruction, so they are never written back.
+  void DiscardDeadGuestRegisters(const CodeBlockInstruction& cbi);
+
+  /// Writes the result of a load-delayed instruction, directly if nothing can see the old value in the delay slot.
+  void WriteLoadDelayedGuestRegister(const CodeBlockInstruction& cbi, Reg guest_reg, Value&& value);
+
+  /// Returns true if the constant address is in the scratchpad, which is then accessed directly.
+  static bool IsScratchpadAddress(const Value& address, RegSize size);
+  Value EmitLoadScratchpad(const Value& address, RegSize size);
+  void EmitStoreScratchpad(const Value& address, const Value& value);
+
+  /// Returns true if a load or store at address should be compiled as a fastmem access.
+  bool ShouldUseFastmem(const Value& address, RegSize size) const;
+
   Value DoGTERegisterRead(u32 index);
   void DoGTERegisterWrite(u32 index, const Value& value);
 
@@ -201,6 +245,16 @@ private:
 
   TickCount m_delayed_cycles_add = 0;
 
+  // PCs which can be linked to at the end of the block.
+  std::array<u32, 2> m_exit_targets = {};
+  u32 m_num_exit_targets = 0;
+  std::vector<CodeBlockExit>* m_exits = nullptr;
+
+  // Mask of guest registers which are dead after each instruction, indexed like the block's instructions.
+  std::vector<u64> m_dead_guest_registers;
+
+  std::vector<LoadStoreBackpatchInfo>* m_backpatch_info = nullptr;
+
   // whether various flags need to be reset.
   bool m_current_instruction_in_branch_delay_slot_dirty = false;
   bool m_branch_was_taken_dirty = false;
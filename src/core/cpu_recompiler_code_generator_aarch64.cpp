@@ -176,8 +176,14 @@ void CodeGenerator::EmitBeginBlock()
 
 void CodeGenerator::EmitEndBlock()
 {
+  EmitBlockExit(m_exit_targets.data(), m_num_exit_targets, true);
+}
+
+void CodeGenerator::EmitBlockExit(const u32* exit_targets, u32 num_exit_targets, bool commit)
+{
+  // Blocks don't have linkable exits on AArch64 yet (SUPPORTS_BLOCK_LINKING), so they always return to the dispatcher.
   m_register_cache.FreeHostReg(RCPUPTR);
-  m_register_cache.PopCalleeSavedRegisters(true);
+  m_register_cache.PopCalleeSavedRegisters(commit);
 
   m_emit->Add(a64::sp, a64::sp, FUNCTION_STACK_SIZE);
   m_emit->Ret();
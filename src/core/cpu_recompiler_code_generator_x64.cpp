@@ -1,6 +1,8 @@
+#include "bus.h"
 #include "cpu_core.h"
 #include "cpu_recompiler_code_generator.h"
 #include "cpu_recompiler_thunks.h"
+#include <cstring>
 
 namespace CPU::Recompiler {
 
@@ -192,12 +194,99 @@ void CodeGenerator::EmitBeginBlock()
 
 void CodeGenerator::EmitEndBlock()
 {
+  EmitBlockExit(m_exit_targets.data(), m_num_exit_targets, true);
+}
+
+void CodeGenerator::EmitBlockExit(const u32* exit_targets, u32 num_exit_targets, bool commit)
+{
+  // The CPU pointer register is callee-saved, so pass it on in the argument register for linked blocks.
+  if (num_exit_targets > 0)
+    m_emit->mov(GetHostReg64(RARG1), GetCPUPtrReg());
+
   m_register_cache.FreeHostReg(RCPUPTR);
-  m_register_cache.PopCalleeSavedRegisters(true);
+  m_register_cache.PopCalleeSavedRegisters(commit);
+
+  if (num_exit_targets == 0)
+  {
+    m_emit->ret();
+    return;
+  }
+
+  // The stack is now the same as when the block was called, so linked blocks are entered with a jump, and return
+  // straight to the dispatcher. Like the dispatcher, stop when the timeslice ends or an interrupt is pending.
+  const Xbyak::Reg64 cpu = GetHostReg64(RARG1);
+  const Xbyak::Reg32 temp = GetHostReg32(RRETURN);
+  Xbyak::Label return_label;
+  Xbyak::Label no_interrupt_label;
+  m_emit->mov(temp, m_emit->dword[cpu + offsetof(Core, m_pending_ticks)]);
+  m_emit->cmp(temp, m_emit->dword[cpu + offsetof(Core, m_downcount)]);
+  m_emit->jge(return_label, Xbyak::CodeGenerator::T_NEAR);
+  m_emit->mov(temp, m_emit->dword[cpu + offsetof(Core, m_cop0_regs.cause.bits)]);
+  m_emit->and_(temp, m_emit->dword[cpu + offsetof(Core, m_cop0_regs.sr.bits)]);
+  m_emit->test(temp, UINT32_C(0xFF00));
+  m_emit->jz(no_interrupt_label);
+  m_emit->test(m_emit->byte[cpu + offsetof(Core, m_cop0_regs.sr.bits)], 1);
+  m_emit->jnz(return_label, Xbyak::CodeGenerator::T_NEAR);
+  m_emit->L(no_interrupt_label);
+
+  m_emit->mov(temp, m_emit->dword[cpu + offsetof(Core, m_regs.pc)]);
+  for (u32 i = 0; i < num_exit_targets; i++)
+  {
+    Xbyak::Label next_label;
+    Xbyak::Label unlinked_label;
+    m_emit->cmp(temp, exit_targets[i]);
+    m_emit->jne(next_label);
+
+    // Patched to the linked block's code, falls through when unlinked.
+    CodeBlockExit exit;
+    exit.target_pc = exit_targets[i];
+    exit.jump_code = GetCurrentCodePointer();
+    m_emit->jmp(unlinked_label, Xbyak::CodeGenerator::T_NEAR);
+    m_emit->L(unlinked_label);
+    exit.unlinked_code = GetCurrentCodePointer();
+    m_exits->push_back(exit);
+
+    // Let the dispatcher know which block to link.
+    m_emit->mov(GetHostReg64(RRETURN), reinterpret_cast<uintptr_t>(m_block));
+    m_emit->mov(m_emit->qword[cpu + offsetof(Core, m_unlinked_exit_block)], GetHostReg64(RRETURN));
+    m_emit->ret();
+    m_emit->L(next_label);
+  }
 
+  m_emit->L(return_label);
   m_emit->ret();
 }
 
+void CodeGenerator::BackpatchLoadStore(const LoadStoreBackpatchInfo& info)
+{
+  // jmp rel32, then pad out the rest of the access.
+  u8* code = static_cast<u8*>(info.host_code);
+  Assert(info.host_code_size >= 5);
+
+  const s64 displacement =
+    static_cast<s64>(reinterpret_cast<intptr_t>(info.slow_code) - reinterpret_cast<intptr_t>(code + 5));
+  Assert(Xbyak::inner::IsInInt32(static_cast<u64>(displacement)));
+
+  const s32 displacement32 = static_cast<s32>(displacement);
+  code[0] = 0xE9;
+  std::memcpy(code + 1, &displacement32, sizeof(displacement32));
+  std::memset(code + 5, 0x90, info.host_code_size - 5);
+  JitCodeBuffer::FlushInstructionCache(code, info.host_code_size);
+}
+
+void CodeGenerator::PatchExitJump(void* jump_code, const void* target)
+{
+  // jmp rel32
+  u8* code = static_cast<u8*>(jump_code);
+  DebugAssert(code[0] == 0xE9);
+
+  const s64 displacement = static_cast<s64>(reinterpret_cast<intptr_t>(target) - reinterpret_cast<intptr_t>(code + 5));
+  Assert(Xbyak::inner::IsInInt32(static_cast<u64>(displacement)));
+
+  const s32 displacement32 = static_cast<s32>(displacement);
+  std::memcpy(code + 1, &displacement32, sizeof(displacement32));
+}
+
 void CodeGenerator::EmitExceptionExit()
 {
   AddPendingCycles(false);
@@ -1635,12 +1724,110 @@ void CodeGenerator::EmitAddCPUStructField(u32 offset, const Value& value)
 
 Value CodeGenerator::EmitLoadGuestMemory(const CodeBlockInstruction& cbi, const Value& address, RegSize size)
 {
-  const Value pc = Value::FromConstantU32(cbi.pc);
   AddPendingCycles(true);
 
   // We need to use the full 64 bits here since we test the sign bit result.
   Value result = m_register_cache.AllocateScratch(RegSize_64);
 
+  if (ShouldUseFastmem(address, size))
+    EmitLoadGuestMemoryFastmem(cbi, address, size, result);
+  else
+    EmitLoadGuestMemorySlowmem(cbi, address, size, result, false);
+
+  // Downcast to ignore upper 56/48/32 bits. This should be a noop.
+  switch (size)
+  {
+    case RegSize_8:
+      ConvertValueSizeInPlace(&result, RegSize_8, false);
+      break;
+
+    case RegSize_16:
+      ConvertValueSizeInPlace(&result, RegSize_16, false);
+      break;
+
+    case RegSize_32:
+      ConvertValueSizeInPlace(&result, RegSize_32, false);
+      break;
+
+    default:
+      UnreachableCode();
+      break;
+  }
+
+  return result;
+}
+
+void CodeGenerator::EmitLoadGuestMemoryFastmem(const CodeBlockInstruction& cbi, const Value& address, RegSize size,
+                                               Value& result)
+{
+  // The slow path is emitted to far code after the fast path, so it starts at the current far code pointer. Misaligned
+  // addresses jump to it directly, and it's backpatched in if the access faults.
+  void* slow_code = GetCurrentFarCodePointer();
+
+  Value host_address = m_register_cache.AllocateScratch(RegSize_64);
+  if (address.IsConstant())
+  {
+    m_emit->mov(GetHostReg32(host_address.host_reg), static_cast<u32>(address.constant_value));
+  }
+  else
+  {
+    if (size != RegSize_8)
+    {
+      m_emit->test(GetHostReg32(address.host_reg), (size == RegSize_32) ? 3 : 1);
+      m_emit->jnz(slow_code);
+    }
+
+    // Clears the upper 32 bits of the address.
+    m_emit->mov(GetHostReg32(host_address.host_reg), GetHostReg32(address.host_reg));
+  }
+  m_emit->add(GetHostReg64(host_address), m_emit->qword[GetCPUPtrReg() + offsetof(Core, m_fastmem_base)]);
+
+  LoadStoreBackpatchInfo bpi;
+  bpi.host_code = GetCurrentNearCodePointer();
+  bpi.slow_code = slow_code;
+
+  switch (size)
+  {
+    case RegSize_8:
+      m_emit->movzx(GetHostReg32(result.host_reg), m_emit->byte[GetHostReg64(host_address)]);
+      break;
+
+    case RegSize_16:
+      m_emit->movzx(GetHostReg32(result.host_reg), m_emit->word[GetHostReg64(host_address)]);
+      break;
+
+    case RegSize_32:
+      m_emit->mov(GetHostReg32(result.host_reg), m_emit->dword[GetHostReg64(host_address)]);
+      break;
+
+    default:
+      UnreachableCode();
+      break;
+  }
+
+  // Same timing as Bus::DoRAMAccess(). The slow path adds the ticks for whatever it accesses instead.
+  m_emit->add(m_emit->dword[GetCPUPtrReg() + offsetof(Core, m_pending_ticks)],
+              static_cast<u32>(Bus::RAM_READ_ACCESS_DELAY));
+
+  void* return_code = GetCurrentNearCodePointer();
+  bpi.host_code_size = static_cast<u32>(static_cast<u8*>(return_code) - static_cast<u8*>(bpi.host_code));
+  m_backpatch_info->push_back(bpi);
+
+  m_register_cache.PushState();
+
+  SwitchToFarCode();
+  EmitLoadGuestMemorySlowmem(cbi, address, size, result, true);
+  m_emit->jmp(return_code, Xbyak::CodeGenerator::T_NEAR);
+  SwitchToNearCode();
+
+  m_register_cache.PopState();
+}
+
+void CodeGenerator::EmitLoadGuestMemorySlowmem(const CodeBlockInstruction& cbi, const Value& address, RegSize size,
+                                               Value& result, bool in_far_code)
+{
+  const Value pc = Value::FromConstantU32(cbi.pc);
+
   // NOTE: This can leave junk in the upper bits
   switch (size)
   {
@@ -1662,6 +1849,20 @@ Value CodeGenerator::EmitLoadGuestMemory(const CodeBlockInstruction& cbi, const
   }
 
   m_emit->test(GetHostReg64(result.host_reg), GetHostReg64(result.host_reg));
+
+  if (in_far_code)
+  {
+    Xbyak::Label load_okay;
+    m_emit->jns(load_okay);
+
+    m_register_cache.PushState();
+    EmitExceptionExit();
+    m_register_cache.PopState();
+
+    m_emit->L(load_okay);
+    return;
+  }
+
   m_emit->js(GetCurrentFarCodePointer());
 
   m_register_cache.PushState();
@@ -1672,36 +1873,115 @@ Value CodeGenerator::EmitLoadGuestMemory(const CodeBlockInstruction& cbi, const
   SwitchToNearCode();
 
   m_register_cache.PopState();
+}
 
-  // Downcast to ignore upper 56/48/32 bits. This should be a noop.
-  switch (size)
+void CodeGenerator::EmitStoreGuestMemory(const CodeBlockInstruction& cbi, const Value& address, const Value& value)
+{
+  AddPendingCycles(true);
+
+  if (ShouldUseFastmem(address, value.size))
+  {
+    EmitStoreGuestMemoryFastmem(cbi, address, value);
+  }
+  else
+  {
+    Value result = m_register_cache.AllocateScratch(RegSize_8);
+    EmitStoreGuestMemorySlowmem(cbi, address, value, result, false);
+  }
+}
+
+void CodeGenerator::EmitStoreGuestMemoryFastmem(const CodeBlockInstruction& cbi, const Value& address,
+                                                const Value& value)
+{
+  void* slow_code = GetCurrentFarCodePointer();
+
+  // Allocating in far code could evict a guest register which the near code still expects to be there, so everything
+  // the slow path needs is allocated up front.
+  Value result = m_register_cache.AllocateScratch(RegSize_8);
+
+  Value host_address = m_register_cache.AllocateScratch(RegSize_64);
+  if (address.IsConstant())
+  {
+    m_emit->mov(GetHostReg32(host_address.host_reg), static_cast<u32>(address.constant_value));
+  }
+  else
+  {
+    if (value.size != RegSize_8)
+    {
+      m_emit->test(GetHostReg32(address.host_reg), (value.size == RegSize_32) ? 3 : 1);
+      m_emit->jnz(slow_code);
+    }
+
+    m_emit->mov(GetHostReg32(host_address.host_reg), GetHostReg32(address.host_reg));
+  }
+
+  // Stores are dropped while the cache is isolated, let the slow path deal with that.
+  static_assert(offsetof(Cop0Registers::SR, bits) == 0, "SR bits are the start of the union");
+  m_emit->test(m_emit->byte[GetCPUPtrReg() + offsetof(Core, m_cop0_regs.sr.bits) + 2], 1);
+  m_emit->jnz(slow_code);
+
+  m_emit->add(GetHostReg64(host_address), m_emit->qword[GetCPUPtrReg() + offsetof(Core, m_fastmem_base)]);
+
+  LoadStoreBackpatchInfo bpi;
+  bpi.host_code = GetCurrentNearCodePointer();
+  bpi.slow_code = slow_code;
+
+  switch (value.size)
   {
     case RegSize_8:
-      ConvertValueSizeInPlace(&result, RegSize_8, false);
-      break;
+    {
+      if (value.IsConstant())
+        m_emit->mov(m_emit->byte[GetHostReg64(host_address)], static_cast<u8>(value.constant_value));
+      else
+        m_emit->mov(m_emit->byte[GetHostReg64(host_address)], GetHostReg8(value.host_reg));
+    }
+    break;
 
     case RegSize_16:
-      ConvertValueSizeInPlace(&result, RegSize_16, false);
-      break;
+    {
+      if (value.IsConstant())
+        m_emit->mov(m_emit->word[GetHostReg64(host_address)], static_cast<u16>(value.constant_value));
+      else
+        m_emit->mov(m_emit->word[GetHostReg64(host_address)], GetHostReg16(value.host_reg));
+    }
+    break;
 
     case RegSize_32:
-      ConvertValueSizeInPlace(&result, RegSize_32, false);
-      break;
+    {
+      if (value.IsConstant())
+        m_emit->mov(m_emit->dword[GetHostReg64(host_address)], static_cast<u32>(value.constant_value));
+      else
+        m_emit->mov(m_emit->dword[GetHostReg64(host_address)], GetHostReg32(value.host_reg));
+    }
+    break;
 
     default:
       UnreachableCode();
       break;
   }
 
-  return result;
+  // Leave enough space for the backpatched jump.
+  while ((static_cast<u8*>(GetCurrentNearCodePointer()) - static_cast<u8*>(bpi.host_code)) < 5)
+    m_emit->nop();
+
+  void* return_code = GetCurrentNearCodePointer();
+  bpi.host_code_size = static_cast<u32>(static_cast<u8*>(return_code) - static_cast<u8*>(bpi.host_code));
+  m_backpatch_info->push_back(bpi);
+
+  m_register_cache.PushState();
+
+  SwitchToFarCode();
+  EmitStoreGuestMemorySlowmem(cbi, address, value, result, true);
+  m_emit->jmp(return_code, Xbyak::CodeGenerator::T_NEAR);
+  SwitchToNearCode();
+
+  m_register_cache.PopState();
 }
 
-void CodeGenerator::EmitStoreGuestMemory(const CodeBlockInstruction& cbi, const Value& address, const Value& value)
+void CodeGenerator::EmitStoreGuestMemorySlowmem(const CodeBlockInstruction& cbi, const Value& address,
+                                                const Value& value, Value& result, bool in_far_code)
 {
   const Value pc = Value::FromConstantU32(cbi.pc);
-  AddPendingCycles(true);
-
-  Value result = m_register_cache.AllocateScratch(RegSize_8);
 
   switch (value.size)
   {
@@ -1725,12 +2005,23 @@ void CodeGenerator::EmitStoreGuestMemory(const CodeBlockInstruction& cbi, const
   m_register_cache.PushState();
 
   m_emit->test(GetHostReg8(result), GetHostReg8(result));
-  m_emit->jz(GetCurrentFarCodePointer());
 
-  // store exception path
-  SwitchToFarCode();
-  EmitExceptionExit();
-  SwitchToNearCode();
+  if (in_far_code)
+  {
+    Xbyak::Label store_okay;
+    m_emit->jnz(store_okay);
+    EmitExceptionExit();
+    m_emit->L(store_okay);
+  }
+  else
+  {
+    m_emit->jz(GetCurrentFarCodePointer());
+
+    // store exception path
+    SwitchToFarCode();
+    EmitExceptionExit();
+    SwitchToNearCode();
+  }
 
   m_register_cache.PopState();
 }
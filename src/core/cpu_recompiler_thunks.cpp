@@ -149,11 +149,6 @@ void Thunks::RaiseAddressException(Core* cpu, u32 address, bool store, bool bran
     cpu->RaiseException(store ? Exception::AdES : Exception::AdEL);
 }
 
-void Thunks::ExecuteGTEInstruction(Core* cpu, u32 instruction_bits)
-{
-  cpu->m_cop2.ExecuteInstruction(GTE::Instruction{instruction_bits});
-}
-
 u32 Thunks::ReadGTERegister(Core* cpu, u32 reg)
 {
   return cpu->m_cop2.ReadRegister(reg);
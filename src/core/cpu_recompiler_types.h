@@ -77,6 +77,12 @@ constexpr u32 MAX_FAR_HOST_BYTES_PER_INSTRUCTION = 128;
 // Are shifts implicitly masked to 0..31?
 constexpr bool SHIFTS_ARE_IMPLICITLY_MASKED = true;
 
+// Can block exits be patched to jump straight to the next block?
+constexpr bool SUPPORTS_BLOCK_LINKING = true;
+
+// Can loads and stores go through the fastmem range, and be backpatched to the slow path when they fault?
+constexpr bool SUPPORTS_FASTMEM = true;
+
 // ABI selection
 #if defined(WIN32)
 #define ABI_WIN64 1
@@ -105,6 +111,12 @@ constexpr u32 MAX_FAR_HOST_BYTES_PER_INSTRUCTION = 128;
 // Are shifts implicitly masked to 0..31?
 constexpr bool SHIFTS_ARE_IMPLICITLY_MASKED = true;
 
+// Can block exits be patched to jump straight to the next block?
+constexpr bool SUPPORTS_BLOCK_LINKING = false;
+
+// Can loads and stores go through the fastmem range, and be backpatched to the slow path when they fault?
+constexpr bool SUPPORTS_FASTMEM = false;
+
 #else
 
 using HostReg = int;
@@ -121,6 +133,8 @@ enum : u32
 constexpr HostReg HostReg_Invalid = static_cast<HostReg>(HostReg_Count);
 constexpr RegSize HostPointerSize = RegSize_64;
 constexpr bool SHIFTS_ARE_IMPLICITLY_MASKED = false;
+constexpr bool SUPPORTS_BLOCK_LINKING = false;
+constexpr bool SUPPORTS_FASTMEM = false;
 
 #endif
 
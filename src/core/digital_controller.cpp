@@ -1,5 +1,6 @@
 #include "digital_controller.h"
 #include "common/assert.h"
+#include "common/state_wrapper.h"
 
 DigitalController::DigitalController() = default;
 
@@ -20,6 +21,11 @@ std::optional<s32> DigitalController::GetButtonCodeByName(std::string_view butto
   return StaticGetButtonCodeByName(button_name);
 }
 
+void DigitalController::DoInputState(StateWrapper& sw)
+{
+  sw.Do(&m_button_state);
+}
+
 void DigitalController::SetAxisState(s32 axis_code, float value) {}
 
 void DigitalController::SetButtonState(Button button, bool pressed)
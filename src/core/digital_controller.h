@@ -41,6 +41,8 @@ public:
   std::optional<s32> GetAxisCodeByName(std::string_view axis_name) const override;
   std::optional<s32> GetButtonCodeByName(std::string_view button_name) const override;
 
+  void DoInputState(StateWrapper& sw) override;
+
   void SetAxisState(s32 axis_code, float value) override;
   void SetButtonState(s32 button_code, bool pressed) override;
 
@@ -27,12 +27,24 @@ void DMA::Initialize(System* system, Bus* bus, InterruptController* interrupt_co
   m_mdec = mdec;
   m_transfer_buffer.resize(32);
 
+  static constexpr std::array<const char*, NUM_CHANNELS> event_names = {
+    {"DMA0 Transfer", "DMA1 Transfer", "DMA2 Transfer", "DMA3 Transfer", "DMA4 Transfer", "DMA5 Transfer",
+     "DMA6 Transfer"}};
+  static constexpr std::array<TimingEventCallback, NUM_CHANNELS> event_callbacks = {
+    {&TransferChannelEvent<0>, &TransferChannelEvent<1>, &TransferChannelEvent<2>, &TransferChannelEvent<3>,
+     &TransferChannelEvent<4>, &TransferChannelEvent<5>, &TransferChannelEvent<6>}};
+  for (u32 i = 0; i < NUM_CHANNELS; i++)
+    m_state[i].transfer_event = system->CreateTimingEvent(event_names[i], 1, 1, event_callbacks[i], this, false);
+
+#ifdef WITH_PROFILER
+  static constexpr std::array<const char*, NUM_CHANNELS> channel_names = {
+    {"MDECin", "MDECout", "GPU", "CDROM", "SPU", "PIO", "OTC"}};
   for (u32 i = 0; i < NUM_CHANNELS; i++)
   {
-    m_state[i].transfer_event = system->CreateTimingEvent(
-      StringUtil::StdStringFromFormat("DMA%u Transfer", i), 1, 1,
-      std::bind(&DMA::TransferChannel, this, static_cast<Channel>(i), std::placeholders::_2), false);
+    m_state[i].profiler_counter = system->GetProfiler()->RegisterCounter(
+      Profiler::Category::DMA, StringUtil::StdStringFromFormat("DMA%u %s", i, channel_names[i]));
   }
+#endif
 }
 
 void DMA::Reset()
@@ -284,6 +296,7 @@ void DMA::UpdateChannelTransferEvent(Channel channel)
 void DMA::TransferChannel(Channel channel, TickCount ticks_late)
 {
   ChannelState& cs = m_state[static_cast<u32>(channel)];
+  PROFILE_SCOPE(m_system->GetProfiler(), cs.profiler_counter);
   cs.transfer_event->Deactivate();
 
   const bool copy_to_device = cs.channel_control.copy_to_device;
@@ -75,6 +75,13 @@ private:
   void UpdateChannelTransferEvent(Channel channel);
   void TransferChannel(Channel channel, TickCount ticks_late);
 
+  // Timing event callback, the channel is a template parameter as the event only carries the DMA pointer.
+  template<u32 channel>
+  static void TransferChannelEvent(void* param, TickCount ticks, TickCount ticks_late)
+  {
+    static_cast<DMA*>(param)->TransferChannel(static_cast<Channel>(channel), ticks_late);
+  }
+
   // from device -> memory
   void TransferDeviceToMemory(Channel channel, u32 address, u32 increment, u32 word_count);
 
@@ -94,6 +101,7 @@ private:
   struct ChannelState
   {
     std::unique_ptr<TimingEvent> transfer_event;
+    u32 profiler_counter = 0;
     u32 base_address = 0;
 
     union BlockControl
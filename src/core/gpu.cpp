@@ -28,7 +28,20 @@ bool GPU::Initialize(HostDisplay* host_display, System* system, DMA* dma, Interr
   m_timers = timers;
   m_force_progressive_scan = m_system->GetSettings().gpu_force_progressive_scan;
   m_tick_event =
-    m_system->CreateTimingEvent("GPU Tick", 1, 1, std::bind(&GPU::Execute, this, std::placeholders::_1), true);
+    m_system->CreateTimingEvent("GPU Tick", 1, 1,
+                                [](void* param, TickCount ticks, TickCount ticks_late) {
+                                  static_cast<GPU*>(param)->Execute(ticks);
+                                },
+                                this, true);
+
+#ifdef WITH_PROFILER
+  for (u32 i = 0; i < static_cast<u32>(m_profiler_gp0_counters.size()); i++)
+  {
+    m_profiler_gp0_counters[i] =
+      m_system->GetProfiler()->RegisterCounter(Profiler::Category::GPUCommand, GetGP0CommandProfilerName(i));
+  }
+#endif
+
   return true;
 }
 
@@ -153,10 +166,18 @@ bool GPU::DoState(StateWrapper& sw)
     m_GPUSTAT.check_mask_before_draw = false;
     m_GPUSTAT.set_mask_while_drawing = false;
 
-    // Still need a temporary here.
-    HeapArray<u16, VRAM_WIDTH * VRAM_HEIGHT> temp;
-    sw.DoBytes(temp.data(), VRAM_WIDTH * VRAM_HEIGHT * sizeof(u16));
-    UpdateVRAM(0, 0, VRAM_WIDTH, VRAM_HEIGHT, temp.data());
+    // In-memory states can be uploaded straight from the buffer, otherwise we still need a temporary here.
+    const void* vram_data = sw.ReadInPlace(VRAM_WIDTH * VRAM_HEIGHT * sizeof(u16), alignof(u16));
+    if (vram_data)
+    {
+      UpdateVRAM(0, 0, VRAM_WIDTH, VRAM_HEIGHT, vram_data);
+    }
+    else
+    {
+      HeapArray<u16, VRAM_WIDTH * VRAM_HEIGHT> temp;
+      sw.DoBytes(temp.data(), VRAM_WIDTH * VRAM_HEIGHT * sizeof(u16));
+      UpdateVRAM(0, 0, VRAM_WIDTH, VRAM_HEIGHT, temp.data());
+    }
 
     // Restore mask setting.
     m_GPUSTAT.bits = old_GPUSTAT;
@@ -173,6 +194,18 @@ bool GPU::DoState(StateWrapper& sw)
   return !sw.HasError();
 }
 
+u64 GPU::GetVRAMHash()
+{
+  ReadVRAM(0, 0, VRAM_WIDTH, VRAM_HEIGHT);
+
+  // FNV-1a over the raw pixels.
+  u64 hash = UINT64_C(0xCBF29CE484222325);
+  for (u32 i = 0; i < VRAM_WIDTH * VRAM_HEIGHT; i++)
+    hash = (hash ^ m_vram_ptr[i]) * UINT64_C(0x100000001B3);
+
+  return hash;
+}
+
 void GPU::ResetGraphicsAPIState() {}
 
 void GPU::RestoreGraphicsAPIState() {}
@@ -229,6 +262,7 @@ u32 GPU::ReadRegister(u32 offset)
 
 void GPU::WriteRegister(u32 offset, u32 value)
 {
+  SystemComponentScope component_scope(m_system, System::Component::GPU);
   switch (offset)
   {
     case 0x00:
@@ -247,6 +281,7 @@ void GPU::WriteRegister(u32 offset, u32 value)
 
 void GPU::DMARead(u32* words, u32 word_count)
 {
+  SystemComponentScope component_scope(m_system, System::Component::GPU);
   if (m_GPUSTAT.dma_direction != DMADirection::GPUREADtoCPU)
   {
     Log_ErrorPrintf("Invalid DMA direction from GPU DMA read");
@@ -260,6 +295,7 @@ void GPU::DMARead(u32* words, u32 word_count)
 
 void GPU::DMAWrite(const u32* words, u32 word_count)
 {
+  SystemComponentScope component_scope(m_system, System::Component::GPU);
   switch (m_GPUSTAT.dma_direction)
   {
     case DMADirection::CPUtoGP0:
@@ -396,6 +432,7 @@ void GPU::UpdateSliceTicks()
 
 void GPU::Execute(TickCount ticks)
 {
+  SystemComponentScope component_scope(m_system, System::Component::GPU);
   // convert cpu/master clock to GPU ticks, accounting for partial cycles because of the non-integer divider
   {
     const TickCount temp = (ticks * 11) + m_crtc_state.fractional_ticks;
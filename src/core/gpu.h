@@ -113,6 +113,9 @@ public:
   virtual void Reset();
   virtual bool DoState(StateWrapper& sw);
 
+  // Returns a hash of the VRAM contents, for comparing renderer output between runs.
+  u64 GetVRAMHash();
+
   // Graphics API state reset/restore - call when drawing the UI etc.
   virtual void ResetGraphicsAPIState();
   virtual void RestoreGraphicsAPIState();
@@ -555,6 +558,9 @@ protected:
 
   std::vector<u32> m_GP0_buffer;
 
+  // Profiler counter for each GP0 command, commands of the same type share a counter.
+  std::array<u32, 256> m_profiler_gp0_counters = {};
+
   struct Stats
   {
     u32 num_vram_reads;
@@ -571,6 +577,7 @@ private:
   using GP0CommandHandler = bool (GPU::*)(const u32*&, u32);
   using GP0CommandHandlerTable = std::array<GP0CommandHandler, 256>;
   static GP0CommandHandlerTable GenerateGP0CommandHandlerTable();
+  static const char* GetGP0CommandProfilerName(u32 command);
 
   // Rendering commands, returns false if not enough data is provided
   bool HandleUnknownGP0Command(const u32*& command_ptr, u32 command_size);
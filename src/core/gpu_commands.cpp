@@ -32,6 +32,7 @@ void GPU::ExecuteCommands()
   {
     const u32 command = command_ptr[0] >> 24;
     const u32* old_command_ptr = command_ptr;
+    PROFILE_SCOPE(m_system->GetProfiler(), m_profiler_gp0_counters[command]);
     if (!(this->*s_GP0_command_handler_table[command])(command_ptr, command_size))
       break;
 
@@ -87,6 +88,28 @@ GPU::GP0CommandHandlerTable GPU::GenerateGP0CommandHandlerTable()
   return table;
 }
 
+const char* GPU::GetGP0CommandProfilerName(u32 command)
+{
+  if (command == 0x02)
+    return "Fill Rectangle";
+  else if (command >= 0x20 && command <= 0x3F)
+    return "Polygon";
+  else if (command >= 0x40 && command <= 0x5F)
+    return "Line";
+  else if (command >= 0x60 && command <= 0x7F)
+    return "Rectangle";
+  else if (command >= 0x80 && command <= 0x9F)
+    return "Copy VRAM to VRAM";
+  else if (command >= 0xA0 && command <= 0xBF)
+    return "Copy CPU to VRAM";
+  else if (command >= 0xC0 && command <= 0xDF)
+    return "Copy VRAM to CPU";
+  else if (command >= 0xE1 && command <= 0xE6)
+    return "Draw State";
+  else
+    return "Other";
+}
+
 bool GPU::HandleUnknownGP0Command(const u32*& command_ptr, u32 command_size)
 {
   const u32 command = *(command_ptr++) >> 24;
@@ -1,17 +1,21 @@
 #include "gpu_sw.h"
 #include "common/assert.h"
+#include "common/log.h"
 #include "host_display.h"
 #include "system.h"
 #include <algorithm>
+Log_SetChannel(GPU_SW);
 
 GPU_SW::GPU_SW()
 {
   m_vram.fill(0);
   m_vram_ptr = m_vram.data();
+  m_vram_dirty_rect.Set(0, 0, VRAM_WIDTH, VRAM_HEIGHT);
 }
 
 GPU_SW::~GPU_SW()
 {
+  StopWorkerThreads();
   m_host_display->SetDisplayTexture(nullptr, 0, 0, 0, 0, 0, 0, 1.0f);
 }
 
@@ -30,34 +34,141 @@ bool GPU_SW::Initialize(HostDisplay* host_display, System* system, DMA* dma, Int
   if (!m_display_texture)
     return false;
 
+  SelectSpanFunctions();
+  SelectCopyOutFunctions();
+
+  const u32 thread_count = GetWorkerThreadCount();
+  if (thread_count > 0)
+    StartWorkerThreads(thread_count);
+
   return true;
 }
 
 void GPU_SW::Reset()
 {
+  SyncWorkerThread();
+
   GPU::Reset();
 
   m_vram.fill(0);
+  MarkVRAMDirty(0, 0, VRAM_WIDTH, VRAM_HEIGHT);
+}
+
+void GPU_SW::UpdateSettings()
+{
+  GPU::UpdateSettings();
+
+  // The workers read the span functions, so they must be idle before switching.
+  SyncWorkerThread();
+  SelectSpanFunctions();
+  SelectCopyOutFunctions();
+
+  const u32 thread_count = GetWorkerThreadCount();
+  if (thread_count == m_worker_thread_count)
+    return;
+
+  StopWorkerThreads();
+  if (thread_count > 0)
+    StartWorkerThreads(thread_count);
+}
+
+void GPU_SW::SelectSpanFunctions()
+{
+  m_span_functions = nullptr;
+
+#ifdef CPU_X64
+  if (!m_system->GetSettings().debugging.disable_gpu_sw_simd)
+  {
+    if (CPUDetect::HasAVX2())
+      m_span_functions = GetSpanFunctionsAVX2();
+    else if (CPUDetect::HasSSE41())
+      m_span_functions = GetSpanFunctionsSSE41();
+  }
+#endif
+
+  Log_InfoPrintf("Using %s span shading", m_span_functions ? m_span_functions->name : "scalar");
+}
+
+void GPU_SW::SelectCopyOutFunctions()
+{
+  m_copy_out_15bit = &GPU_SW::CopyOut15Bit;
+  m_copy_out_24bit = &GPU_SW::CopyOut24Bit;
+
+#ifdef CPU_X64
+  if (!m_system->GetSettings().debugging.disable_gpu_sw_simd)
+  {
+    // SSE2 is part of the x64 baseline.
+    m_copy_out_15bit = &GPU_SW::CopyOut15BitSSE2;
+    if (CPUDetect::HasAVX2())
+    {
+      m_copy_out_15bit = &GPU_SW::CopyOut15BitAVX2;
+      m_copy_out_24bit = &GPU_SW::CopyOut24BitAVX2;
+    }
+    else if (CPUDetect::HasSSE41())
+    {
+      m_copy_out_24bit = &GPU_SW::CopyOut24BitSSE41;
+    }
+  }
+#endif
+}
+
+u32 GPU_SW::GetWorkerThreadCount() const
+{
+  const Settings& settings = m_system->GetSettings();
+  if (!settings.gpu_use_thread)
+    return 0;
+
+  return std::clamp<u32>(settings.gpu_sw_thread_count, 1, MAX_WORKER_THREADS);
 }
 
 void GPU_SW::ReadVRAM(u32 x, u32 y, u32 width, u32 height)
 {
-  // No need to do anything - pointer is already up to date.
+  // The pointer is up to date once all queued commands have executed.
+  SyncWorkerThread();
 }
 
 void GPU_SW::FillVRAM(u32 x, u32 y, u32 width, u32 height, u32 color)
 {
-  const u16 color16 = RGBA8888ToRGBA5551(color);
+  SWCommand cmd;
+  cmd.type = SWCommandType::FillVRAM;
+  cmd.textured = false;
+  cmd.exclusive = true;
+  FillDrawState(&cmd.state);
+  cmd.params = {x, y, width, height, RGBA8888ToRGBA5551(color), 0};
+  SubmitCommand(cmd);
+  MarkVRAMDirty(x, y, width, height);
+}
+
+void GPU_SW::UpdateVRAM(u32 x, u32 y, u32 width, u32 height, const void* data)
+{
+  // Writes go directly to VRAM, so any queued commands must complete first.
+  SyncWorkerThread();
+  GPU::UpdateVRAM(x, y, width, height, data);
+  MarkVRAMDirty(x, y, width, height);
+}
+
+void GPU_SW::CopyVRAM(u32 src_x, u32 src_y, u32 dst_x, u32 dst_y, u32 width, u32 height)
+{
+  SWCommand cmd;
+  cmd.type = SWCommandType::CopyVRAM;
+  cmd.textured = false;
+  cmd.exclusive = true;
+  FillDrawState(&cmd.state);
+  cmd.params = {src_x, src_y, dst_x, dst_y, width, height};
+  SubmitCommand(cmd);
+  MarkVRAMDirty(dst_x, dst_y, width, height);
+}
+
+void GPU_SW::DoFillVRAM(u32 x, u32 y, u32 width, u32 height, u16 color16)
+{
   for (u32 yoffs = 0; yoffs < height; yoffs++)
     std::fill_n(GetPixelPtr(x, y + yoffs), width, color16);
 }
 
-void GPU_SW::CopyVRAM(u32 src_x, u32 src_y, u32 dst_x, u32 dst_y, u32 width, u32 height)
+void GPU_SW::DoCopyVRAM(u32 src_x, u32 src_y, u32 dst_x, u32 dst_y, u32 width, u32 height, u16 mask_and,
+                        u16 mask_or)
 {
   // This doesn't have a fast path, but do we really need one? It's not common.
-  const u16 mask_and = m_GPUSTAT.GetMaskAND();
-  const u16 mask_or = m_GPUSTAT.GetMaskOR();
-
   for (u32 row = 0; row < height; row++)
   {
     const u16* src_row_ptr = &m_vram_ptr[((src_y + row) % VRAM_HEIGHT) * VRAM_WIDTH];
@@ -108,8 +219,332 @@ void GPU_SW::CopyOut24Bit(const u16* src_ptr, u32 src_stride, u32* dst_ptr, u32
   }
 }
 
+void GPU_SW::FillDrawState(SWDrawState* state) const
+{
+  state->drawing_area_left = static_cast<s32>(m_drawing_area.left);
+  state->drawing_area_top = static_cast<s32>(m_drawing_area.top);
+  state->drawing_area_right = static_cast<s32>(m_drawing_area.right);
+  state->drawing_area_bottom = static_cast<s32>(m_drawing_area.bottom);
+  state->drawing_offset_x = m_drawing_offset.x;
+  state->drawing_offset_y = m_drawing_offset.y;
+  state->texture_page_x = m_draw_mode.texture_page_x;
+  state->texture_page_y = m_draw_mode.texture_page_y;
+  state->texture_palette_x = m_draw_mode.texture_palette_x;
+  state->texture_palette_y = m_draw_mode.texture_palette_y;
+  state->texture_window_and_x = Truncate8(~(m_draw_mode.texture_window_mask_x * 8u));
+  state->texture_window_and_y = Truncate8(~(m_draw_mode.texture_window_mask_y * 8u));
+  state->texture_window_or_x =
+    Truncate8((m_draw_mode.texture_window_offset_x & m_draw_mode.texture_window_mask_x) * 8u);
+  state->texture_window_or_y =
+    Truncate8((m_draw_mode.texture_window_offset_y & m_draw_mode.texture_window_mask_y) * 8u);
+  state->texture_mode = m_draw_mode.GetTextureMode();
+  state->transparency_mode = m_draw_mode.GetTransparencyMode();
+  state->mask_and = m_GPUSTAT.GetMaskAND();
+  state->mask_or = m_GPUSTAT.GetMaskOR();
+  state->texture_reads_drawing_area = GetTextureReadRect(*state).Intersects(GetDrawingAreaRect(*state));
+}
+
+void GPU_SW::SubmitCommand(SWCommand& cmd)
+{
+  if (m_worker_thread_count == 0)
+  {
+    ExecuteCommand(cmd, 0, 1);
+    return;
+  }
+
+  if (m_worker_thread_count > 1)
+    UpdateCommandHazards(cmd);
+
+  const u64 write_seq = m_command_queue_write_seq.load(std::memory_order_relaxed);
+  if ((write_seq - GetCompletedCommandSeq()) >= COMMAND_QUEUE_SIZE)
+  {
+    // Queue is full, wait for the workers to make some space.
+    std::unique_lock<std::mutex> lock(m_worker_mutex);
+    m_producer_waiting.store(true);
+    m_worker_done_cv.wait(lock, [this, write_seq]() { return (write_seq - GetCompletedCommandSeq()) < COMMAND_QUEUE_SIZE; });
+    m_producer_waiting.store(false);
+  }
+
+  m_command_queue[write_seq % COMMAND_QUEUE_SIZE] = cmd;
+  m_command_queue_write_seq.store(write_seq + 1, std::memory_order_seq_cst);
+
+  if (m_sleeping_worker_count.load(std::memory_order_seq_cst) > 0)
+  {
+    std::unique_lock<std::mutex> lock(m_worker_mutex);
+    m_worker_wake_cv.notify_all();
+  }
+}
+
+Common::Rectangle<u32> GPU_SW::GetDrawingAreaRect(const SWDrawState& state)
+{
+  return Common::Rectangle<u32>(static_cast<u32>(state.drawing_area_left), static_cast<u32>(state.drawing_area_top),
+                                static_cast<u32>(state.drawing_area_right) + 1,
+                                static_cast<u32>(state.drawing_area_bottom) + 1);
+}
+
+Common::Rectangle<u32> GPU_SW::GetTextureReadRect(const SWDrawState& state)
+{
+  u32 page_width, palette_width;
+  switch (state.texture_mode)
+  {
+    case TextureMode::Palette4Bit:
+      page_width = 64;
+      palette_width = 16;
+      break;
+    case TextureMode::Palette8Bit:
+      page_width = 128;
+      palette_width = 256;
+      break;
+    default:
+      page_width = 256;
+      palette_width = 0;
+      break;
+  }
+
+  Common::Rectangle<u32> rect(state.texture_page_x, state.texture_page_y,
+                              std::min<u32>(state.texture_page_x + page_width, VRAM_WIDTH),
+                              std::min<u32>(state.texture_page_y + 256, VRAM_HEIGHT));
+  if (palette_width > 0)
+  {
+    rect.Include(Common::Rectangle<u32>(state.texture_palette_x, state.texture_palette_y,
+                                        std::min<u32>(state.texture_palette_x + palette_width, VRAM_WIDTH),
+                                        state.texture_palette_y + 1));
+  }
+
+  return rect;
+}
+
+void GPU_SW::UpdateCommandHazards(SWCommand& cmd)
+{
+  // Conservatively assume a primitive can write anywhere in the drawing area, and read anywhere in its texture page.
+  const Common::Rectangle<u32> write_rect = GetDrawingAreaRect(cmd.state);
+  Common::Rectangle<u32> read_rect;
+  if (cmd.textured)
+  {
+    const Common::Rectangle<u32> texture_rect = GetTextureReadRect(cmd.state);
+    read_rect.Set(texture_rect.left, texture_rect.top, texture_rect.right, texture_rect.bottom);
+
+    // Sampling from the destination depends on the order pixels are written in, so it can't be split into bands.
+    if (cmd.state.texture_reads_drawing_area)
+      cmd.exclusive = true;
+  }
+
+  if (cmd.exclusive)
+  {
+    // Nothing may overlap with this command, so the following command must wait for it too.
+    cmd.fence = true;
+    m_pending_read_rect.Set(0, 0, VRAM_WIDTH, VRAM_HEIGHT);
+    m_pending_write_rect.Set(0, 0, VRAM_WIDTH, VRAM_HEIGHT);
+    return;
+  }
+
+  // Writes from other bands are only visible to texture reads after a fence, and reads by earlier commands in other
+  // bands must complete before the area is overwritten.
+  cmd.fence = read_rect.Intersects(m_pending_write_rect) || write_rect.Intersects(m_pending_read_rect);
+  if (cmd.fence)
+  {
+    m_pending_read_rect.Set(read_rect.left, read_rect.top, read_rect.right, read_rect.bottom);
+    m_pending_write_rect.Set(write_rect.left, write_rect.top, write_rect.right, write_rect.bottom);
+  }
+  else
+  {
+    m_pending_read_rect.Include(read_rect);
+    m_pending_write_rect.Include(write_rect);
+  }
+}
+
+void GPU_SW::ExecuteCommand(const SWCommand& cmd, u32 band_index, u32 band_count)
+{
+  SWDrawState state = cmd.state;
+  state.band_index = band_index;
+  state.band_count = band_count;
+
+  switch (cmd.type)
+  {
+    case SWCommandType::DrawPolygon:
+    {
+      (this->*cmd.draw_triangle)(state, &cmd.vertices[0], &cmd.vertices[1], &cmd.vertices[2]);
+      if (cmd.num_vertices > 3)
+        (this->*cmd.draw_triangle)(state, &cmd.vertices[2], &cmd.vertices[1], &cmd.vertices[3]);
+    }
+    break;
+
+    case SWCommandType::DrawRectangle:
+    {
+      const SWVertex& v = cmd.vertices[0];
+      (this->*cmd.draw_rectangle)(state, v.x, v.y, cmd.params[0], cmd.params[1], v.color_r, v.color_g, v.color_b,
+                                  v.texcoord_x, v.texcoord_y);
+    }
+    break;
+
+    case SWCommandType::DrawLine:
+      (this->*cmd.draw_line)(state, &cmd.vertices[0], &cmd.vertices[1]);
+      break;
+
+    case SWCommandType::FillVRAM:
+      DoFillVRAM(cmd.params[0], cmd.params[1], cmd.params[2], cmd.params[3], Truncate16(cmd.params[4]));
+      break;
+
+    case SWCommandType::CopyVRAM:
+      DoCopyVRAM(cmd.params[0], cmd.params[1], cmd.params[2], cmd.params[3], cmd.params[4], cmd.params[5],
+                 cmd.state.mask_and, cmd.state.mask_or);
+      break;
+
+    default:
+      UnreachableCode();
+      break;
+  }
+}
+
+void GPU_SW::StartWorkerThreads(u32 count)
+{
+  Assert(m_worker_thread_count == 0 && count > 0 && count <= MAX_WORKER_THREADS);
+  Log_InfoPrintf("Starting %u software renderer worker thread(s)", count);
+
+  m_command_queue.resize(COMMAND_QUEUE_SIZE);
+  m_command_queue_write_seq.store(0);
+  m_pending_read_rect.SetInvalid();
+  m_pending_write_rect.SetInvalid();
+  m_worker_shutdown.store(false);
+  m_worker_thread_count = count;
+
+  for (u32 i = 0; i < count; i++)
+  {
+    m_worker_threads[i].read_seq.store(0);
+    m_worker_threads[i].thread = std::thread(&GPU_SW::WorkerThreadEntryPoint, this, i);
+  }
+}
+
+void GPU_SW::StopWorkerThreads()
+{
+  if (m_worker_thread_count == 0)
+    return;
+
+  Log_InfoPrint("Stopping software renderer worker threads");
+  SyncWorkerThread();
+
+  {
+    std::unique_lock<std::mutex> lock(m_worker_mutex);
+    m_worker_shutdown.store(true);
+    m_worker_wake_cv.notify_all();
+  }
+
+  for (u32 i = 0; i < m_worker_thread_count; i++)
+    m_worker_threads[i].thread.join();
+
+  m_worker_thread_count = 0;
+  m_command_queue.clear();
+  m_command_queue.shrink_to_fit();
+}
+
+void GPU_SW::WorkerThreadEntryPoint(u32 index)
+{
+  WorkerThread& self = m_worker_threads[index];
+  const u32 band_count = m_worker_thread_count;
+
+  for (;;)
+  {
+    const u64 seq = self.read_seq.load(std::memory_order_relaxed);
+    if (seq == m_command_queue_write_seq.load(std::memory_order_acquire))
+    {
+      std::unique_lock<std::mutex> lock(m_worker_mutex);
+      m_sleeping_worker_count.fetch_add(1, std::memory_order_seq_cst);
+
+      // Re-check after publishing the sleeping count, the producer may have queued something in between.
+      m_worker_wake_cv.wait(lock, [this, seq]() {
+        return m_worker_shutdown.load() || seq != m_command_queue_write_seq.load(std::memory_order_seq_cst);
+      });
+      m_sleeping_worker_count.fetch_sub(1, std::memory_order_seq_cst);
+
+      if (seq == m_command_queue_write_seq.load() && m_worker_shutdown.load())
+        break;
+
+      continue;
+    }
+
+    const SWCommand& cmd = m_command_queue[seq % COMMAND_QUEUE_SIZE];
+    if (cmd.fence)
+    {
+      // Wait for the other workers to catch up. They can't be sleeping, as this command hasn't been executed yet.
+      while (GetCompletedCommandSeq() < seq)
+        std::this_thread::yield();
+    }
+
+    if (!cmd.exclusive)
+      ExecuteCommand(cmd, index, band_count);
+    else if (index == 0)
+      ExecuteCommand(cmd, 0, 1);
+
+    self.read_seq.store(seq + 1, std::memory_order_seq_cst);
+
+    if (m_producer_waiting.load(std::memory_order_seq_cst))
+    {
+      std::unique_lock<std::mutex> lock(m_worker_mutex);
+      m_worker_done_cv.notify_one();
+    }
+  }
+}
+
+u64 GPU_SW::GetCompletedCommandSeq() const
+{
+  u64 seq = m_worker_threads[0].read_seq.load(std::memory_order_acquire);
+  for (u32 i = 1; i < m_worker_thread_count; i++)
+    seq = std::min(seq, m_worker_threads[i].read_seq.load(std::memory_order_acquire));
+
+  return seq;
+}
+
+void GPU_SW::SyncWorkerThread()
+{
+  if (m_worker_thread_count == 0)
+    return;
+
+  const u64 write_seq = m_command_queue_write_seq.load(std::memory_order_relaxed);
+  if (GetCompletedCommandSeq() != write_seq)
+  {
+    std::unique_lock<std::mutex> lock(m_worker_mutex);
+    m_producer_waiting.store(true);
+    m_worker_done_cv.wait(lock, [this, write_seq]() { return GetCompletedCommandSeq() == write_seq; });
+    m_producer_waiting.store(false);
+  }
+
+  // Everything queued so far is complete, so nothing can conflict with the next command.
+  m_pending_read_rect.SetInvalid();
+  m_pending_write_rect.SetInvalid();
+}
+
+void GPU_SW::MarkVRAMDirty(u32 x, u32 y, u32 width, u32 height)
+{
+  const u32 right = x + width;
+  const u32 bottom = y + height;
+  m_vram_dirty_rect.Include(Common::Rectangle<u32>((right > VRAM_WIDTH) ? 0 : x, (bottom > VRAM_HEIGHT) ? 0 : y,
+                                                   std::min<u32>(right, VRAM_WIDTH),
+                                                   std::min<u32>(bottom, VRAM_HEIGHT)));
+}
+
+bool GPU_SW::IsScanoutRequired(u32 x, u32 y, u32 width, u32 height, bool is_24bit)
+{
+  // 24-bit pixels take 1.5 halfwords, and the copy reads one byte past the last pixel. Reads past the end of a row
+  // continue into the next one.
+  const u32 vram_width = is_24bit ? ((width * 3 + 1) / 2 + 1) : width;
+  Common::Rectangle<u32> read_rect(x, y, x + vram_width, y + height);
+  if (read_rect.right > VRAM_WIDTH)
+    read_rect.Set(0, y, VRAM_WIDTH, std::min<u32>(y + height + 1, VRAM_HEIGHT));
+
+  const bool required = (m_scanout_rect != read_rect || m_scanout_24bit != is_24bit ||
+                         (m_vram_dirty_rect.Valid() && m_vram_dirty_rect.Intersects(read_rect)));
+
+  m_scanout_rect.Set(read_rect.left, read_rect.top, read_rect.right, read_rect.bottom);
+  m_scanout_24bit = is_24bit;
+  m_vram_dirty_rect.SetInvalid();
+  return required;
+}
+
 void GPU_SW::UpdateDisplay()
 {
+  // Scanout reads VRAM, so wait for any pending drawing.
+  SyncWorkerThread();
+
   // fill display texture
   m_display_texture_buffer.resize(VRAM_WIDTH * VRAM_HEIGHT);
 
@@ -128,17 +563,28 @@ void GPU_SW::UpdateDisplay()
     if (m_GPUSTAT.display_disable)
     {
       m_host_display->SetDisplayTexture(nullptr, 0, 0, 0, 0, 0, 0, display_aspect_ratio);
+      m_scanout_rect.SetInvalid();
       return;
     }
     else if (m_GPUSTAT.display_area_color_depth_24)
     {
-      CopyOut24Bit(m_vram.data() + vram_offset_y * VRAM_WIDTH + vram_offset_x, VRAM_WIDTH,
-                   m_display_texture_buffer.data(), display_width, display_width, display_height);
+      if (IsScanoutRequired(vram_offset_x, vram_offset_y, display_width, display_height, true))
+      {
+        m_copy_out_24bit(m_vram.data() + vram_offset_y * VRAM_WIDTH + vram_offset_x, VRAM_WIDTH,
+                         m_display_texture_buffer.data(), display_width, display_width, display_height);
+        m_host_display->UpdateTexture(m_display_texture.get(), 0, 0, display_width, display_height,
+                                      m_display_texture_buffer.data(), display_width * sizeof(u32));
+      }
     }
     else
     {
-      CopyOut15Bit(m_vram.data() + vram_offset_y * VRAM_WIDTH + vram_offset_x, VRAM_WIDTH,
-                   m_display_texture_buffer.data(), display_width, display_width, display_height);
+      if (IsScanoutRequired(vram_offset_x, vram_offset_y, display_width, display_height, false))
+      {
+        m_copy_out_15bit(m_vram.data() + vram_offset_y * VRAM_WIDTH + vram_offset_x, VRAM_WIDTH,
+                         m_display_texture_buffer.data(), display_width, display_width, display_height);
+        m_host_display->UpdateTexture(m_display_texture.get(), 0, 0, display_width, display_height,
+                                      m_display_texture_buffer.data(), display_width * sizeof(u32));
+      }
     }
   }
   else
@@ -146,12 +592,15 @@ void GPU_SW::UpdateDisplay()
     display_width = VRAM_WIDTH;
     display_height = VRAM_HEIGHT;
     display_aspect_ratio = 1.0f;
-    CopyOut15Bit(m_vram.data(), VRAM_WIDTH, m_display_texture_buffer.data(), display_width, display_width,
-                 display_height);
+    if (IsScanoutRequired(0, 0, display_width, display_height, false))
+    {
+      m_copy_out_15bit(m_vram.data(), VRAM_WIDTH, m_display_texture_buffer.data(), display_width, display_width,
+                       display_height);
+      m_host_display->UpdateTexture(m_display_texture.get(), 0, 0, display_width, display_height,
+                                    m_display_texture_buffer.data(), display_width * sizeof(u32));
+    }
   }
 
-  m_host_display->UpdateTexture(m_display_texture.get(), 0, 0, display_width, display_height,
-                                m_display_texture_buffer.data(), display_width * sizeof(u32));
   m_host_display->SetDisplayTexture(m_display_texture->GetHandle(), 0, 0, display_width, display_height, VRAM_WIDTH,
                                     VRAM_HEIGHT, display_aspect_ratio);
 }
@@ -160,6 +609,14 @@ void GPU_SW::DispatchRenderCommand(RenderCommand rc, u32 num_vertices, const u32
 {
   const bool dithering_enable = rc.IsDitheringEnabled() && m_GPUSTAT.dither_enable;
 
+  SWCommand cmd;
+  cmd.textured = rc.texture_enable;
+  cmd.exclusive = false;
+  FillDrawState(&cmd.state);
+
+  // Primitives are clipped to the drawing area, so it bounds everything they can write.
+  m_vram_dirty_rect.Include(GetDrawingAreaRect(cmd.state));
+
   switch (rc.primitive)
   {
     case Primitive::Polygon:
@@ -168,12 +625,10 @@ void GPU_SW::DispatchRenderCommand(RenderCommand rc, u32 num_vertices, const u32
       const bool shaded = rc.shading_enable;
       const bool textured = rc.texture_enable;
 
-      std::array<SWVertex, 4> vertices;
-
       u32 buffer_pos = 1;
       for (u32 i = 0; i < num_vertices; i++)
       {
-        SWVertex& vert = vertices[i];
+        SWVertex& vert = cmd.vertices[i];
         const u32 color_rgb = (shaded && i > 0) ? (command_ptr[buffer_pos++] & UINT32_C(0x00FFFFFF)) : first_color;
         vert.color_r = Truncate8(color_rgb);
         vert.color_g = Truncate8(color_rgb >> 8);
@@ -194,22 +649,19 @@ void GPU_SW::DispatchRenderCommand(RenderCommand rc, u32 num_vertices, const u32
         }
       }
 
-      const DrawTriangleFunction DrawFunction = GetDrawTriangleFunction(
-        rc.shading_enable, rc.texture_enable, rc.raw_texture_enable, rc.transparency_enable, dithering_enable);
-
-      (this->*DrawFunction)(&vertices[0], &vertices[1], &vertices[2]);
-      if (num_vertices > 3)
-        (this->*DrawFunction)(&vertices[2], &vertices[1], &vertices[3]);
+      cmd.type = SWCommandType::DrawPolygon;
+      cmd.num_vertices = static_cast<u8>(num_vertices);
+      cmd.draw_triangle = GetDrawTriangleFunction(rc.shading_enable, rc.texture_enable, rc.raw_texture_enable,
+                                                  rc.transparency_enable, dithering_enable);
+      SubmitCommand(cmd);
     }
     break;
 
     case Primitive::Rectangle:
     {
       u32 buffer_pos = 1;
-      const auto [r, g, b] = UnpackColorRGB24(rc.color_for_first_vertex);
       const VertexPosition vp{command_ptr[buffer_pos++]};
       const u32 texcoord_and_palette = rc.texture_enable ? command_ptr[buffer_pos++] : 0;
-      const auto [texcoord_x, texcoord_y] = UnpackTexcoord(Truncate16(texcoord_and_palette));
 
       s32 width;
       s32 height;
@@ -233,10 +685,15 @@ void GPU_SW::DispatchRenderCommand(RenderCommand rc, u32 num_vertices, const u32
           break;
       }
 
-      const DrawRectangleFunction DrawFunction =
-        GetDrawRectangleFunction(rc.texture_enable, rc.raw_texture_enable, rc.transparency_enable);
-
-      (this->*DrawFunction)(vp.x, vp.y, width, height, r, g, b, texcoord_x, texcoord_y);
+      cmd.type = SWCommandType::DrawRectangle;
+      cmd.num_vertices = 1;
+      cmd.draw_rectangle = GetDrawRectangleFunction(rc.texture_enable, rc.raw_texture_enable, rc.transparency_enable);
+      cmd.vertices[0].SetPosition(vp);
+      cmd.vertices[0].SetColorRGB24(rc.color_for_first_vertex);
+      cmd.vertices[0].SetTexcoord(Truncate16(texcoord_and_palette));
+      cmd.params[0] = static_cast<u32>(width);
+      cmd.params[1] = static_cast<u32>(height);
+      SubmitCommand(cmd);
     }
     break;
 
@@ -245,27 +702,25 @@ void GPU_SW::DispatchRenderCommand(RenderCommand rc, u32 num_vertices, const u32
       const u32 first_color = rc.color_for_first_vertex;
       const bool shaded = rc.shading_enable;
 
-      const DrawLineFunction DrawFunction = GetDrawLineFunction(shaded, rc.transparency_enable, dithering_enable);
+      cmd.type = SWCommandType::DrawLine;
+      cmd.num_vertices = 2;
+      cmd.draw_line = GetDrawLineFunction(shaded, rc.transparency_enable, dithering_enable);
 
-      std::array<SWVertex, 2> vertices = {};
       u32 buffer_pos = 1;
 
       // first vertex
-      SWVertex* p0 = &vertices[0];
-      SWVertex* p1 = &vertices[1];
-      p0->SetPosition(VertexPosition{command_ptr[buffer_pos++]});
-      p0->SetColorRGB24(first_color);
+      cmd.vertices[1] = {};
+      cmd.vertices[1].SetPosition(VertexPosition{command_ptr[buffer_pos++]});
+      cmd.vertices[1].SetColorRGB24(first_color);
 
-      // remaining vertices in line strip
+      // remaining vertices in line strip, each segment is queued separately
       for (u32 i = 1; i < num_vertices; i++)
       {
-        p1->SetColorRGB24(shaded ? (command_ptr[buffer_pos++] & UINT32_C(0x00FFFFFF)) : first_color);
-        p1->SetPosition(VertexPosition{command_ptr[buffer_pos++]});
-
-        (this->*DrawFunction)(p0, p1);
-
-        // swap p0/p1 so that the last vertex is used as the first for the next line
-        std::swap(p0, p1);
+        // the last vertex is used as the first for the next line
+        cmd.vertices[0] = cmd.vertices[1];
+        cmd.vertices[1].SetColorRGB24(shaded ? (command_ptr[buffer_pos++] & UINT32_C(0x00FFFFFF)) : first_color);
+        cmd.vertices[1].SetPosition(VertexPosition{command_ptr[buffer_pos++]});
+        SubmitCommand(cmd);
       }
     }
     break;
@@ -325,7 +780,7 @@ static constexpr u8 Interpolate(u8 v0, u8 v1, u8 v2, s32 w0, s32 w1, s32 w2, s32
 
 template<bool shading_enable, bool texture_enable, bool raw_texture_enable, bool transparency_enable,
          bool dithering_enable>
-void GPU_SW::DrawTriangle(const SWVertex* v0, const SWVertex* v1, const SWVertex* v2)
+void GPU_SW::DrawTriangle(const SWDrawState& state, const SWVertex* v0, const SWVertex* v1, const SWVertex* v2)
 {
 #define orient2d(ax, ay, bx, by, cx, cy) ((bx - ax) * (cy - ay) - (by - ay) * (cx - ax))
 
@@ -333,12 +788,12 @@ void GPU_SW::DrawTriangle(const SWVertex* v0, const SWVertex* v1, const SWVertex
   if (IsClockwiseWinding(v0, v1, v2))
     std::swap(v1, v2);
 
-  const s32 px0 = v0->x + m_drawing_offset.x;
-  const s32 py0 = v0->y + m_drawing_offset.y;
-  const s32 px1 = v1->x + m_drawing_offset.x;
-  const s32 py1 = v1->y + m_drawing_offset.y;
-  const s32 px2 = v2->x + m_drawing_offset.x;
-  const s32 py2 = v2->y + m_drawing_offset.y;
+  const s32 px0 = v0->x + state.drawing_offset_x;
+  const s32 py0 = v0->y + state.drawing_offset_y;
+  const s32 px1 = v1->x + state.drawing_offset_x;
+  const s32 py1 = v1->y + state.drawing_offset_y;
+  const s32 px2 = v2->x + state.drawing_offset_x;
+  const s32 py2 = v2->y + state.drawing_offset_y;
 
   // Barycentric coordinates at minX/minY corner
   const s32 ws = orient2d(px0, py0, px1, py1, px2, py2);
@@ -356,10 +811,10 @@ void GPU_SW::DrawTriangle(const SWVertex* v0, const SWVertex* v1, const SWVertex
     return;
 
   // clip to drawing area
-  min_x = std::clamp(min_x, static_cast<s32>(m_drawing_area.left), static_cast<s32>(m_drawing_area.right));
-  max_x = std::clamp(max_x, static_cast<s32>(m_drawing_area.left), static_cast<s32>(m_drawing_area.right));
-  min_y = std::clamp(min_y, static_cast<s32>(m_drawing_area.top), static_cast<s32>(m_drawing_area.bottom));
-  max_y = std::clamp(max_y, static_cast<s32>(m_drawing_area.top), static_cast<s32>(m_drawing_area.bottom));
+  min_x = std::clamp(min_x, state.drawing_area_left, state.drawing_area_right);
+  max_x = std::clamp(max_x, state.drawing_area_left, state.drawing_area_right);
+  min_y = std::clamp(min_y, state.drawing_area_top, state.drawing_area_bottom);
+  max_y = std::clamp(max_y, state.drawing_area_top, state.drawing_area_bottom);
 
   // compute per-pixel increments
   const s32 a01 = py0 - py1, b01 = px1 - px0;
@@ -376,9 +831,36 @@ void GPU_SW::DrawTriangle(const SWVertex* v0, const SWVertex* v1, const SWVertex
   s32 w1 = orient2d(px2, py2, px0, py0, min_x, min_y);
   s32 w2 = orient2d(px0, py0, px1, py1, min_x, min_y);
 
+  // shade whole rows at once when possible, unless texels could be modified by the span itself
+  const ShadeTriangleSpanFunction ShadeSpan =
+    (m_span_functions && !(texture_enable && state.texture_reads_drawing_area)) ?
+      m_span_functions->triangle[u8(shading_enable)][u8(texture_enable)][u8(raw_texture_enable)]
+                                [u8(transparency_enable)][u8(dithering_enable)] :
+      nullptr;
+
   // *exclusive* of max coordinate in PSX
   for (s32 y = min_y; y <= max_y; y++)
   {
+    if (!state.IsRowInBand(y))
+    {
+      w0 += b12;
+      w1 += b20;
+      w2 += b01;
+      continue;
+    }
+
+    if (ShadeSpan)
+    {
+      const SWTriangleSpan span = {v0, v1, v2, min_x, y, static_cast<u32>(max_x - min_x + 1), w0, w1, w2, a12, a20,
+                                   a01, w0_bias, w1_bias, w2_bias, ws};
+      ShadeSpan(m_vram.data(), state, span);
+
+      w0 += b12;
+      w1 += b20;
+      w2 += b01;
+      continue;
+    }
+
     s32 row_w0 = w0;
     s32 row_w1 = w1;
     s32 row_w2 = w2;
@@ -399,7 +881,7 @@ void GPU_SW::DrawTriangle(const SWVertex* v0, const SWVertex* v1, const SWVertex
         const u8 texcoord_y = Interpolate(v0->texcoord_y, v1->texcoord_y, v2->texcoord_y, b0, b1, b2, ws);
 
         ShadePixel<texture_enable, raw_texture_enable, transparency_enable, dithering_enable>(
-          static_cast<u32>(x), static_cast<u32>(y), r, g, b, texcoord_x, texcoord_y);
+          state, static_cast<u32>(x), static_cast<u32>(y), r, g, b, texcoord_x, texcoord_y);
       }
 
       row_w0 += a12;
@@ -447,80 +929,99 @@ GPU_SW::DrawTriangleFunction GPU_SW::GetDrawTriangleFunction(bool shading_enable
 }
 
 template<bool texture_enable, bool raw_texture_enable, bool transparency_enable>
-void GPU_SW::DrawRectangle(s32 origin_x, s32 origin_y, u32 width, u32 height, u8 r, u8 g, u8 b, u8 origin_texcoord_x,
-                           u8 origin_texcoord_y)
+void GPU_SW::DrawRectangle(const SWDrawState& state, s32 origin_x, s32 origin_y, u32 width, u32 height, u8 r, u8 g,
+                           u8 b, u8 origin_texcoord_x, u8 origin_texcoord_y)
 {
-  origin_x += m_drawing_offset.x;
-  origin_y += m_drawing_offset.y;
+  origin_x += state.drawing_offset_x;
+  origin_y += state.drawing_offset_y;
+
+  const ShadeRectangleSpanFunction ShadeSpan =
+    (m_span_functions && !(texture_enable && state.texture_reads_drawing_area)) ?
+      m_span_functions->rectangle[u8(texture_enable)][u8(raw_texture_enable)][u8(transparency_enable)] :
+      nullptr;
 
   for (u32 offset_y = 0; offset_y < height; offset_y++)
   {
     const s32 y = origin_y + static_cast<s32>(offset_y);
-    if (y < static_cast<s32>(m_drawing_area.top) || y > static_cast<s32>(m_drawing_area.bottom))
+    if (y < state.drawing_area_top || y > state.drawing_area_bottom || !state.IsRowInBand(y))
       continue;
 
     const u8 texcoord_y = Truncate8(ZeroExtend32(origin_texcoord_y) + offset_y);
 
+    if (ShadeSpan)
+    {
+      const s32 start_x = std::max(origin_x, state.drawing_area_left);
+      const s32 end_x = std::min(origin_x + static_cast<s32>(width) - 1, state.drawing_area_right);
+      if (start_x <= end_x)
+      {
+        const u8 start_texcoord_x =
+          Truncate8(ZeroExtend32(origin_texcoord_x) + static_cast<u32>(start_x - origin_x));
+        const SWRectangleSpan span = {start_x, y, static_cast<u32>(end_x - start_x + 1), r, g, b, start_texcoord_x,
+                                      texcoord_y};
+        ShadeSpan(m_vram.data(), state, span);
+      }
+
+      continue;
+    }
+
     for (u32 offset_x = 0; offset_x < width; offset_x++)
     {
       const s32 x = origin_x + static_cast<s32>(offset_x);
-      if (x < static_cast<s32>(m_drawing_area.left) || x > static_cast<s32>(m_drawing_area.right))
+      if (x < state.drawing_area_left || x > state.drawing_area_right)
         continue;
 
       const u8 texcoord_x = Truncate8(ZeroExtend32(origin_texcoord_x) + offset_x);
 
       ShadePixel<texture_enable, raw_texture_enable, transparency_enable, false>(
-        static_cast<u32>(x), static_cast<u32>(y), r, g, b, texcoord_x, texcoord_y);
+        state, static_cast<u32>(x), static_cast<u32>(y), r, g, b, texcoord_x, texcoord_y);
     }
   }
 }
 
 template<bool texture_enable, bool raw_texture_enable, bool transparency_enable, bool dithering_enable>
-void GPU_SW::ShadePixel(u32 x, u32 y, u8 color_r, u8 color_g, u8 color_b, u8 texcoord_x, u8 texcoord_y)
+void GPU_SW::ShadePixel(const SWDrawState& state, u32 x, u32 y, u8 color_r, u8 color_g, u8 color_b, u8 texcoord_x,
+                        u8 texcoord_y)
 {
   VRAMPixel color;
   bool transparent;
   if constexpr (texture_enable)
   {
     // Apply texture window
-    // TODO: Precompute the second half
-    texcoord_x = (texcoord_x & ~(m_draw_mode.texture_window_mask_x * 8u)) |
-                 ((m_draw_mode.texture_window_offset_x & m_draw_mode.texture_window_mask_x) * 8u);
-    texcoord_y = (texcoord_y & ~(m_draw_mode.texture_window_mask_y * 8u)) |
-                 ((m_draw_mode.texture_window_offset_y & m_draw_mode.texture_window_mask_y) * 8u);
+    texcoord_x = (texcoord_x & state.texture_window_and_x) | state.texture_window_or_x;
+    texcoord_y = (texcoord_y & state.texture_window_and_y) | state.texture_window_or_y;
 
     VRAMPixel texture_color;
-    switch (m_draw_mode.GetTextureMode())
+    switch (state.texture_mode)
     {
       case GPU::TextureMode::Palette4Bit:
       {
         const u16 palette_value =
-          GetPixel(std::min<u32>(m_draw_mode.texture_page_x + ZeroExtend32(texcoord_x / 4), VRAM_WIDTH - 1),
-                   std::min<u32>(m_draw_mode.texture_page_y + ZeroExtend32(texcoord_y), VRAM_HEIGHT - 1));
+          GetPixel(std::min<u32>(state.texture_page_x + ZeroExtend32(texcoord_x / 4), VRAM_WIDTH - 1),
+                   std::min<u32>(state.texture_page_y + ZeroExtend32(texcoord_y), VRAM_HEIGHT - 1));
         const u16 palette_index = (palette_value >> ((texcoord_x % 4) * 4)) & 0x0Fu;
         texture_color.bits =
-          GetPixel(std::min<u32>(m_draw_mode.texture_palette_x + ZeroExtend32(palette_index), VRAM_WIDTH - 1),
-                   m_draw_mode.texture_palette_y);
+          GetPixel(std::min<u32>(state.texture_palette_x + ZeroExtend32(palette_index), VRAM_WIDTH - 1),
+                   state.texture_palette_y);
       }
       break;
 
       case GPU::TextureMode::Palette8Bit:
       {
         const u16 palette_value =
-          GetPixel(std::min<u32>(m_draw_mode.texture_page_x + ZeroExtend32(texcoord_x / 2), VRAM_WIDTH - 1),
-                   std::min<u32>(m_draw_mode.texture_page_y + ZeroExtend32(texcoord_y), VRAM_HEIGHT - 1));
+          GetPixel(std::min<u32>(state.texture_page_x + ZeroExtend32(texcoord_x / 2), VRAM_WIDTH - 1),
+                   std::min<u32>(state.texture_page_y + ZeroExtend32(texcoord_y), VRAM_HEIGHT - 1));
         const u16 palette_index = (palette_value >> ((texcoord_x % 2) * 8)) & 0xFFu;
         texture_color.bits =
-          GetPixel(std::min<u32>(m_draw_mode.texture_palette_x + ZeroExtend32(palette_index), VRAM_WIDTH - 1),
-                   m_draw_mode.texture_palette_y);
+          GetPixel(std::min<u32>(state.texture_palette_x + ZeroExtend32(palette_index), VRAM_WIDTH - 1),
+                   state.texture_palette_y);
       }
       break;
 
       default:
       {
         texture_color.bits =
-          GetPixel(std::min<u32>(m_draw_mode.texture_page_x + ZeroExtend32(texcoord_x), VRAM_WIDTH - 1),
-                   std::min<u32>(m_draw_mode.texture_page_y + ZeroExtend32(texcoord_y), VRAM_HEIGHT - 1));
+          GetPixel(std::min<u32>(state.texture_page_x + ZeroExtend32(texcoord_x), VRAM_WIDTH - 1),
+                   std::min<u32>(state.texture_page_y + ZeroExtend32(texcoord_y), VRAM_HEIGHT - 1));
       }
       break;
     }
@@ -569,7 +1070,7 @@ void GPU_SW::ShadePixel(u32 x, u32 y, u8 color_r, u8 color_g, u8 color_b, u8 tex
   color.Set(func(bg_color.r.GetValue(), color.r.GetValue()), func(bg_color.g.GetValue(), color.g.GetValue()),          \
             func(bg_color.b.GetValue(), color.b.GetValue()), color.c.GetValue())
 
-      switch (m_draw_mode.GetTransparencyMode())
+      switch (state.transparency_mode)
       {
         case GPU::TransparencyMode::HalfBackgroundPlusHalfForeground:
           BLEND_RGB(BLEND_AVERAGE);
@@ -600,11 +1101,11 @@ void GPU_SW::ShadePixel(u32 x, u32 y, u8 color_r, u8 color_g, u8 color_b, u8 tex
     UNREFERENCED_VARIABLE(transparent);
   }
 
-   const u16 mask_and = m_GPUSTAT.GetMaskAND();
-   if ((bg_color.bits & mask_and) != mask_and)
-     return;
+  const u16 mask_and = state.mask_and;
+  if ((bg_color.bits & mask_and) != mask_and)
+    return;
 
-  SetPixel(static_cast<u32>(x), static_cast<u32>(y), color.bits | m_GPUSTAT.GetMaskOR());
+  SetPixel(static_cast<u32>(x), static_cast<u32>(y), color.bits | state.mask_or);
 }
 
 constexpr FixedPointCoord GetLineCoordStep(s32 delta, s32 k)
@@ -629,7 +1130,7 @@ constexpr FixedPointColor GetLineColorStep(s32 delta, s32 k)
 }
 
 template<bool shading_enable, bool transparency_enable, bool dithering_enable>
-void GPU_SW::DrawLine(const SWVertex* p0, const SWVertex* p1)
+void GPU_SW::DrawLine(const SWDrawState& state, const SWVertex* p0, const SWVertex* p1)
 {
   // Algorithm based on Mednafen.
   if (p0->x > p1->x)
@@ -676,18 +1177,18 @@ void GPU_SW::DrawLine(const SWVertex* p0, const SWVertex* p1)
 
   for (s32 i = 0; i <= k; i++)
   {
-    const s32 x = m_drawing_offset.x + FixedToIntCoord(current_x);
-    const s32 y = m_drawing_offset.y + FixedToIntCoord(current_y);
+    const s32 x = state.drawing_offset_x + FixedToIntCoord(current_x);
+    const s32 y = state.drawing_offset_y + FixedToIntCoord(current_y);
 
     const u8 r = shading_enable ? FixedColorToInt(current_r) : p0->color_r;
     const u8 g = shading_enable ? FixedColorToInt(current_g) : p0->color_g;
     const u8 b = shading_enable ? FixedColorToInt(current_b) : p0->color_b;
 
-    if (x >= static_cast<s32>(m_drawing_area.left) && x <= static_cast<s32>(m_drawing_area.right) &&
-        y >= static_cast<s32>(m_drawing_area.top) && y <= static_cast<s32>(m_drawing_area.bottom))
+    if (x >= state.drawing_area_left && x <= state.drawing_area_right &&
+        y >= state.drawing_area_top && y <= state.drawing_area_bottom && state.IsRowInBand(y))
     {
-      ShadePixel<false, false, transparency_enable, dithering_enable>(static_cast<u32>(x), static_cast<u32>(y), r, g, b,
-                                                                      0, 0);
+      ShadePixel<false, false, transparency_enable, dithering_enable>(state, static_cast<u32>(x), static_cast<u32>(y),
+                                                                      r, g, b, 0, 0);
     }
 
     current_x += step_x;
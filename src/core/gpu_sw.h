@@ -1,7 +1,13 @@
 #pragma once
+#include "common/cpu_detect.h"
+#include "common/rectangle.h"
 #include "gpu.h"
 #include <array>
+#include <atomic>
+#include <condition_variable>
 #include <memory>
+#include <mutex>
+#include <thread>
 #include <vector>
 
 class HostDisplayTexture;
@@ -17,6 +23,7 @@ public:
   bool Initialize(HostDisplay* host_display, System* system, DMA* dma, InterruptController* interrupt_controller,
                   Timers* timers) override;
   void Reset() override;
+  void UpdateSettings() override;
 
   u16 GetPixel(u32 x, u32 y) const { return m_vram[VRAM_WIDTH * y + x]; }
   const u16* GetPixelPtr(u32 x, u32 y) const { return &m_vram[VRAM_WIDTH * y + x]; }
@@ -40,10 +47,134 @@ protected:
     ALWAYS_INLINE void SetTexcoord(u16 value) { std::tie(texcoord_x, texcoord_y) = UnpackTexcoord(value); }
   };
 
+  // Render state captured at the time a command is queued, as the GPU registers can change before it executes.
+  struct SWDrawState
+  {
+    s32 drawing_area_left;
+    s32 drawing_area_top;
+    s32 drawing_area_right;
+    s32 drawing_area_bottom;
+    s32 drawing_offset_x;
+    s32 drawing_offset_y;
+    u32 texture_page_x;
+    u32 texture_page_y;
+    u32 texture_palette_x;
+    u32 texture_palette_y;
+    u8 texture_window_and_x;
+    u8 texture_window_and_y;
+    u8 texture_window_or_x;
+    u8 texture_window_or_y;
+    TextureMode texture_mode;
+    TransparencyMode transparency_mode;
+    u16 mask_and;
+    u16 mask_or;
+
+    // Set when the texture page or CLUT overlaps the drawing area, so texels depend on the order pixels are written.
+    bool texture_reads_drawing_area;
+
+    // Interleaved scanlines owned by the thread executing the command, rows where (y % band_count) == band_index.
+    u32 band_index;
+    u32 band_count;
+
+    ALWAYS_INLINE bool IsRowInBand(s32 y) const { return (static_cast<u32>(y) % band_count) == band_index; }
+  };
+
+  using DrawTriangleFunction = void (GPU_SW::*)(const SWDrawState& state, const SWVertex* v0, const SWVertex* v1,
+                                                const SWVertex* v2);
+  using DrawRectangleFunction = void (GPU_SW::*)(const SWDrawState& state, s32 origin_x, s32 origin_y, u32 width,
+                                                 u32 height, u8 r, u8 g, u8 b, u8 origin_texcoord_x,
+                                                 u8 origin_texcoord_y);
+  using DrawLineFunction = void (GPU_SW::*)(const SWDrawState& state, const SWVertex* p0, const SWVertex* p1);
+  using CopyOutFunction = void (*)(const u16* src_ptr, u32 src_stride, u32* dst_ptr, u32 dst_stride, u32 width,
+                                   u32 height);
+
+  enum class SWCommandType : u8
+  {
+    DrawPolygon,
+    DrawRectangle,
+    DrawLine,
+    FillVRAM,
+    CopyVRAM
+  };
+
+  struct SWCommand
+  {
+    SWCommandType type;
+    u8 num_vertices;
+
+    // Set when the command depends on VRAM written by earlier commands in other bands, or vice versa. All workers
+    // must complete the previous commands before any of them start this one.
+    bool fence = false;
+
+    // Set when the command samples from VRAM.
+    bool textured = false;
+
+    // Set when the command reads from its own destination, or touches VRAM outside its bands. Executed by the first
+    // worker alone, after a fence.
+    bool exclusive = false;
+
+    union
+    {
+      DrawTriangleFunction draw_triangle;
+      DrawRectangleFunction draw_rectangle;
+      DrawLineFunction draw_line;
+    };
+    SWDrawState state;
+    std::array<SWVertex, 4> vertices;
+
+    // Rectangle size, or fill/copy coordinates.
+    std::array<u32, 6> params;
+  };
+
+  enum : u32
+  {
+    COMMAND_QUEUE_SIZE = 4096,
+    MAX_WORKER_THREADS = 16
+  };
+
+  struct alignas(64) WorkerThread
+  {
+    std::thread thread;
+
+    // Sequence number of the next command this worker will execute, i.e. all earlier commands are complete.
+    std::atomic<u64> read_seq{0};
+  };
+
   void ReadVRAM(u32 x, u32 y, u32 width, u32 height) override;
   void FillVRAM(u32 x, u32 y, u32 width, u32 height, u32 color) override;
+  void UpdateVRAM(u32 x, u32 y, u32 width, u32 height, const void* data) override;
   void CopyVRAM(u32 src_x, u32 src_y, u32 dst_x, u32 dst_y, u32 width, u32 height) override;
 
+  //////////////////////////////////////////////////////////////////////////
+  // Command queue
+  //////////////////////////////////////////////////////////////////////////
+  void FillDrawState(SWDrawState* state) const;
+  void SubmitCommand(SWCommand& cmd);
+  void ExecuteCommand(const SWCommand& cmd, u32 band_index, u32 band_count);
+
+  /// Determines whether a command can be rasterized in parallel with its neighbours when using multiple workers.
+  void UpdateCommandHazards(SWCommand& cmd);
+
+  static Common::Rectangle<u32> GetDrawingAreaRect(const SWDrawState& state);
+
+  /// Returns the area of VRAM a textured primitive can sample from, including the CLUT.
+  static Common::Rectangle<u32> GetTextureReadRect(const SWDrawState& state);
+
+  /// Returns the number of worker threads to use from the settings, or zero to rasterize on the emulation thread.
+  u32 GetWorkerThreadCount() const;
+  void StartWorkerThreads(u32 count);
+  void StopWorkerThreads();
+  void WorkerThreadEntryPoint(u32 index);
+
+  /// Returns the lowest sequence number which has not been completed by all workers.
+  u64 GetCompletedCommandSeq() const;
+
+  /// Waits for all queued commands to complete. Call before accessing VRAM from the emulation thread.
+  void SyncWorkerThread();
+
+  void DoFillVRAM(u32 x, u32 y, u32 width, u32 height, u16 color16);
+  void DoCopyVRAM(u32 src_x, u32 src_y, u32 dst_x, u32 dst_y, u32 width, u32 height, u16 mask_and, u16 mask_or);
+
   //////////////////////////////////////////////////////////////////////////
   // Scanout
   //////////////////////////////////////////////////////////////////////////
@@ -51,6 +182,27 @@ protected:
 
   static void CopyOut24Bit(const u16* src_ptr, u32 src_stride, u32* dst_ptr, u32 dst_stride, u32 width, u32 height);
 
+#ifdef CPU_X64
+  // gpu_sw_scanout.cpp
+  static void CopyOut15BitSSE2(const u16* src_ptr, u32 src_stride, u32* dst_ptr, u32 dst_stride, u32 width,
+                               u32 height);
+  static void CopyOut15BitAVX2(const u16* src_ptr, u32 src_stride, u32* dst_ptr, u32 dst_stride, u32 width,
+                               u32 height);
+  static void CopyOut24BitSSE41(const u16* src_ptr, u32 src_stride, u32* dst_ptr, u32 dst_stride, u32 width,
+                                u32 height);
+  static void CopyOut24BitAVX2(const u16* src_ptr, u32 src_stride, u32* dst_ptr, u32 dst_stride, u32 width,
+                               u32 height);
+#endif
+
+  /// Picks the fastest scanout conversions supported by the host CPU.
+  void SelectCopyOutFunctions();
+
+  /// Records a write to VRAM, wrapping coordinates are treated as touching the whole width/height.
+  void MarkVRAMDirty(u32 x, u32 y, u32 width, u32 height);
+
+  /// Returns false if the display texture already holds this area of VRAM, and it has not been written since.
+  bool IsScanoutRequired(u32 x, u32 y, u32 width, u32 height, bool is_24bit);
+
   void UpdateDisplay() override;
 
   //////////////////////////////////////////////////////////////////////////
@@ -62,33 +214,107 @@ protected:
   static bool IsClockwiseWinding(const SWVertex* v0, const SWVertex* v1, const SWVertex* v2);
 
   template<bool texture_enable, bool raw_texture_enable, bool transparency_enable, bool dithering_enable>
-  void ShadePixel(u32 x, u32 y, u8 color_r, u8 color_g, u8 color_b, u8 texcoord_x, u8 texcoord_y);
+  void ShadePixel(const SWDrawState& state, u32 x, u32 y, u8 color_r, u8 color_g, u8 color_b, u8 texcoord_x,
+                  u8 texcoord_y);
 
   template<bool shading_enable, bool texture_enable, bool raw_texture_enable, bool transparency_enable,
            bool dithering_enable>
-  void DrawTriangle(const SWVertex* v0, const SWVertex* v1, const SWVertex* v2);
+  void DrawTriangle(const SWDrawState& state, const SWVertex* v0, const SWVertex* v1, const SWVertex* v2);
 
-  using DrawTriangleFunction = void (GPU_SW::*)(const SWVertex* v0, const SWVertex* v1, const SWVertex* v2);
   DrawTriangleFunction GetDrawTriangleFunction(bool shading_enable, bool texture_enable, bool raw_texture_enable,
                                                bool transparency_enable, bool dithering_enable);
 
   template<bool texture_enable, bool raw_texture_enable, bool transparency_enable>
-  void DrawRectangle(s32 origin_x, s32 origin_y, u32 width, u32 height, u8 r, u8 g, u8 b, u8 origin_texcoord_x,
-                     u8 origin_texcoord_y);
+  void DrawRectangle(const SWDrawState& state, s32 origin_x, s32 origin_y, u32 width, u32 height, u8 r, u8 g, u8 b,
+                     u8 origin_texcoord_x, u8 origin_texcoord_y);
 
-  using DrawRectangleFunction = void (GPU_SW::*)(s32 origin_x, s32 origin_y, u32 width, u32 height, u8 r, u8 g, u8 b,
-                                                 u8 origin_texcoord_x, u8 origin_texcoord_y);
   DrawRectangleFunction GetDrawRectangleFunction(bool texture_enable, bool raw_texture_enable,
                                                  bool transparency_enable);
 
   template<bool shading_enable, bool transparency_enable, bool dithering_enable>
-  void DrawLine(const SWVertex* p0, const SWVertex* p1);
+  void DrawLine(const SWDrawState& state, const SWVertex* p0, const SWVertex* p1);
 
-  using DrawLineFunction = void (GPU_SW::*)(const SWVertex* p0, const SWVertex* p1);
   DrawLineFunction GetDrawLineFunction(bool shading_enable, bool transparency_enable, bool dithering_enable);
 
+  //////////////////////////////////////////////////////////////////////////
+  // Span shading
+  //////////////////////////////////////////////////////////////////////////
+
+  /// One row of a triangle, starting at x. The weights are the barycentric coordinates at x, before biasing.
+  struct SWTriangleSpan
+  {
+    const SWVertex* v0;
+    const SWVertex* v1;
+    const SWVertex* v2;
+    s32 x;
+    s32 y;
+    u32 width;
+    s32 w0, w1, w2;
+    s32 w0_step, w1_step, w2_step;
+    s32 w0_bias, w1_bias, w2_bias;
+    s32 ws;
+  };
+
+  /// One row of a rectangle, clipped to the drawing area. The texture coordinate is for the pixel at x.
+  struct SWRectangleSpan
+  {
+    s32 x;
+    s32 y;
+    u32 width;
+    u8 r, g, b;
+    u8 texcoord_x, texcoord_y;
+  };
+
+  using ShadeTriangleSpanFunction = void (*)(u16* vram, const SWDrawState& state, const SWTriangleSpan& span);
+  using ShadeRectangleSpanFunction = void (*)(u16* vram, const SWDrawState& state, const SWRectangleSpan& span);
+
+  struct SWSpanFunctions
+  {
+    const char* name;
+    ShadeTriangleSpanFunction triangle[2][2][2][2][2];
+    ShadeRectangleSpanFunction rectangle[2][2][2];
+  };
+
+  /// Vectorized span shaders, parameterized by the instruction set. Defined in gpu_sw_span.inl.
+  template<typename V>
+  struct SWSpanShader;
+
+  /// Picks the fastest span shaders supported by the host CPU, or none to shade one pixel at a time.
+  void SelectSpanFunctions();
+
+#ifdef CPU_X64
+  static const SWSpanFunctions* GetSpanFunctionsSSE41();
+  static const SWSpanFunctions* GetSpanFunctionsAVX2();
+#endif
+
   std::vector<u32> m_display_texture_buffer;
   std::unique_ptr<HostDisplayTexture> m_display_texture;
 
   std::array<u16, VRAM_WIDTH * VRAM_HEIGHT> m_vram;
+
+  const SWSpanFunctions* m_span_functions = nullptr;
+  CopyOutFunction m_copy_out_15bit = &GPU_SW::CopyOut15Bit;
+  CopyOutFunction m_copy_out_24bit = &GPU_SW::CopyOut24Bit;
+
+  // VRAM area held in the display texture, and VRAM written since it was copied out.
+  Common::Rectangle<u32> m_scanout_rect;
+  Common::Rectangle<u32> m_vram_dirty_rect;
+  bool m_scanout_24bit = false;
+
+  // Single-producer ring of commands, every worker executes every command for its own band.
+  std::vector<SWCommand> m_command_queue;
+  std::atomic<u64> m_command_queue_write_seq{0};
+
+  // VRAM read/written by commands queued since the last fence, for detecting hazards between bands.
+  Common::Rectangle<u32> m_pending_read_rect;
+  Common::Rectangle<u32> m_pending_write_rect;
+
+  std::array<WorkerThread, MAX_WORKER_THREADS> m_worker_threads;
+  u32 m_worker_thread_count = 0;
+  std::mutex m_worker_mutex;
+  std::condition_variable m_worker_wake_cv;
+  std::condition_variable m_worker_done_cv;
+  std::atomic<u32> m_sleeping_worker_count{0};
+  std::atomic_bool m_producer_waiting{false};
+  std::atomic_bool m_worker_shutdown{false};
 };
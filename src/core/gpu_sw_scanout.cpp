@@ -0,0 +1,157 @@
+#include "gpu_sw.h"
+
+#ifdef CPU_X64
+
+#include <immintrin.h>
+
+#ifdef _MSC_VER
+#define TARGET_SSE41
+#define TARGET_AVX2
+#else
+#define TARGET_SSE41 __attribute__((target("sse4.1")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+// Vectorized versions of GPU_SW::CopyOut15Bit and GPU_SW::CopyOut24Bit. The output must match the scalar versions,
+// which handle the remaining pixels of each row.
+
+void GPU_SW::CopyOut15BitSSE2(const u16* src_ptr, u32 src_stride, u32* dst_ptr, u32 dst_stride, u32 width,
+                              u32 height)
+{
+  const __m128i mask_5bit = _mm_set1_epi16(0x1F);
+  const __m128i mask_3bit = _mm_set1_epi16(0x07);
+  const __m128i mask_8bit = _mm_set1_epi16(0xFF);
+
+  for (u32 row = 0; row < height; row++)
+  {
+    u32 col = 0;
+    for (; (col + 8) <= width; col += 8)
+    {
+      const __m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src_ptr + col));
+
+      // 00012345 -> 12345345, matching RGBA5551ToRGBA8888().
+      const __m128i r = _mm_and_si128(value, mask_5bit);
+      const __m128i g = _mm_and_si128(_mm_srli_epi16(value, 5), mask_5bit);
+      const __m128i b = _mm_and_si128(_mm_srli_epi16(value, 10), mask_5bit);
+      const __m128i a = _mm_and_si128(_mm_srai_epi16(value, 15), mask_8bit);
+      const __m128i r8 = _mm_or_si128(_mm_slli_epi16(r, 3), _mm_and_si128(r, mask_3bit));
+      const __m128i g8 = _mm_or_si128(_mm_slli_epi16(g, 3), _mm_and_si128(g, mask_3bit));
+      const __m128i b8 = _mm_or_si128(_mm_slli_epi16(b, 3), _mm_and_si128(b, mask_3bit));
+
+      const __m128i rg = _mm_or_si128(r8, _mm_slli_epi16(g8, 8));
+      const __m128i ba = _mm_or_si128(b8, _mm_slli_epi16(a, 8));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(dst_ptr + col), _mm_unpacklo_epi16(rg, ba));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(dst_ptr + col + 4), _mm_unpackhi_epi16(rg, ba));
+    }
+
+    if (col < width)
+      CopyOut15Bit(src_ptr + col, src_stride, dst_ptr + col, dst_stride, width - col, 1);
+
+    src_ptr += src_stride;
+    dst_ptr += dst_stride;
+  }
+}
+
+TARGET_AVX2 void GPU_SW::CopyOut15BitAVX2(const u16* src_ptr, u32 src_stride, u32* dst_ptr, u32 dst_stride,
+                                          u32 width, u32 height)
+{
+  const __m256i mask_5bit = _mm256_set1_epi16(0x1F);
+  const __m256i mask_3bit = _mm256_set1_epi16(0x07);
+  const __m256i mask_8bit = _mm256_set1_epi16(0xFF);
+
+  for (u32 row = 0; row < height; row++)
+  {
+    u32 col = 0;
+    for (; (col + 16) <= width; col += 16)
+    {
+      const __m256i value = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src_ptr + col));
+
+      const __m256i r = _mm256_and_si256(value, mask_5bit);
+      const __m256i g = _mm256_and_si256(_mm256_srli_epi16(value, 5), mask_5bit);
+      const __m256i b = _mm256_and_si256(_mm256_srli_epi16(value, 10), mask_5bit);
+      const __m256i a = _mm256_and_si256(_mm256_srai_epi16(value, 15), mask_8bit);
+      const __m256i r8 = _mm256_or_si256(_mm256_slli_epi16(r, 3), _mm256_and_si256(r, mask_3bit));
+      const __m256i g8 = _mm256_or_si256(_mm256_slli_epi16(g, 3), _mm256_and_si256(g, mask_3bit));
+      const __m256i b8 = _mm256_or_si256(_mm256_slli_epi16(b, 3), _mm256_and_si256(b, mask_3bit));
+
+      const __m256i rg = _mm256_or_si256(r8, _mm256_slli_epi16(g8, 8));
+      const __m256i ba = _mm256_or_si256(b8, _mm256_slli_epi16(a, 8));
+
+      // Unpacking works within each 128-bit half, so this gives pixels 0-3,8-11 and 4-7,12-15.
+      const __m256i lo = _mm256_unpacklo_epi16(rg, ba);
+      const __m256i hi = _mm256_unpackhi_epi16(rg, ba);
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst_ptr + col), _mm256_permute2x128_si256(lo, hi, 0x20));
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst_ptr + col + 8), _mm256_permute2x128_si256(lo, hi, 0x31));
+    }
+
+    if (col < width)
+      CopyOut15BitSSE2(src_ptr + col, src_stride, dst_ptr + col, dst_stride, width - col, 1);
+
+    src_ptr += src_stride;
+    dst_ptr += dst_stride;
+  }
+}
+
+// Expands four packed 24-bit pixels to 32 bits. Like the scalar version, the fourth byte is the next pixel's red.
+static constexpr s8 COPY_OUT_24BIT_SHUFFLE[16] = {0, 1, 2, 3, 3, 4, 5, 6, 6, 7, 8, 9, 9, 10, 11, 12};
+
+TARGET_SSE41 void GPU_SW::CopyOut24BitSSE41(const u16* src_ptr, u32 src_stride, u32* dst_ptr, u32 dst_stride,
+                                            u32 width, u32 height)
+{
+  const __m128i shuffle = _mm_loadu_si128(reinterpret_cast<const __m128i*>(COPY_OUT_24BIT_SHUFFLE));
+
+  for (u32 row = 0; row < height; row++)
+  {
+    const u8* src_row_ptr = reinterpret_cast<const u8*>(src_ptr);
+
+    // Each group reads 16 bytes, so stop while the scalar loop would still read that far, to avoid overrunning VRAM.
+    u32 col = 0;
+    for (; (col + 4) < width; col += 4)
+    {
+      const __m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src_row_ptr + col * 3));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(dst_ptr + col), _mm_shuffle_epi8(value, shuffle));
+    }
+
+    if (col < width)
+    {
+      CopyOut24Bit(reinterpret_cast<const u16*>(src_row_ptr + col * 3), src_stride, dst_ptr + col, dst_stride,
+                   width - col, 1);
+    }
+
+    src_ptr += src_stride;
+    dst_ptr += dst_stride;
+  }
+}
+
+TARGET_AVX2 void GPU_SW::CopyOut24BitAVX2(const u16* src_ptr, u32 src_stride, u32* dst_ptr, u32 dst_stride,
+                                          u32 width, u32 height)
+{
+  const __m256i shuffle =
+    _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(COPY_OUT_24BIT_SHUFFLE)));
+
+  for (u32 row = 0; row < height; row++)
+  {
+    const u8* src_row_ptr = reinterpret_cast<const u8*>(src_ptr);
+
+    u32 col = 0;
+    for (; (col + 8) < width; col += 8)
+    {
+      const u8* src_pixel_ptr = src_row_ptr + col * 3;
+      const __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src_pixel_ptr));
+      const __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src_pixel_ptr + 12));
+      const __m256i value = _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst_ptr + col), _mm256_shuffle_epi8(value, shuffle));
+    }
+
+    if (col < width)
+    {
+      CopyOut24Bit(reinterpret_cast<const u16*>(src_row_ptr + col * 3), src_stride, dst_ptr + col, dst_stride,
+                   width - col, 1);
+    }
+
+    src_ptr += src_stride;
+    dst_ptr += dst_stride;
+  }
+}
+
+#endif
@@ -0,0 +1,369 @@
+#pragma once
+#include "gpu_sw.h"
+
+// Vectorized span shading for the software renderer. This file is included by a translation unit for each
+// instruction set, which first defines SPAN_TARGET and a vector type V providing:
+//   Vec, LANES, Zero, Set1, Ramp, Load, Store, LoadPixels, StorePixels, Add, Sub, MulLo, And, Or, AndNot,
+//   ShiftLeft, ShiftRight, Min, Max, CmpEq, CmpGt, Select, IsZero and DivTrunc.
+// Every lane holds one pixel as a 32-bit integer. The results must match GPU_SW::ShadePixel exactly.
+
+template<typename V>
+struct GPU_SW::SWSpanShader
+{
+  using Vec = typename V::Vec;
+  static constexpr u32 LANES = V::LANES;
+
+  static SPAN_TARGET ALWAYS_INLINE Vec Clamp(Vec v, s32 min, s32 max)
+  {
+    return V::Max(V::Min(v, V::Set1(max)), V::Set1(min));
+  }
+
+  static SPAN_TARGET ALWAYS_INLINE Vec Interpolate(Vec c0, Vec c1, Vec c2, Vec w0, Vec w1, Vec w2, s32 ws)
+  {
+    const Vec v = V::Add(V::Add(V::MulLo(w0, c0), V::MulLo(w1, c1)), V::MulLo(w2, c2));
+    return Clamp(V::DivTrunc(v, ws), 0, 0xFF);
+  }
+
+  static SPAN_TARGET ALWAYS_INLINE Vec PackRGB(Vec r, Vec g, Vec b)
+  {
+    return V::Or(V::Or(V::ShiftRight(r, 3), V::ShiftLeft(V::ShiftRight(g, 3), 5)),
+                 V::ShiftLeft(V::ShiftRight(b, 3), 10));
+  }
+
+  /// Multiplies a 5-bit texel component by an 8-bit vertex color, as in GPU_SW::ShadePixel.
+  static SPAN_TARGET ALWAYS_INLINE Vec Modulate(Vec texel5, Vec color)
+  {
+    const Vec texel8 = V::Or(V::ShiftLeft(texel5, 3), V::And(texel5, V::Set1(7)));
+    return V::Min(V::ShiftRight(V::MulLo(texel8, color), 7), V::Set1(0xFF));
+  }
+
+  static SPAN_TARGET ALWAYS_INLINE Vec GetDitherOffsets(s32 x, s32 y)
+  {
+    // Spans are processed in multiples of four pixels, so the pattern is the same for every group.
+    alignas(32) s32 offsets[LANES];
+    for (u32 i = 0; i < LANES; i++)
+      offsets[i] = DITHER_MATRIX[static_cast<u32>(y) & 3u][(static_cast<u32>(x) + i) & 3u];
+
+    return V::Load(offsets);
+  }
+
+  static SPAN_TARGET void FetchTexels(const u16* vram, const SWDrawState& state, Vec write_mask, Vec u, Vec v,
+                                      s32* texels)
+  {
+    alignas(32) s32 mask[LANES];
+    alignas(32) s32 us[LANES];
+    alignas(32) s32 vs[LANES];
+    V::Store(mask, write_mask);
+    V::Store(us, u);
+    V::Store(vs, v);
+
+    const u32 page_x = state.texture_page_x;
+    const u32 page_y = state.texture_page_y;
+    const u32 palette_x = state.texture_palette_x;
+    const u32 palette_row = state.texture_palette_y * VRAM_WIDTH;
+
+    for (u32 i = 0; i < LANES; i++)
+    {
+      if (!mask[i])
+      {
+        texels[i] = 0;
+        continue;
+      }
+
+      const u8 texcoord_x = (Truncate8(us[i]) & state.texture_window_and_x) | state.texture_window_or_x;
+      const u8 texcoord_y = (Truncate8(vs[i]) & state.texture_window_and_y) | state.texture_window_or_y;
+      const u32 row = std::min<u32>(page_y + ZeroExtend32(texcoord_y), VRAM_HEIGHT - 1) * VRAM_WIDTH;
+
+      switch (state.texture_mode)
+      {
+        case GPU::TextureMode::Palette4Bit:
+        {
+          const u16 palette_value = vram[row + std::min<u32>(page_x + ZeroExtend32(texcoord_x / 4), VRAM_WIDTH - 1)];
+          const u16 palette_index = (palette_value >> ((texcoord_x % 4) * 4)) & 0x0Fu;
+          texels[i] = vram[palette_row + std::min<u32>(palette_x + ZeroExtend32(palette_index), VRAM_WIDTH - 1)];
+        }
+        break;
+
+        case GPU::TextureMode::Palette8Bit:
+        {
+          const u16 palette_value = vram[row + std::min<u32>(page_x + ZeroExtend32(texcoord_x / 2), VRAM_WIDTH - 1)];
+          const u16 palette_index = (palette_value >> ((texcoord_x % 2) * 8)) & 0xFFu;
+          texels[i] = vram[palette_row + std::min<u32>(palette_x + ZeroExtend32(palette_index), VRAM_WIDTH - 1)];
+        }
+        break;
+
+        default:
+          texels[i] = vram[row + std::min<u32>(page_x + ZeroExtend32(texcoord_x), VRAM_WIDTH - 1)];
+          break;
+      }
+    }
+  }
+
+  /// Shades LANES pixels at dst. Lanes which are clear in write_mask are left untouched.
+  template<bool texture_enable, bool raw_texture_enable, bool transparency_enable, bool dithering_enable>
+  static SPAN_TARGET ALWAYS_INLINE void ShadeLanes(const u16* vram, const SWDrawState& state, u16* dst,
+                                                   Vec write_mask, Vec dither, Vec r, Vec g, Vec b, Vec u, Vec v)
+  {
+    const Vec mask_5bit = V::Set1(0x1F);
+    const Vec mask_c = V::Set1(0x8000);
+
+    Vec color;
+    Vec transparent;
+    if constexpr (texture_enable)
+    {
+      alignas(32) s32 texels[LANES];
+      FetchTexels(vram, state, write_mask, u, v, texels);
+
+      const Vec texel = V::Load(texels);
+      write_mask = V::AndNot(V::CmpEq(texel, V::Zero()), write_mask);
+      if (V::IsZero(write_mask))
+        return;
+
+      const Vec texel_c = V::And(texel, mask_c);
+      transparent = V::CmpEq(texel_c, mask_c);
+
+      if constexpr (raw_texture_enable)
+      {
+        color = texel;
+      }
+      else
+      {
+        Vec mr = Modulate(V::And(texel, mask_5bit), r);
+        Vec mg = Modulate(V::And(V::ShiftRight(texel, 5), mask_5bit), g);
+        Vec mb = Modulate(V::And(V::ShiftRight(texel, 10), mask_5bit), b);
+        if constexpr (dithering_enable)
+        {
+          mr = Clamp(V::Add(mr, dither), 0, 0xFF);
+          mg = Clamp(V::Add(mg, dither), 0, 0xFF);
+          mb = Clamp(V::Add(mb, dither), 0, 0xFF);
+        }
+
+        color = V::Or(PackRGB(mr, mg, mb), texel_c);
+      }
+    }
+    else
+    {
+      transparent = V::Set1(-1);
+
+      if constexpr (dithering_enable)
+      {
+        r = Clamp(V::Add(r, dither), 0, 0xFF);
+        g = Clamp(V::Add(g, dither), 0, 0xFF);
+        b = Clamp(V::Add(b, dither), 0, 0xFF);
+      }
+
+      color = PackRGB(r, g, b);
+    }
+
+    const Vec bg = V::LoadPixels(dst);
+    if constexpr (transparency_enable)
+    {
+      const Vec bg_r = V::And(bg, mask_5bit);
+      const Vec bg_g = V::And(V::ShiftRight(bg, 5), mask_5bit);
+      const Vec bg_b = V::And(V::ShiftRight(bg, 10), mask_5bit);
+      Vec fg_r = V::And(color, mask_5bit);
+      Vec fg_g = V::And(V::ShiftRight(color, 5), mask_5bit);
+      Vec fg_b = V::And(V::ShiftRight(color, 10), mask_5bit);
+
+      switch (state.transparency_mode)
+      {
+        case GPU::TransparencyMode::HalfBackgroundPlusHalfForeground:
+        {
+          fg_r = V::Add(V::ShiftRight(bg_r, 1), V::ShiftRight(fg_r, 1));
+          fg_g = V::Add(V::ShiftRight(bg_g, 1), V::ShiftRight(fg_g, 1));
+          fg_b = V::Add(V::ShiftRight(bg_b, 1), V::ShiftRight(fg_b, 1));
+        }
+        break;
+
+        case GPU::TransparencyMode::BackgroundPlusForeground:
+        {
+          fg_r = V::Min(V::Add(bg_r, fg_r), mask_5bit);
+          fg_g = V::Min(V::Add(bg_g, fg_g), mask_5bit);
+          fg_b = V::Min(V::Add(bg_b, fg_b), mask_5bit);
+        }
+        break;
+
+        case GPU::TransparencyMode::BackgroundMinusForeground:
+        {
+          fg_r = V::Max(V::Sub(bg_r, fg_r), V::Zero());
+          fg_g = V::Max(V::Sub(bg_g, fg_g), V::Zero());
+          fg_b = V::Max(V::Sub(bg_b, fg_b), V::Zero());
+        }
+        break;
+
+        case GPU::TransparencyMode::BackgroundPlusQuarterForeground:
+        {
+          fg_r = V::Min(V::Add(bg_r, V::ShiftRight(fg_r, 2)), mask_5bit);
+          fg_g = V::Min(V::Add(bg_g, V::ShiftRight(fg_g, 2)), mask_5bit);
+          fg_b = V::Min(V::Add(bg_b, V::ShiftRight(fg_b, 2)), mask_5bit);
+        }
+        break;
+
+        default:
+          break;
+      }
+
+      const Vec blended =
+        V::Or(V::Or(fg_r, V::ShiftLeft(fg_g, 5)), V::Or(V::ShiftLeft(fg_b, 10), V::And(color, mask_c)));
+      color = V::Select(transparent, blended, color);
+    }
+
+    const Vec mask_and = V::Set1(state.mask_and);
+    write_mask = V::And(write_mask, V::CmpEq(V::And(bg, mask_and), mask_and));
+    color = V::Or(color, V::Set1(state.mask_or));
+    V::StorePixels(dst, V::Select(write_mask, color, bg));
+  }
+
+  /// Shades a partial group through a temporary buffer, so nothing past the end of the span is accessed.
+  template<bool texture_enable, bool raw_texture_enable, bool transparency_enable, bool dithering_enable>
+  static SPAN_TARGET void ShadeTail(const u16* vram, const SWDrawState& state, u16* dst, u32 count, Vec write_mask,
+                                    Vec dither, Vec r, Vec g, Vec b, Vec u, Vec v)
+  {
+    u16 temp[LANES] = {};
+    std::copy_n(dst, count, temp);
+    ShadeLanes<texture_enable, raw_texture_enable, transparency_enable, dithering_enable>(vram, state, temp,
+                                                                                          write_mask, dither, r, g, b,
+                                                                                          u, v);
+    std::copy_n(temp, count, dst);
+  }
+
+  template<bool shading_enable, bool texture_enable, bool raw_texture_enable, bool transparency_enable,
+           bool dithering_enable>
+  static SPAN_TARGET void ShadeTriangle(u16* vram, const SWDrawState& state, const SWTriangleSpan& span)
+  {
+    const Vec ramp = V::Ramp();
+    const Vec w0_step = V::Set1(static_cast<s32>(static_cast<u32>(span.w0_step) * LANES));
+    const Vec w1_step = V::Set1(static_cast<s32>(static_cast<u32>(span.w1_step) * LANES));
+    const Vec w2_step = V::Set1(static_cast<s32>(static_cast<u32>(span.w2_step) * LANES));
+    const Vec w0_bias = V::Set1(span.w0_bias);
+    const Vec w1_bias = V::Set1(span.w1_bias);
+    const Vec w2_bias = V::Set1(span.w2_bias);
+    Vec w0 = V::Add(V::Set1(span.w0), V::MulLo(ramp, V::Set1(span.w0_step)));
+    Vec w1 = V::Add(V::Set1(span.w1), V::MulLo(ramp, V::Set1(span.w1_step)));
+    Vec w2 = V::Add(V::Set1(span.w2), V::MulLo(ramp, V::Set1(span.w2_step)));
+
+    const SWVertex* v0 = span.v0;
+    const SWVertex* v1 = span.v1;
+    const SWVertex* v2 = span.v2;
+    const Vec dither = dithering_enable ? GetDitherOffsets(span.x, span.y) : V::Zero();
+    u16* row = &vram[static_cast<u32>(span.y) * VRAM_WIDTH + static_cast<u32>(span.x)];
+
+    for (u32 offset = 0; offset < span.width; offset += LANES)
+    {
+      const u32 remaining = span.width - offset;
+      Vec inside = V::CmpGt(V::Or(V::Or(V::Add(w0, w0_bias), V::Add(w1, w1_bias)), V::Add(w2, w2_bias)), V::Set1(-1));
+      if (remaining < LANES)
+        inside = V::And(inside, V::CmpGt(V::Set1(static_cast<s32>(remaining)), ramp));
+
+      if (!V::IsZero(inside))
+      {
+        Vec r, g, b;
+        if constexpr (shading_enable)
+        {
+          r = Interpolate(V::Set1(v0->color_r), V::Set1(v1->color_r), V::Set1(v2->color_r), w0, w1, w2, span.ws);
+          g = Interpolate(V::Set1(v0->color_g), V::Set1(v1->color_g), V::Set1(v2->color_g), w0, w1, w2, span.ws);
+          b = Interpolate(V::Set1(v0->color_b), V::Set1(v1->color_b), V::Set1(v2->color_b), w0, w1, w2, span.ws);
+        }
+        else
+        {
+          r = V::Set1(v0->color_r);
+          g = V::Set1(v0->color_g);
+          b = V::Set1(v0->color_b);
+        }
+
+        Vec u, v;
+        if constexpr (texture_enable)
+        {
+          u = Interpolate(V::Set1(v0->texcoord_x), V::Set1(v1->texcoord_x), V::Set1(v2->texcoord_x), w0, w1, w2,
+                          span.ws);
+          v = Interpolate(V::Set1(v0->texcoord_y), V::Set1(v1->texcoord_y), V::Set1(v2->texcoord_y), w0, w1, w2,
+                          span.ws);
+        }
+        else
+        {
+          u = V::Zero();
+          v = V::Zero();
+        }
+
+        if (remaining >= LANES)
+        {
+          ShadeLanes<texture_enable, raw_texture_enable, transparency_enable, dithering_enable>(
+            vram, state, row + offset, inside, dither, r, g, b, u, v);
+        }
+        else
+        {
+          ShadeTail<texture_enable, raw_texture_enable, transparency_enable, dithering_enable>(
+            vram, state, row + offset, remaining, inside, dither, r, g, b, u, v);
+        }
+      }
+
+      w0 = V::Add(w0, w0_step);
+      w1 = V::Add(w1, w1_step);
+      w2 = V::Add(w2, w2_step);
+    }
+  }
+
+  template<bool texture_enable, bool raw_texture_enable, bool transparency_enable>
+  static SPAN_TARGET void ShadeRectangle(u16* vram, const SWDrawState& state, const SWRectangleSpan& span)
+  {
+    const Vec ramp = V::Ramp();
+    const Vec r = V::Set1(span.r);
+    const Vec g = V::Set1(span.g);
+    const Vec b = V::Set1(span.b);
+    const Vec v = V::Set1(span.texcoord_y);
+    Vec u = V::Add(V::Set1(span.texcoord_x), ramp);
+    u16* row = &vram[static_cast<u32>(span.y) * VRAM_WIDTH + static_cast<u32>(span.x)];
+
+    for (u32 offset = 0; offset < span.width; offset += LANES)
+    {
+      const u32 remaining = span.width - offset;
+      const Vec wrapped_u = V::And(u, V::Set1(0xFF));
+      if (remaining >= LANES)
+      {
+        ShadeLanes<texture_enable, raw_texture_enable, transparency_enable, false>(
+          vram, state, row + offset, V::Set1(-1), V::Zero(), r, g, b, wrapped_u, v);
+      }
+      else
+      {
+        ShadeTail<texture_enable, raw_texture_enable, transparency_enable, false>(
+          vram, state, row + offset, remaining, V::CmpGt(V::Set1(static_cast<s32>(remaining)), ramp), V::Zero(), r, g,
+          b, wrapped_u, v);
+      }
+
+      u = V::Add(u, V::Set1(LANES));
+    }
+  }
+
+  static const SWSpanFunctions* GetFunctions(const char* name)
+  {
+#define T(SHADING, TEXTURE, RAW_TEXTURE, TRANSPARENCY, DITHERING)                                                      \
+  &ShadeTriangle<SHADING, TEXTURE, RAW_TEXTURE, TRANSPARENCY, DITHERING>
+#define R(TEXTURE, RAW_TEXTURE, TRANSPARENCY) &ShadeRectangle<TEXTURE, RAW_TEXTURE, TRANSPARENCY>
+
+    static const SWSpanFunctions functions = {
+      name,
+      {{{{{T(false, false, false, false, false), T(false, false, false, false, true)},
+          {T(false, false, false, true, false), T(false, false, false, true, true)}},
+         {{T(false, false, true, false, false), T(false, false, true, false, true)},
+          {T(false, false, true, true, false), T(false, false, true, true, true)}}},
+        {{{T(false, true, false, false, false), T(false, true, false, false, true)},
+          {T(false, true, false, true, false), T(false, true, false, true, true)}},
+         {{T(false, true, true, false, false), T(false, true, true, false, true)},
+          {T(false, true, true, true, false), T(false, true, true, true, true)}}}},
+       {{{{T(true, false, false, false, false), T(true, false, false, false, true)},
+          {T(true, false, false, true, false), T(true, false, false, true, true)}},
+         {{T(true, false, true, false, false), T(true, false, true, false, true)},
+          {T(true, false, true, true, false), T(true, false, true, true, true)}}},
+        {{{T(true, true, false, false, false), T(true, true, false, false, true)},
+          {T(true, true, false, true, false), T(true, true, false, true, true)}},
+         {{T(true, true, true, false, false), T(true, true, true, false, true)},
+          {T(true, true, true, true, false), T(true, true, true, true, true)}}}}},
+      {{{R(false, false, false), R(false, false, true)}, {R(false, true, false), R(false, true, true)}},
+       {{R(true, false, false), R(true, false, true)}, {R(true, true, false), R(true, true, true)}}}};
+
+#undef R
+#undef T
+
+    return &functions;
+  }
+};
@@ -0,0 +1,72 @@
+#include "gpu_sw.h"
+
+#ifdef CPU_X64
+
+#include <algorithm>
+#include <immintrin.h>
+
+#ifdef _MSC_VER
+#define SPAN_TARGET
+#else
+#define SPAN_TARGET __attribute__((target("avx2")))
+#endif
+
+namespace {
+struct AVX2Vector
+{
+  using Vec = __m256i;
+  static constexpr u32 LANES = 8;
+
+  static SPAN_TARGET ALWAYS_INLINE Vec Zero() { return _mm256_setzero_si256(); }
+  static SPAN_TARGET ALWAYS_INLINE Vec Set1(s32 value) { return _mm256_set1_epi32(value); }
+  static SPAN_TARGET ALWAYS_INLINE Vec Ramp() { return _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7); }
+  static SPAN_TARGET ALWAYS_INLINE Vec Load(const s32* ptr)
+  {
+    return _mm256_loadu_si256(reinterpret_cast<const Vec*>(ptr));
+  }
+  static SPAN_TARGET ALWAYS_INLINE void Store(s32* ptr, Vec v) { _mm256_storeu_si256(reinterpret_cast<Vec*>(ptr), v); }
+
+  static SPAN_TARGET ALWAYS_INLINE Vec LoadPixels(const u16* ptr)
+  {
+    return _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(ptr)));
+  }
+  static SPAN_TARGET ALWAYS_INLINE void StorePixels(u16* ptr, Vec v)
+  {
+    const __m128i packed = _mm_packus_epi32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(ptr), packed);
+  }
+
+  static SPAN_TARGET ALWAYS_INLINE Vec Add(Vec a, Vec b) { return _mm256_add_epi32(a, b); }
+  static SPAN_TARGET ALWAYS_INLINE Vec Sub(Vec a, Vec b) { return _mm256_sub_epi32(a, b); }
+  static SPAN_TARGET ALWAYS_INLINE Vec MulLo(Vec a, Vec b) { return _mm256_mullo_epi32(a, b); }
+  static SPAN_TARGET ALWAYS_INLINE Vec And(Vec a, Vec b) { return _mm256_and_si256(a, b); }
+  static SPAN_TARGET ALWAYS_INLINE Vec Or(Vec a, Vec b) { return _mm256_or_si256(a, b); }
+  static SPAN_TARGET ALWAYS_INLINE Vec AndNot(Vec a, Vec b) { return _mm256_andnot_si256(a, b); }
+  static SPAN_TARGET ALWAYS_INLINE Vec ShiftLeft(Vec v, int n) { return _mm256_slli_epi32(v, n); }
+  static SPAN_TARGET ALWAYS_INLINE Vec ShiftRight(Vec v, int n) { return _mm256_srli_epi32(v, n); }
+  static SPAN_TARGET ALWAYS_INLINE Vec Min(Vec a, Vec b) { return _mm256_min_epi32(a, b); }
+  static SPAN_TARGET ALWAYS_INLINE Vec Max(Vec a, Vec b) { return _mm256_max_epi32(a, b); }
+  static SPAN_TARGET ALWAYS_INLINE Vec CmpEq(Vec a, Vec b) { return _mm256_cmpeq_epi32(a, b); }
+  static SPAN_TARGET ALWAYS_INLINE Vec CmpGt(Vec a, Vec b) { return _mm256_cmpgt_epi32(a, b); }
+  static SPAN_TARGET ALWAYS_INLINE Vec Select(Vec mask, Vec a, Vec b) { return _mm256_blendv_epi8(b, a, mask); }
+  static SPAN_TARGET ALWAYS_INLINE bool IsZero(Vec v) { return _mm256_testz_si256(v, v) != 0; }
+
+  /// Truncating signed division. Exact for 32-bit operands, since doubles hold them without rounding.
+  static SPAN_TARGET ALWAYS_INLINE Vec DivTrunc(Vec n, s32 d)
+  {
+    const __m256d dd = _mm256_set1_pd(static_cast<double>(d));
+    const __m128i lo = _mm256_cvttpd_epi32(_mm256_div_pd(_mm256_cvtepi32_pd(_mm256_castsi256_si128(n)), dd));
+    const __m128i hi = _mm256_cvttpd_epi32(_mm256_div_pd(_mm256_cvtepi32_pd(_mm256_extracti128_si256(n, 1)), dd));
+    return _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+  }
+};
+} // namespace
+
+#include "gpu_sw_span.inl"
+
+const GPU_SW::SWSpanFunctions* GPU_SW::GetSpanFunctionsAVX2()
+{
+  return SWSpanShader<AVX2Vector>::GetFunctions("AVX2");
+}
+
+#endif
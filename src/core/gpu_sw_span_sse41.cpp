@@ -0,0 +1,68 @@
+#include "gpu_sw.h"
+
+#ifdef CPU_X64
+
+#include <algorithm>
+#include <smmintrin.h>
+
+#ifdef _MSC_VER
+#define SPAN_TARGET
+#else
+#define SPAN_TARGET __attribute__((target("sse4.1")))
+#endif
+
+namespace {
+struct SSE41Vector
+{
+  using Vec = __m128i;
+  static constexpr u32 LANES = 4;
+
+  static SPAN_TARGET ALWAYS_INLINE Vec Zero() { return _mm_setzero_si128(); }
+  static SPAN_TARGET ALWAYS_INLINE Vec Set1(s32 value) { return _mm_set1_epi32(value); }
+  static SPAN_TARGET ALWAYS_INLINE Vec Ramp() { return _mm_setr_epi32(0, 1, 2, 3); }
+  static SPAN_TARGET ALWAYS_INLINE Vec Load(const s32* ptr) { return _mm_loadu_si128(reinterpret_cast<const Vec*>(ptr)); }
+  static SPAN_TARGET ALWAYS_INLINE void Store(s32* ptr, Vec v) { _mm_storeu_si128(reinterpret_cast<Vec*>(ptr), v); }
+
+  static SPAN_TARGET ALWAYS_INLINE Vec LoadPixels(const u16* ptr)
+  {
+    return _mm_cvtepu16_epi32(_mm_loadl_epi64(reinterpret_cast<const Vec*>(ptr)));
+  }
+  static SPAN_TARGET ALWAYS_INLINE void StorePixels(u16* ptr, Vec v)
+  {
+    _mm_storel_epi64(reinterpret_cast<Vec*>(ptr), _mm_packus_epi32(v, v));
+  }
+
+  static SPAN_TARGET ALWAYS_INLINE Vec Add(Vec a, Vec b) { return _mm_add_epi32(a, b); }
+  static SPAN_TARGET ALWAYS_INLINE Vec Sub(Vec a, Vec b) { return _mm_sub_epi32(a, b); }
+  static SPAN_TARGET ALWAYS_INLINE Vec MulLo(Vec a, Vec b) { return _mm_mullo_epi32(a, b); }
+  static SPAN_TARGET ALWAYS_INLINE Vec And(Vec a, Vec b) { return _mm_and_si128(a, b); }
+  static SPAN_TARGET ALWAYS_INLINE Vec Or(Vec a, Vec b) { return _mm_or_si128(a, b); }
+  static SPAN_TARGET ALWAYS_INLINE Vec AndNot(Vec a, Vec b) { return _mm_andnot_si128(a, b); }
+  static SPAN_TARGET ALWAYS_INLINE Vec ShiftLeft(Vec v, int n) { return _mm_slli_epi32(v, n); }
+  static SPAN_TARGET ALWAYS_INLINE Vec ShiftRight(Vec v, int n) { return _mm_srli_epi32(v, n); }
+  static SPAN_TARGET ALWAYS_INLINE Vec Min(Vec a, Vec b) { return _mm_min_epi32(a, b); }
+  static SPAN_TARGET ALWAYS_INLINE Vec Max(Vec a, Vec b) { return _mm_max_epi32(a, b); }
+  static SPAN_TARGET ALWAYS_INLINE Vec CmpEq(Vec a, Vec b) { return _mm_cmpeq_epi32(a, b); }
+  static SPAN_TARGET ALWAYS_INLINE Vec CmpGt(Vec a, Vec b) { return _mm_cmpgt_epi32(a, b); }
+  static SPAN_TARGET ALWAYS_INLINE Vec Select(Vec mask, Vec a, Vec b) { return _mm_blendv_epi8(b, a, mask); }
+  static SPAN_TARGET ALWAYS_INLINE bool IsZero(Vec v) { return _mm_testz_si128(v, v) != 0; }
+
+  /// Truncating signed division. Exact for 32-bit operands, since doubles hold them without rounding.
+  static SPAN_TARGET ALWAYS_INLINE Vec DivTrunc(Vec n, s32 d)
+  {
+    const __m128d dd = _mm_set1_pd(static_cast<double>(d));
+    const __m128i lo = _mm_cvttpd_epi32(_mm_div_pd(_mm_cvtepi32_pd(n), dd));
+    const __m128i hi = _mm_cvttpd_epi32(_mm_div_pd(_mm_cvtepi32_pd(_mm_unpackhi_epi64(n, n)), dd));
+    return _mm_unpacklo_epi64(lo, hi);
+  }
+};
+} // namespace
+
+#include "gpu_sw_span.inl"
+
+const GPU_SW::SWSpanFunctions* GPU_SW::GetSpanFunctionsSSE41()
+{
+  return SWSpanShader<SSE41Vector>::GetFunctions("SSE4.1");
+}
+
+#endif
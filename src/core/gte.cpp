@@ -44,7 +44,19 @@ Core::Core() = default;
 
 Core::~Core() = default;
 
-void Core::Initialize() {}
+void Core::Initialize()
+{
+  SetSIMDEnabled(true);
+}
+
+void Core::SetSIMDEnabled(bool enabled)
+{
+#ifdef CPU_X64
+  m_simd_enabled = enabled && CPUDetect::HasAVX2();
+#else
+  m_simd_enabled = false;
+#endif
+}
 
 void Core::Reset()
 {
@@ -179,116 +191,16 @@ void Core::WriteRegister(u32 index, u32 value)
   }
 }
 
-void Core::ExecuteInstruction(Instruction inst)
-{
-  // Panic("GTE instruction");
-
-  switch (inst.command)
-  {
-    case 0x01:
-      Execute_RTPS(inst);
-      break;
-
-    case 0x06:
-      Execute_NCLIP(inst);
-      break;
-
-    case 0x0C:
-      Execute_OP(inst);
-      break;
-
-    case 0x10:
-      Execute_DPCS(inst);
-      break;
-
-    case 0x11:
-      Execute_INTPL(inst);
-      break;
-
-    case 0x12:
-      Execute_MVMVA(inst);
-      break;
-
-    case 0x13:
-      Execute_NCDS(inst);
-      break;
-
-    case 0x14:
-      Execute_CDP(inst);
-      break;
-
-    case 0x16:
-      Execute_NCDT(inst);
-      break;
-
-    case 0x1B:
-      Execute_NCCS(inst);
-      break;
-
-    case 0x1C:
-      Execute_CC(inst);
-      break;
-
-    case 0x1E:
-      Execute_NCS(inst);
-      break;
-
-    case 0x20:
-      Execute_NCT(inst);
-      break;
-
-    case 0x28:
-      Execute_SQR(inst);
-      break;
-
-    case 0x29:
-      Execute_DCPL(inst);
-      break;
-
-    case 0x2A:
-      Execute_DPCT(inst);
-      break;
-
-    case 0x2D:
-      Execute_AVSZ3(inst);
-      break;
-
-    case 0x2E:
-      Execute_AVSZ4(inst);
-      break;
-
-    case 0x30:
-      Execute_RTPT(inst);
-      break;
-
-    case 0x3D:
-      Execute_GPF(inst);
-      break;
-
-    case 0x3E:
-      Execute_GPL(inst);
-      break;
-
-    case 0x3F:
-      Execute_NCCT(inst);
-      break;
-
-    default:
-      Panic("Missing handler");
-      break;
-  }
-}
-
 void Core::SetOTZ(s32 value)
 {
   if (value < 0)
   {
-    m_regs.FLAG.sz1_otz_saturated = true;
+    m_regs.FLAG.Set(m_regs.FLAG.sz1_otz_saturated);
     value = 0;
   }
   else if (value > 0xFFFF)
   {
-    m_regs.FLAG.sz1_otz_saturated = true;
+    m_regs.FLAG.Set(m_regs.FLAG.sz1_otz_saturated);
     value = 0xFFFF;
   }
 
@@ -299,23 +211,23 @@ void Core::PushSXY(s32 x, s32 y)
 {
   if (x < -1024)
   {
-    m_regs.FLAG.sx2_saturated = true;
+    m_regs.FLAG.Set(m_regs.FLAG.sx2_saturated);
     x = -1024;
   }
   else if (x > 1023)
   {
-    m_regs.FLAG.sx2_saturated = true;
+    m_regs.FLAG.Set(m_regs.FLAG.sx2_saturated);
     x = 1023;
   }
 
   if (y < -1024)
   {
-    m_regs.FLAG.sy2_saturated = true;
+    m_regs.FLAG.Set(m_regs.FLAG.sy2_saturated);
     y = -1024;
   }
   else if (y > 1023)
   {
-    m_regs.FLAG.sy2_saturated = true;
+    m_regs.FLAG.Set(m_regs.FLAG.sy2_saturated);
     y = 1023;
   }
 
@@ -329,12 +241,12 @@ void Core::PushSZ(s32 value)
 {
   if (value < 0)
   {
-    m_regs.FLAG.sz1_otz_saturated = true;
+    m_regs.FLAG.Set(m_regs.FLAG.sz1_otz_saturated);
     value = 0;
   }
   else if (value > 0xFFFF)
   {
-    m_regs.FLAG.sz1_otz_saturated = true;
+    m_regs.FLAG.Set(m_regs.FLAG.sz1_otz_saturated);
     value = 0xFFFF;
   }
 
@@ -361,7 +273,7 @@ u32 Core::UNRDivide(u32 lhs, u32 rhs)
 {
   if (rhs * 2 <= lhs)
   {
-    m_regs.FLAG.divide_overflow = true;
+    m_regs.FLAG.Set(m_regs.FLAG.divide_overflow);
     return 0x1FFFF;
   }
 
@@ -401,7 +313,7 @@ u32 Core::UNRDivide(u32 lhs, u32 rhs)
   return std::min<u32>(0x1FFFF, result);
 }
 
-void Core::MulMatVec(const s16 M[3][3], const s16 Vx, const s16 Vy, const s16 Vz, u8 shift, bool lm)
+ALWAYS_INLINE void Core::MulMatVec(const s16 M[3][3], const s16 Vx, const s16 Vy, const s16 Vz, u8 shift, bool lm)
 {
 #define dot3(i)                                                                                                        \
   TruncateAndSetMACAndIR<i + 1>(SignExtendMACResult<i + 1>((s64(M[i][0]) * s64(Vx)) + (s64(M[i][1]) * s64(Vy))) +      \
@@ -415,11 +327,11 @@ void Core::MulMatVec(const s16 M[3][3], const s16 Vx, const s16 Vy, const s16 Vz
 #undef dot3
 }
 
-void Core::MulMatVec(const s16 M[3][3], const s32 T[3], const s16 Vx, const s16 Vy, const s16 Vz, u8 shift, bool lm)
+ALWAYS_INLINE void Core::MulMatVec(const s16 M[3][3], const s32 T[3], const s16 Vx, const s16 Vy, const s16 Vz, u8 shift, bool lm)
 {
 #define dot3(i)                                                                                                        \
   TruncateAndSetMACAndIR<i + 1>(                                                                                       \
-    SignExtendMACResult<i + 1>(SignExtendMACResult<i + 1>((s64(T[i]) << 12) + (s64(M[i][0]) * s64(Vx))) +              \
+    SignExtendMACResult<i + 1>(SignExtendMACResult<i + 1>((s64(T[i]) * 4096) + (s64(M[i][0]) * s64(Vx))) +             \
                                (s64(M[i][1]) * s64(Vy))) +                                                             \
       (s64(M[i][2]) * s64(Vz)),                                                                                        \
     shift, lm)
@@ -431,7 +343,14 @@ void Core::MulMatVec(const s16 M[3][3], const s32 T[3], const s16 Vx, const s16
 #undef dot3
 }
 
-void Core::Execute_MVMVA(Instruction inst)
+ALWAYS_INLINE void Core::SetMACAndIR(const s64 MAC[3], u8 shift, bool lm)
+{
+  TruncateAndSetMACAndIR<1>(MAC[0], shift, lm);
+  TruncateAndSetMACAndIR<2>(MAC[1], shift, lm);
+  TruncateAndSetMACAndIR<3>(MAC[2], shift, lm);
+}
+
+ALWAYS_INLINE void Core::Execute_MVMVA(Instruction inst)
 {
   m_regs.FLAG.Clear();
 
@@ -511,7 +430,7 @@ void Core::Execute_MVMVA(Instruction inst)
   m_regs.FLAG.UpdateError();
 }
 
-void Core::Execute_SQR(Instruction inst)
+ALWAYS_INLINE void Core::Execute_SQR(Instruction inst)
 {
   m_regs.FLAG.Clear();
 
@@ -529,7 +448,7 @@ void Core::Execute_SQR(Instruction inst)
   m_regs.FLAG.UpdateError();
 }
 
-void Core::Execute_OP(Instruction inst)
+ALWAYS_INLINE void Core::Execute_OP(Instruction inst)
 {
   m_regs.FLAG.Clear();
 
@@ -552,20 +471,27 @@ void Core::Execute_OP(Instruction inst)
   m_regs.FLAG.UpdateError();
 }
 
-void Core::RTPS(const s16 V[3], u8 shift, bool lm, bool last)
+ALWAYS_INLINE void Core::RTPS(const s16 V[3], u8 shift, bool lm, bool last)
 {
 #define dot3(i)                                                                                                        \
   SignExtendMACResult<i + 1>(                                                                                          \
-    SignExtendMACResult<i + 1>((s64(m_regs.TR[i]) << 12) + (s64(m_regs.RT[i][0]) * s64(V[0]))) +                       \
+    SignExtendMACResult<i + 1>((s64(m_regs.TR[i]) * 4096) + (s64(m_regs.RT[i][0]) * s64(V[0]))) +                      \
     (s64(m_regs.RT[i][1]) * s64(V[1]))) +                                                                              \
     (s64(m_regs.RT[i][2]) * s64(V[2]))
 
   // IR1 = MAC1 = (TRX*1000h + RT11*VX0 + RT12*VY0 + RT13*VZ0) SAR (sf*12)
   // IR2 = MAC2 = (TRY*1000h + RT21*VX0 + RT22*VY0 + RT23*VZ0) SAR (sf*12)
   // IR3 = MAC3 = (TRZ*1000h + RT31*VX0 + RT32*VY0 + RT33*VZ0) SAR (sf*12)
-  const s64 x = dot3(0);
-  const s64 y = dot3(1);
-  const s64 z = dot3(2);
+  const s64 MAC[3] = {dot3(0), dot3(1), dot3(2)};
+  RTPS(MAC, shift, lm, last);
+#undef dot3
+}
+
+ALWAYS_INLINE void Core::RTPS(const s64 MAC[3], u8 shift, bool lm, bool last)
+{
+  const s64 x = MAC[0];
+  const s64 y = MAC[1];
+  const s64 z = MAC[2];
   TruncateAndSetMAC<1>(x, shift);
   TruncateAndSetMAC<2>(y, shift);
   TruncateAndSetMAC<3>(z, shift);
@@ -577,7 +503,6 @@ void Core::RTPS(const s16 V[3], u8 shift, bool lm, bool last)
   // when "MAC3" exceeds -8000h..+7FFFh).
   TruncateAndSetIR<3>(s32(z >> 12), false);
   m_regs.dr32[11] = std::clamp(m_regs.MAC3, lm ? 0 : IR123_MIN_VALUE, IR123_MAX_VALUE);
-#undef dot3
 
   // SZ3 = MAC3 SAR ((1-sf)*12)                           ;ScreenZ FIFO 0..+FFFFh
   PushSZ(s32(z >> 12));
@@ -600,20 +525,35 @@ void Core::RTPS(const s16 V[3], u8 shift, bool lm, bool last)
   }
 }
 
-void Core::Execute_RTPS(Instruction inst)
+ALWAYS_INLINE void Core::Execute_RTPS(Instruction inst)
 {
   m_regs.FLAG.Clear();
   RTPS(m_regs.V0, inst.GetShift(), inst.lm, true);
   m_regs.FLAG.UpdateError();
 }
 
-void Core::Execute_RTPT(Instruction inst)
+ALWAYS_INLINE void Core::Execute_RTPT(Instruction inst)
 {
   m_regs.FLAG.Clear();
 
   const u8 shift = inst.GetShift();
   const bool lm = inst.lm;
 
+#ifdef CPU_X64
+  if (m_simd_enabled)
+  {
+    // The three matrix multiplies are independent, only the projection has to happen in order.
+    const s16* const V[3] = {m_regs.V0, m_regs.V1, m_regs.V2};
+    s64 MAC[3][3];
+    m_regs.FLAG.bits |= MulMatVecAVX2(m_regs.RT, m_regs.TR, V, 3, MAC);
+    RTPS(MAC[0], shift, lm, false);
+    RTPS(MAC[1], shift, lm, false);
+    RTPS(MAC[2], shift, lm, true);
+    m_regs.FLAG.UpdateError();
+    return;
+  }
+#endif
+
   RTPS(m_regs.V0, shift, lm, false);
   RTPS(m_regs.V1, shift, lm, false);
   RTPS(m_regs.V2, shift, lm, true);
@@ -621,7 +561,7 @@ void Core::Execute_RTPT(Instruction inst)
   m_regs.FLAG.UpdateError();
 }
 
-void Core::Execute_NCLIP(Instruction inst)
+ALWAYS_INLINE void Core::Execute_NCLIP(Instruction inst)
 {
   // MAC0 =   SX0*SY1 + SX1*SY2 + SX2*SY0 - SX0*SY2 - SX1*SY0 - SX2*SY1
   m_regs.FLAG.Clear();
@@ -634,7 +574,7 @@ void Core::Execute_NCLIP(Instruction inst)
   m_regs.FLAG.UpdateError();
 }
 
-void Core::Execute_AVSZ3(Instruction inst)
+ALWAYS_INLINE void Core::Execute_AVSZ3(Instruction inst)
 {
   m_regs.FLAG.Clear();
 
@@ -645,7 +585,7 @@ void Core::Execute_AVSZ3(Instruction inst)
   m_regs.FLAG.UpdateError();
 }
 
-void Core::Execute_AVSZ4(Instruction inst)
+ALWAYS_INLINE void Core::Execute_AVSZ4(Instruction inst)
 {
   m_regs.FLAG.Clear();
 
@@ -656,13 +596,13 @@ void Core::Execute_AVSZ4(Instruction inst)
   m_regs.FLAG.UpdateError();
 }
 
-void Core::InterpolateColor(s64 in_MAC1, s64 in_MAC2, s64 in_MAC3, u8 shift, bool lm)
+ALWAYS_INLINE void Core::InterpolateColor(s64 in_MAC1, s64 in_MAC2, s64 in_MAC3, u8 shift, bool lm)
 {
   // [MAC1,MAC2,MAC3] = MAC+(FC-MAC)*IR0
   //   [IR1,IR2,IR3] = (([RFC,GFC,BFC] SHL 12) - [MAC1,MAC2,MAC3]) SAR (sf*12)
-  TruncateAndSetMACAndIR<1>((s64(m_regs.FC[0]) << 12) - in_MAC1, shift, false);
-  TruncateAndSetMACAndIR<2>((s64(m_regs.FC[1]) << 12) - in_MAC2, shift, false);
-  TruncateAndSetMACAndIR<3>((s64(m_regs.FC[2]) << 12) - in_MAC3, shift, false);
+  TruncateAndSetMACAndIR<1>((s64(m_regs.FC[0]) * 4096) - in_MAC1, shift, false);
+  TruncateAndSetMACAndIR<2>((s64(m_regs.FC[1]) * 4096) - in_MAC2, shift, false);
+  TruncateAndSetMACAndIR<3>((s64(m_regs.FC[2]) * 4096) - in_MAC3, shift, false);
 
   //   [MAC1,MAC2,MAC3] = (([IR1,IR2,IR3] * IR0) + [MAC1,MAC2,MAC3])
   // [MAC1,MAC2,MAC3] = [MAC1,MAC2,MAC3] SAR (sf*12)
@@ -671,7 +611,40 @@ void Core::InterpolateColor(s64 in_MAC1, s64 in_MAC2, s64 in_MAC3, u8 shift, boo
   TruncateAndSetMACAndIR<3>(s64(s32(m_regs.IR3) * s32(m_regs.IR0)) + in_MAC3, shift, lm);
 }
 
-void Core::NCS(const s16 V[3], u8 shift, bool lm)
+ALWAYS_INLINE void Core::MulColorIR(u8 shift, bool lm)
+{
+  TruncateAndSetMACAndIR<1>(s64(s32(ZeroExtend32(m_regs.RGBC[0])) * s32(m_regs.IR1)) * 16, shift, lm);
+  TruncateAndSetMACAndIR<2>(s64(s32(ZeroExtend32(m_regs.RGBC[1])) * s32(m_regs.IR2)) * 16, shift, lm);
+  TruncateAndSetMACAndIR<3>(s64(s32(ZeroExtend32(m_regs.RGBC[2])) * s32(m_regs.IR3)) * 16, shift, lm);
+}
+
+#ifdef CPU_X64
+
+ALWAYS_INLINE void Core::LightVerticesAVX2(u8 shift, bool lm, s64 MAC[3][3])
+{
+  // [IR1,IR2,IR3] = [MAC1,MAC2,MAC3] = (LLM*V) SAR (sf*12)
+  static constexpr s32 no_translation[3] = {};
+  const s16* const V[3] = {m_regs.V0, m_regs.V1, m_regs.V2};
+  m_regs.FLAG.bits |= MulMatVecAVX2(m_regs.LLM, no_translation, V, 3, MAC);
+
+  // Only the saturation flags of the first stage are visible, its MAC/IR values get overwritten.
+  s16 IR[3][3];
+  for (u32 i = 0; i < 3; i++)
+  {
+    SetMACAndIR(MAC[i], shift, lm);
+    IR[i][0] = m_regs.IR1;
+    IR[i][1] = m_regs.IR2;
+    IR[i][2] = m_regs.IR3;
+  }
+
+  // [IR1,IR2,IR3] = [MAC1,MAC2,MAC3] = (BK*1000h + LCM*IR) SAR (sf*12)
+  const s16* const LV[3] = {IR[0], IR[1], IR[2]};
+  m_regs.FLAG.bits |= MulMatVecAVX2(m_regs.LCM, m_regs.BK, LV, 3, MAC);
+}
+
+#endif
+
+ALWAYS_INLINE void Core::NCS(const s16 V[3], u8 shift, bool lm)
 {
   // [IR1,IR2,IR3] = [MAC1,MAC2,MAC3] = (LLM*V0) SAR (sf*12)
   MulMatVec(m_regs.LLM, V[0], V[1], V[2], shift, lm);
@@ -683,7 +656,7 @@ void Core::NCS(const s16 V[3], u8 shift, bool lm)
   PushRGBFromMAC();
 }
 
-void Core::Execute_NCS(Instruction inst)
+ALWAYS_INLINE void Core::Execute_NCS(Instruction inst)
 {
   m_regs.FLAG.Clear();
 
@@ -692,13 +665,29 @@ void Core::Execute_NCS(Instruction inst)
   m_regs.FLAG.UpdateError();
 }
 
-void Core::Execute_NCT(Instruction inst)
+ALWAYS_INLINE void Core::Execute_NCT(Instruction inst)
 {
   m_regs.FLAG.Clear();
 
   const u8 shift = inst.GetShift();
   const bool lm = inst.lm;
 
+#ifdef CPU_X64
+  if (m_simd_enabled)
+  {
+    s64 MAC[3][3];
+    LightVerticesAVX2(shift, lm, MAC);
+    for (u32 i = 0; i < 3; i++)
+    {
+      SetMACAndIR(MAC[i], shift, lm);
+      PushRGBFromMAC();
+    }
+
+    m_regs.FLAG.UpdateError();
+    return;
+  }
+#endif
+
   NCS(m_regs.V0, shift, lm);
   NCS(m_regs.V1, shift, lm);
   NCS(m_regs.V2, shift, lm);
@@ -706,7 +695,7 @@ void Core::Execute_NCT(Instruction inst)
   m_regs.FLAG.UpdateError();
 }
 
-void Core::NCCS(const s16 V[3], u8 shift, bool lm)
+ALWAYS_INLINE void Core::NCCS(const s16 V[3], u8 shift, bool lm)
 {
   // [IR1,IR2,IR3] = [MAC1,MAC2,MAC3] = (LLM*V0) SAR (sf*12)
   MulMatVec(m_regs.LLM, V[0], V[1], V[2], shift, lm);
@@ -714,17 +703,14 @@ void Core::NCCS(const s16 V[3], u8 shift, bool lm)
   // [IR1,IR2,IR3] = [MAC1,MAC2,MAC3] = (BK*1000h + LCM*IR) SAR (sf*12)
   MulMatVec(m_regs.LCM, m_regs.BK, m_regs.IR1, m_regs.IR2, m_regs.IR3, shift, lm);
 
-  // [MAC1,MAC2,MAC3] = [R*IR1,G*IR2,B*IR3] SHL 4          ;<--- for NCDx/NCCx
-  // [MAC1,MAC2,MAC3] = [MAC1,MAC2,MAC3] SAR (sf*12)       ;<--- for NCDx/NCCx
-  TruncateAndSetMACAndIR<1>(s64(s32(ZeroExtend32(m_regs.RGBC[0])) * s32(m_regs.IR1)) << 4, shift, lm);
-  TruncateAndSetMACAndIR<2>(s64(s32(ZeroExtend32(m_regs.RGBC[1])) * s32(m_regs.IR2)) << 4, shift, lm);
-  TruncateAndSetMACAndIR<3>(s64(s32(ZeroExtend32(m_regs.RGBC[2])) * s32(m_regs.IR3)) << 4, shift, lm);
+  // [MAC1,MAC2,MAC3] = [R*IR1,G*IR2,B*IR3] SHL 4 SAR (sf*12)
+  MulColorIR(shift, lm);
 
   // Color FIFO = [MAC1/16,MAC2/16,MAC3/16,CODE], [IR1,IR2,IR3] = [MAC1,MAC2,MAC3]
   PushRGBFromMAC();
 }
 
-void Core::Execute_NCCS(Instruction inst)
+ALWAYS_INLINE void Core::Execute_NCCS(Instruction inst)
 {
   m_regs.FLAG.Clear();
 
@@ -733,13 +719,30 @@ void Core::Execute_NCCS(Instruction inst)
   m_regs.FLAG.UpdateError();
 }
 
-void Core::Execute_NCCT(Instruction inst)
+ALWAYS_INLINE void Core::Execute_NCCT(Instruction inst)
 {
   m_regs.FLAG.Clear();
 
   const u8 shift = inst.GetShift();
   const bool lm = inst.lm;
 
+#ifdef CPU_X64
+  if (m_simd_enabled)
+  {
+    s64 MAC[3][3];
+    LightVerticesAVX2(shift, lm, MAC);
+    for (u32 i = 0; i < 3; i++)
+    {
+      SetMACAndIR(MAC[i], shift, lm);
+      MulColorIR(shift, lm);
+      PushRGBFromMAC();
+    }
+
+    m_regs.FLAG.UpdateError();
+    return;
+  }
+#endif
+
   NCCS(m_regs.V0, shift, lm);
   NCCS(m_regs.V1, shift, lm);
   NCCS(m_regs.V2, shift, lm);
@@ -747,7 +750,7 @@ void Core::Execute_NCCT(Instruction inst)
   m_regs.FLAG.UpdateError();
 }
 
-void Core::NCDS(const s16 V[3], u8 shift, bool lm)
+ALWAYS_INLINE void Core::NCDS(const s16 V[3], u8 shift, bool lm)
 {
   // [IR1,IR2,IR3] = [MAC1,MAC2,MAC3] = (LLM*V0) SAR (sf*12)
   MulMatVec(m_regs.LLM, V[0], V[1], V[2], shift, lm);
@@ -757,9 +760,9 @@ void Core::NCDS(const s16 V[3], u8 shift, bool lm)
 
   // No need to assign these to MAC[1-3], as it'll never overflow.
   // [MAC1,MAC2,MAC3] = [R*IR1,G*IR2,B*IR3] SHL 4          ;<--- for NCDx/NCCx
-  const s32 in_MAC1 = (s32(ZeroExtend32(m_regs.RGBC[0])) * s32(m_regs.IR1)) << 4;
-  const s32 in_MAC2 = (s32(ZeroExtend32(m_regs.RGBC[1])) * s32(m_regs.IR2)) << 4;
-  const s32 in_MAC3 = (s32(ZeroExtend32(m_regs.RGBC[2])) * s32(m_regs.IR3)) << 4;
+  const s32 in_MAC1 = (s32(ZeroExtend32(m_regs.RGBC[0])) * s32(m_regs.IR1)) * 16;
+  const s32 in_MAC2 = (s32(ZeroExtend32(m_regs.RGBC[1])) * s32(m_regs.IR2)) * 16;
+  const s32 in_MAC3 = (s32(ZeroExtend32(m_regs.RGBC[2])) * s32(m_regs.IR3)) * 16;
 
   // [MAC1,MAC2,MAC3] = MAC+(FC-MAC)*IR0                   ;<--- for NCDx only
   InterpolateColor(in_MAC1, in_MAC2, in_MAC3, shift, lm);
@@ -768,7 +771,7 @@ void Core::NCDS(const s16 V[3], u8 shift, bool lm)
   PushRGBFromMAC();
 }
 
-void Core::Execute_NCDS(Instruction inst)
+ALWAYS_INLINE void Core::Execute_NCDS(Instruction inst)
 {
   m_regs.FLAG.Clear();
 
@@ -777,7 +780,7 @@ void Core::Execute_NCDS(Instruction inst)
   m_regs.FLAG.UpdateError();
 }
 
-void Core::Execute_NCDT(Instruction inst)
+ALWAYS_INLINE void Core::Execute_NCDT(Instruction inst)
 {
   m_regs.FLAG.Clear();
 
@@ -791,7 +794,7 @@ void Core::Execute_NCDT(Instruction inst)
   m_regs.FLAG.UpdateError();
 }
 
-void Core::Execute_CC(Instruction inst)
+ALWAYS_INLINE void Core::Execute_CC(Instruction inst)
 {
   m_regs.FLAG.Clear();
 
@@ -801,11 +804,8 @@ void Core::Execute_CC(Instruction inst)
   // [IR1,IR2,IR3] = [MAC1,MAC2,MAC3] = (BK*1000h + LCM*IR) SAR (sf*12)
   MulMatVec(m_regs.LCM, m_regs.BK, m_regs.IR1, m_regs.IR2, m_regs.IR3, shift, lm);
 
-  // [MAC1,MAC2,MAC3] = [R*IR1,G*IR2,B*IR3] SHL 4
-  // [MAC1,MAC2,MAC3] = [MAC1,MAC2,MAC3] SAR (sf*12)
-  TruncateAndSetMACAndIR<1>(s64(s32(ZeroExtend32(m_regs.RGBC[0])) * s32(m_regs.IR1)) << 4, shift, lm);
-  TruncateAndSetMACAndIR<2>(s64(s32(ZeroExtend32(m_regs.RGBC[1])) * s32(m_regs.IR2)) << 4, shift, lm);
-  TruncateAndSetMACAndIR<3>(s64(s32(ZeroExtend32(m_regs.RGBC[2])) * s32(m_regs.IR3)) << 4, shift, lm);
+  // [MAC1,MAC2,MAC3] = [R*IR1,G*IR2,B*IR3] SHL 4 SAR (sf*12)
+  MulColorIR(shift, lm);
 
   // Color FIFO = [MAC1/16,MAC2/16,MAC3/16,CODE], [IR1,IR2,IR3] = [MAC1,MAC2,MAC3]
   PushRGBFromMAC();
@@ -813,7 +813,7 @@ void Core::Execute_CC(Instruction inst)
   m_regs.FLAG.UpdateError();
 }
 
-void Core::Execute_CDP(Instruction inst)
+ALWAYS_INLINE void Core::Execute_CDP(Instruction inst)
 {
   m_regs.FLAG.Clear();
 
@@ -825,9 +825,9 @@ void Core::Execute_CDP(Instruction inst)
 
   // No need to assign these to MAC[1-3], as it'll never overflow.
   // [MAC1,MAC2,MAC3] = [R*IR1,G*IR2,B*IR3] SHL 4
-  const s32 in_MAC1 = (s32(ZeroExtend32(m_regs.RGBC[0])) * s32(m_regs.IR1)) << 4;
-  const s32 in_MAC2 = (s32(ZeroExtend32(m_regs.RGBC[1])) * s32(m_regs.IR2)) << 4;
-  const s32 in_MAC3 = (s32(ZeroExtend32(m_regs.RGBC[2])) * s32(m_regs.IR3)) << 4;
+  const s32 in_MAC1 = (s32(ZeroExtend32(m_regs.RGBC[0])) * s32(m_regs.IR1)) * 16;
+  const s32 in_MAC2 = (s32(ZeroExtend32(m_regs.RGBC[1])) * s32(m_regs.IR2)) * 16;
+  const s32 in_MAC3 = (s32(ZeroExtend32(m_regs.RGBC[2])) * s32(m_regs.IR3)) * 16;
 
   // [MAC1,MAC2,MAC3] = MAC+(FC-MAC)*IR0                   ;<--- for CDP only
   // [MAC1, MAC2, MAC3] = [MAC1, MAC2, MAC3] SAR(sf * 12)
@@ -839,7 +839,7 @@ void Core::Execute_CDP(Instruction inst)
   m_regs.FLAG.UpdateError();
 }
 
-void Core::DPCS(const u8 color[3], u8 shift, bool lm)
+ALWAYS_INLINE void Core::DPCS(const u8 color[3], u8 shift, bool lm)
 {
   // In: [IR1,IR2,IR3]=Vector, FC=Far Color, IR0=Interpolation value, CODE=MSB of RGBC
   // [MAC1,MAC2,MAC3] = [R,G,B] SHL 16                     ;<--- for DPCS/DPCT
@@ -854,7 +854,7 @@ void Core::DPCS(const u8 color[3], u8 shift, bool lm)
   PushRGBFromMAC();
 }
 
-void Core::Execute_DPCS(Instruction inst)
+ALWAYS_INLINE void Core::Execute_DPCS(Instruction inst)
 {
   m_regs.FLAG.Clear();
 
@@ -863,7 +863,7 @@ void Core::Execute_DPCS(Instruction inst)
   m_regs.FLAG.UpdateError();
 }
 
-void Core::Execute_DPCT(Instruction inst)
+ALWAYS_INLINE void Core::Execute_DPCT(Instruction inst)
 {
   m_regs.FLAG.Clear();
 
@@ -876,7 +876,7 @@ void Core::Execute_DPCT(Instruction inst)
   m_regs.FLAG.UpdateError();
 }
 
-void Core::Execute_DCPL(Instruction inst)
+ALWAYS_INLINE void Core::Execute_DCPL(Instruction inst)
 {
   m_regs.FLAG.Clear();
 
@@ -885,9 +885,9 @@ void Core::Execute_DCPL(Instruction inst)
 
   // No need to assign these to MAC[1-3], as it'll never overflow.
   // [MAC1,MAC2,MAC3] = [R*IR1,G*IR2,B*IR3] SHL 4          ;<--- for DCPL only
-  const s32 in_MAC1 = (s32(ZeroExtend32(m_regs.RGBC[0])) * s32(m_regs.IR1)) << 4;
-  const s32 in_MAC2 = (s32(ZeroExtend32(m_regs.RGBC[1])) * s32(m_regs.IR2)) << 4;
-  const s32 in_MAC3 = (s32(ZeroExtend32(m_regs.RGBC[2])) * s32(m_regs.IR3)) << 4;
+  const s32 in_MAC1 = (s32(ZeroExtend32(m_regs.RGBC[0])) * s32(m_regs.IR1)) * 16;
+  const s32 in_MAC2 = (s32(ZeroExtend32(m_regs.RGBC[1])) * s32(m_regs.IR2)) * 16;
+  const s32 in_MAC3 = (s32(ZeroExtend32(m_regs.RGBC[2])) * s32(m_regs.IR3)) * 16;
 
   // [MAC1,MAC2,MAC3] = MAC+(FC-MAC)*IR0
   InterpolateColor(in_MAC1, in_MAC2, in_MAC3, shift, lm);
@@ -898,7 +898,7 @@ void Core::Execute_DCPL(Instruction inst)
   m_regs.FLAG.UpdateError();
 }
 
-void Core::Execute_INTPL(Instruction inst)
+ALWAYS_INLINE void Core::Execute_INTPL(Instruction inst)
 {
   m_regs.FLAG.Clear();
 
@@ -908,7 +908,7 @@ void Core::Execute_INTPL(Instruction inst)
   // No need to assign these to MAC[1-3], as it'll never overflow.
   // [MAC1,MAC2,MAC3] = [IR1,IR2,IR3] SHL 12               ;<--- for INTPL only
   // [MAC1,MAC2,MAC3] = MAC+(FC-MAC)*IR0
-  InterpolateColor(s32(m_regs.IR1) << 12, s32(m_regs.IR2) << 12, s32(m_regs.IR3) << 12, shift, lm);
+  InterpolateColor(s32(m_regs.IR1) * 4096, s32(m_regs.IR2) * 4096, s32(m_regs.IR3) * 4096, shift, lm);
 
   // Color FIFO = [MAC1/16,MAC2/16,MAC3/16,CODE], [IR1,IR2,IR3] = [MAC1,MAC2,MAC3]
   PushRGBFromMAC();
@@ -916,7 +916,7 @@ void Core::Execute_INTPL(Instruction inst)
   m_regs.FLAG.UpdateError();
 }
 
-void Core::Execute_GPL(Instruction inst)
+ALWAYS_INLINE void Core::Execute_GPL(Instruction inst)
 {
   m_regs.FLAG.Clear();
 
@@ -935,7 +935,7 @@ void Core::Execute_GPL(Instruction inst)
   m_regs.FLAG.UpdateError();
 }
 
-void Core::Execute_GPF(Instruction inst)
+ALWAYS_INLINE void Core::Execute_GPF(Instruction inst)
 {
   m_regs.FLAG.Clear();
 
@@ -954,4 +954,147 @@ void Core::Execute_GPF(Instruction inst)
   m_regs.FLAG.UpdateError();
 }
 
+void Core::ExecuteInstruction(Instruction inst)
+{
+  GetInstructionImpl(inst)(this);
+}
+
+template<u32 bits>
+void Core::ExecuteInstructionImpl(Core* gte)
+{
+  // bits is a constant, so this switch and the shift/lm/MVMVA operand selection fold away.
+  const Instruction inst{bits};
+
+  switch (inst.command)
+  {
+    case 0x01:
+      gte->Execute_RTPS(inst);
+      break;
+
+    case 0x06:
+      gte->Execute_NCLIP(inst);
+      break;
+
+    case 0x0C:
+      gte->Execute_OP(inst);
+      break;
+
+    case 0x10:
+      gte->Execute_DPCS(inst);
+      break;
+
+    case 0x11:
+      gte->Execute_INTPL(inst);
+      break;
+
+    case 0x12:
+      gte->Execute_MVMVA(inst);
+      break;
+
+    case 0x13:
+      gte->Execute_NCDS(inst);
+      break;
+
+    case 0x14:
+      gte->Execute_CDP(inst);
+      break;
+
+    case 0x16:
+      gte->Execute_NCDT(inst);
+      break;
+
+    case 0x1B:
+      gte->Execute_NCCS(inst);
+      break;
+
+    case 0x1C:
+      gte->Execute_CC(inst);
+      break;
+
+    case 0x1E:
+      gte->Execute_NCS(inst);
+      break;
+
+    case 0x20:
+      gte->Execute_NCT(inst);
+      break;
+
+    case 0x28:
+      gte->Execute_SQR(inst);
+      break;
+
+    case 0x29:
+      gte->Execute_DCPL(inst);
+      break;
+
+    case 0x2A:
+      gte->Execute_DPCT(inst);
+      break;
+
+    case 0x2D:
+      gte->Execute_AVSZ3(inst);
+      break;
+
+    case 0x2E:
+      gte->Execute_AVSZ4(inst);
+      break;
+
+    case 0x30:
+      gte->Execute_RTPT(inst);
+      break;
+
+    case 0x3D:
+      gte->Execute_GPF(inst);
+      break;
+
+    case 0x3E:
+      gte->Execute_GPL(inst);
+      break;
+
+    case 0x3F:
+      gte->Execute_NCCT(inst);
+      break;
+
+    default:
+      Panic("Missing handler");
+      break;
+  }
+}
+
+// Command tables are indexed by the command bits, lm and sf. MVMVA has its own table, which also includes the matrix,
+// vector and translation selection.
+static constexpr u32 GetCommandTableBits(u32 index)
+{
+  return (index & 0x3F) | (((index >> 6) & 1) << 10) | (((index >> 7) & 1) << 19);
+}
+
+static constexpr u32 GetMVMVATableBits(u32 index)
+{
+  return 0x12 | ((index & 1) << 10) | (((index >> 1) & 1) << 19) | (((index >> 2) & 3) << 13) |
+         (((index >> 4) & 3) << 15) | (((index >> 6) & 3) << 17);
+}
+
+template<u32 (*GetBits)(u32), size_t... I>
+constexpr std::array<Core::InstructionImpl, sizeof...(I)> Core::MakeInstructionImplTable(std::index_sequence<I...>)
+{
+  return {{&ExecuteInstructionImpl<GetBits(static_cast<u32>(I))>...}};
+}
+
+Core::InstructionImpl Core::GetInstructionImpl(Instruction inst)
+{
+  static constexpr auto command_table = MakeInstructionImplTable<GetCommandTableBits>(std::make_index_sequence<256>());
+  static constexpr auto mvmva_table = MakeInstructionImplTable<GetMVMVATableBits>(std::make_index_sequence<256>());
+
+  if (inst.command == 0x12)
+  {
+    return mvmva_table[ZeroExtend32(static_cast<u8>(inst.lm)) | (ZeroExtend32(inst.sf.GetValue()) << 1) |
+                       (ZeroExtend32(inst.mvmva_translation_vector.GetValue()) << 2) |
+                       (ZeroExtend32(inst.mvmva_multiply_vector.GetValue()) << 4) |
+                       (ZeroExtend32(inst.mvmva_multiply_matrix.GetValue()) << 6)];
+  }
+
+  return command_table[ZeroExtend32(inst.command.GetValue()) | (ZeroExtend32(static_cast<u8>(inst.lm)) << 6) |
+                       (ZeroExtend32(inst.sf.GetValue()) << 7)];
+}
+
 } // namespace GTE
@@ -1,6 +1,9 @@
 #pragma once
+#include "common/cpu_detect.h"
 #include "common/state_wrapper.h"
 #include "gte_types.h"
+#include <array>
+#include <utility>
 
 namespace CPU {
 class Core;
@@ -31,6 +34,17 @@ public:
 
   void ExecuteInstruction(Instruction inst);
 
+  /// Entry point for a single command, with its shift, saturation and MVMVA operands fixed at compile time.
+  using InstructionImpl = void (*)(Core* gte);
+
+  /// Returns the entry point for the command in inst. Used by the recompiler to skip decoding at runtime.
+  static InstructionImpl GetInstructionImpl(Instruction inst);
+
+  /// Enables the vectorized versions of RTPT, NCT and NCCT, if the host supports them. On by default after
+  /// Initialize(). The results are identical either way, this exists so the two can be compared.
+  void SetSIMDEnabled(bool enabled);
+  bool IsSIMDEnabled() const { return m_simd_enabled; }
+
 private:
   static constexpr s64 MAC0_MIN_VALUE = -(INT64_C(1) << 31);
   static constexpr s64 MAC0_MAX_VALUE = (INT64_C(1) << 31) - 1;
@@ -75,15 +89,39 @@ private:
   // 3x3 matrix * 3x1 vector with translation, updates MAC[1-3] and IR[1-3]
   void MulMatVec(const s16 M[3][3], const s32 T[3], const s16 Vx, const s16 Vy, const s16 Vz, u8 shift, bool lm);
 
+  // Sets MAC[1-3] and IR[1-3] from the untruncated results of a matrix * vector product.
+  void SetMACAndIR(const s64 MAC[3], u8 shift, bool lm);
+
+#ifdef CPU_X64
+  // gte_avx2.cpp
+  // T*1000h + M*V for count vectors, without truncating the results. Returns the FLAG bits for overflows in the
+  // partial sums, which the scalar version sets as it goes.
+  static u32 MulMatVecAVX2(const s16 M[3][3], const s32 T[3], const s16* const V[], u32 count, s64 results[][3]);
+
+  // Light matrix and light colour stages of NCT/NCCT for all three vertices. Returns the untruncated results of the
+  // second stage for each vertex, which the caller applies in order.
+  void LightVerticesAVX2(u8 shift, bool lm, s64 MAC[3][3]);
+#endif
+
+  // [MAC1,MAC2,MAC3] = [R*IR1,G*IR2,B*IR3] SHL 4 SAR (sf*12), updates IR[1-3]
+  void MulColorIR(u8 shift, bool lm);
+
   // Interpolate colour, or as in nocash "MAC+(FC-MAC)*IR0".
   void InterpolateColor(s64 in_MAC1, s64 in_MAC2, s64 in_MAC3, u8 shift, bool lm);
 
   void RTPS(const s16 V[3], u8 shift, bool lm, bool last);
+  void RTPS(const s64 MAC[3], u8 shift, bool lm, bool last);
   void NCS(const s16 V[3], u8 shift, bool lm);
   void NCCS(const s16 V[3], u8 shift, bool lm);
   void NCDS(const s16 V[3], u8 shift, bool lm);
   void DPCS(const u8 color[3], u8 shift, bool lm);
 
+  template<u32 bits>
+  static void ExecuteInstructionImpl(Core* gte);
+
+  template<u32 (*GetBits)(u32), size_t... I>
+  static constexpr std::array<InstructionImpl, sizeof...(I)> MakeInstructionImplTable(std::index_sequence<I...>);
+
   void Execute_MVMVA(Instruction inst);
   void Execute_SQR(Instruction inst);
   void Execute_OP(Instruction inst);
@@ -108,6 +146,7 @@ private:
   void Execute_GPF(Instruction inst);
 
   Regs m_regs = {};
+  bool m_simd_enabled = false;
 };
 
 #include "gte.inl"
@@ -8,24 +8,24 @@ void GTE::Core::CheckMACOverflow(s64 value)
   if (value < MIN_VALUE)
   {
     if constexpr (index == 0)
-      m_regs.FLAG.mac0_underflow = true;
+      m_regs.FLAG.Set(m_regs.FLAG.mac0_underflow);
     else if constexpr (index == 1)
-      m_regs.FLAG.mac1_underflow = true;
+      m_regs.FLAG.Set(m_regs.FLAG.mac1_underflow);
     else if constexpr (index == 2)
-      m_regs.FLAG.mac2_underflow = true;
+      m_regs.FLAG.Set(m_regs.FLAG.mac2_underflow);
     else if constexpr (index == 3)
-      m_regs.FLAG.mac3_underflow = true;
+      m_regs.FLAG.Set(m_regs.FLAG.mac3_underflow);
   }
   else if (value > MAX_VALUE)
   {
     if constexpr (index == 0)
-      m_regs.FLAG.mac0_overflow = true;
+      m_regs.FLAG.Set(m_regs.FLAG.mac0_overflow);
     else if constexpr (index == 1)
-      m_regs.FLAG.mac1_overflow = true;
+      m_regs.FLAG.Set(m_regs.FLAG.mac1_overflow);
     else if constexpr (index == 2)
-      m_regs.FLAG.mac2_overflow = true;
+      m_regs.FLAG.Set(m_regs.FLAG.mac2_overflow);
     else if constexpr (index == 3)
-      m_regs.FLAG.mac3_overflow = true;
+      m_regs.FLAG.Set(m_regs.FLAG.mac3_overflow);
   }
 }
 
@@ -57,25 +57,25 @@ void GTE::Core::TruncateAndSetIR(s32 value, bool lm)
   {
     value = actual_min_value;
     if constexpr (index == 0)
-      m_regs.FLAG.ir0_saturated = true;
+      m_regs.FLAG.Set(m_regs.FLAG.ir0_saturated);
     else if constexpr (index == 1)
-      m_regs.FLAG.ir1_saturated = true;
+      m_regs.FLAG.Set(m_regs.FLAG.ir1_saturated);
     else if constexpr (index == 2)
-      m_regs.FLAG.ir2_saturated = true;
+      m_regs.FLAG.Set(m_regs.FLAG.ir2_saturated);
     else if constexpr (index == 3)
-      m_regs.FLAG.ir3_saturated = true;
+      m_regs.FLAG.Set(m_regs.FLAG.ir3_saturated);
   }
   else if (value > MAX_VALUE)
   {
     value = MAX_VALUE;
     if constexpr (index == 0)
-      m_regs.FLAG.ir0_saturated = true;
+      m_regs.FLAG.Set(m_regs.FLAG.ir0_saturated);
     else if constexpr (index == 1)
-      m_regs.FLAG.ir1_saturated = true;
+      m_regs.FLAG.Set(m_regs.FLAG.ir1_saturated);
     else if constexpr (index == 2)
-      m_regs.FLAG.ir2_saturated = true;
+      m_regs.FLAG.Set(m_regs.FLAG.ir2_saturated);
     else if constexpr (index == 3)
-      m_regs.FLAG.ir3_saturated = true;
+      m_regs.FLAG.Set(m_regs.FLAG.ir3_saturated);
   }
 
   // store sign-extended 16-bit value as 32-bit
@@ -104,11 +104,11 @@ u32 GTE::Core::TruncateRGB(s32 value)
   if (value < 0 || value > 0xFF)
   {
     if constexpr (index == 0)
-      m_regs.FLAG.color_r_saturated = true;
+      m_regs.FLAG.Set(m_regs.FLAG.color_r_saturated);
     else if constexpr (index == 1)
-      m_regs.FLAG.color_g_saturated = true;
+      m_regs.FLAG.Set(m_regs.FLAG.color_g_saturated);
     else
-      m_regs.FLAG.color_b_saturated = true;
+      m_regs.FLAG.Set(m_regs.FLAG.color_b_saturated);
 
     return (value < 0) ? 0 : 0xFF;
   }
@@ -0,0 +1,74 @@
+#include "gte.h"
+
+#ifdef CPU_X64
+
+#include <immintrin.h>
+
+#ifdef _MSC_VER
+#define TARGET_AVX2
+#else
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+// Vectorized version of the matrix * vector product in MulMatVec(). Each 64-bit lane holds one row, so the three rows
+// of a vector are computed at once, and the overflow checks become compares. The fourth lane is always zero.
+
+namespace GTE {
+
+TARGET_AVX2 static ALWAYS_INLINE __m256i SignExtendMAC(__m256i value)
+{
+  // There's no 64-bit arithmetic shift in AVX2, so sign extend from 44 bits by biasing, masking and unbiasing.
+  const __m256i bias = _mm256_set1_epi64x(INT64_C(1) << 43);
+  const __m256i mask = _mm256_set1_epi64x((INT64_C(1) << 44) - 1);
+  return _mm256_sub_epi64(_mm256_and_si256(_mm256_add_epi64(value, bias), mask), bias);
+}
+
+TARGET_AVX2 u32 Core::MulMatVecAVX2(const s16 M[3][3], const s32 T[3], const s16* const V[], u32 count,
+                                    s64 results[][3])
+{
+  const __m256i max_value = _mm256_set1_epi64x(MAC123_MAX_VALUE);
+  const __m256i min_value = _mm256_set1_epi64x(MAC123_MIN_VALUE);
+
+  // _mm256_mul_epi32 multiplies the sign-extended low 32 bits of each lane.
+  const __m256i translation = _mm256_slli_epi64(_mm256_setr_epi64x(T[0], T[1], T[2], 0), 12);
+  const __m256i column0 = _mm256_setr_epi64x(M[0][0], M[1][0], M[2][0], 0);
+  const __m256i column1 = _mm256_setr_epi64x(M[0][1], M[1][1], M[2][1], 0);
+  const __m256i column2 = _mm256_setr_epi64x(M[0][2], M[1][2], M[2][2], 0);
+
+  __m256i overflow = _mm256_setzero_si256();
+  __m256i underflow = _mm256_setzero_si256();
+  for (u32 i = 0; i < count; i++)
+  {
+    __m256i sum = _mm256_add_epi64(translation, _mm256_mul_epi32(column0, _mm256_set1_epi64x(V[i][0])));
+    overflow = _mm256_or_si256(overflow, _mm256_cmpgt_epi64(sum, max_value));
+    underflow = _mm256_or_si256(underflow, _mm256_cmpgt_epi64(min_value, sum));
+
+    sum = _mm256_add_epi64(SignExtendMAC(sum), _mm256_mul_epi32(column1, _mm256_set1_epi64x(V[i][1])));
+    overflow = _mm256_or_si256(overflow, _mm256_cmpgt_epi64(sum, max_value));
+    underflow = _mm256_or_si256(underflow, _mm256_cmpgt_epi64(min_value, sum));
+
+    sum = _mm256_add_epi64(SignExtendMAC(sum), _mm256_mul_epi32(column2, _mm256_set1_epi64x(V[i][2])));
+
+    alignas(32) s64 lanes[4];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), sum);
+    results[i][0] = lanes[0];
+    results[i][1] = lanes[1];
+    results[i][2] = lanes[2];
+  }
+
+  // Lane n is MAC(n+1), which maps to FLAG bits 30-n (overflow) and 27-n (underflow).
+  const u32 overflow_lanes = static_cast<u32>(_mm256_movemask_pd(_mm256_castsi256_pd(overflow)));
+  const u32 underflow_lanes = static_cast<u32>(_mm256_movemask_pd(_mm256_castsi256_pd(underflow)));
+  u32 flags = 0;
+  for (u32 lane = 0; lane < 3; lane++)
+  {
+    flags |= ((overflow_lanes >> lane) & 1u) << (30 - lane);
+    flags |= ((underflow_lanes >> lane) & 1u) << (27 - lane);
+  }
+
+  return flags;
+}
+
+} // namespace GTE
+
+#endif
@@ -36,8 +36,20 @@ union FLAGS
 
   ALWAYS_INLINE void Clear() { bits = 0; }
 
+  // Flags are only ever modified through bits. Stores through two different BitField types are assumed not to alias,
+  // which lets the compiler drop flags once the command is inlined.
+  template<typename FieldType>
+  ALWAYS_INLINE void Set(const FieldType& field)
+  {
+    bits |= field.GetMask();
+  }
+
   // Bits 30..23, 18..13 OR'ed
-  ALWAYS_INLINE void UpdateError() { error = (bits & UINT32_C(0x7F87E000)) != UINT32_C(0); }
+  ALWAYS_INLINE void UpdateError()
+  {
+    if ((bits & UINT32_C(0x7F87E000)) != UINT32_C(0))
+      bits |= error.GetMask();
+  }
 };
 
 union Regs
@@ -6,11 +6,13 @@
 #include "common/file_system.h"
 #include "common/log.h"
 #include "common/string_util.h"
+#include "cpu_code_cache.h"
 #include "dma.h"
 #include "game_list.h"
 #include "gpu.h"
 #include "host_display.h"
 #include "mdec.h"
+#include "save_state_compression.h"
 #include "spu.h"
 #include "system.h"
 #include "timers.h"
@@ -53,7 +55,10 @@ HostInterface::HostInterface()
   m_game_list->SetDatabaseFilename(GetGameListDatabaseFileName());
 }
 
-HostInterface::~HostInterface() = default;
+HostInterface::~HostInterface()
+{
+  WaitForSaveStateThread();
+}
 
 bool HostInterface::CreateSystem()
 {
@@ -88,6 +93,9 @@ void HostInterface::ResetSystem()
 
 void HostInterface::DestroySystem()
 {
+  // Make sure the last state is on disk before we go, it's usually the resume state.
+  WaitForSaveStateThread();
+
   m_system.reset();
   m_paused = false;
   UpdateSpeedLimiterState();
@@ -280,6 +288,12 @@ void HostInterface::DrawDebugWindows()
     m_system->GetSPU()->DrawDebugStateWindow();
   if (debug_settings.show_mdec_state)
     m_system->GetMDEC()->DrawDebugStateWindow();
+  if (debug_settings.show_profiler)
+    m_system->GetProfiler()->DrawDebugWindow(&debug_settings.show_profiler);
+  if (debug_settings.show_code_cache_state)
+    m_system->GetCPUCodeCache()->DrawDebugWindow();
+  if (debug_settings.show_hot_blocks)
+    m_system->GetCPUCodeCache()->DrawHotBlocksWindow(&debug_settings.show_hot_blocks);
 }
 
 void HostInterface::ClearImGuiFocus()
@@ -295,12 +309,15 @@ std::optional<std::vector<u8>> HostInterface::GetBIOSImage(ConsoleRegion region)
   {                                                                                                                    \
     std::string try_filename = filename;                                                                               \
     std::optional<BIOS::Image> found_image = BIOS::LoadImageFromFile(try_filename);                                    \
-    BIOS::Hash found_hash = BIOS::GetHash(*found_image);                                                               \
-    Log_DevPrintf("Hash for BIOS '%s': %s", try_filename.c_str(), found_hash.ToString().c_str());                      \
-    if (BIOS::IsValidHashForRegion(region, found_hash))                                                                \
+    if (found_image)                                                                                                   \
     {                                                                                                                  \
-      Log_InfoPrintf("Using BIOS from '%s'", try_filename.c_str());                                                    \
-      return found_image;                                                                                              \
+      BIOS::Hash found_hash = BIOS::GetHash(*found_image);                                                             \
+      Log_DevPrintf("Hash for BIOS '%s': %s", try_filename.c_str(), found_hash.ToString().c_str());                    \
+      if (BIOS::IsValidHashForRegion(region, found_hash))                                                              \
+      {                                                                                                                \
+        Log_InfoPrintf("Using BIOS from '%s'", try_filename.c_str());                                                  \
+        return found_image;                                                                                            \
+      }                                                                                                                \
     }                                                                                                                  \
   } while (0)
 
@@ -341,13 +358,20 @@ std::optional<std::vector<u8>> HostInterface::GetBIOSImage(ConsoleRegion region)
 
 bool HostInterface::LoadState(const char* filename)
 {
+  // The state could still be being written.
+  WaitForSaveStateThread();
+
   std::unique_ptr<ByteStream> stream = FileSystem::OpenFile(filename, BYTESTREAM_OPEN_READ | BYTESTREAM_OPEN_STREAMED);
   if (!stream)
     return false;
 
   AddFormattedOSDMessage(2.0f, "Loading state from %s...", filename);
 
-  const bool result = m_system->LoadState(stream.get());
+  std::vector<u8> state_data;
+  bool result = SaveStateCompression::ReadFile(stream.get(), &state_data);
+  if (result)
+    result = m_system->LoadState(state_data.data(), static_cast<u32>(state_data.size()));
+
   if (!result)
   {
     ReportFormattedError("Loading state from %s failed. Resetting.", filename);
@@ -359,25 +383,56 @@ bool HostInterface::LoadState(const char* filename)
 
 bool HostInterface::SaveState(const char* filename)
 {
-  std::unique_ptr<ByteStream> stream =
-    FileSystem::OpenFile(filename, BYTESTREAM_OPEN_CREATE | BYTESTREAM_OPEN_WRITE | BYTESTREAM_OPEN_TRUNCATE |
-                                     BYTESTREAM_OPEN_ATOMIC_UPDATE | BYTESTREAM_OPEN_STREAMED);
-  if (!stream)
+  // Only serializing the state happens on this thread, compressing and writing it out is done in the background.
+  std::unique_ptr<GrowableMemoryByteStream> state_stream = ByteStream_CreateGrowableMemoryStream();
+  if (!m_system->SaveSnapshot(state_stream.get()))
+  {
+    ReportFormattedError("Saving state to %s failed.", filename);
     return false;
+  }
 
-  const bool result = m_system->SaveState(stream.get());
-  if (!result)
+  WaitForSaveStateThread();
+  m_save_state_thread =
+    std::thread(&HostInterface::WriteSaveStateFile, this, std::string(filename), std::move(state_stream));
+  return true;
+}
+
+bool HostInterface::WaitForSaveStateThread()
+{
+  if (m_save_state_thread.joinable())
+    m_save_state_thread.join();
+
+  return m_save_state_written;
+}
+
+void HostInterface::WriteSaveStateFile(std::string filename, std::unique_ptr<GrowableMemoryByteStream> state_stream)
+{
+  // ReportError() can show a message box, which isn't safe off the main thread, so failures only go to the OSD.
+  m_save_state_written = false;
+  std::vector<u8> file_data;
+  if (!SaveStateCompression::Compress(state_stream->GetMemoryPointer(), state_stream->GetMemorySize(), &file_data))
   {
-    ReportFormattedError("Saving state to %s failed.", filename);
-    stream->Discard();
+    AddFormattedOSDMessage(5.0f, "Compressing state for %s failed.", filename.c_str());
+    return;
   }
-  else
+
+  state_stream.reset();
+
+  std::unique_ptr<ByteStream> stream = FileSystem::OpenFile(
+    filename.c_str(), BYTESTREAM_OPEN_CREATE | BYTESTREAM_OPEN_WRITE | BYTESTREAM_OPEN_TRUNCATE |
+                        BYTESTREAM_OPEN_ATOMIC_UPDATE | BYTESTREAM_OPEN_STREAMED);
+  if (!stream || !stream->Write2(file_data.data(), static_cast<u32>(file_data.size())) || !stream->Commit())
   {
-    AddFormattedOSDMessage(2.0f, "State saved to %s.", filename);
-    stream->Commit();
+    Log_ErrorPrintf("Failed to write state to %s", filename.c_str());
+    AddFormattedOSDMessage(5.0f, "Saving state to %s failed.", filename.c_str());
+    if (stream)
+      stream->Discard();
+
+    return;
   }
 
-  return result;
+  m_save_state_written = true;
+  AddFormattedOSDMessage(2.0f, "State saved to %s.", filename.c_str());
 }
 
 void HostInterface::UpdateSpeedLimiterState()
@@ -475,6 +530,11 @@ std::string HostInterface::GetGameListDatabaseFileName() const
   return GetUserDirectoryRelativePath("cache/redump.dat");
 }
 
+std::string HostInterface::GetCodeCacheFileName(const char* game_code) const
+{
+  return GetUserDirectoryRelativePath("cache/%s.codecache", game_code);
+}
+
 std::string HostInterface::GetGameSaveStateFileName(const char* game_code, s32 slot)
 {
   if (slot < 0)
@@ -505,6 +565,8 @@ void HostInterface::SetDefaultSettings()
 {
   m_settings.region = ConsoleRegion::Auto;
   m_settings.cpu_execution_mode = CPUExecutionMode::Interpreter;
+  m_settings.cpu_fastmem = true;
+  m_settings.cpu_persistent_code_cache = false;
 
   m_settings.emulation_speed = 1.0f;
   m_settings.speed_limiter_enabled = true;
@@ -515,6 +577,8 @@ void HostInterface::SetDefaultSettings()
   m_settings.gpu_true_color = true;
   m_settings.gpu_texture_filtering = false;
   m_settings.gpu_force_progressive_scan = true;
+  m_settings.gpu_use_thread = true;
+  m_settings.gpu_sw_thread_count = 1;
   m_settings.gpu_use_debug_device = false;
   m_settings.display_linear_filtering = true;
   m_settings.display_fullscreen = false;
@@ -538,15 +602,20 @@ void HostInterface::UpdateSettings(const std::function<void()>& apply_callback)
 {
   const float old_emulation_speed = m_settings.emulation_speed;
   const CPUExecutionMode old_cpu_execution_mode = m_settings.cpu_execution_mode;
+  const bool old_cpu_fastmem = m_settings.cpu_fastmem;
   const GPURenderer old_gpu_renderer = m_settings.gpu_renderer;
   const u32 old_gpu_resolution_scale = m_settings.gpu_resolution_scale;
   const bool old_gpu_true_color = m_settings.gpu_true_color;
   const bool old_gpu_texture_filtering = m_settings.gpu_texture_filtering;
   const bool old_gpu_force_progressive_scan = m_settings.gpu_force_progressive_scan;
+  const bool old_gpu_use_thread = m_settings.gpu_use_thread;
+  const u32 old_gpu_sw_thread_count = m_settings.gpu_sw_thread_count;
   const bool old_vsync_enabled = m_settings.video_sync_enabled;
   const bool old_audio_sync_enabled = m_settings.audio_sync_enabled;
   const bool old_speed_limiter_enabled = m_settings.speed_limiter_enabled;
   const bool old_display_linear_filtering = m_settings.display_linear_filtering;
+  const bool old_rewind_enable = m_settings.rewind_enable;
+  const u32 old_rewind_save_slots = m_settings.rewind_save_slots;
 
   apply_callback();
 
@@ -570,13 +639,21 @@ void HostInterface::UpdateSettings(const std::function<void()>& apply_callback)
     if (m_settings.cpu_execution_mode != old_cpu_execution_mode)
       m_system->SetCPUExecutionMode(m_settings.cpu_execution_mode);
 
+    if (m_settings.cpu_fastmem != old_cpu_fastmem)
+      m_system->SetCPUFastmem(m_settings.cpu_fastmem);
+
     if (m_settings.gpu_resolution_scale != old_gpu_resolution_scale ||
         m_settings.gpu_true_color != old_gpu_true_color ||
         m_settings.gpu_texture_filtering != old_gpu_texture_filtering ||
-        m_settings.gpu_force_progressive_scan != old_gpu_force_progressive_scan)
+        m_settings.gpu_force_progressive_scan != old_gpu_force_progressive_scan ||
+        m_settings.gpu_use_thread != old_gpu_use_thread ||
+        m_settings.gpu_sw_thread_count != old_gpu_sw_thread_count)
     {
       m_system->UpdateGPUSettings();
     }
+
+    if (m_settings.rewind_enable != old_rewind_enable || m_settings.rewind_save_slots != old_rewind_save_slots)
+      m_system->UpdateRewindSettings();
   }
 
   if (m_settings.display_linear_filtering != old_display_linear_filtering)
@@ -9,10 +9,12 @@
 #include <mutex>
 #include <optional>
 #include <string>
+#include <thread>
 #include <vector>
 
 class AudioStream;
 class CDImage;
+class GrowableMemoryByteStream;
 class HostDisplay;
 class GameList;
 
@@ -57,8 +59,14 @@ public:
   virtual std::optional<std::vector<u8>> GetBIOSImage(ConsoleRegion region);
 
   bool LoadState(const char* filename);
+
+  /// Saves the state to memory, then compresses and writes it to the file in the background. Errors writing the file
+  /// are reported through OSD messages, use WaitForSaveStateThread() to find out whether it was written.
   bool SaveState(const char* filename);
 
+  /// Blocks until the last save state has been written. Returns false if writing it failed.
+  bool WaitForSaveStateThread();
+
   /// Returns the base user directory path.
   const std::string& GetUserDirectory() const { return m_user_directory; }
 
@@ -99,6 +107,9 @@ protected:
   /// Returns the path of the game database cache file.
   std::string GetGameListDatabaseFileName() const;
 
+  /// Returns the path of the persistent code cache for a game.
+  std::string GetCodeCacheFileName(const char* game_code) const;
+
   /// Returns the path to a save state file. Specifying an index of -1 is the "resume" save state.
   std::string GetGameSaveStateFileName(const char* game_code, s32 slot);
 
@@ -126,6 +137,8 @@ protected:
 
   void UpdateSpeedLimiterState();
 
+  void WriteSaveStateFile(std::string filename, std::unique_ptr<GrowableMemoryByteStream> state_stream);
+
   void DrawFPSWindow();
   void DrawOSDMessages();
   void DrawDebugWindows();
@@ -144,4 +157,9 @@ protected:
 
   std::deque<OSDMessage> m_osd_messages;
   std::mutex m_osd_messages_lock;
+
+  std::thread m_save_state_thread;
+
+  // Only accessed by the save state thread while it's running.
+  bool m_save_state_written = true;
 };
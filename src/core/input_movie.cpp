@@ -0,0 +1,163 @@
+#include "input_movie.h"
+#include "common/byte_stream.h"
+#include "common/file_system.h"
+#include "common/log.h"
+#include "common/state_wrapper.h"
+#include "save_state_compression.h"
+Log_SetChannel(InputMovie);
+
+static constexpr u32 FILE_MAGIC = 0x564D5344; // DSMV
+static constexpr u32 FILE_VERSION = 1;
+
+InputMovie::InputMovie() = default;
+
+InputMovie::InputMovie(std::vector<u8> initial_state, const ControllerTypes& controller_types,
+                       u32 checkpoint_interval)
+  : m_initial_state(std::move(initial_state)), m_controller_types(controller_types),
+    m_checkpoint_interval(checkpoint_interval)
+{
+}
+
+InputMovie::~InputMovie() = default;
+
+std::unique_ptr<InputMovie> InputMovie::LoadFromFile(const char* filename)
+{
+  std::unique_ptr<ByteStream> stream = FileSystem::OpenFile(filename, BYTESTREAM_OPEN_READ | BYTESTREAM_OPEN_STREAMED);
+  if (!stream)
+  {
+    Log_ErrorPrintf("Failed to open movie '%s'", filename);
+    return nullptr;
+  }
+
+  // Movies are compressed the same way as save states, mostly for the initial state.
+  std::vector<u8> data;
+  if (!SaveStateCompression::ReadFile(stream.get(), &data))
+    return nullptr;
+
+  std::unique_ptr<InputMovie> movie(new InputMovie());
+  StateWrapper sw(data.data(), static_cast<u32>(data.size()));
+  if (!movie->DoState(sw))
+  {
+    Log_ErrorPrintf("'%s' is not a valid movie", filename);
+    return nullptr;
+  }
+
+  return movie;
+}
+
+bool InputMovie::SaveToFile(const char* filename)
+{
+  std::unique_ptr<GrowableMemoryByteStream> data_stream = ByteStream_CreateGrowableMemoryStream();
+  {
+    StateWrapper sw(data_stream.get(), StateWrapper::Mode::Write);
+    if (!DoState(sw))
+      return false;
+  }
+
+  std::vector<u8> file_data;
+  if (!SaveStateCompression::Compress(data_stream->GetMemoryPointer(), data_stream->GetMemorySize(), &file_data))
+    return false;
+
+  std::unique_ptr<ByteStream> stream =
+    FileSystem::OpenFile(filename, BYTESTREAM_OPEN_CREATE | BYTESTREAM_OPEN_WRITE | BYTESTREAM_OPEN_TRUNCATE |
+                                     BYTESTREAM_OPEN_ATOMIC_UPDATE | BYTESTREAM_OPEN_STREAMED);
+  if (!stream || !stream->Write2(file_data.data(), static_cast<u32>(file_data.size())))
+  {
+    Log_ErrorPrintf("Failed to write movie to '%s'", filename);
+    if (stream)
+      stream->Discard();
+
+    return false;
+  }
+
+  return stream->Commit();
+}
+
+const InputMovie::Checkpoint* InputMovie::GetCheckpoint(u32 frame) const
+{
+  if (!IsCheckpointFrame(frame))
+    return nullptr;
+
+  const u32 index = ((frame + 1) / m_checkpoint_interval) - 1;
+  return (index < m_checkpoints.size()) ? &m_checkpoints[index] : nullptr;
+}
+
+void InputMovie::AddCheckpoint(const Checkpoint& checkpoint)
+{
+  m_checkpoints.push_back(checkpoint);
+}
+
+bool InputMovie::AddFrame(const void* input, u32 size)
+{
+  if (m_frame_count == 0)
+    m_frame_size = size;
+  else if (size != m_frame_size)
+    return false;
+
+  const u8* input_bytes = static_cast<const u8*>(input);
+  m_frame_inputs.insert(m_frame_inputs.end(), input_bytes, input_bytes + size);
+  m_frame_count++;
+  return true;
+}
+
+// Counts come straight from the file, so make sure that many elements could fit in the rest of the data before
+// anything is allocated for them.
+static bool DoCount(StateWrapper& sw, u32* count, u32 element_size)
+{
+  sw.Do(count);
+  return !sw.IsReading() || (!sw.HasError() && (static_cast<u64>(*count) * element_size) <= sw.GetRemainingSize());
+}
+
+static bool DoByteVector(StateWrapper& sw, std::vector<u8>* data)
+{
+  u32 size = static_cast<u32>(data->size());
+  if (!DoCount(sw, &size, sizeof(u8)))
+    return false;
+
+  if (sw.IsReading())
+    data->resize(size);
+
+  if (size > 0)
+    sw.DoBytes(data->data(), size);
+
+  return true;
+}
+
+bool InputMovie::DoState(StateWrapper& sw)
+{
+  u32 magic = FILE_MAGIC;
+  u32 version = FILE_VERSION;
+  sw.Do(&magic);
+  sw.Do(&version);
+  if (magic != FILE_MAGIC || version != FILE_VERSION)
+    return false;
+
+  sw.Do(&m_controller_types);
+  for (const ControllerType type : m_controller_types)
+  {
+    if (static_cast<u32>(type) >= static_cast<u32>(ControllerType::Count))
+      return false;
+  }
+
+  sw.Do(&m_checkpoint_interval);
+  sw.Do(&m_frame_count);
+  sw.Do(&m_frame_size);
+  if (!DoByteVector(sw, &m_initial_state) || !DoByteVector(sw, &m_frame_inputs))
+    return false;
+
+  // Checkpoints are stored as the frame and both hashes, without padding.
+  u32 checkpoint_count = static_cast<u32>(m_checkpoints.size());
+  if (!DoCount(sw, &checkpoint_count, sizeof(u32) + sizeof(u64) + sizeof(u64)))
+    return false;
+
+  if (sw.IsReading())
+    m_checkpoints.resize(checkpoint_count);
+  for (Checkpoint& checkpoint : m_checkpoints)
+  {
+    sw.Do(&checkpoint.frame);
+    sw.Do(&checkpoint.ram_hash);
+    sw.Do(&checkpoint.vram_hash);
+  }
+
+  return !sw.HasError() && m_frame_inputs.size() == (static_cast<size_t>(m_frame_count) * m_frame_size);
+}
@@ -0,0 +1,66 @@
+#pragma once
+#include "types.h"
+#include <array>
+#include <memory>
+#include <vector>
+
+class StateWrapper;
+
+// Records the controller input of every frame, starting from a save state, so a run can be reproduced exactly. Every
+// few frames a hash of RAM and VRAM is stored as a checkpoint, so playback can tell where it diverged.
+class InputMovie
+{
+public:
+  struct Checkpoint
+  {
+    u32 frame;
+    u64 ram_hash;
+    u64 vram_hash;
+  };
+
+  using ControllerTypes = std::array<ControllerType, NUM_CONTROLLER_AND_CARD_PORTS>;
+
+  InputMovie(std::vector<u8> initial_state, const ControllerTypes& controller_types, u32 checkpoint_interval);
+  ~InputMovie();
+
+  /// Loads a movie written by SaveToFile(). Returns null if the file can't be read or isn't a movie.
+  static std::unique_ptr<InputMovie> LoadFromFile(const char* filename);
+  bool SaveToFile(const char* filename);
+
+  const std::vector<u8>& GetInitialState() const { return m_initial_state; }
+  const ControllerTypes& GetControllerTypes() const { return m_controller_types; }
+  u32 GetCheckpointInterval() const { return m_checkpoint_interval; }
+  u32 GetFrameCount() const { return m_frame_count; }
+  u32 GetCheckpointCount() const { return static_cast<u32>(m_checkpoints.size()); }
+
+  /// Returns true if a checkpoint should be taken at the end of the specified frame.
+  bool IsCheckpointFrame(u32 frame) const
+  {
+    return (m_checkpoint_interval > 0 && ((frame + 1) % m_checkpoint_interval) == 0);
+  }
+
+  /// Returns the checkpoint taken at the end of the specified frame, or null if there wasn't one.
+  const Checkpoint* GetCheckpoint(u32 frame) const;
+  void AddCheckpoint(const Checkpoint& checkpoint);
+
+  /// Appends the input for the next frame. All frames of a movie have the same size, as the controllers don't change.
+  bool AddFrame(const void* input, u32 size);
+
+  /// Returns the input of the specified frame, GetFrameSize() bytes long. The size is zero when no controllers are
+  /// connected, in which case there's no input stored at all.
+  const u8* GetFrameInput(u32 frame) const { return m_frame_inputs.data() + (frame * m_frame_size); }
+  u32 GetFrameSize() const { return m_frame_size; }
+
+private:
+  InputMovie();
+
+  bool DoState(StateWrapper& sw);
+
+  std::vector<u8> m_initial_state;
+  std::vector<u8> m_frame_inputs;
+  std::vector<Checkpoint> m_checkpoints;
+  ControllerTypes m_controller_types{};
+  u32 m_checkpoint_interval = 0;
+  u32 m_frame_count = 0;
+  u32 m_frame_size = 0;
+};
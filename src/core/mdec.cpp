@@ -16,7 +16,10 @@ void MDEC::Initialize(System* system, DMA* dma)
   m_system = system;
   m_dma = dma;
   m_block_copy_out_event = system->CreateTimingEvent("MDEC Block Copy Out", TICKS_PER_BLOCK, TICKS_PER_BLOCK,
-                                                     std::bind(&MDEC::CopyOutBlock, this), false);
+                                                     [](void* param, TickCount ticks, TickCount ticks_late) {
+                                                       static_cast<MDEC*>(param)->CopyOutBlock();
+                                                     },
+                                                     this, false);
 }
 
 void MDEC::Reset()
@@ -73,6 +76,7 @@ u32 MDEC::ReadRegister(u32 offset)
 
 void MDEC::WriteRegister(u32 offset, u32 value)
 {
+  SystemComponentScope component_scope(m_system, System::Component::MDEC);
   switch (offset)
   {
     case 0:
@@ -105,6 +109,7 @@ void MDEC::WriteRegister(u32 offset, u32 value)
 
 void MDEC::DMARead(u32* words, u32 word_count)
 {
+  SystemComponentScope component_scope(m_system, System::Component::MDEC);
   do
   {
     const u32 words_to_read = std::min(word_count, m_data_out_fifo.GetSize());
@@ -126,6 +131,7 @@ void MDEC::DMARead(u32* words, u32 word_count)
 
 void MDEC::DMAWrite(const u32* words, u32 word_count)
 {
+  SystemComponentScope component_scope(m_system, System::Component::MDEC);
   do
   {
     const u32 halfwords_to_write = std::min(word_count * 2, m_data_in_fifo.GetSpace() & ~u32(2));
@@ -415,6 +421,7 @@ void MDEC::ScheduleBlockCopyOut(TickCount ticks)
 
 void MDEC::CopyOutBlock()
 {
+  SystemComponentScope component_scope(m_system, System::Component::MDEC);
   DebugAssert(m_command == Command::DecodeMacroblock);
   m_block_copy_out_event->Deactivate();
 
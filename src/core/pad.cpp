@@ -16,8 +16,10 @@ void Pad::Initialize(System* system, InterruptController* interrupt_controller)
 {
   m_system = system;
   m_interrupt_controller = interrupt_controller;
-  m_transfer_event = system->CreateTimingEvent("Pad Serial Transfer", 1, 1,
-                                               std::bind(&Pad::TransferEvent, this, std::placeholders::_2), false);
+  m_transfer_event = system->CreateTimingEvent(
+    "Pad Serial Transfer", 1, 1,
+    [](void* param, TickCount ticks, TickCount ticks_late) { static_cast<Pad*>(param)->TransferEvent(ticks_late); },
+    this, false);
 }
 
 void Pad::Reset()
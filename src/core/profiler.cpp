@@ -0,0 +1,198 @@
+#include "profiler.h"
+#include "common/byte_stream.h"
+#include "common/file_system.h"
+#include "common/log.h"
+#include "common/string_util.h"
+#include <algorithm>
+#include <cfloat>
+#include <imgui.h>
+Log_SetChannel(Profiler);
+
+Profiler::Profiler() = default;
+
+Profiler::~Profiler() = default;
+
+bool Profiler::IsAvailable()
+{
+#ifdef WITH_PROFILER
+  return true;
+#else
+  return false;
+#endif
+}
+
+const char* Profiler::GetCategoryName(Category category)
+{
+  static constexpr std::array<const char*, static_cast<size_t>(Category::Count)> names = {
+    {"CPU", "Event", "GPU Command", "DMA"}};
+  return names[static_cast<size_t>(category)];
+}
+
+Profiler::CounterIndex Profiler::RegisterCounter(Category category, std::string name)
+{
+  for (u32 i = 0; i < static_cast<u32>(m_counters.size()); i++)
+  {
+    if (m_counters[i].category == category && m_counters[i].name == name)
+      return i;
+  }
+
+  Counter counter = {};
+  counter.name = std::move(name);
+  counter.category = category;
+  m_counters.push_back(std::move(counter));
+  return static_cast<CounterIndex>(m_counters.size() - 1);
+}
+
+void Profiler::EndFrame(float frame_time_ms)
+{
+  m_history_position = (m_history_position + 1) % HISTORY_LENGTH;
+  m_frame_time_history_ms[m_history_position] = frame_time_ms;
+  m_frame_count++;
+
+  for (Counter& counter : m_counters)
+  {
+    counter.history_ms[m_history_position] =
+      static_cast<float>(Common::Timer::ConvertValueToMilliseconds(counter.frame_time));
+    counter.total_time += counter.frame_time;
+    counter.total_calls += counter.frame_calls;
+    counter.worst_frame_time = std::max(counter.worst_frame_time, counter.frame_time);
+    counter.frame_time = 0;
+    counter.frame_calls = 0;
+  }
+}
+
+void Profiler::Reset()
+{
+  for (Counter& counter : m_counters)
+  {
+    counter.frame_time = 0;
+    counter.frame_calls = 0;
+    counter.total_time = 0;
+    counter.total_calls = 0;
+    counter.worst_frame_time = 0;
+    counter.history_ms.fill(0.0f);
+  }
+
+  m_frame_time_history_ms.fill(0.0f);
+  m_history_position = 0;
+  m_frame_count = 0;
+}
+
+bool Profiler::DumpToFile(const char* filename) const
+{
+  std::unique_ptr<ByteStream> stream =
+    FileSystem::OpenFile(filename, BYTESTREAM_OPEN_CREATE | BYTESTREAM_OPEN_WRITE | BYTESTREAM_OPEN_TRUNCATE |
+                                     BYTESTREAM_OPEN_ATOMIC_UPDATE | BYTESTREAM_OPEN_STREAMED);
+  if (!stream)
+  {
+    Log_ErrorPrintf("Failed to open '%s' for writing", filename);
+    return false;
+  }
+
+  const u32 frames = std::max(m_frame_count, 1u);
+  const u32 history_frames = std::min(m_frame_count, static_cast<u32>(HISTORY_LENGTH));
+
+  std::string line = "category,name,frames,calls,total_ms,average_frame_ms,worst_frame_ms,history_ms\n";
+  stream->Write2(line.data(), static_cast<u32>(line.size()));
+
+  for (const Counter& counter : m_counters)
+  {
+    const double total_ms = Common::Timer::ConvertValueToMilliseconds(counter.total_time);
+    line = StringUtil::StdStringFromFormat(
+      "%s,\"%s\",%u,%llu,%.4f,%.4f,%.4f,", GetCategoryName(counter.category), counter.name.c_str(), m_frame_count,
+      static_cast<unsigned long long>(counter.total_calls), total_ms, total_ms / static_cast<double>(frames),
+      Common::Timer::ConvertValueToMilliseconds(counter.worst_frame_time));
+
+    // Oldest to newest.
+    for (u32 i = 0; i < history_frames; i++)
+    {
+      const u32 pos = (m_history_position + HISTORY_LENGTH - (history_frames - 1) + i) % HISTORY_LENGTH;
+      line += StringUtil::StdStringFromFormat((i == 0) ? "%.4f" : ";%.4f", counter.history_ms[pos]);
+    }
+
+    line += '\n';
+    stream->Write2(line.data(), static_cast<u32>(line.size()));
+  }
+
+  if (!stream->Commit())
+  {
+    Log_ErrorPrintf("Failed to write profiler dump to '%s'", filename);
+    stream->Discard();
+    return false;
+  }
+
+  Log_InfoPrintf("Wrote %zu profiler counters to '%s'", m_counters.size(), filename);
+  return true;
+}
+
+void Profiler::DrawDebugWindow(bool* show_window)
+{
+  ImGui::SetNextWindowSize(ImVec2(700, 500), ImGuiCond_FirstUseEver);
+  if (!ImGui::Begin("Profiler", show_window))
+  {
+    ImGui::End();
+    return;
+  }
+
+  if (!IsAvailable())
+  {
+    ImGui::TextUnformatted("Profiling counters are not available in this build, rebuild with ENABLE_PROFILER.");
+    ImGui::End();
+    return;
+  }
+
+  if (ImGui::Button("Reset"))
+    Reset();
+  ImGui::SameLine();
+  if (ImGui::Button("Dump to profiler.csv"))
+    DumpToFile("profiler.csv");
+
+  ImGui::PlotHistogram("##frame_times", m_frame_time_history_ms.data(), HISTORY_LENGTH,
+                       static_cast<int>((m_history_position + 1) % HISTORY_LENGTH), "Frame Time (ms)", 0.0f, 33.3f,
+                       ImVec2(0.0f, 60.0f));
+
+  const u32 frames = std::max(m_frame_count, 1u);
+  for (u32 category = 0; category < static_cast<u32>(Category::Count); category++)
+  {
+    if (!ImGui::CollapsingHeader(GetCategoryName(static_cast<Category>(category)), ImGuiTreeNodeFlags_DefaultOpen))
+      continue;
+
+    ImGui::Columns(5);
+    ImGui::SetColumnWidth(0, 220.0f);
+    ImGui::TextUnformatted("Name");
+    ImGui::NextColumn();
+    ImGui::TextUnformatted("Calls/Frame");
+    ImGui::NextColumn();
+    ImGui::TextUnformatted("Last (ms)");
+    ImGui::NextColumn();
+    ImGui::TextUnformatted("Average (ms)");
+    ImGui::NextColumn();
+    ImGui::TextUnformatted("History");
+    ImGui::NextColumn();
+
+    for (const Counter& counter : m_counters)
+    {
+      if (counter.category != static_cast<Category>(category))
+        continue;
+
+      ImGui::TextUnformatted(counter.name.c_str());
+      ImGui::NextColumn();
+      ImGui::Text("%.1f", static_cast<double>(counter.total_calls) / static_cast<double>(frames));
+      ImGui::NextColumn();
+      ImGui::Text("%.3f", counter.history_ms[m_history_position]);
+      ImGui::NextColumn();
+      ImGui::Text("%.3f", Common::Timer::ConvertValueToMilliseconds(counter.total_time) / static_cast<double>(frames));
+      ImGui::NextColumn();
+      ImGui::PushID(&counter);
+      ImGui::PlotHistogram("##history", counter.history_ms.data(), HISTORY_LENGTH,
+                           static_cast<int>((m_history_position + 1) % HISTORY_LENGTH), nullptr, 0.0f, FLT_MAX,
+                           ImVec2(-1.0f, 16.0f));
+      ImGui::PopID();
+      ImGui::NextColumn();
+    }
+
+    ImGui::Columns(1);
+  }
+
+  ImGui::End();
+}
@@ -0,0 +1,109 @@
+#pragma once
+#include "common/timer.h"
+#include "types.h"
+#include <array>
+#include <string>
+#include <vector>
+
+// Lightweight host-time instrumentation. Counters accumulate time and call counts per frame, and keep a short
+// per-frame history. The instrumentation points are only compiled in when WITH_PROFILER is defined, otherwise
+// the PROFILE_SCOPE macro expands to nothing and the counters stay empty.
+class Profiler
+{
+public:
+  using CounterIndex = u32;
+
+  enum class Category : u8
+  {
+    CPU,
+    Event,
+    GPUCommand,
+    DMA,
+    Count
+  };
+
+  enum : u32
+  {
+    HISTORY_LENGTH = 120
+  };
+
+  struct Counter
+  {
+    std::string name;
+    Category category;
+
+    Common::Timer::Value frame_time;
+    u32 frame_calls;
+
+    Common::Timer::Value total_time;
+    u64 total_calls;
+    Common::Timer::Value worst_frame_time;
+
+    std::array<float, HISTORY_LENGTH> history_ms;
+  };
+
+  Profiler();
+  ~Profiler();
+
+  /// Returns true if the instrumentation points were compiled in.
+  static bool IsAvailable();
+
+  static const char* GetCategoryName(Category category);
+
+  /// Registers a new counter, or returns the existing counter with the same category and name.
+  CounterIndex RegisterCounter(Category category, std::string name);
+
+  const std::vector<Counter>& GetCounters() const { return m_counters; }
+  u32 GetFrameCount() const { return m_frame_count; }
+
+  /// Returns the index of the most recent frame in the history arrays.
+  u32 GetHistoryPosition() const { return m_history_position; }
+  const std::array<float, HISTORY_LENGTH>& GetFrameTimeHistory() const { return m_frame_time_history_ms; }
+
+  ALWAYS_INLINE void AddSample(CounterIndex index, Common::Timer::Value time)
+  {
+    Counter& counter = m_counters[index];
+    counter.frame_time += time;
+    counter.frame_calls++;
+  }
+
+  /// Moves the current frame's samples to the history. Call once per emulated frame.
+  void EndFrame(float frame_time_ms);
+
+  /// Clears all accumulated samples and history, keeping the registered counters.
+  void Reset();
+
+  /// Writes a CSV summary of all counters, including the per-frame history.
+  bool DumpToFile(const char* filename) const;
+
+  void DrawDebugWindow(bool* show_window);
+
+private:
+  std::vector<Counter> m_counters;
+  std::array<float, HISTORY_LENGTH> m_frame_time_history_ms = {};
+  u32 m_history_position = 0;
+  u32 m_frame_count = 0;
+};
+
+class ProfilerScope
+{
+public:
+  ALWAYS_INLINE ProfilerScope(Profiler* profiler, Profiler::CounterIndex index)
+    : m_profiler(profiler), m_index(index), m_start_time(Common::Timer::GetValue())
+  {
+  }
+  ALWAYS_INLINE ~ProfilerScope() { m_profiler->AddSample(m_index, Common::Timer::GetValue() - m_start_time); }
+
+private:
+  Profiler* m_profiler;
+  Profiler::CounterIndex m_index;
+  Common::Timer::Value m_start_time;
+};
+
+#ifdef WITH_PROFILER
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+#define PROFILE_SCOPE(profiler, index) ProfilerScope PROFILE_CONCAT(profile_scope_, __LINE__)((profiler), (index))
+#else
+#define PROFILE_SCOPE(profiler, index)
+#endif
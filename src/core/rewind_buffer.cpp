@@ -0,0 +1,147 @@
+#include "rewind_buffer.h"
+#include "common/assert.h"
+#include <algorithm>
+#include <cstring>
+
+static constexpr size_t MAX_UNUSED_DELTA_CAPACITY = 64 * 1024;
+
+RewindBuffer::RewindBuffer(u32 slot_count) : m_slot_count(std::max(slot_count, 1u))
+{
+  // The newest state doesn't need a delta.
+  m_deltas.resize(m_slot_count - 1);
+}
+
+RewindBuffer::~RewindBuffer() = default;
+
+u32 RewindBuffer::GetStorageSize() const
+{
+  u32 size = static_cast<u32>(m_newest_state.size());
+  for (u32 i = 0; i < m_state_count - std::min(m_state_count, 1u); i++)
+    size += static_cast<u32>(m_deltas[(m_first_delta + i) % m_deltas.size()].runs.size());
+
+  return size;
+}
+
+void RewindBuffer::Push(const u8* data, u32 size)
+{
+  if (m_state_count > 0 && !m_deltas.empty())
+  {
+    const u32 delta_count = m_state_count - 1;
+    if (delta_count == static_cast<u32>(m_deltas.size()))
+    {
+      m_first_delta = (m_first_delta + 1) % static_cast<u32>(m_deltas.size());
+      m_state_count--;
+    }
+
+    Delta& delta = m_deltas[(m_first_delta + m_state_count - 1) % m_deltas.size()];
+    EncodeDelta(m_newest_state.data(), static_cast<u32>(m_newest_state.size()), data, size, &delta);
+  }
+
+  // assign() reuses the capacity, the size of a state doesn't change much.
+  m_newest_state.assign(data, data + size);
+  m_state_count = std::min(m_state_count + 1, m_slot_count);
+}
+
+void RewindBuffer::Pop()
+{
+  Assert(m_state_count > 0);
+  m_state_count--;
+  if (m_state_count == 0)
+  {
+    m_newest_state.clear();
+    return;
+  }
+
+  ApplyDelta(m_deltas[(m_first_delta + m_state_count - 1) % m_deltas.size()], &m_newest_state);
+}
+
+void RewindBuffer::Clear()
+{
+  m_newest_state.clear();
+  m_first_delta = 0;
+  m_state_count = 0;
+}
+
+static ALWAYS_INLINE u64 LoadWord(const u8* ptr)
+{
+  u64 value;
+  std::memcpy(&value, ptr, sizeof(value));
+  return value;
+}
+
+static ALWAYS_INLINE void AppendU32(std::vector<u8>* buffer, u32 value)
+{
+  const u8* bytes = reinterpret_cast<const u8*>(&value);
+  buffer->insert(buffer->end(), bytes, bytes + sizeof(value));
+}
+
+void RewindBuffer::EncodeDelta(const u8* old_data, u32 old_size, const u8* new_data, u32 new_size, Delta* delta)
+{
+  // Bytes past the end of the shorter state are treated as zero.
+  const u32 size = std::max(old_size, new_size);
+  const u32 common_size = std::min(old_size, new_size);
+  auto get_xor = [old_data, old_size, new_data, new_size](u32 offset) -> u8 {
+    return ((offset < old_size) ? old_data[offset] : 0) ^ ((offset < new_size) ? new_data[offset] : 0);
+  };
+
+  delta->runs.clear();
+  delta->state_size = old_size;
+
+  u32 offset = 0;
+  u32 last_run_end = 0;
+  while (offset < size)
+  {
+    // Skip over identical data a word at a time, this is where almost all of the time goes.
+    while ((offset + sizeof(u64)) <= common_size && LoadWord(old_data + offset) == LoadWord(new_data + offset))
+      offset += sizeof(u64);
+    while (offset < size && get_xor(offset) == 0)
+      offset++;
+    if (offset == size)
+      break;
+
+    // Extend the run until there's a word of identical data, shorter gaps are cheaper to store in the run.
+    const u32 run_start = offset;
+    while (offset < size &&
+           ((offset + sizeof(u64)) > common_size || LoadWord(old_data + offset) != LoadWord(new_data + offset)))
+    {
+      offset++;
+    }
+
+    AppendU32(&delta->runs, run_start - last_run_end);
+    AppendU32(&delta->runs, offset - run_start);
+    for (u32 i = run_start; i < offset; i++)
+      delta->runs.push_back(get_xor(i));
+
+    last_run_end = offset;
+  }
+
+  // Don't let a slot which once held a large delta keep the memory when it's reused for small ones.
+  if (delta->runs.capacity() > MAX_UNUSED_DELTA_CAPACITY && delta->runs.capacity() > (delta->runs.size() * 2))
+    delta->runs.shrink_to_fit();
+}
+
+void RewindBuffer::ApplyDelta(const Delta& delta, std::vector<u8>* state)
+{
+  // Growing zero-fills, which matches how the shorter state was padded when encoding.
+  state->resize(delta.state_size);
+
+  const u8* runs = delta.runs.data();
+  const u8* runs_end = runs + delta.runs.size();
+  u32 offset = 0;
+  while (runs != runs_end)
+  {
+    u32 skip, length;
+    std::memcpy(&skip, runs, sizeof(skip));
+    std::memcpy(&length, runs + sizeof(skip), sizeof(length));
+    runs += sizeof(skip) + sizeof(length);
+
+    // Bytes past the end of the older state were only in the newer one.
+    offset += skip;
+    const u32 apply_length = std::min(length, delta.state_size - std::min(offset, delta.state_size));
+    for (u32 i = 0; i < apply_length; i++)
+      (*state)[offset + i] ^= runs[i];
+
+    runs += length;
+    offset += length;
+  }
+}
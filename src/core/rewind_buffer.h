@@ -0,0 +1,50 @@
+#pragma once
+#include "types.h"
+#include <vector>
+
+// Keeps the last few save states in memory, so the emulation can be stepped backwards. Only the newest state is kept
+// whole. Each older state is stored as the difference to the state after it, which is small as RAM, VRAM and SPU RAM
+// only change in a few places between snapshots.
+class RewindBuffer
+{
+public:
+  RewindBuffer(u32 slot_count);
+  ~RewindBuffer();
+
+  u32 GetSlotCount() const { return m_slot_count; }
+  u32 GetStateCount() const { return m_state_count; }
+  bool IsEmpty() const { return (m_state_count == 0); }
+
+  /// Returns the number of bytes the states are using, including the newest state.
+  u32 GetStorageSize() const;
+
+  /// Returns the newest state, only valid when not empty.
+  const u8* GetNewestState() const { return m_newest_state.data(); }
+  u32 GetNewestStateSize() const { return static_cast<u32>(m_newest_state.size()); }
+
+  /// Adds a new state. If all slots are used, the oldest state is dropped.
+  void Push(const u8* data, u32 size);
+
+  /// Drops the newest state, rebuilding the one before it.
+  void Pop();
+
+  void Clear();
+
+private:
+  // Encoded as runs of {u32 offset from the end of the last run, u32 length, XOR of the states}.
+  struct Delta
+  {
+    std::vector<u8> runs;
+    u32 state_size;
+  };
+
+  static void EncodeDelta(const u8* old_data, u32 old_size, const u8* new_data, u32 new_size, Delta* delta);
+  static void ApplyDelta(const Delta& delta, std::vector<u8>* state);
+
+  // Ring of deltas, the first is the oldest. The buffers are reused when the oldest state is dropped.
+  std::vector<Delta> m_deltas;
+  std::vector<u8> m_newest_state;
+  u32 m_slot_count;
+  u32 m_first_delta = 0;
+  u32 m_state_count = 0;
+};
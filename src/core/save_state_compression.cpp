@@ -0,0 +1,89 @@
+#include "save_state_compression.h"
+#include "common/byte_stream.h"
+#include "common/log.h"
+#include <cstring>
+#include <zlib.h>
+Log_SetChannel(SaveStateCompression);
+
+namespace SaveStateCompression {
+
+static constexpr u32 HEADER_MAGIC = 0x5A535344; // DSSZ
+static constexpr u32 READ_CHUNK_SIZE = 256 * 1024;
+
+// The size comes from the file, so don't trust it. A state is mostly RAM (2MB), VRAM (1MB) and SPU RAM (512KB), this
+// leaves plenty of room for input movies, which store a state plus the input of each frame.
+static constexpr u32 MAX_UNCOMPRESSED_SIZE = 16 * (2 * 1024 * 1024 + 1024 * 1024 + 512 * 1024);
+
+struct Header
+{
+  u32 magic;
+  u32 uncompressed_size;
+};
+
+bool Compress(const void* data, u32 size, std::vector<u8>* file_data)
+{
+  uLongf compressed_size = compressBound(static_cast<uLong>(size));
+  file_data->resize(sizeof(Header) + compressed_size);
+
+  const Header header = {HEADER_MAGIC, size};
+  std::memcpy(file_data->data(), &header, sizeof(header));
+
+  const int result = compress2(file_data->data() + sizeof(Header), &compressed_size, static_cast<const Bytef*>(data),
+                               static_cast<uLong>(size), Z_DEFAULT_COMPRESSION);
+  if (result != Z_OK)
+  {
+    Log_ErrorPrintf("compress2() failed: %d", result);
+    return false;
+  }
+
+  file_data->resize(sizeof(Header) + compressed_size);
+  return true;
+}
+
+bool ReadFile(ByteStream* stream, std::vector<u8>* state_data)
+{
+  // Read the whole file, files opened as streamed don't necessarily know their size.
+  std::vector<u8> file_data;
+  for (;;)
+  {
+    const size_t position = file_data.size();
+    file_data.resize(position + READ_CHUNK_SIZE);
+    const u32 bytes_read = stream->Read(file_data.data() + position, READ_CHUNK_SIZE);
+    file_data.resize(position + bytes_read);
+    if (bytes_read < READ_CHUNK_SIZE)
+      break;
+  }
+
+  Header header = {};
+  if (file_data.size() >= sizeof(header))
+    std::memcpy(&header, file_data.data(), sizeof(header));
+
+  if (header.magic != HEADER_MAGIC)
+  {
+    // Uncompressed state.
+    *state_data = std::move(file_data);
+    return true;
+  }
+
+  if (header.uncompressed_size > MAX_UNCOMPRESSED_SIZE)
+  {
+    Log_ErrorPrintf("Uncompressed size of %u bytes is too large, the file is probably corrupted",
+                    header.uncompressed_size);
+    return false;
+  }
+
+  state_data->resize(header.uncompressed_size);
+  uLongf uncompressed_size = static_cast<uLongf>(header.uncompressed_size);
+  const int result = uncompress(state_data->data(), &uncompressed_size, file_data.data() + sizeof(header),
+                                static_cast<uLong>(file_data.size() - sizeof(header)));
+  if (result != Z_OK || uncompressed_size != header.uncompressed_size)
+  {
+    Log_ErrorPrintf("uncompress() failed: %d (%u of %u bytes)", result, static_cast<u32>(uncompressed_size),
+                    header.uncompressed_size);
+    return false;
+  }
+
+  return true;
+}
+
+} // namespace SaveStateCompression
@@ -0,0 +1,17 @@
+#pragma once
+#include "types.h"
+#include <vector>
+
+class ByteStream;
+
+// Save state files are a small header followed by the zlib-compressed state. States from before compression was
+// added start with the "System" marker instead, and are still loaded as-is.
+namespace SaveStateCompression {
+
+/// Compresses a state into a file image, including the header.
+bool Compress(const void* data, u32 size, std::vector<u8>* file_data);
+
+/// Reads a whole state file, decompressing it if needed.
+bool ReadFile(ByteStream* stream, std::vector<u8>* state_data);
+
+} // namespace SaveStateCompression
@@ -12,9 +12,14 @@ void Settings::Load(SettingsInterface& si)
   emulation_speed = si.GetFloatValue("General", "EmulationSpeed", 1.0f);
   speed_limiter_enabled = si.GetBoolValue("General", "SpeedLimiterEnabled", true);
   start_paused = si.GetBoolValue("General", "StartPaused", false);
+  rewind_enable = si.GetBoolValue("General", "RewindEnable", false);
+  rewind_save_frequency = static_cast<u32>(si.GetIntValue("General", "RewindFrequency", 6));
+  rewind_save_slots = static_cast<u32>(si.GetIntValue("General", "RewindSaveSlots", 100));
 
   cpu_execution_mode = ParseCPUExecutionMode(si.GetStringValue("CPU", "ExecutionMode", "Interpreter").c_str())
                          .value_or(CPUExecutionMode::Interpreter);
+  cpu_fastmem = si.GetBoolValue("CPU", "Fastmem", true);
+  cpu_persistent_code_cache = si.GetBoolValue("CPU", "PersistentCodeCache", false);
 
   gpu_renderer =
     ParseRendererName(si.GetStringValue("GPU", "Renderer", "OpenGL").c_str()).value_or(GPURenderer::HardwareOpenGL);
@@ -22,6 +27,8 @@ void Settings::Load(SettingsInterface& si)
   gpu_true_color = si.GetBoolValue("GPU", "TrueColor", false);
   gpu_texture_filtering = si.GetBoolValue("GPU", "TextureFiltering", false);
   gpu_force_progressive_scan = si.GetBoolValue("GPU", "ForceProgressiveScan", true);
+  gpu_use_thread = si.GetBoolValue("GPU", "UseThread", true);
+  gpu_sw_thread_count = static_cast<u32>(si.GetIntValue("GPU", "SoftwareThreadCount", 1));
   gpu_use_debug_device = si.GetBoolValue("GPU", "UseDebugDevice", false);
 
   display_linear_filtering = si.GetBoolValue("Display", "LinearFiltering", true);
@@ -47,11 +54,15 @@ void Settings::Load(SettingsInterface& si)
   debugging.show_vram = si.GetBoolValue("Debug", "ShowVRAM");
   debugging.dump_cpu_to_vram_copies = si.GetBoolValue("Debug", "DumpCPUToVRAMCopies");
   debugging.dump_vram_to_cpu_copies = si.GetBoolValue("Debug", "DumpVRAMToCPUCopies");
+  debugging.disable_gpu_sw_simd = si.GetBoolValue("Debug", "DisableGPUSWSIMD");
   debugging.show_gpu_state = si.GetBoolValue("Debug", "ShowGPUState");
   debugging.show_cdrom_state = si.GetBoolValue("Debug", "ShowCDROMState");
   debugging.show_spu_state = si.GetBoolValue("Debug", "ShowSPUState");
   debugging.show_timers_state = si.GetBoolValue("Debug", "ShowTimersState");
   debugging.show_mdec_state = si.GetBoolValue("Debug", "ShowMDECState");
+  debugging.show_profiler = si.GetBoolValue("Debug", "ShowProfiler");
+  debugging.show_code_cache_state = si.GetBoolValue("Debug", "ShowCodeCacheState");
+  debugging.show_hot_blocks = si.GetBoolValue("Debug", "ShowHotBlocks");
 }
 
 void Settings::Save(SettingsInterface& si) const
@@ -61,14 +72,21 @@ void Settings::Save(SettingsInterface& si) const
   si.SetFloatValue("General", "EmulationSpeed", emulation_speed);
   si.SetBoolValue("General", "SpeedLimiterEnabled", speed_limiter_enabled);
   si.SetBoolValue("General", "StartPaused", start_paused);
+  si.SetBoolValue("General", "RewindEnable", rewind_enable);
+  si.SetIntValue("General", "RewindFrequency", static_cast<int>(rewind_save_frequency));
+  si.SetIntValue("General", "RewindSaveSlots", static_cast<int>(rewind_save_slots));
 
   si.SetStringValue("CPU", "ExecutionMode", GetCPUExecutionModeName(cpu_execution_mode));
+  si.SetBoolValue("CPU", "Fastmem", cpu_fastmem);
+  si.SetBoolValue("CPU", "PersistentCodeCache", cpu_persistent_code_cache);
 
   si.SetStringValue("GPU", "Renderer", GetRendererName(gpu_renderer));
   si.SetIntValue("GPU", "ResolutionScale", static_cast<long>(gpu_resolution_scale));
   si.SetBoolValue("GPU", "TrueColor", gpu_true_color);
   si.SetBoolValue("GPU", "TextureFiltering", gpu_texture_filtering);
   si.SetBoolValue("GPU", "ForceProgressiveScan", gpu_force_progressive_scan);
+  si.SetBoolValue("GPU", "UseThread", gpu_use_thread);
+  si.SetIntValue("GPU", "SoftwareThreadCount", static_cast<long>(gpu_sw_thread_count));
   si.SetBoolValue("GPU", "UseDebugDevice", gpu_use_debug_device);
 
   si.SetBoolValue("Display", "LinearFiltering", display_linear_filtering);
@@ -105,11 +123,15 @@ void Settings::Save(SettingsInterface& si) const
   si.SetBoolValue("Debug", "ShowVRAM", debugging.show_vram);
   si.SetBoolValue("Debug", "DumpCPUToVRAMCopies", debugging.dump_cpu_to_vram_copies);
   si.SetBoolValue("Debug", "DumpVRAMToCPUCopies", debugging.dump_vram_to_cpu_copies);
+  si.SetBoolValue("Debug", "DisableGPUSWSIMD", debugging.disable_gpu_sw_simd);
   si.SetBoolValue("Debug", "ShowGPUState", debugging.show_gpu_state);
   si.SetBoolValue("Debug", "ShowCDROMState", debugging.show_cdrom_state);
   si.SetBoolValue("Debug", "ShowSPUState", debugging.show_spu_state);
   si.SetBoolValue("Debug", "ShowTimersState", debugging.show_timers_state);
   si.SetBoolValue("Debug", "ShowMDECState", debugging.show_mdec_state);
+  si.SetBoolValue("Debug", "ShowProfiler", debugging.show_profiler);
+  si.SetBoolValue("Debug", "ShowCodeCacheState", debugging.show_code_cache_state);
+  si.SetBoolValue("Debug", "ShowHotBlocks", debugging.show_hot_blocks);
 }
 
 static std::array<const char*, 4> s_console_region_names = {{"Auto", "NTSC-J", "NTSC-U", "PAL"}};
@@ -140,9 +162,10 @@ const char* Settings::GetConsoleRegionDisplayName(ConsoleRegion region)
   return s_console_region_display_names[static_cast<int>(region)];
 }
 
-static std::array<const char*, 3> s_cpu_execution_mode_names = {{"Interpreter", "CachedInterpreter", "Recompiler"}};
-static std::array<const char*, 3> s_cpu_execution_mode_display_names = {
-  {"Intepreter (Slowest)", "Cached Interpreter (Faster)", "Recompiler (Fastest)"}};
+static std::array<const char*, 4> s_cpu_execution_mode_names = {
+  {"Interpreter", "CachedInterpreter", "PredecodedInterpreter", "Recompiler"}};
+static std::array<const char*, 4> s_cpu_execution_mode_display_names = {
+  {"Intepreter (Slowest)", "Cached Interpreter (Faster)", "Pre-decoded Interpreter (Faster)", "Recompiler (Fastest)"}};
 
 std::optional<CPUExecutionMode> Settings::ParseCPUExecutionMode(const char* str)
 {
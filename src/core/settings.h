@@ -34,17 +34,25 @@ struct Settings
   ConsoleRegion region = ConsoleRegion::Auto;
 
   CPUExecutionMode cpu_execution_mode = CPUExecutionMode::Interpreter;
+  bool cpu_fastmem = true;
+  bool cpu_persistent_code_cache = false;
 
   float emulation_speed = 1.0f;
   bool start_paused = false;
   bool speed_limiter_enabled = true;
 
+  bool rewind_enable = false;
+  u32 rewind_save_frequency = 6;
+  u32 rewind_save_slots = 100;
+
   GPURenderer gpu_renderer = GPURenderer::Software;
   u32 gpu_resolution_scale = 1;
   mutable u32 max_gpu_resolution_scale = 1;
   bool gpu_true_color = false;
   bool gpu_texture_filtering = false;
   bool gpu_force_progressive_scan = false;
+  bool gpu_use_thread = true;
+  u32 gpu_sw_thread_count = 1;
   bool gpu_use_debug_device = false;
   bool display_linear_filtering = true;
   bool display_fullscreen = false;
@@ -58,6 +66,7 @@ struct Settings
     bool show_vram = false;
     bool dump_cpu_to_vram_copies = false;
     bool dump_vram_to_cpu_copies = false;
+    bool disable_gpu_sw_simd = false;
 
     // Mutable because the imgui window can close itself.
     mutable bool show_gpu_state = false;
@@ -65,6 +74,9 @@ struct Settings
     mutable bool show_spu_state = false;
     mutable bool show_timers_state = false;
     mutable bool show_mdec_state = false;
+    mutable bool show_profiler = false;
+    mutable bool show_code_cache_state = false;
+    mutable bool show_hot_blocks = false;
   } debugging;
 
   // TODO: Controllers, memory cards, etc.
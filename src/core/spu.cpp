@@ -25,7 +25,10 @@ void SPU::Initialize(System* system, DMA* dma, InterruptController* interrupt_co
   m_dma = dma;
   m_interrupt_controller = interrupt_controller;
   m_sample_event = m_system->CreateTimingEvent("SPU Sample", SYSCLK_TICKS_PER_SPU_TICK, SYSCLK_TICKS_PER_SPU_TICK,
-                                               std::bind(&SPU::Execute, this, std::placeholders::_1), false);
+                                               [](void* param, TickCount ticks, TickCount ticks_late) {
+                                                 static_cast<SPU*>(param)->Execute(ticks);
+                                               },
+                                               this, false);
 }
 
 void SPU::Reset()
@@ -527,6 +530,7 @@ void SPU::WriteVoiceRegister(u32 offset, u16 value)
 
 void SPU::DMARead(u32* words, u32 word_count)
 {
+  SystemComponentScope component_scope(m_system, System::Component::SPU);
   // test for wrap-around
   if ((m_transfer_address & ~RAM_MASK) != ((m_transfer_address + (word_count * sizeof(u32))) & ~RAM_MASK))
   {
@@ -547,6 +551,7 @@ void SPU::DMARead(u32* words, u32 word_count)
 
 void SPU::DMAWrite(const u32* words, u32 word_count)
 {
+  SystemComponentScope component_scope(m_system, System::Component::SPU);
   // test for wrap-around
   if ((m_transfer_address & ~RAM_MASK) != ((m_transfer_address + (word_count * sizeof(u32))) & ~RAM_MASK))
   {
@@ -626,6 +631,7 @@ void SPU::IncrementCaptureBufferPosition()
 
 void SPU::Execute(TickCount ticks)
 {
+  SystemComponentScope component_scope(m_system, System::Component::SPU);
   DebugAssert(m_SPUCNT.enable || m_SPUCNT.cd_audio_enable);
 
   u32 remaining_frames = static_cast<u32>((ticks + m_ticks_carry) / SYSCLK_TICKS_PER_SPU_TICK);
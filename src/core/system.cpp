@@ -2,6 +2,8 @@
 #include "bios.h"
 #include "bus.h"
 #include "cdrom.h"
+#include "common/file_system.h"
+#include "common/byte_stream.h"
 #include "common/log.h"
 #include "common/state_wrapper.h"
 #include "controller.h"
@@ -12,14 +14,18 @@
 #include "gpu.h"
 #include "host_display.h"
 #include "host_interface.h"
+#include "input_movie.h"
 #include "interrupt_controller.h"
 #include "mdec.h"
 #include "memory_card.h"
 #include "pad.h"
+#include "rewind_buffer.h"
 #include "sio.h"
 #include "spu.h"
 #include "timers.h"
+#include <cinttypes>
 #include <cstdio>
+#include <cstring>
 #include <imgui.h>
 Log_SetChannel(System);
 
@@ -42,12 +48,17 @@ System::System(HostInterface* host_interface) : m_host_interface(host_interface)
   m_spu = std::make_unique<SPU>();
   m_mdec = std::make_unique<MDEC>();
   m_sio = std::make_unique<SIO>();
+  m_profiler = std::make_unique<Profiler>();
+  m_profiler_interpreter_counter = m_profiler->RegisterCounter(Profiler::Category::CPU, "Interpreter");
+  m_profiler_code_cache_counter = m_profiler->RegisterCounter(Profiler::Category::CPU, "Code Cache");
   m_region = host_interface->m_settings.region;
   m_cpu_execution_mode = host_interface->m_settings.cpu_execution_mode;
 }
 
 System::~System()
 {
+  SavePersistentCodeCache();
+
   // we have to explicitly destroy components because they can deregister events
   DestroyComponents();
 }
@@ -64,9 +75,12 @@ std::unique_ptr<System> System::Create(HostInterface* host_interface)
 bool System::RecreateGPU(GPURenderer renderer)
 {
   // save current state
-  std::unique_ptr<ByteStream> state_stream = ByteStream_CreateGrowableMemoryStream();
-  StateWrapper sw(state_stream.get(), StateWrapper::Mode::Write);
-  const bool state_valid = m_gpu->DoState(sw) && DoEventsState(sw);
+  std::unique_ptr<GrowableMemoryByteStream> state_stream = ByteStream_CreateGrowableMemoryStream();
+  bool state_valid;
+  {
+    StateWrapper sw(state_stream.get(), StateWrapper::Mode::Write);
+    state_valid = m_gpu->DoState(sw) && DoEventsState(sw);
+  }
   if (!state_valid)
     Log_ErrorPrintf("Failed to save old GPU state when switching renderers");
 
@@ -80,8 +94,7 @@ bool System::RecreateGPU(GPURenderer renderer)
 
   if (state_valid)
   {
-    state_stream->SeekAbsolute(0);
-    sw.SetMode(StateWrapper::Mode::Read);
+    StateWrapper sw(state_stream->GetMemoryPointer(), state_stream->GetMemorySize());
     m_gpu->DoState(sw);
     DoEventsState(sw);
   }
@@ -98,7 +111,12 @@ void System::SetCPUExecutionMode(CPUExecutionMode mode)
 {
   m_cpu_execution_mode = mode;
   m_cpu_code_cache->Flush();
-  m_cpu_code_cache->SetUseRecompiler(mode == CPUExecutionMode::Recompiler);
+  m_cpu_code_cache->SetExecutionMode(mode);
+}
+
+void System::SetCPUFastmem(bool enabled)
+{
+  m_cpu_code_cache->SetUseFastmem(enabled);
 }
 
 bool System::Boot(const char* filename)
@@ -188,6 +206,9 @@ bool System::Boot(const char* filename)
   // Load the patched BIOS up.
   m_bus->SetBIOS(*bios_image);
 
+  LoadPersistentCodeCache();
+  UpdateRewindSettings();
+
   // Good to go.
   return true;
 }
@@ -195,7 +216,7 @@ bool System::Boot(const char* filename)
 void System::InitializeComponents()
 {
   m_cpu->Initialize(m_bus.get());
-  m_cpu_code_cache->Initialize(this, m_cpu.get(), m_bus.get(), m_cpu_execution_mode == CPUExecutionMode::Recompiler);
+  m_cpu_code_cache->Initialize(this, m_cpu.get(), m_bus.get(), m_cpu_execution_mode, GetSettings().cpu_fastmem);
   m_bus->Initialize(m_cpu.get(), m_cpu_code_cache.get(), m_dma.get(), m_interrupt_controller.get(), m_gpu.get(),
                     m_cdrom.get(), m_pad.get(), m_timers.get(), m_spu.get(), m_mdec.get(), m_sio.get());
 
@@ -281,7 +302,9 @@ bool System::DoState(StateWrapper& sw)
   std::string media_filename = m_cdrom->GetMediaFileName();
   sw.Do(&media_filename);
 
-  if (sw.IsReading())
+  // The disc is usually unchanged, e.g. when rewinding, so keep the open image instead of reopening it and looking the
+  // game up again. Its position is restored by the CDROM state.
+  if (sw.IsReading() && media_filename != m_cdrom->GetMediaFileName())
   {
     std::unique_ptr<CDImage> media;
     if (!media_filename.empty())
@@ -357,14 +380,42 @@ void System::Reset()
   m_frame_number = 1;
   m_internal_frame_number = 0;
   m_global_tick_counter = 0;
-  m_last_event_run_time = 0;
   ResetPerformanceCounters();
+
+  // Rewinding to before the reset would be confusing.
+  if (m_rewind_buffer)
+    m_rewind_buffer->Clear();
+
+  if (m_input_movie_mode != InputMovieMode::None)
+    InterruptInputMovie("the system was reset");
 }
 
 bool System::LoadState(ByteStream* state)
 {
   StateWrapper sw(state, StateWrapper::Mode::Read);
-  return DoState(sw);
+  return LoadState(sw);
+}
+
+bool System::LoadState(const void* data, u32 size)
+{
+  StateWrapper sw(data, size);
+  return LoadState(sw);
+}
+
+bool System::LoadState(StateWrapper& sw)
+{
+  if (!DoState(sw))
+    return false;
+
+  if (m_rewind_buffer)
+    m_rewind_buffer->Clear();
+
+  if (m_input_movie_mode != InputMovieMode::None)
+    InterruptInputMovie("a state was loaded");
+
+  // Loading the state flushed the code cache.
+  LoadPersistentCodeCache();
+  return true;
 }
 
 bool System::SaveState(ByteStream* state)
@@ -373,18 +424,282 @@ bool System::SaveState(ByteStream* state)
   return DoState(sw);
 }
 
+bool System::SaveSnapshot(GrowableMemoryByteStream* stream)
+{
+  stream->SeekAbsolute(0);
+  StateWrapper sw(stream, StateWrapper::Mode::Write);
+  return DoState(sw);
+}
+
+bool System::LoadSnapshot(const void* data, u32 size)
+{
+  // Unlike LoadState(), the persistent code cache isn't preloaded, as snapshots are loaded often.
+  StateWrapper sw(data, size);
+  return DoState(sw);
+}
+
+void System::UpdateRewindSettings()
+{
+  const Settings& settings = GetSettings();
+  if (!settings.rewind_enable)
+  {
+    m_rewind_buffer.reset();
+    m_rewind_stream.reset();
+    return;
+  }
+
+  if (m_rewind_buffer && m_rewind_buffer->GetSlotCount() == settings.rewind_save_slots)
+    return;
+
+  m_rewind_buffer = std::make_unique<RewindBuffer>(settings.rewind_save_slots);
+  if (!m_rewind_stream)
+    m_rewind_stream = ByteStream_CreateGrowableMemoryStream();
+  m_rewind_frame_counter = 0;
+}
+
+void System::SaveRewindState()
+{
+  if (++m_rewind_frame_counter < GetSettings().rewind_save_frequency)
+    return;
+
+  m_rewind_frame_counter = 0;
+
+  SystemComponentScope component_scope(this, Component::Other);
+  const Common::Timer::Value start_time = Common::Timer::GetValue();
+  if (!SaveSnapshot(m_rewind_stream.get()))
+  {
+    Log_ErrorPrintf("Failed to save rewind state");
+    return;
+  }
+
+  m_rewind_buffer->Push(m_rewind_stream->GetMemoryPointer(), static_cast<u32>(m_rewind_stream->GetPosition()));
+  m_rewind_save_time += Common::Timer::GetValue() - start_time;
+  m_rewind_save_count++;
+}
+
+bool System::Rewind()
+{
+  if (!m_rewind_buffer || m_rewind_buffer->IsEmpty())
+    return false;
+
+  if (!LoadSnapshot(m_rewind_buffer->GetNewestState(), m_rewind_buffer->GetNewestStateSize()))
+  {
+    Log_ErrorPrintf("Failed to load rewind state");
+    m_rewind_buffer->Clear();
+    return false;
+  }
+
+  m_rewind_buffer->Pop();
+
+  // Don't save the state we just went back to again straight away.
+  m_rewind_frame_counter = 0;
+
+  if (m_input_movie_mode != InputMovieMode::None)
+    InterruptInputMovie("the system was rewound");
+
+  return true;
+}
+
+System::RewindStatistics System::GetRewindStatistics() const
+{
+  RewindStatistics stats = {};
+  if (m_rewind_buffer)
+  {
+    stats.states = m_rewind_buffer->GetStateCount();
+    stats.slots = m_rewind_buffer->GetSlotCount();
+    stats.storage_size = m_rewind_buffer->GetStorageSize();
+    stats.state_size = m_rewind_buffer->GetNewestStateSize();
+  }
+
+  stats.saves = m_rewind_save_count;
+  stats.average_save_time_ms =
+    (m_rewind_save_count > 0) ?
+      (Common::Timer::ConvertValueToMilliseconds(m_rewind_save_time) / static_cast<double>(m_rewind_save_count)) :
+      0.0;
+  return stats;
+}
+
+bool System::StartInputMovieRecording(u32 checkpoint_interval)
+{
+  StopInputMovie();
+
+  if (!m_input_movie_stream)
+    m_input_movie_stream = ByteStream_CreateGrowableMemoryStream();
+  if (!SaveSnapshot(m_input_movie_stream.get()))
+  {
+    Log_ErrorPrintf("Failed to save initial state for input movie");
+    return false;
+  }
+
+  const u8* state_data = m_input_movie_stream->GetMemoryPointer();
+  std::vector<u8> initial_state(state_data, state_data + m_input_movie_stream->GetPosition());
+
+  InputMovie::ControllerTypes controller_types;
+  for (u32 i = 0; i < NUM_CONTROLLER_AND_CARD_PORTS; i++)
+  {
+    const Controller* controller = m_pad->GetController(i);
+    controller_types[i] = controller ? controller->GetType() : ControllerType::None;
+  }
+
+  m_input_movie = std::make_unique<InputMovie>(std::move(initial_state), controller_types, checkpoint_interval);
+  m_input_movie_mode = InputMovieMode::Recording;
+  m_input_movie_frame = 0;
+  m_input_movie_checkpoints = 0;
+  m_input_movie_mismatched_checkpoints = 0;
+  m_input_movie_first_mismatch_frame = 0;
+  return true;
+}
+
+bool System::StartInputMoviePlayback(std::unique_ptr<InputMovie> movie)
+{
+  StopInputMovie();
+
+  const std::vector<u8>& initial_state = movie->GetInitialState();
+  if (!LoadState(initial_state.data(), static_cast<u32>(initial_state.size())))
+  {
+    Log_ErrorPrintf("Failed to load initial state of input movie");
+    return false;
+  }
+
+  // Loading the state switches the controllers to the ones it was saved with, but check in case it didn't.
+  for (u32 i = 0; i < NUM_CONTROLLER_AND_CARD_PORTS; i++)
+  {
+    const Controller* controller = m_pad->GetController(i);
+    const ControllerType type = controller ? controller->GetType() : ControllerType::None;
+    if (type != movie->GetControllerTypes()[i])
+    {
+      Log_ErrorPrintf("Input movie was recorded with controller type %s in port %u, but %s is connected",
+                      Settings::GetControllerTypeName(movie->GetControllerTypes()[i]), i + 1u,
+                      Settings::GetControllerTypeName(type));
+      return false;
+    }
+  }
+
+  m_input_movie = std::move(movie);
+  m_input_movie_mode = (m_input_movie->GetFrameCount() > 0) ? InputMovieMode::Playback : InputMovieMode::None;
+  m_input_movie_frame = 0;
+  m_input_movie_checkpoints = 0;
+  m_input_movie_mismatched_checkpoints = 0;
+  m_input_movie_first_mismatch_frame = 0;
+  return true;
+}
+
+std::unique_ptr<InputMovie> System::StopInputMovie()
+{
+  m_input_movie_mode = InputMovieMode::None;
+  return std::move(m_input_movie);
+}
+
+System::InputMovieStatistics System::GetInputMovieStatistics() const
+{
+  InputMovieStatistics stats = {};
+  stats.frame = m_input_movie_frame;
+  stats.frame_count = m_input_movie ? m_input_movie->GetFrameCount() : 0;
+  stats.checkpoints = m_input_movie_checkpoints;
+  stats.mismatched_checkpoints = m_input_movie_mismatched_checkpoints;
+  stats.first_mismatch_frame = m_input_movie_first_mismatch_frame;
+  return stats;
+}
+
+void System::BeginInputMovieFrame()
+{
+  if (m_input_movie_mode == InputMovieMode::Recording)
+  {
+    m_input_movie_stream->SeekAbsolute(0);
+    {
+      StateWrapper sw(m_input_movie_stream.get(), StateWrapper::Mode::Write);
+      for (u32 i = 0; i < NUM_CONTROLLER_AND_CARD_PORTS; i++)
+      {
+        Controller* controller = m_pad->GetController(i);
+        if (controller)
+          controller->DoInputState(sw);
+      }
+    }
+
+    if (!m_input_movie->AddFrame(m_input_movie_stream->GetMemoryPointer(),
+                                 static_cast<u32>(m_input_movie_stream->GetPosition())))
+    {
+      InterruptInputMovie("the controllers changed");
+    }
+  }
+  else
+  {
+    // Overrides whatever the host set, so the input is the same as when recording.
+    StateWrapper sw(m_input_movie->GetFrameInput(m_input_movie_frame), m_input_movie->GetFrameSize());
+    for (u32 i = 0; i < NUM_CONTROLLER_AND_CARD_PORTS; i++)
+    {
+      Controller* controller = m_pad->GetController(i);
+      if (controller)
+        controller->DoInputState(sw);
+    }
+  }
+}
+
+void System::EndInputMovieFrame()
+{
+  const u32 frame = m_input_movie_frame++;
+  if (m_input_movie->IsCheckpointFrame(frame))
+  {
+    const InputMovie::Checkpoint checkpoint = {frame, m_bus->GetRAMHash(), m_gpu->GetVRAMHash()};
+    if (m_input_movie_mode == InputMovieMode::Recording)
+    {
+      m_input_movie->AddCheckpoint(checkpoint);
+      m_input_movie_checkpoints++;
+    }
+    else if (const InputMovie::Checkpoint* expected = m_input_movie->GetCheckpoint(frame))
+    {
+      m_input_movie_checkpoints++;
+      if (checkpoint.ram_hash != expected->ram_hash || checkpoint.vram_hash != expected->vram_hash)
+      {
+        if (m_input_movie_mismatched_checkpoints++ == 0)
+        {
+          m_input_movie_first_mismatch_frame = frame;
+          Log_ErrorPrintf("Input movie diverged by frame %u: RAM hash %016" PRIx64 " (expected %016" PRIx64
+                          "), VRAM hash %016" PRIx64 " (expected %016" PRIx64 ")",
+                          frame, checkpoint.ram_hash, expected->ram_hash, checkpoint.vram_hash, expected->vram_hash);
+          m_host_interface->AddFormattedOSDMessage(5.0f, "Input movie diverged by frame %u.", frame);
+        }
+      }
+    }
+  }
+
+  if (m_input_movie_mode == InputMovieMode::Playback && m_input_movie_frame == m_input_movie->GetFrameCount())
+  {
+    m_input_movie_mode = InputMovieMode::None;
+    m_host_interface->AddFormattedOSDMessage(2.0f, "Input movie finished, %u of %u checkpoints matched.",
+                                             m_input_movie_checkpoints - m_input_movie_mismatched_checkpoints,
+                                             m_input_movie_checkpoints);
+  }
+}
+
+void System::InterruptInputMovie(const char* reason)
+{
+  Log_WarningPrintf("Input movie %s stopped at frame %u, as %s",
+                    (m_input_movie_mode == InputMovieMode::Recording) ? "recording" : "playback", m_input_movie_frame,
+                    reason);
+  m_input_movie_mode = InputMovieMode::None;
+}
+
 void System::RunFrame()
 {
   m_frame_timer.Reset();
   m_frame_done = false;
 
+  if (m_input_movie_mode != InputMovieMode::None)
+    BeginInputMovieFrame();
+
+  SystemComponentScope component_scope(this, Component::CPU);
+
   // Duplicated to avoid branch in the while loop, as the downcount can be quite low at times.
   if (m_cpu_execution_mode == CPUExecutionMode::Interpreter)
   {
     do
     {
       UpdateCPUDowncount();
-      m_cpu->Execute();
+      {
+        PROFILE_SCOPE(m_profiler.get(), m_profiler_interpreter_counter);
+        m_cpu->Execute();
+      }
       RunEvents();
     } while (!m_frame_done);
   }
@@ -393,7 +708,10 @@ void System::RunFrame()
     do
     {
       UpdateCPUDowncount();
-      m_cpu_code_cache->Execute();
+      {
+        PROFILE_SCOPE(m_profiler.get(), m_profiler_code_cache_counter);
+        m_cpu_code_cache->Execute();
+      }
       RunEvents();
     } while (!m_frame_done);
   }
@@ -401,6 +719,16 @@ void System::RunFrame()
   // Generate any pending samples from the SPU before sleeping, this way we reduce the chances of underruns.
   m_spu->GeneratePendingSamples();
 
+  if (m_input_movie_mode != InputMovieMode::None)
+    EndInputMovieFrame();
+
+  if (m_rewind_buffer)
+    SaveRewindState();
+
+#ifdef WITH_PROFILER
+  m_profiler->EndFrame(static_cast<float>(m_frame_timer.GetTimeMilliseconds()));
+#endif
+
   UpdatePerformanceCounters();
 }
 
@@ -499,6 +827,40 @@ void System::ResetPerformanceCounters()
   m_last_throttle_time = 0;
 }
 
+void System::SetComponentTimingEnabled(bool enabled)
+{
+  if (m_component_timing_enabled == enabled)
+    return;
+
+  m_component_timing_enabled = enabled;
+  m_current_component = Component::Other;
+  m_component_timestamp = Common::Timer::GetValue();
+}
+
+void System::ResetComponentTimes()
+{
+  m_component_times.fill(0);
+  m_component_timestamp = Common::Timer::GetValue();
+}
+
+const char* System::GetComponentName(Component component)
+{
+  static constexpr std::array<const char*, static_cast<size_t>(Component::Count)> names = {
+    {"CPU", "GPU", "SPU", "CDROM", "MDEC", "Other"}};
+  return names[static_cast<size_t>(component)];
+}
+
+System::Component System::SwitchComponent(Component component)
+{
+  const Common::Timer::Value now = Common::Timer::GetValue();
+  m_component_times[static_cast<size_t>(m_current_component)] += now - m_component_timestamp;
+  m_component_timestamp = now;
+
+  const Component previous = m_current_component;
+  m_current_component = component;
+  return previous;
+}
+
 bool System::LoadEXE(const char* filename, std::vector<u8>& bios_image)
 {
   std::FILE* fp = std::fopen(filename, "rb");
@@ -597,6 +959,9 @@ Controller* System::GetController(u32 slot) const
 
 void System::UpdateControllers()
 {
+  if (m_input_movie_mode != InputMovieMode::None)
+    InterruptInputMovie("the controllers changed");
+
   const Settings& settings = m_host_interface->GetSettings();
   for (u32 i = 0; i < NUM_CONTROLLER_AND_CARD_PORTS; i++)
   {
@@ -645,134 +1010,151 @@ void System::RemoveMedia()
   m_cdrom->RemoveMedia();
 }
 
-std::unique_ptr<TimingEvent> System::CreateTimingEvent(std::string name, TickCount period, TickCount interval,
-                                                       TimingEventCallback callback, bool activate)
+std::unique_ptr<TimingEvent> System::CreateTimingEvent(const char* name, TickCount period, TickCount interval,
+                                                       TimingEventCallback callback, void* callback_param,
+                                                       bool activate)
 {
   std::unique_ptr<TimingEvent> event =
-    std::make_unique<TimingEvent>(this, std::move(name), period, interval, std::move(callback));
+    std::make_unique<TimingEvent>(this, name, period, interval, callback, callback_param);
+#ifdef WITH_PROFILER
+  event->m_profiler_counter = m_profiler->RegisterCounter(Profiler::Category::Event, event->GetName());
+#endif
   if (activate)
     event->Activate();
 
   return event;
 }
 
-static bool CompareEvents(const TimingEvent* lhs, const TimingEvent* rhs)
+void System::LinkActiveEvent(TimingEvent* event)
+{
+  // Events which run at the same time are kept in the order they were scheduled.
+  TimingEvent* prev = nullptr;
+  TimingEvent* next = m_active_events_head;
+  while (next && !event->IsBefore(next))
+  {
+    prev = next;
+    next = next->m_next;
+  }
+
+  event->m_prev = prev;
+  event->m_next = next;
+  if (prev)
+    prev->m_next = event;
+  else
+    m_active_events_head = event;
+  if (next)
+    next->m_prev = event;
+}
+
+void System::UnlinkActiveEvent(TimingEvent* event)
 {
-  return lhs->GetDowncount() > rhs->GetDowncount();
+  if (event->m_prev)
+    event->m_prev->m_next = event->m_next;
+  else
+    m_active_events_head = event->m_next;
+  if (event->m_next)
+    event->m_next->m_prev = event->m_prev;
+
+  event->m_prev = nullptr;
+  event->m_next = nullptr;
 }
 
 void System::AddActiveEvent(TimingEvent* event)
 {
-  m_events.push_back(event);
-  if (!m_running_events)
-  {
-    std::push_heap(m_events.begin(), m_events.end(), CompareEvents);
-    if (!m_frame_done)
-      UpdateCPUDowncount();
-  }
-  else
-  {
-    m_events_need_sorting = true;
-  }
+  LinkActiveEvent(event);
+  m_active_event_count++;
+  if (!m_running_events && !m_frame_done)
+    UpdateCPUDowncount();
 }
 
 void System::RemoveActiveEvent(TimingEvent* event)
 {
-  auto iter = std::find_if(m_events.begin(), m_events.end(), [event](const auto& it) { return event == it; });
-  if (iter == m_events.end())
+  if (m_active_event_count == 0)
   {
     Panic("Attempt to remove inactive event");
     return;
   }
 
-  m_events.erase(iter);
-  if (!m_running_events)
-  {
-    std::make_heap(m_events.begin(), m_events.end(), CompareEvents);
-    if (!m_events.empty() && !m_frame_done)
-      UpdateCPUDowncount();
-  }
-  else
+  UnlinkActiveEvent(event);
+  m_active_event_count--;
+  if (!m_running_events && m_active_events_head && !m_frame_done)
+    UpdateCPUDowncount();
+}
+
+void System::RescheduleEvent(TimingEvent* event)
+{
+  // Only move the event if it's out of order with its neighbours, usually it's only a few places at most.
+  if ((event->m_prev && event->IsBefore(event->m_prev)) ||
+      (event->m_next && event->m_next->IsBefore(event)))
   {
-    m_events_need_sorting = true;
+    UnlinkActiveEvent(event);
+    LinkActiveEvent(event);
   }
+
+  if (!m_running_events && !m_frame_done)
+    UpdateCPUDowncount();
 }
 
 void System::SortEvents()
 {
-  if (!m_running_events)
-  {
-    std::make_heap(m_events.begin(), m_events.end(), CompareEvents);
-    if (!m_frame_done)
-      UpdateCPUDowncount();
-  }
-  else
+  TimingEvent* event = m_active_events_head;
+  m_active_events_head = nullptr;
+  while (event)
   {
-    m_events_need_sorting = true;
+    TimingEvent* next = event->m_next;
+    LinkActiveEvent(event);
+    event = next;
   }
+
+  if (!m_running_events && m_active_events_head && !m_frame_done)
+    UpdateCPUDowncount();
 }
 
 void System::RunEvents()
 {
-  DebugAssert(!m_running_events && !m_events.empty());
+  DebugAssert(!m_running_events && m_active_events_head);
 
   const TickCount pending_ticks = m_cpu->GetPendingTicks();
   m_global_tick_counter += static_cast<u32>(pending_ticks);
   m_cpu->ResetPendingTicks();
 
-  TickCount time = static_cast<TickCount>(m_global_tick_counter - m_last_event_run_time);
+  SystemComponentScope component_scope(this, Component::Other);
   m_running_events = true;
-  m_last_event_run_time = m_global_tick_counter;
 
-  // Apply downcount to all events.
-  // This will result in a negative downcount for those events which are late.
-  for (TimingEvent* evt : m_events)
+  // Event times are absolute, so nothing needs to be updated for the time which has passed.
+  // Late events have a next run time before the current time.
+  while (static_cast<TickCount>(m_active_events_head->m_next_run_time - m_global_tick_counter) <= 0)
   {
-    evt->m_downcount -= time;
-    evt->m_time_since_last_run += time;
-  }
-
-  // Now we can actually run the callbacks.
-  while (m_events.front()->GetDowncount() <= 0)
-  {
-    TimingEvent* evt = m_events.front();
-    const TickCount ticks_late = -evt->m_downcount;
-    std::pop_heap(m_events.begin(), m_events.end(), CompareEvents);
+    TimingEvent* evt = m_active_events_head;
+    const TickCount ticks_late = static_cast<TickCount>(m_global_tick_counter - evt->m_next_run_time);
 
     // Factor late time into the time for the next invocation.
-    const TickCount ticks_to_execute = evt->m_time_since_last_run;
-    evt->m_downcount += evt->m_interval;
-    evt->m_time_since_last_run = 0;
+    const TickCount ticks_to_execute = static_cast<TickCount>(m_global_tick_counter - evt->m_last_run_time);
+    evt->m_next_run_time += static_cast<u32>(evt->m_interval);
+    evt->m_last_run_time = m_global_tick_counter;
 
-    // The cycles_late is only an indicator, it doesn't modify the cycles to execute.
-    evt->m_callback(ticks_to_execute, ticks_late);
+    // Place it in the appropriate position in the queue before running it, in case the callback changes it.
+    RescheduleEvent(evt);
 
-    // Place it in the appropriate position in the queue.
-    if (m_events_need_sorting)
-    {
-      // Another event may have been changed by this event, or the interval/downcount changed.
-      std::make_heap(m_events.begin(), m_events.end(), CompareEvents);
-      m_events_need_sorting = false;
-    }
-    else
+    // The cycles_late is only an indicator, it doesn't modify the cycles to execute.
     {
-      // Keep the event list in a heap. The event we just serviced will be in the last place,
-      // so we can use push_here instead of make_heap, which should be faster.
-      std::push_heap(m_events.begin(), m_events.end(), CompareEvents);
+      PROFILE_SCOPE(m_profiler.get(), evt->m_profiler_counter);
+      evt->m_callback(evt->m_callback_param, ticks_to_execute, ticks_late);
     }
   }
 
   m_running_events = false;
-  m_cpu->SetDowncount(m_events.front()->GetDowncount());
+  UpdateCPUDowncount();
 }
 
 void System::UpdateCPUDowncount()
 {
-  m_cpu->SetDowncount(m_events[0]->GetDowncount());
+  m_cpu->SetDowncount(static_cast<TickCount>(m_active_events_head->m_next_run_time - m_global_tick_counter));
 }
 
 bool System::DoEventsState(StateWrapper& sw)
 {
+  // Times are stored relative to the global tick counter, which is serialized separately.
   if (sw.IsReading())
   {
     // Load timestamps for the clock events.
@@ -799,33 +1181,41 @@ bool System::DoEventsState(StateWrapper& sw)
         continue;
       }
 
-      // Using reschedule is safe here since we call sort afterwards.
-      event->m_downcount = downcount;
-      event->m_time_since_last_run = time_since_last_run;
+      // Modifying the event directly is safe here since we sort afterwards.
+      event->m_next_run_time = m_global_tick_counter + static_cast<u32>(downcount);
+      event->m_last_run_time = m_global_tick_counter - static_cast<u32>(time_since_last_run);
       event->m_period = period;
       event->m_interval = interval;
     }
 
-    sw.Do(&m_last_event_run_time);
+    // Time of the last event run, which is always the global tick counter outside of RunEvents().
+    u32 last_event_run_time = 0;
+    sw.Do(&last_event_run_time);
 
     Log_DevPrintf("Loaded %u events from save state.", event_count);
     SortEvents();
   }
   else
   {
-    u32 event_count = static_cast<u32>(m_events.size());
+    u32 event_count = m_active_event_count;
     sw.Do(&event_count);
 
-    for (TimingEvent* evt : m_events)
+    for (const TimingEvent* evt = m_active_events_head; evt; evt = evt->m_next)
     {
-      sw.Do(&evt->m_name);
-      sw.Do(&evt->m_downcount);
-      sw.Do(&evt->m_time_since_last_run);
-      sw.Do(&evt->m_period);
-      sw.Do(&evt->m_interval);
+      std::string event_name(evt->m_name);
+      TickCount downcount = evt->GetDowncount();
+      TickCount time_since_last_run = static_cast<TickCount>(m_global_tick_counter - evt->m_last_run_time);
+      TickCount period = evt->m_period;
+      TickCount interval = evt->m_interval;
+      sw.Do(&event_name);
+      sw.Do(&downcount);
+      sw.Do(&time_since_last_run);
+      sw.Do(&period);
+      sw.Do(&interval);
     }
 
-    sw.Do(&m_last_event_run_time);
+    u32 last_event_run_time = m_global_tick_counter;
+    sw.Do(&last_event_run_time);
 
     Log_DevPrintf("Wrote %u events to save state.", event_count);
   }
@@ -835,14 +1225,21 @@ bool System::DoEventsState(StateWrapper& sw)
 
 TimingEvent* System::FindActiveEvent(const char* name)
 {
-  auto iter =
-    std::find_if(m_events.begin(), m_events.end(), [&name](auto& ev) { return ev->GetName().compare(name) == 0; });
+  for (TimingEvent* event = m_active_events_head; event; event = event->m_next)
+  {
+    if (std::strcmp(event->m_name, name) == 0)
+      return event;
+  }
 
-  return (iter != m_events.end()) ? *iter : nullptr;
+  return nullptr;
 }
 
 void System::UpdateRunningGame(const char* path, CDImage* image)
 {
+  // The code cache still holds the blocks of the previous game at this point.
+  if (m_running_game_path != (path ? path : ""))
+    SavePersistentCodeCache();
+
   m_running_game_path.clear();
   m_running_game_code.clear();
   m_running_game_title.clear();
@@ -874,3 +1271,39 @@ void System::UpdateRunningGame(const char* path, CDImage* image)
 
   m_host_interface->OnRunningGameChanged();
 }
+
+void System::LoadPersistentCodeCache()
+{
+  if (!GetSettings().cpu_persistent_code_cache || m_running_game_code.empty())
+    return;
+
+  const std::string filename = m_host_interface->GetCodeCacheFileName(m_running_game_code.c_str());
+  std::unique_ptr<ByteStream> stream =
+    FileSystem::OpenFile(filename.c_str(), BYTESTREAM_OPEN_READ | BYTESTREAM_OPEN_STREAMED);
+  if (!stream)
+    return;
+
+  if (!m_cpu_code_cache->LoadPersistentBlocks(stream.get()))
+    Log_WarningPrintf("Failed to load code cache '%s'", filename.c_str());
+}
+
+void System::SavePersistentCodeCache()
+{
+  if (!GetSettings().cpu_persistent_code_cache || m_running_game_code.empty())
+    return;
+
+  const std::string filename = m_host_interface->GetCodeCacheFileName(m_running_game_code.c_str());
+  std::unique_ptr<ByteStream> stream =
+    FileSystem::OpenFile(filename.c_str(), BYTESTREAM_OPEN_CREATE | BYTESTREAM_OPEN_WRITE | BYTESTREAM_OPEN_TRUNCATE |
+                                             BYTESTREAM_OPEN_ATOMIC_UPDATE | BYTESTREAM_OPEN_STREAMED);
+  if (!stream || !m_cpu_code_cache->SavePersistentBlocks(stream.get()))
+  {
+    Log_ErrorPrintf("Failed to save code cache '%s'", filename.c_str());
+    if (stream)
+      stream->Discard();
+
+    return;
+  }
+
+  stream->Commit();
+}
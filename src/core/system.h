@@ -1,13 +1,18 @@
 #pragma once
 #include "common/timer.h"
 #include "host_interface.h"
+#include "profiler.h"
 #include "timing_event.h"
 #include "types.h"
+#include <array>
 #include <memory>
 #include <optional>
 #include <string>
 
 class ByteStream;
+class GrowableMemoryByteStream;
+class InputMovie;
+class RewindBuffer;
 class CDImage;
 class StateWrapper;
 
@@ -33,6 +38,20 @@ class System
   friend TimingEvent;
 
 public:
+  /// Components which host time can be attributed to, for performance analysis.
+  enum class Component : u8
+  {
+    CPU,
+    GPU,
+    SPU,
+    CDROM,
+    MDEC,
+    Other,
+    Count
+  };
+
+  using ComponentTimes = std::array<Common::Timer::Value, static_cast<size_t>(Component::Count)>;
+
   ~System();
 
   /// Creates a new System.
@@ -41,6 +60,7 @@ public:
   // Accessing components.
   HostInterface* GetHostInterface() const { return m_host_interface; }
   CPU::Core* GetCPU() const { return m_cpu.get(); }
+  CPU::CodeCache* GetCPUCodeCache() const { return m_cpu_code_cache.get(); }
   Bus* GetBus() const { return m_bus.get(); }
   DMA* GetDMA() const { return m_dma.get(); }
   InterruptController* GetInterruptController() const { return m_interrupt_controller.get(); }
@@ -50,6 +70,7 @@ public:
   Timers* GetTimers() const { return m_timers.get(); }
   SPU* GetSPU() const { return m_spu.get(); }
   MDEC* GetMDEC() const { return m_mdec.get(); }
+  Profiler* GetProfiler() const { return m_profiler.get(); }
 
   ConsoleRegion GetRegion() const { return m_region; }
   bool IsPALRegion() const { return m_region == ConsoleRegion::PAL; }
@@ -79,8 +100,58 @@ public:
   void Reset();
 
   bool LoadState(ByteStream* state);
+  bool LoadState(const void* data, u32 size);
   bool SaveState(ByteStream* state);
 
+  /// Saves the state to memory. The stream is rewound first and keeps its buffer, so once it has grown to fit a state,
+  /// saving doesn't allocate. The size of the state is the stream position afterwards.
+  bool SaveSnapshot(GrowableMemoryByteStream* stream);
+  bool LoadSnapshot(const void* data, u32 size);
+
+  /// Creates or destroys the rewind buffer, call when the rewind settings change.
+  void UpdateRewindSettings();
+
+  /// Loads the newest rewind state, and drops it so the next call goes further back. Returns false if there are no
+  /// states left, or rewind is disabled.
+  bool Rewind();
+
+  struct RewindStatistics
+  {
+    u32 states;
+    u32 slots;
+    u32 storage_size;
+    u32 state_size;
+    u32 saves;
+    double average_save_time_ms;
+  };
+  RewindStatistics GetRewindStatistics() const;
+
+  /// Starts recording the controller input of every frame, beginning with a snapshot of the current state. RAM and
+  /// VRAM hashes are stored every checkpoint_interval frames, zero disables checkpoints.
+  bool StartInputMovieRecording(u32 checkpoint_interval);
+
+  /// Loads the movie's initial state, then drives the controllers from it each frame, comparing against the
+  /// checkpoints. Playback ends after the last frame of the movie.
+  bool StartInputMoviePlayback(std::unique_ptr<InputMovie> movie);
+
+  /// Stops recording or playback, and returns the movie. Loading a state, resetting, rewinding or changing controllers
+  /// also ends recording or playback, but the movie is kept until this is called, so the frames recorded so far can
+  /// still be saved.
+  std::unique_ptr<InputMovie> StopInputMovie();
+
+  bool IsRecordingInputMovie() const { return (m_input_movie_mode == InputMovieMode::Recording); }
+  bool IsPlayingInputMovie() const { return (m_input_movie_mode == InputMovieMode::Playback); }
+
+  struct InputMovieStatistics
+  {
+    u32 frame;
+    u32 frame_count;
+    u32 checkpoints;
+    u32 mismatched_checkpoints;
+    u32 first_mismatch_frame;
+  };
+  InputMovieStatistics GetInputMovieStatistics() const;
+
   /// Recreates the GPU component, saving/loading the state so it is preserved. Call when the GPU renderer changes.
   bool RecreateGPU(GPURenderer renderer);
 
@@ -89,6 +160,7 @@ public:
 
   /// Forcibly changes the CPU execution mode, ignoring settings.
   void SetCPUExecutionMode(CPUExecutionMode mode);
+  void SetCPUFastmem(bool enabled);
 
   void RunFrame();
 
@@ -104,6 +176,24 @@ public:
   void UpdatePerformanceCounters();
   void ResetPerformanceCounters();
 
+  /// Enables accounting of host time per component. Adds a timer read on each component entry when enabled.
+  void SetComponentTimingEnabled(bool enabled);
+  bool IsComponentTimingEnabled() const { return m_component_timing_enabled; }
+  const ComponentTimes& GetComponentTimes() const { return m_component_times; }
+  void ResetComponentTimes();
+  static const char* GetComponentName(Component component);
+
+  /// Begins charging host time to the specified component, returns the component to restore afterwards.
+  ALWAYS_INLINE Component EnterComponent(Component component)
+  {
+    return m_component_timing_enabled ? SwitchComponent(component) : component;
+  }
+  ALWAYS_INLINE void LeaveComponent(Component previous)
+  {
+    if (m_component_timing_enabled)
+      SwitchComponent(previous);
+  }
+
   bool LoadEXE(const char* filename, std::vector<u8>& bios_image);
   bool SetExpansionROM(const char* filename);
 
@@ -119,14 +209,22 @@ public:
   bool InsertMedia(const char* path);
   void RemoveMedia();
 
-  /// Creates a new event.
-  std::unique_ptr<TimingEvent> CreateTimingEvent(std::string name, TickCount period, TickCount interval,
-                                                 TimingEventCallback callback, bool activate);
+  /// Creates a new event. The name must outlive the event.
+  std::unique_ptr<TimingEvent> CreateTimingEvent(const char* name, TickCount period, TickCount interval,
+                                                 TimingEventCallback callback, void* callback_param, bool activate);
 
 private:
   System(HostInterface* host_interface);
 
+  enum class InputMovieMode : u8
+  {
+    None,
+    Recording,
+    Playback
+  };
+
   bool DoState(StateWrapper& sw);
+  bool LoadState(StateWrapper& sw);
   bool CreateGPU(GPURenderer renderer);
 
   void InitializeComponents();
@@ -135,6 +233,15 @@ private:
   // Active event management
   void AddActiveEvent(TimingEvent* event);
   void RemoveActiveEvent(TimingEvent* event);
+
+  // Inserts/removes an event in the sorted list, without updating the CPU downcount.
+  void LinkActiveEvent(TimingEvent* event);
+  void UnlinkActiveEvent(TimingEvent* event);
+
+  // Moves an event whose next run time changed to its new position in the list.
+  void RescheduleEvent(TimingEvent* event);
+
+  // Re-sorts the whole list, after the events have been modified directly.
   void SortEvents();
 
   // Runs any pending events. Call when CPU downcount is zero.
@@ -154,12 +261,30 @@ private:
   template<typename T>
   void EnumerateActiveEvents(T callback) const
   {
-    for (const TimingEvent* ev : m_events)
+    for (const TimingEvent* ev = m_active_events_head; ev; ev = ev->m_next)
       callback(ev);
   }
 
   void UpdateRunningGame(const char* path, CDImage* image);
 
+  /// Preloads or saves the recompiled blocks of the running game, if the persistent code cache is enabled.
+  void LoadPersistentCodeCache();
+  void SavePersistentCodeCache();
+
+  Component SwitchComponent(Component component);
+
+  /// Saves a rewind state every few frames, called at the end of each frame.
+  void SaveRewindState();
+
+  /// Records or applies the controller input for a movie, called at the start of each frame.
+  void BeginInputMovieFrame();
+
+  /// Stores or checks the movie checkpoint, called at the end of each frame.
+  void EndInputMovieFrame();
+
+  /// Ends recording or playback when the state is changed from outside the movie.
+  void InterruptInputMovie(const char* reason);
+
   HostInterface* m_host_interface;
   std::unique_ptr<CPU::Core> m_cpu;
   std::unique_ptr<CPU::CodeCache> m_cpu_code_cache;
@@ -173,16 +298,31 @@ private:
   std::unique_ptr<SPU> m_spu;
   std::unique_ptr<MDEC> m_mdec;
   std::unique_ptr<SIO> m_sio;
+  std::unique_ptr<Profiler> m_profiler;
+  std::unique_ptr<RewindBuffer> m_rewind_buffer;
+  std::unique_ptr<GrowableMemoryByteStream> m_rewind_stream;
+  u32 m_rewind_frame_counter = 0;
+  u32 m_rewind_save_count = 0;
+  Common::Timer::Value m_rewind_save_time = 0;
+  std::unique_ptr<InputMovie> m_input_movie;
+  std::unique_ptr<GrowableMemoryByteStream> m_input_movie_stream;
+  InputMovieMode m_input_movie_mode = InputMovieMode::None;
+  u32 m_input_movie_frame = 0;
+  u32 m_input_movie_checkpoints = 0;
+  u32 m_input_movie_mismatched_checkpoints = 0;
+  u32 m_input_movie_first_mismatch_frame = 0;
+  Profiler::CounterIndex m_profiler_interpreter_counter = 0;
+  Profiler::CounterIndex m_profiler_code_cache_counter = 0;
   ConsoleRegion m_region = ConsoleRegion::NTSC_U;
   CPUExecutionMode m_cpu_execution_mode = CPUExecutionMode::Interpreter;
   u32 m_frame_number = 1;
   u32 m_internal_frame_number = 1;
   u32 m_global_tick_counter = 0;
 
-  std::vector<TimingEvent*> m_events;
-  u32 m_last_event_run_time = 0;
+  // Intrusive list of the active events, sorted by next run time.
+  TimingEvent* m_active_events_head = nullptr;
+  u32 m_active_event_count = 0;
   bool m_running_events = false;
-  bool m_events_need_sorting = false;
   bool m_frame_done = false;
 
   std::string m_running_game_path;
@@ -208,4 +348,24 @@ private:
   u32 m_last_global_tick_counter = 0;
   Common::Timer m_fps_timer;
   Common::Timer m_frame_timer;
+
+  ComponentTimes m_component_times = {};
+  Common::Timer::Value m_component_timestamp = 0;
+  Component m_current_component = Component::Other;
+  bool m_component_timing_enabled = false;
+};
+
+/// Charges host time spent in the enclosing scope to a component, when component timing is enabled.
+class SystemComponentScope
+{
+public:
+  ALWAYS_INLINE SystemComponentScope(System* system, System::Component component)
+    : m_system(system), m_previous(system->EnterComponent(component))
+  {
+  }
+  ALWAYS_INLINE ~SystemComponentScope() { m_system->LeaveComponent(m_previous); }
+
+private:
+  System* m_system;
+  System::Component m_previous;
 };
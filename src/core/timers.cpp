@@ -16,8 +16,10 @@ void Timers::Initialize(System* system, InterruptController* interrupt_controlle
   m_system = system;
   m_interrupt_controller = interrupt_controller;
   m_gpu = gpu;
-  m_sysclk_event = system->CreateTimingEvent("Timer SysClk Interrupt", 1, 1,
-                                             std::bind(&Timers::AddSysClkTicks, this, std::placeholders::_1), false);
+  m_sysclk_event = system->CreateTimingEvent(
+    "Timer SysClk Interrupt", 1, 1,
+    [](void* param, TickCount ticks, TickCount ticks_late) { static_cast<Timers*>(param)->AddSysClkTicks(ticks); },
+    this, false);
 }
 
 void Timers::Reset()
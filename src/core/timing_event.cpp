@@ -3,10 +3,10 @@
 #include "cpu_core.h"
 #include "system.h"
 
-TimingEvent::TimingEvent(System* system, std::string name, TickCount period, TickCount interval,
-                         TimingEventCallback callback)
-  : m_downcount(interval), m_time_since_last_run(0), m_period(period), m_interval(interval),
-    m_callback(std::move(callback)), m_system(system), m_name(std::move(name)), m_active(false)
+TimingEvent::TimingEvent(System* system, const char* name, TickCount period, TickCount interval,
+                         TimingEventCallback callback, void* callback_param)
+  : m_next_run_time(static_cast<u32>(interval)), m_last_run_time(0), m_period(period), m_interval(interval),
+    m_callback(callback), m_callback_param(callback_param), m_system(system), m_name(name), m_active(false)
 {
 }
 
@@ -16,33 +16,40 @@ TimingEvent::~TimingEvent()
     m_system->RemoveActiveEvent(this);
 }
 
+u32 TimingEvent::GetCurrentTime() const
+{
+  const TickCount pending_ticks = m_system->m_running_events ? 0 : m_system->m_cpu->GetPendingTicks();
+  return m_system->m_global_tick_counter + static_cast<u32>(pending_ticks);
+}
+
+TickCount TimingEvent::GetDowncount() const
+{
+  const u32 base = m_active ? m_system->m_global_tick_counter : 0;
+  return static_cast<TickCount>(m_next_run_time - base);
+}
+
 TickCount TimingEvent::GetTicksSinceLastExecution() const
 {
-  return m_system->m_cpu->GetPendingTicks() + m_time_since_last_run;
+  const u32 base = m_active ? m_system->m_global_tick_counter : 0;
+  return m_system->m_cpu->GetPendingTicks() + static_cast<TickCount>(base - m_last_run_time);
 }
 
 TickCount TimingEvent::GetTicksUntilNextExecution() const
 {
-  return std::max(m_downcount - m_system->m_cpu->GetPendingTicks(), static_cast<TickCount>(0));
+  return std::max(GetDowncount() - m_system->m_cpu->GetPendingTicks(), static_cast<TickCount>(0));
 }
 
 void TimingEvent::Schedule(TickCount ticks)
 {
-  m_downcount = ticks;
-  m_time_since_last_run = 0;
-
   // Factor in partial time if this was rescheduled outside of an event handler. Say, an MMIO write.
-  if (!m_system->m_running_events)
-  {
-    const TickCount pending_ticks = m_system->m_cpu->GetPendingTicks();
-    m_downcount += pending_ticks;
-    m_time_since_last_run -= pending_ticks;
-  }
+  const u32 current_time = GetCurrentTime();
+  m_next_run_time = current_time + static_cast<u32>(ticks);
+  m_last_run_time = current_time;
 
   if (m_active)
   {
-    // If this is a call from an IO handler for example, re-sort the event queue.
-    m_system->SortEvents();
+    // If this is a call from an IO handler for example, move the event to its new position in the queue.
+    m_system->RescheduleEvent(this);
   }
   else
   {
@@ -69,9 +76,9 @@ void TimingEvent::Reset()
   if (!m_active)
     return;
 
-  m_downcount = m_interval;
-  m_time_since_last_run = 0;
-  m_system->SortEvents();
+  m_next_run_time = m_system->m_global_tick_counter + static_cast<u32>(m_interval);
+  m_last_run_time = m_system->m_global_tick_counter;
+  m_system->RescheduleEvent(this);
 }
 
 void TimingEvent::InvokeEarly(bool force /* = false */)
@@ -79,17 +86,20 @@ void TimingEvent::InvokeEarly(bool force /* = false */)
   if (!m_active)
     return;
 
-  const TickCount pending_ticks = m_system->m_running_events ? 0 : m_system->m_cpu->GetPendingTicks();
-  const TickCount ticks_to_execute = m_time_since_last_run + pending_ticks;
+  const u32 current_time = GetCurrentTime();
+  const TickCount ticks_to_execute = static_cast<TickCount>(current_time - m_last_run_time);
   if (!force && ticks_to_execute < m_period)
     return;
 
-  m_downcount = pending_ticks + m_interval;
-  m_time_since_last_run -= ticks_to_execute;
-  m_callback(ticks_to_execute, 0);
+  m_next_run_time = current_time + static_cast<u32>(m_interval);
+  m_last_run_time = current_time;
+  {
+    PROFILE_SCOPE(m_system->GetProfiler(), m_profiler_counter);
+    m_callback(m_callback_param, ticks_to_execute, 0);
+  }
 
-  // Since we've changed the downcount, we need to re-sort the events.
-  m_system->SortEvents();
+  // Since we've changed the next run time, we need to move the event in the queue.
+  m_system->RescheduleEvent(this);
 }
 
 void TimingEvent::Activate()
@@ -98,9 +108,9 @@ void TimingEvent::Activate()
     return;
 
   // leave the downcount intact
-  const TickCount pending_ticks = m_system->m_running_events ? 0 : m_system->m_cpu->GetPendingTicks();
-  m_downcount += pending_ticks;
-  m_time_since_last_run -= pending_ticks;
+  const u32 current_time = GetCurrentTime();
+  m_next_run_time += current_time;
+  m_last_run_time += current_time;
 
   m_active = true;
   m_system->AddActiveEvent(this);
@@ -111,9 +121,9 @@ void TimingEvent::Deactivate()
   if (!m_active)
     return;
 
-  const TickCount pending_ticks = m_system->m_running_events ? 0 : m_system->m_cpu->GetPendingTicks();
-  m_downcount -= pending_ticks;
-  m_time_since_last_run += pending_ticks;
+  const u32 current_time = GetCurrentTime();
+  m_next_run_time -= current_time;
+  m_last_run_time -= current_time;
 
   m_active = false;
   m_system->RemoveActiveEvent(this);
@@ -121,10 +131,12 @@ void TimingEvent::Deactivate()
 
 void TimingEvent::SetDowncount(TickCount downcount)
 {
+  // Pending ticks are included even when inactive, as Activate() has always added them again.
   const TickCount pending_ticks = m_system->m_running_events ? 0 : m_system->m_cpu->GetPendingTicks();
-  m_downcount = downcount + pending_ticks;
-  m_time_since_last_run = -pending_ticks;
+  const u32 base = (m_active ? m_system->m_global_tick_counter : 0) + static_cast<u32>(pending_ticks);
+  m_next_run_time = base + static_cast<u32>(downcount);
+  m_last_run_time = base;
 
   if (m_active)
-    m_system->SortEvents();
+    m_system->RescheduleEvent(this);
 }
@@ -1,33 +1,35 @@
 #pragma once
-#include <functional>
 #include <memory>
-#include <vector>
 
 #include "types.h"
 
 class System;
 class TimingEvent;
 
-// Event callback type. Second parameter is the number of cycles the event was executed "late".
-using TimingEventCallback = std::function<void(TickCount ticks, TickCount ticks_late)>;
+// Event callback type. Param is the pointer passed at creation, ticks_late is the number of cycles the event was
+// executed "late".
+using TimingEventCallback = void (*)(void* param, TickCount ticks, TickCount ticks_late);
 
 class TimingEvent
 {
   friend System;
 
 public:
-  TimingEvent(System* system, std::string name, TickCount period, TickCount interval, TimingEventCallback callback);
+  // The name must outlive the event, it's used to find the event when loading save states.
+  TimingEvent(System* system, const char* name, TickCount period, TickCount interval, TimingEventCallback callback,
+              void* callback_param);
   ~TimingEvent();
 
   System* GetSystem() const { return m_system; }
-  const std::string& GetName() const { return m_name; }
+  const char* GetName() const { return m_name; }
   bool IsActive() const { return m_active; }
 
   // Returns the number of ticks between each event.
   TickCount GetPeriod() const { return m_period; }
   TickCount GetInterval() const { return m_interval; }
 
-  TickCount GetDowncount() const { return m_downcount; }
+  // Relative to the last time events were run.
+  TickCount GetDowncount() const;
 
   // Includes pending time.
   TickCount GetTicksSinceLastExecution() const;
@@ -64,13 +66,31 @@ public:
   void SetPeriod(TickCount period) { m_period = period; }
 
 private:
-  TickCount m_downcount;
-  TickCount m_time_since_last_run;
+  // Current time, including pending ticks when called outside of an event callback.
+  u32 GetCurrentTime() const;
+
+  // Wrap-safe, the global tick counter overflows every couple of minutes.
+  ALWAYS_INLINE bool IsBefore(const TimingEvent* other) const
+  {
+    return static_cast<s32>(m_next_run_time - other->m_next_run_time) < 0;
+  }
+
+  // Global tick counter values of the next and last execution, so nothing has to be updated as time passes.
+  // While the event is inactive, they're relative to the time it was deactivated instead.
+  u32 m_next_run_time;
+  u32 m_last_run_time;
+
   TickCount m_period;
   TickCount m_interval;
 
+  // Links in the system's active event list, which is sorted by next run time.
+  TimingEvent* m_prev = nullptr;
+  TimingEvent* m_next = nullptr;
+
   TimingEventCallback m_callback;
+  void* m_callback_param;
   System* m_system;
-  std::string m_name;
+  const char* m_name;
+  u32 m_profiler_counter = 0;
   bool m_active;
 };
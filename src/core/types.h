@@ -35,6 +35,7 @@ enum class CPUExecutionMode : u8
 {
   Interpreter,
   CachedInterpreter,
+  PredecodedInterpreter,
   Recompiler,
   Count
 };
@@ -0,0 +1,432 @@
+#include "bench_host_interface.h"
+#include "common/audio_stream.h"
+#include "common/byte_stream.h"
+#include "common/file_system.h"
+#include "common/timer.h"
+#include "core/controller.h"
+#include "core/cpu_code_cache.h"
+#include "core/gpu.h"
+#include "core/input_movie.h"
+#include "core/system.h"
+#include "null_host_display.h"
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+
+static constexpr u32 HOT_BLOCKS_DUMP_COUNT = 100;
+static constexpr u32 RECORDED_INPUT_PERIOD = 16;
+
+BenchHostInterface::BenchHostInterface() = default;
+
+BenchHostInterface::~BenchHostInterface()
+{
+  if (m_system)
+    DestroySystem();
+
+  m_audio_stream.reset();
+  m_display.reset();
+}
+
+std::unique_ptr<BenchHostInterface> BenchHostInterface::Create(const Options& options)
+{
+  std::unique_ptr<BenchHostInterface> intf = std::make_unique<BenchHostInterface>();
+  intf->m_options = options;
+
+  // Always use the software renderer, there's no display to draw to, and disable anything which would throttle.
+  Settings& settings = intf->m_settings;
+  settings.cpu_execution_mode = options.cpu_execution_mode;
+  settings.cpu_fastmem = options.fastmem;
+  settings.gpu_renderer = GPURenderer::Software;
+  settings.speed_limiter_enabled = false;
+  settings.video_sync_enabled = false;
+  settings.audio_sync_enabled = false;
+  settings.audio_backend = AudioBackend::Null;
+  settings.bios_patch_fast_boot = options.fast_boot;
+  settings.rewind_enable = (options.rewind_frequency > 0);
+  settings.rewind_save_frequency = options.rewind_frequency;
+  if (!options.record_movie_filename.empty())
+    settings.controller_types[0] = ControllerType::DigitalController;
+  if (!options.bios_path.empty())
+    settings.bios_path = options.bios_path;
+
+  intf->m_display = NullHostDisplay::Create();
+  intf->m_audio_stream = AudioStream::CreateNullAudioStream();
+  if (!intf->m_audio_stream->Reconfigure(AUDIO_SAMPLE_RATE, AUDIO_CHANNELS))
+    return nullptr;
+
+  return intf;
+}
+
+void BenchHostInterface::ReportError(const char* message)
+{
+  std::fprintf(stderr, "Error: %s\n", message);
+}
+
+void BenchHostInterface::ReportMessage(const char* message)
+{
+  std::fprintf(stderr, "%s\n", message);
+}
+
+bool BenchHostInterface::BootAndRun(u32 frames)
+{
+  if (!CreateSystem() ||
+      !BootSystem(m_options.filename.empty() ? nullptr : m_options.filename.c_str(), nullptr))
+  {
+    return false;
+  }
+
+  for (u32 i = 0; i < frames; i++)
+    m_system->RunFrame();
+
+  return true;
+}
+
+bool BenchHostInterface::Run()
+{
+  // Let the system settle (e.g. BIOS intro or disc spin-up) before measuring. Movies start from their own state.
+  const bool play_movie = !m_options.play_movie_filename.empty();
+  if (!BootAndRun(play_movie ? 0 : m_options.warmup_frames) || (play_movie && !StartMoviePlayback()))
+    return false;
+
+  if (!m_options.record_movie_filename.empty() && !m_system->StartInputMovieRecording(m_options.checkpoint_interval))
+  {
+    ReportError("Failed to start recording movie");
+    return false;
+  }
+
+  m_system->SetComponentTimingEnabled(true);
+  m_system->ResetComponentTimes();
+  m_system->GetProfiler()->Reset();
+
+  // Only the measured frames are counted.
+  if (!m_options.hot_blocks_filename.empty())
+    m_system->GetCPUCodeCache()->SetBlockProfilingEnabled(true);
+
+  double worst_frame_time = 0.0;
+  Common::Timer total_timer;
+  for (u32 i = 0; i < m_options.frames; i++)
+  {
+    if (m_system->IsRecordingInputMovie())
+      UpdateRecordedInput(i);
+
+    Common::Timer frame_timer;
+    m_system->RunFrame();
+    worst_frame_time = std::max(worst_frame_time, frame_timer.GetTimeMilliseconds());
+  }
+
+  const double total_time = total_timer.GetTimeMilliseconds();
+  m_system->SetComponentTimingEnabled(false);
+
+  PrintResults(total_time, worst_frame_time);
+
+  if (!m_options.profile_dump_filename.empty())
+  {
+    if (!Profiler::IsAvailable())
+      ReportError("Profiling counters are not available in this build, rebuild with ENABLE_PROFILER.");
+    else if (!m_system->GetProfiler()->DumpToFile(m_options.profile_dump_filename.c_str()))
+      ReportFormattedError("Failed to write profiler counters to '%s'", m_options.profile_dump_filename.c_str());
+  }
+
+  if (!m_options.hot_blocks_filename.empty() &&
+      !m_system->GetCPUCodeCache()->DumpHotBlocks(m_options.hot_blocks_filename.c_str(), HOT_BLOCKS_DUMP_COUNT))
+  {
+    ReportFormattedError("Failed to write hot blocks to '%s'", m_options.hot_blocks_filename.c_str());
+  }
+
+  if (!m_options.record_movie_filename.empty() && !FinishMovieRecording())
+    return false;
+
+  if (play_movie && !CheckMoviePlayback())
+    return false;
+
+  if (!m_options.save_state_filename.empty() && !CheckSaveState())
+    return false;
+
+  if (m_options.state_round_trips > 0 && !CheckStateRoundTrips())
+    return false;
+
+  if (m_options.rewind_frequency > 0 && !CheckRewind())
+    return false;
+
+  if (m_options.compare_scalar)
+    return CompareWithScalarRenderer();
+
+  return true;
+}
+
+bool BenchHostInterface::StartMoviePlayback()
+{
+  const char* filename = m_options.play_movie_filename.c_str();
+  std::unique_ptr<InputMovie> movie = InputMovie::LoadFromFile(filename);
+  if (!movie)
+  {
+    ReportFormattedError("Failed to load movie from '%s'", filename);
+    return false;
+  }
+
+  // The whole movie is measured.
+  m_options.frames = movie->GetFrameCount();
+  m_options.warmup_frames = 0;
+  if (!m_system->StartInputMoviePlayback(std::move(movie)))
+  {
+    ReportFormattedError("Failed to start playing movie '%s'", filename);
+    return false;
+  }
+
+  return true;
+}
+
+void BenchHostInterface::UpdateRecordedInput(u32 frame)
+{
+  // Holds a pseudo-random button for half of each period, so there's some input for the movie to reproduce.
+  Controller* controller = m_system->GetController(0);
+  const u32 phase = frame % RECORDED_INPUT_PERIOD;
+  if (!controller || (phase != 0 && phase != (RECORDED_INPUT_PERIOD / 2)))
+    return;
+
+  const Controller::ButtonList buttons = Controller::GetButtonNames(controller->GetType());
+  if (buttons.empty())
+    return;
+
+  const u32 index = (((frame / RECORDED_INPUT_PERIOD) * UINT32_C(2654435761)) >> 16) % static_cast<u32>(buttons.size());
+  controller->SetButtonState(buttons[index].second, phase == 0);
+}
+
+bool BenchHostInterface::FinishMovieRecording()
+{
+  const char* filename = m_options.record_movie_filename.c_str();
+  std::unique_ptr<InputMovie> movie = m_system->StopInputMovie();
+  if (!movie || !movie->SaveToFile(filename))
+  {
+    ReportFormattedError("Failed to write movie to '%s'", filename);
+    return false;
+  }
+
+  std::printf("\nRecorded %u frames with %u checkpoints to %s\n", movie->GetFrameCount(), movie->GetCheckpointCount(),
+              filename);
+  return true;
+}
+
+bool BenchHostInterface::CheckMoviePlayback()
+{
+  const System::InputMovieStatistics stats = m_system->GetInputMovieStatistics();
+  std::printf("\nMovie: %u/%u frames played, %u of %u checkpoints matched\n", stats.frame, stats.frame_count,
+              stats.checkpoints - stats.mismatched_checkpoints, stats.checkpoints);
+  if (stats.mismatched_checkpoints > 0)
+  {
+    ReportFormattedError("Playback diverged from the movie by frame %u", stats.first_mismatch_frame);
+    return false;
+  }
+  if (stats.frame != stats.frame_count)
+  {
+    ReportError("Movie playback was interrupted");
+    return false;
+  }
+
+  return true;
+}
+
+bool BenchHostInterface::CheckSaveState()
+{
+  const char* filename = m_options.save_state_filename.c_str();
+  const u64 hash = m_system->GetGPU()->GetVRAMHash();
+
+  // Only the serialization blocks the emulation thread, compressing and writing happens in the background.
+  Common::Timer save_timer;
+  if (!SaveState(filename))
+    return false;
+  const double save_time = save_timer.GetTimeMilliseconds();
+  if (!WaitForSaveStateThread())
+  {
+    ReportFormattedError("Failed to write state to '%s'", filename);
+    return false;
+  }
+  const double write_time = save_timer.GetTimeMilliseconds();
+
+  std::unique_ptr<GrowableMemoryByteStream> state_stream = ByteStream_CreateGrowableMemoryStream();
+  FILESYSTEM_STAT_DATA file_stat;
+  if (!m_system->SaveState(state_stream.get()) || !FileSystem::StatFile(filename, &file_stat))
+  {
+    ReportFormattedError("Failed to write state to '%s'", filename);
+    return false;
+  }
+
+  std::printf("\nSave state: %u KB (%u KB uncompressed), %.2f ms on the emulation thread, %.2f ms until written\n",
+              static_cast<u32>(file_stat.Size / 1024), state_stream->GetMemorySize() / 1024, save_time, write_time);
+
+  // Loading into a reset system should give back the same VRAM.
+  m_system->Reset();
+  Common::Timer load_timer;
+  if (!LoadState(filename))
+    return false;
+  const double load_time = load_timer.GetTimeMilliseconds();
+
+  const u64 loaded_hash = m_system->GetGPU()->GetVRAMHash();
+  std::printf("Loaded state in %.2f ms, VRAM hash %016llx (%016llx)\n", load_time,
+              static_cast<unsigned long long>(loaded_hash), static_cast<unsigned long long>(hash));
+  if (loaded_hash != hash)
+  {
+    ReportError("Loaded state has different VRAM contents");
+    return false;
+  }
+
+  return true;
+}
+
+bool BenchHostInterface::CheckStateRoundTrips()
+{
+  const u32 iterations = m_options.state_round_trips;
+  const u64 hash = m_system->GetGPU()->GetVRAMHash();
+  std::unique_ptr<GrowableMemoryByteStream> state_stream = ByteStream_CreateGrowableMemoryStream();
+
+  // The stream is reused, like the rewind buffer does, so only the first save pays for growing it.
+  double total_save_time = 0.0;
+  double total_load_time = 0.0;
+  double worst_save_time = 0.0;
+  double worst_load_time = 0.0;
+  for (u32 i = 0; i < iterations; i++)
+  {
+    Common::Timer save_timer;
+    if (!m_system->SaveSnapshot(state_stream.get()))
+    {
+      ReportError("Failed to save snapshot");
+      return false;
+    }
+    const double save_time = save_timer.GetTimeMilliseconds();
+
+    Common::Timer load_timer;
+    if (!m_system->LoadSnapshot(state_stream->GetMemoryPointer(), static_cast<u32>(state_stream->GetPosition())))
+    {
+      ReportError("Failed to load snapshot");
+      return false;
+    }
+    const double load_time = load_timer.GetTimeMilliseconds();
+
+    total_save_time += save_time;
+    total_load_time += load_time;
+    worst_save_time = std::max(worst_save_time, save_time);
+    worst_load_time = std::max(worst_load_time, load_time);
+
+    if (m_system->GetGPU()->GetVRAMHash() != hash)
+    {
+      ReportFormattedError("VRAM contents changed after %u state round trips", i + 1);
+      return false;
+    }
+  }
+
+  std::printf("\nState round trips: %u, %u KB per state\n", iterations,
+              static_cast<u32>(state_stream->GetPosition() / 1024));
+  std::printf("Save: %.3f ms average, %.3f ms worst\n", total_save_time / static_cast<double>(iterations),
+              worst_save_time);
+  std::printf("Load: %.3f ms average, %.3f ms worst\n", total_load_time / static_cast<double>(iterations),
+              worst_load_time);
+  return true;
+}
+
+bool BenchHostInterface::CheckRewind()
+{
+  const System::RewindStatistics stats = m_system->GetRewindStatistics();
+  std::printf("\nRewind: %u/%u states, %u KB stored, %u KB per state, %u saves, %.3f ms per save\n", stats.states,
+              stats.slots, stats.storage_size / 1024, stats.state_size / 1024, stats.saves,
+              stats.average_save_time_ms);
+
+  // Steps back through every state, then runs forward again. Emulation is deterministic, so if the states were
+  // saved and rebuilt correctly, VRAM ends up the same.
+  const u64 hash = m_system->GetGPU()->GetVRAMHash();
+  const u32 frame_number = m_system->GetFrameNumber();
+
+  u32 rewound_states = 0;
+  Common::Timer rewind_timer;
+  while (m_system->Rewind())
+    rewound_states++;
+  const double rewind_time = rewind_timer.GetTimeMilliseconds();
+
+  const u32 oldest_frame_number = m_system->GetFrameNumber();
+  while (m_system->GetFrameNumber() < frame_number)
+    m_system->RunFrame();
+
+  const u64 replayed_hash = m_system->GetGPU()->GetVRAMHash();
+  std::printf("Rewound %u states in %.2f ms to frame %u, VRAM hash after replaying to frame %u: %016llx (%016llx)\n",
+              rewound_states, rewind_time, oldest_frame_number, frame_number,
+              static_cast<unsigned long long>(replayed_hash), static_cast<unsigned long long>(hash));
+  if (rewound_states != stats.states || replayed_hash != hash)
+  {
+    ReportError("Replaying from the oldest rewind state gave different results");
+    return false;
+  }
+
+  return true;
+}
+
+bool BenchHostInterface::CompareWithScalarRenderer()
+{
+  // Runs the same frames again with the vectorized span shading disabled. Emulation is deterministic, so any
+  // difference in VRAM comes from the renderer.
+  const u64 hash = m_system->GetGPU()->GetVRAMHash();
+  DestroySystem();
+
+  m_settings.debugging.disable_gpu_sw_simd = true;
+  const bool result = BootAndRun(m_options.warmup_frames + m_options.frames);
+  m_settings.debugging.disable_gpu_sw_simd = false;
+  if (!result)
+    return false;
+
+  const u64 scalar_hash = m_system->GetGPU()->GetVRAMHash();
+  std::printf("\nVRAM hash: %016llx (scalar %016llx)\n", static_cast<unsigned long long>(hash),
+              static_cast<unsigned long long>(scalar_hash));
+  if (hash != scalar_hash)
+  {
+    ReportError("VRAM contents differ from the scalar renderer");
+    return false;
+  }
+
+  return true;
+}
+
+void BenchHostInterface::PrintResults(double total_time, double worst_frame_time) const
+{
+  const u32 frames = m_options.frames;
+  const double average_frame_time = (frames > 0) ? (total_time / static_cast<double>(frames)) : 0.0;
+  const double fps = (total_time > 0.0) ? (static_cast<double>(frames) * 1000.0 / total_time) : 0.0;
+
+  std::printf("Game: %s\n", m_system->GetRunningTitle().empty() ? "(none)" : m_system->GetRunningTitle().c_str());
+  std::printf("CPU execution mode: %s\n", Settings::GetCPUExecutionModeDisplayName(m_settings.cpu_execution_mode));
+  std::printf("Frames: %u (%u warmup)\n", frames, m_options.warmup_frames);
+  std::printf("Total time: %.2f ms\n", total_time);
+  std::printf("FPS: %.2f\n", fps);
+  std::printf("Average frame time: %.3f ms\n", average_frame_time);
+  std::printf("Worst frame time: %.3f ms\n", worst_frame_time);
+
+  const System::ComponentTimes& times = m_system->GetComponentTimes();
+  Common::Timer::Value total_component_time = 0;
+  for (const Common::Timer::Value value : times)
+    total_component_time += value;
+
+  std::printf("\n%-8s %12s %12s %8s\n", "Component", "Total (ms)", "Frame (ms)", "Share");
+  for (u32 i = 0; i < static_cast<u32>(System::Component::Count); i++)
+  {
+    const double component_time = Common::Timer::ConvertValueToMilliseconds(times[i]);
+    const double share = (total_component_time > 0) ?
+                           (static_cast<double>(times[i]) * 100.0 / static_cast<double>(total_component_time)) :
+                           0.0;
+    std::printf("%-8s %12.2f %12.3f %7.2f%%\n", System::GetComponentName(static_cast<System::Component>(i)),
+                component_time, (frames > 0) ? (component_time / static_cast<double>(frames)) : 0.0, share);
+  }
+
+  const CPU::CodeCache::PageStatistics code_stats = m_system->GetCPUCodeCache()->GetTotalPageStatistics();
+  std::printf("\nCode cache: %u invalidations, %u revalidations, %u recompilations, %u data writes\n",
+              code_stats.invalidations, code_stats.revalidations, code_stats.recompilations, code_stats.data_writes);
+
+  const CPU::CodeCache::CodeBufferStatistics buffer_stats = m_system->GetCPUCodeCache()->GetCodeBufferStatistics();
+  std::printf("Code buffer: %u KB near (%u KB live), %u KB far, %u evicted regions, %u evicted blocks\n",
+              buffer_stats.code_used / 1024, buffer_stats.live_code_size / 1024, buffer_stats.far_code_used / 1024,
+              buffer_stats.evicted_regions, buffer_stats.evicted_blocks);
+
+  const CPU::CodeCache::IdleLoopStatistics idle_stats = m_system->GetCPUCodeCache()->GetIdleLoopStatistics();
+  std::printf("Idle loops: %u compiled, %" PRIu64 " skips, %" PRIu64 " cycles skipped\n", idle_stats.idle_loops,
+              idle_stats.skips, idle_stats.skipped_ticks);
+
+  const CPU::CodeCache::LoadDelayStatistics load_delay_stats = m_system->GetCPUCodeCache()->GetLoadDelayStatistics();
+  std::printf("Loads: %u compiled, %u without load delay\n", load_delay_stats.loads,
+              load_delay_stats.skipped_load_delays);
+}
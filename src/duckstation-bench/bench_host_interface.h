@@ -0,0 +1,54 @@
+#pragma once
+#include "core/host_interface.h"
+#include <memory>
+#include <string>
+
+// Host interface which runs the system headless and unthrottled, reporting performance statistics.
+class BenchHostInterface final : public HostInterface
+{
+public:
+  struct Options
+  {
+    std::string filename;
+    std::string bios_path;
+    std::string profile_dump_filename;
+    std::string hot_blocks_filename;
+    std::string save_state_filename;
+    std::string record_movie_filename;
+    std::string play_movie_filename;
+    CPUExecutionMode cpu_execution_mode = CPUExecutionMode::Interpreter;
+    u32 frames = 1000;
+    u32 warmup_frames = 60;
+    u32 rewind_frequency = 0;
+    u32 state_round_trips = 0;
+    u32 checkpoint_interval = 60;
+    bool fast_boot = false;
+    bool fastmem = true;
+    bool compare_scalar = false;
+  };
+
+  BenchHostInterface();
+  ~BenchHostInterface();
+
+  static std::unique_ptr<BenchHostInterface> Create(const Options& options);
+
+  void ReportError(const char* message) override;
+  void ReportMessage(const char* message) override;
+
+  /// Runs the configured number of frames, and prints the results. Returns false if the system could not be booted.
+  bool Run();
+
+private:
+  bool BootAndRun(u32 frames);
+  bool StartMoviePlayback();
+  void UpdateRecordedInput(u32 frame);
+  bool FinishMovieRecording();
+  bool CheckMoviePlayback();
+  bool CheckRewind();
+  bool CheckSaveState();
+  bool CheckStateRoundTrips();
+  bool CompareWithScalarRenderer();
+  void PrintResults(double total_time, double worst_frame_time) const;
+
+  Options m_options;
+};
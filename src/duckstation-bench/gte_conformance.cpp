@@ -0,0 +1,120 @@
+#include "gte_conformance.h"
+#include "common/timer.h"
+#include "core/gte.h"
+#include <array>
+#include <cstdio>
+#include <memory>
+#include <random>
+
+static constexpr std::array<u8, 22> s_commands = {{0x01, 0x06, 0x0C, 0x10, 0x11, 0x12, 0x13, 0x14, 0x16, 0x1B, 0x1C,
+                                                   0x1E, 0x20, 0x28, 0x29, 0x2A, 0x2D, 0x2E, 0x30, 0x3D, 0x3E, 0x3F}};
+
+// Commands which have a vectorized implementation, timed separately.
+static constexpr std::array<std::pair<u8, const char*>, 3> s_simd_commands = {
+  {{0x30, "RTPT"}, {0x20, "NCT"}, {0x3F, "NCCT"}}};
+
+static u32 RandomRegisterValue(std::mt19937& rng)
+{
+  // Mix full-range values, which saturate almost everything, with small ones which mostly don't, and values at the
+  // limits of each halfword, which make the intermediate sums overflow.
+  const u32 value = static_cast<u32>(rng());
+  switch (rng() % 5)
+  {
+    case 0:
+      return value;
+    case 1:
+      return static_cast<u32>(static_cast<s32>(value << 16) >> 20);
+    case 2:
+      return (value & 0x0FFF0FFF);
+    case 3:
+      return (value & 0x00FF00FF) | ((value & 0x01000100) ? 0xFF00FF00 : 0);
+    default:
+      return ((value & 0x80000000) ? 0x80000000 : 0x7FFF0000) | ((value & 0x8000) ? 0x8000 : 0x7FFF);
+  }
+}
+
+static u32 RandomInstruction(std::mt19937& rng)
+{
+  // Command, then random lm, sf and MVMVA matrix/vector/translation selection.
+  return s_commands[rng() % s_commands.size()] | (static_cast<u32>(rng()) & 0xFFC00);
+}
+
+static double TimeCommand(GTE::Core* gte, u32 instruction_bits, u32 iterations)
+{
+  std::mt19937 rng(1);
+  for (u32 i = 0; i < GTE::NUM_REGS; i++)
+    gte->WriteRegister(i, RandomRegisterValue(rng));
+
+  // The commands only read vectors and matrices, so the results don't feed into each other.
+  Common::Timer timer;
+  for (u32 i = 0; i < iterations; i++)
+    gte->ExecuteInstruction(GTE::Instruction{instruction_bits});
+
+  return timer.GetTimeNanoseconds() / static_cast<double>(iterations);
+}
+
+bool RunGTEConformanceCheck(u32 iterations)
+{
+  std::unique_ptr<GTE::Core> scalar = std::make_unique<GTE::Core>();
+  std::unique_ptr<GTE::Core> simd = std::make_unique<GTE::Core>();
+  scalar->Initialize();
+  scalar->SetSIMDEnabled(false);
+  simd->Initialize();
+  if (!simd->IsSIMDEnabled())
+  {
+    std::printf("GTE: no SIMD implementation for this host, nothing to compare.\n");
+    return true;
+  }
+
+  std::mt19937 rng(12345);
+  u32 mismatches = 0;
+  for (u32 i = 0; i < iterations; i++)
+  {
+    // New register state every few commands, otherwise let the results of one feed the next.
+    if ((i % 8) == 0)
+    {
+      for (u32 reg = 0; reg < GTE::NUM_REGS; reg++)
+      {
+        const u32 value = RandomRegisterValue(rng);
+        scalar->WriteRegister(reg, value);
+        simd->WriteRegister(reg, value);
+      }
+    }
+
+    const u32 instruction_bits = RandomInstruction(rng);
+    scalar->ExecuteInstruction(GTE::Instruction{instruction_bits});
+    simd->ExecuteInstruction(GTE::Instruction{instruction_bits});
+
+    for (u32 reg = 0; reg < GTE::NUM_REGS; reg++)
+    {
+      const u32 expected = scalar->ReadRegister(reg);
+      const u32 actual = simd->ReadRegister(reg);
+      if (expected == actual)
+        continue;
+
+      std::printf("GTE: command %05X (iteration %u): register %u is %08X, expected %08X\n", instruction_bits, i, reg,
+                  actual, expected);
+
+      // Resynchronize so one difference doesn't report every later command.
+      simd->WriteRegister(reg, expected);
+      mismatches++;
+    }
+
+    if (mismatches >= 20)
+      break;
+  }
+
+  std::printf("GTE: %u commands checked, %u mismatched registers\n", iterations, mismatches);
+
+  static constexpr u32 TIMING_ITERATIONS = 1000000;
+  std::printf("\n%-8s %12s %12s\n", "Command", "Scalar (ns)", "SIMD (ns)");
+  for (const auto& [command, name] : s_simd_commands)
+  {
+    // sf=1, lm=0.
+    const u32 instruction_bits = command | (1u << 19);
+    std::printf("%-8s %12.2f %12.2f\n", name, TimeCommand(scalar.get(), instruction_bits, TIMING_ITERATIONS),
+                TimeCommand(simd.get(), instruction_bits, TIMING_ITERATIONS));
+  }
+
+  return (mismatches == 0);
+}
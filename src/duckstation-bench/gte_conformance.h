@@ -0,0 +1,7 @@
+#pragma once
+#include "common/types.h"
+
+/// Runs random GTE commands on random register states through both the scalar and the SIMD implementations, and
+/// checks that every register matches afterwards. Also prints the time per command for the vectorized commands.
+/// Returns false if any result differed.
+bool RunGTEConformanceCheck(u32 iterations);
@@ -0,0 +1,152 @@
+#include "bench_host_interface.h"
+#include "gte_conformance.h"
+#include "common/log.h"
+#include "core/settings.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+static void PrintUsage(const char* program_name)
+{
+  std::fprintf(stderr,
+               "Usage: %s [options] [disc image or exe]\n"
+               "  -frames <count>   Number of frames to measure (default 1000).\n"
+               "  -warmup <count>   Number of frames to run before measuring (default 60).\n"
+               "  -cpu <mode>       CPU execution mode: Interpreter, CachedInterpreter,\n"
+               "                    PredecodedInterpreter or Recompiler.\n"
+               "  -bios <path>      Path to BIOS image.\n"
+               "  -fastboot         Skip the BIOS intro.\n"
+               "  -no-fastmem       Route recompiled loads and stores through the memory handlers.\n"
+               "  -profile <file>   Write profiling counters to a CSV file (requires ENABLE_PROFILER).\n"
+               "  -hot-blocks <file> Write the blocks which used the most cycles, with disassembly.\n"
+               "  -save-state <file> Save a compressed state after the measured frames, then check loading it.\n"
+               "  -rewind <frames>  Save a rewind state every few frames, then check replaying from the oldest.\n"
+               "  -state-round-trips <count> Time saving and loading in-memory states, checking the VRAM after each.\n"
+               "  -record-movie <file> Record the measured frames with generated input to a movie file.\n"
+               "  -play-movie <file> Play back a movie instead of booting, failing if any checkpoint differs.\n"
+               "  -checkpoint-interval <frames> Frames between RAM/VRAM hashes when recording (default 60).\n"
+               "  -compare-scalar   Check the rendered VRAM against a run with SIMD span shading disabled.\n"
+               "  -check-gte <count> Compare SIMD and scalar GTE results for random commands, then exit.\n"
+               "  -verbose          Print emulator log messages.\n",
+               program_name);
+}
+
+int main(int argc, char* argv[])
+{
+  BenchHostInterface::Options options;
+  u32 gte_check_iterations = 0;
+  bool verbose = false;
+
+  for (int i = 1; i < argc; i++)
+  {
+#define CHECK_ARG(str) !std::strcmp(argv[i], str)
+#define CHECK_ARG_PARAM(str) (!std::strcmp(argv[i], str) && ((i + 1) < argc))
+
+    if (CHECK_ARG_PARAM("-frames"))
+    {
+      options.frames = static_cast<u32>(std::strtoul(argv[++i], nullptr, 10));
+    }
+    else if (CHECK_ARG_PARAM("-warmup"))
+    {
+      options.warmup_frames = static_cast<u32>(std::strtoul(argv[++i], nullptr, 10));
+    }
+    else if (CHECK_ARG_PARAM("-cpu"))
+    {
+      std::optional<CPUExecutionMode> mode = Settings::ParseCPUExecutionMode(argv[++i]);
+      if (!mode)
+      {
+        std::fprintf(stderr, "Invalid CPU execution mode '%s'\n", argv[i]);
+        return EXIT_FAILURE;
+      }
+
+      options.cpu_execution_mode = mode.value();
+    }
+    else if (CHECK_ARG_PARAM("-bios"))
+    {
+      options.bios_path = argv[++i];
+    }
+    else if (CHECK_ARG_PARAM("-profile"))
+    {
+      options.profile_dump_filename = argv[++i];
+    }
+    else if (CHECK_ARG_PARAM("-hot-blocks"))
+    {
+      options.hot_blocks_filename = argv[++i];
+    }
+    else if (CHECK_ARG_PARAM("-save-state"))
+    {
+      options.save_state_filename = argv[++i];
+    }
+    else if (CHECK_ARG_PARAM("-rewind"))
+    {
+      options.rewind_frequency = static_cast<u32>(std::strtoul(argv[++i], nullptr, 10));
+    }
+    else if (CHECK_ARG_PARAM("-record-movie"))
+    {
+      options.record_movie_filename = argv[++i];
+    }
+    else if (CHECK_ARG_PARAM("-play-movie"))
+    {
+      options.play_movie_filename = argv[++i];
+    }
+    else if (CHECK_ARG_PARAM("-checkpoint-interval"))
+    {
+      options.checkpoint_interval = static_cast<u32>(std::strtoul(argv[++i], nullptr, 10));
+    }
+    else if (CHECK_ARG_PARAM("-state-round-trips"))
+    {
+      options.state_round_trips = static_cast<u32>(std::strtoul(argv[++i], nullptr, 10));
+    }
+    else if (CHECK_ARG_PARAM("-check-gte"))
+    {
+      gte_check_iterations = static_cast<u32>(std::strtoul(argv[++i], nullptr, 10));
+    }
+    else if (CHECK_ARG("-fastboot"))
+    {
+      options.fast_boot = true;
+    }
+    else if (CHECK_ARG("-no-fastmem"))
+    {
+      options.fastmem = false;
+    }
+    else if (CHECK_ARG("-compare-scalar"))
+    {
+      options.compare_scalar = true;
+    }
+    else if (CHECK_ARG("-verbose"))
+    {
+      verbose = true;
+    }
+    else if (CHECK_ARG("-help") || argv[i][0] == '-')
+    {
+      PrintUsage(argv[0]);
+      return EXIT_FAILURE;
+    }
+    else
+    {
+      options.filename = argv[i];
+    }
+
+#undef CHECK_ARG
+#undef CHECK_ARG_PARAM
+  }
+
+  const LOGLEVEL level = verbose ? LOGLEVEL_INFO : LOGLEVEL_ERROR;
+  Log::SetConsoleOutputParams(true, nullptr, level);
+  Log::SetFilterLevel(level);
+
+  if (gte_check_iterations > 0)
+    return RunGTEConformanceCheck(gte_check_iterations) ? EXIT_SUCCESS : EXIT_FAILURE;
+
+  std::unique_ptr<BenchHostInterface> host_interface = BenchHostInterface::Create(options);
+  if (!host_interface)
+  {
+    std::fprintf(stderr, "Failed to create host interface\n");
+    return EXIT_FAILURE;
+  }
+
+  if (!host_interface->Run())
+    return EXIT_FAILURE;
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,69 @@
+#include "null_host_display.h"
+
+class NullHostDisplayTexture : public HostDisplayTexture
+{
+public:
+  NullHostDisplayTexture(u32 width, u32 height) : m_width(width), m_height(height) {}
+  ~NullHostDisplayTexture() override = default;
+
+  void* GetHandle() const override { return const_cast<NullHostDisplayTexture*>(this); }
+  u32 GetWidth() const override { return m_width; }
+  u32 GetHeight() const override { return m_height; }
+
+private:
+  u32 m_width;
+  u32 m_height;
+};
+
+NullHostDisplay::NullHostDisplay() = default;
+
+NullHostDisplay::~NullHostDisplay() = default;
+
+std::unique_ptr<HostDisplay> NullHostDisplay::Create()
+{
+  return std::make_unique<NullHostDisplay>();
+}
+
+HostDisplay::RenderAPI NullHostDisplay::GetRenderAPI() const
+{
+  return RenderAPI::None;
+}
+
+void* NullHostDisplay::GetRenderDevice() const
+{
+  return nullptr;
+}
+
+void* NullHostDisplay::GetRenderContext() const
+{
+  return nullptr;
+}
+
+void* NullHostDisplay::GetRenderWindow() const
+{
+  return nullptr;
+}
+
+void NullHostDisplay::ChangeRenderWindow(void* new_window) {}
+
+std::unique_ptr<HostDisplayTexture> NullHostDisplay::CreateTexture(u32 width, u32 height, const void* data,
+                                                                   u32 data_stride, bool dynamic)
+{
+  return std::make_unique<NullHostDisplayTexture>(width, height);
+}
+
+void NullHostDisplay::UpdateTexture(HostDisplayTexture* texture, u32 x, u32 y, u32 width, u32 height,
+                                    const void* data, u32 data_stride)
+{
+}
+
+void NullHostDisplay::SetVSync(bool enabled) {}
+
+std::tuple<u32, u32> NullHostDisplay::GetWindowSize() const
+{
+  return std::make_tuple(0u, 0u);
+}
+
+void NullHostDisplay::WindowResized() {}
+
+void NullHostDisplay::Render() {}
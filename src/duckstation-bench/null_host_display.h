@@ -0,0 +1,32 @@
+#pragma once
+#include "core/host_display.h"
+#include <memory>
+
+// Host display which discards all output, used when running without a window.
+class NullHostDisplay final : public HostDisplay
+{
+public:
+  NullHostDisplay();
+  ~NullHostDisplay();
+
+  static std::unique_ptr<HostDisplay> Create();
+
+  RenderAPI GetRenderAPI() const override;
+  void* GetRenderDevice() const override;
+  void* GetRenderContext() const override;
+  void* GetRenderWindow() const override;
+
+  void ChangeRenderWindow(void* new_window) override;
+
+  std::unique_ptr<HostDisplayTexture> CreateTexture(u32 width, u32 height, const void* data, u32 data_stride,
+                                                    bool dynamic) override;
+  void UpdateTexture(HostDisplayTexture* texture, u32 x, u32 y, u32 width, u32 height, const void* data,
+                     u32 data_stride) override;
+
+  void SetVSync(bool enabled) override;
+
+  std::tuple<u32, u32> GetWindowSize() const override;
+  void WindowResized() override;
+
+  void Render() override;
+};
@@ -20,6 +20,8 @@ GPUSettingsWidget::GPUSettingsWidget(QtHostInterface* host_interface, QWidget* p
   SettingWidgetBinder::BindWidgetToBoolSetting(m_host_interface, m_ui.linearTextureFiltering, "GPU/TextureFiltering");
   SettingWidgetBinder::BindWidgetToBoolSetting(m_host_interface, m_ui.forceProgressiveScan, "GPU/ForceProgressiveScan");
   SettingWidgetBinder::BindWidgetToBoolSetting(m_host_interface, m_ui.useDebugDevice, "GPU/UseDebugDevice");
+  SettingWidgetBinder::BindWidgetToBoolSetting(m_host_interface, m_ui.useThread, "GPU/UseThread");
+  SettingWidgetBinder::BindWidgetToIntSetting(m_host_interface, m_ui.softwareThreadCount, "GPU/SoftwareThreadCount");
 }
 
 GPUSettingsWidget::~GPUSettingsWidget() = default;
@@ -344,6 +344,7 @@ std::vector<QtHostInterface::HotkeyInfo> QtHostInterface::getHotkeyList() const
     {QStringLiteral("FastForward"), QStringLiteral("Toggle Fast Forward"), QStringLiteral("General")},
     {QStringLiteral("Fullscreen"), QStringLiteral("Toggle Fullscreen"), QStringLiteral("General")},
     {QStringLiteral("Pause"), QStringLiteral("Toggle Pause"), QStringLiteral("General")},
+    {QStringLiteral("Rewind"), QStringLiteral("Rewind (Hold)"), QStringLiteral("General")},
     {QStringLiteral("ToggleSoftwareRendering"), QStringLiteral("Toggle Software Rendering"),
      QStringLiteral("Graphics")},
     {QStringLiteral("IncreaseResolutionScale"), QStringLiteral("Increase Resolution Scale"),
@@ -390,6 +391,8 @@ void QtHostInterface::updateHotkeyInputMap()
       pauseSystem(!m_paused);
   });
 
+  hk(QStringLiteral("Rewind"), [this](bool pressed) { m_rewind_held = pressed; });
+
   hk(QStringLiteral("ToggleSoftwareRendering"), [this](bool pressed) {
     if (!pressed)
       ToggleSoftwareRendering();
@@ -590,7 +593,11 @@ void QtHostInterface::threadEntryPoint()
       continue;
     }
 
-    m_system->RunFrame();
+    // Goes back one rewind state per displayed frame, staying on the oldest one when there are none left.
+    if (m_rewind_held && m_settings.rewind_enable)
+      m_system->Rewind();
+    else
+      m_system->RunFrame();
 
     m_system->GetGPU()->ResetGraphicsAPIState();
 
@@ -137,6 +137,9 @@ private:
 
   std::atomic_bool m_shutdown_flag{false};
 
+  // Set by the rewind hotkey, the worker thread rewinds instead of running frames while held.
+  bool m_rewind_held = false;
+
   // input key maps, todo hotkeys
   std::map<int, InputButtonHandler> m_keyboard_input_handlers;
 };
@@ -418,6 +418,13 @@ void SDLHostInterface::HandleSDLKeyEvent(const SDL_Event* event)
     }
     break;
 
+    case SDL_SCANCODE_R:
+    {
+      if (!repeat)
+        m_rewind_held = pressed;
+    }
+    break;
+
     case SDL_SCANCODE_HOME:
     {
       if (pressed && !repeat && m_system)
@@ -922,6 +929,13 @@ void SDLHostInterface::DrawQuickSettingsMenu()
     UpdateSpeedLimiterState();
   }
 
+  if (ImGui::MenuItem("Enable Rewind", nullptr, &m_settings.rewind_enable))
+  {
+    settings_changed = true;
+    if (m_system)
+      m_system->UpdateRewindSettings();
+  }
+
   ImGui::Separator();
 
   if (ImGui::BeginMenu("CPU Execution Mode"))
@@ -1019,6 +1033,8 @@ void SDLHostInterface::DrawDebugMenu()
   ImGui::MenuItem("Show VRAM", nullptr, &debug_settings.show_vram);
   ImGui::MenuItem("Dump CPU to VRAM Copies", nullptr, &debug_settings.dump_cpu_to_vram_copies);
   ImGui::MenuItem("Dump VRAM to CPU Copies", nullptr, &debug_settings.dump_vram_to_cpu_copies);
+  if (ImGui::MenuItem("Disable Software Renderer SIMD", nullptr, &debug_settings.disable_gpu_sw_simd))
+    m_system->UpdateGPUSettings();
   ImGui::Separator();
 
   ImGui::MenuItem("Show CDROM State", nullptr, &debug_settings.show_cdrom_state);
@@ -1032,6 +1048,15 @@ void SDLHostInterface::DrawDebugMenu()
 
   ImGui::MenuItem("Show MDEC State", nullptr, &debug_settings.show_mdec_state);
   ImGui::Separator();
+
+  ImGui::MenuItem("Show Profiler", nullptr, &debug_settings.show_profiler);
+  ImGui::Separator();
+
+  ImGui::MenuItem("Show Code Cache State", nullptr, &debug_settings.show_code_cache_state);
+  ImGui::Separator();
+
+  ImGui::MenuItem("Show Hot Blocks", nullptr, &debug_settings.show_hot_blocks);
+  ImGui::Separator();
 }
 
 void SDLHostInterface::DrawPoweredOffWindow()
@@ -1176,6 +1201,29 @@ void SDLHostInterface::DrawSettingsWindow()
         }
 
         settings_changed |= ImGui::Checkbox("Pause On Start", &m_settings.start_paused);
+
+        bool rewind_settings_changed = ImGui::Checkbox("Enable Rewind (hold R)", &m_settings.rewind_enable);
+
+        int rewind_save_frequency = static_cast<int>(m_settings.rewind_save_frequency);
+        if (ImGui::SliderInt("Rewind Frequency (frames)", &rewind_save_frequency, 1, 60))
+        {
+          m_settings.rewind_save_frequency = static_cast<u32>(rewind_save_frequency);
+          settings_changed = true;
+        }
+
+        int rewind_save_slots = static_cast<int>(m_settings.rewind_save_slots);
+        if (ImGui::SliderInt("Rewind Save Slots", &rewind_save_slots, 1, 1000))
+        {
+          m_settings.rewind_save_slots = static_cast<u32>(rewind_save_slots);
+          rewind_settings_changed = true;
+        }
+
+        if (rewind_settings_changed)
+        {
+          settings_changed = true;
+          if (m_system)
+            m_system->UpdateRewindSettings();
+        }
       }
 
       ImGui::NewLine();
@@ -1285,6 +1333,15 @@ void SDLHostInterface::DrawSettingsWindow()
           m_system->SetCPUExecutionMode(m_settings.cpu_execution_mode);
       }
 
+      if (ImGui::Checkbox("Fastmem (Recompiler)", &m_settings.cpu_fastmem))
+      {
+        settings_changed = true;
+        if (m_system)
+          m_system->SetCPUFastmem(m_settings.cpu_fastmem);
+      }
+
+      settings_changed |= ImGui::Checkbox("Persistent Code Cache", &m_settings.cpu_persistent_code_cache);
+
       ImGui::EndTabItem();
     }
 
@@ -1370,6 +1427,14 @@ void SDLHostInterface::DrawSettingsWindow()
         gpu_settings_changed |= ImGui::Checkbox("True 24-bit Color (disables dithering)", &m_settings.gpu_true_color);
         gpu_settings_changed |= ImGui::Checkbox("Texture Filtering", &m_settings.gpu_texture_filtering);
         gpu_settings_changed |= ImGui::Checkbox("Force Progressive Scan", &m_settings.gpu_force_progressive_scan);
+        gpu_settings_changed |= ImGui::Checkbox("Threaded Software Rendering", &m_settings.gpu_use_thread);
+
+        int sw_thread_count = static_cast<int>(m_settings.gpu_sw_thread_count);
+        if (ImGui::SliderInt("Software Renderer Threads", &sw_thread_count, 1, 16))
+        {
+          m_settings.gpu_sw_thread_count = static_cast<u32>(sw_thread_count);
+          gpu_settings_changed = true;
+        }
       }
 
       ImGui::EndTabItem();
@@ -1589,7 +1654,12 @@ void SDLHostInterface::Run()
         break;
     }
 
-    if (m_system && !m_paused)
+    if (m_system && !m_paused && m_rewind_held && m_settings.rewind_enable)
+    {
+      // Goes back one rewind state per displayed frame, staying on the oldest one when there are none left.
+      m_system->Rewind();
+    }
+    else if (m_system && !m_paused)
     {
       m_system->RunFrame();
       if (m_frame_step_request)
@@ -1626,7 +1696,8 @@ void SDLHostInterface::Run()
   // Save state on exit so it can be resumed
   if (m_system)
   {
-    if (!SaveState(RESUME_SAVESTATE_FILENAME))
+    // Wait for the file to be written, the OSD message wouldn't be seen as we're exiting.
+    if (!SaveState(RESUME_SAVESTATE_FILENAME) || !WaitForSaveStateThread())
       ReportError("Saving state failed, you will not be able to resume this session.");
 
     DestroySystem();
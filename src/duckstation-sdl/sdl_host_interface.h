@@ -136,6 +136,7 @@ private:
 
   bool m_quit_request = false;
   bool m_frame_step_request = false;
+  bool m_rewind_held = false;
   bool m_focus_main_menu_bar = false;
   bool m_settings_window_open = false;
   bool m_about_window_open = false;